@@ -0,0 +1 @@
+EXECUTE_PROCESS(COMMAND /usr/bin/cmake -E remove_directory /usr/local/tars/cpp/include)
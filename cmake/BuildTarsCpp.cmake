@@ -23,12 +23,19 @@ macro(build_tars_server MODULE DEPS)
 
             set(CUR_TARS_GEN ${PATH}/${TARS_H})
             LIST(APPEND TARS_LIST_DEPENDS ${CUR_TARS_GEN})
-            
+
+            #单个tars文件的tars2cpp参数, 例如: set_source_files_properties(a.tars PROPERTIES TARS2CPP_FLAGS "--hash-dispatch")
+            get_source_file_property(TARS_SRC_FLAGS ${TARS_SRC} TARS2CPP_FLAGS)
+            if(NOT TARS_SRC_FLAGS)
+                set(TARS_SRC_FLAGS "")
+            endif()
+            separate_arguments(TARS_SRC_FLAGS)
+
             add_custom_command(OUTPUT ${CUR_TARS_GEN}
                     WORKING_DIRECTORY ${PATH}
                     DEPENDS ${TARS2CPP} ${TARS_SRC}
-                    COMMAND ${TARS2CPP} ${TARS_SRC}
-                    COMMENT "${TARS2CPP} ${TARS_SRC}")
+                    COMMAND ${TARS2CPP} ${TARS_SRC_FLAGS} ${TARS_SRC}
+                    COMMENT "${TARS2CPP} ${TARS_SRC_FLAGS} ${TARS_SRC}")
 
             list(APPEND CLEAN_LIST ${PATH}/${TARS_H})
 
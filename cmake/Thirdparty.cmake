@@ -8,6 +8,8 @@ endif(UNIX)
 option(TARS_SSL "option for ssl" OFF)
 option(TARS_HTTP2 "option for http2" OFF)
 option(TARS_PROTOBUF "option for protocol" OFF)
+option(TARS_IO_URING "option for io_uring epoller backend(linux only)" OFF)
+option(TARS_CORO_HOOK "option for hook blocking syscalls in coroutine(linux only)" OFF)
 
 if (TARS_MYSQL)
     add_definitions(-DTARS_MYSQL=1)
@@ -29,6 +31,14 @@ if (TARS_PROTOBUF)
     add_definitions(-DTARS_PROTOBUF=1)
 endif ()
 
+if (TARS_IO_URING)
+    add_definitions(-DTARS_IO_URING=1)
+endif ()
+
+if (TARS_CORO_HOOK)
+    add_definitions(-DTARS_CORO_HOOK=1)
+endif ()
+
 #-------------------------------------------------------------
 
 set(THIRDPARTY_PATH "${CMAKE_BINARY_DIR}/src")
@@ -349,4 +359,6 @@ message("TARS_GZIP:                 ${TARS_GZIP}")
 message("TARS_HTTP2:                ${TARS_HTTP2}")
 message("TARS_SSL:                  ${TARS_SSL}")
 message("TARS_PROTOBUF:             ${TARS_PROTOBUF}")
+message("TARS_IO_URING:             ${TARS_IO_URING}")
+message("TARS_CORO_HOOK:            ${TARS_CORO_HOOK}")
 #message("TARS_GPERF:                ${TARS_GPERF}")
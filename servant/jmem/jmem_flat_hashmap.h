@@ -0,0 +1,352 @@
+﻿/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except 
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed 
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR 
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the 
+ * specific language governing permissions and limitations under the License.
+ */
+
+#ifndef _JMEM_FLAT_HASHMAP_H
+#define _JMEM_FLAT_HASHMAP_H
+
+#include "util/tc_flat_hashmap.h"
+#include "jmem/jmem_policy.h"
+#include "tup/Tars.h"
+
+namespace tars
+{
+/************************************************************************
+重要说明:
+1 适合key和value都比较小且长度有上限的cache, 例如key 8~64字节, value 256字节以内(都是tars编码后的长度);
+2 数据直接存放在定长槽位中, 查找时用控制字节(有SSE2时用SIMD)一次比较16个槽位, 比TarsHashMap少很多次内存跳转;
+3 满了以后按照CLOCK算法淘汰, 没有回写/备份/脏数据/只有Key等功能, 需要这些功能请使用TarsHashMap;
+4 槽位个数由create时的内存大小和initDataSize决定, 不支持扩容;
+5 key或者value编码后超过最大长度时, set返回RT_DATA_TOO_LONG.
+************************************************************************/
+
+/************************************************************************
+ 基本说明如下:
+ 基于Tars协议的开放寻址内存hashmap
+ 编解码出错则抛出TarsDecodeException和TarsEncodeException
+ 可以对锁策略和存储策略进行组合, 例如:
+ 基于信号量锁, 共享内存存储的hashmap
+ TarsFlatHashMap<Test::Key, Test::Value, SemLockPolicy, ShmStorePolicy>
+ 基于线程锁, 内存存储的hashmap
+ TarsFlatHashMap<Test::Key, Test::Value, ThreadLockPolicy, MemStorePolicy>
+
+ 使用ThreadStripedLockPolicy时所有操作都加独占锁
+ 
+ 初始化之前需要调用initDataSize设置key和value的最大长度:
+ TarsFlatHashMap<Test::Key, Test::Value, ThreadLockPolicy, MemStorePolicy> map;
+ map.initDataSize(64, 256);
+ map.create(pAddr, iSize);
+ ***********************************************************************/
+
+template<typename K,
+         typename V,
+         typename LockPolicy,
+         template<class, class> class StorePolicy>
+class TarsFlatHashMap : public StorePolicy<TC_FlatHashMap, LockPolicy>
+{
+public:
+    /**
+     * 初始化key和value(编码后)的最大长度, create之前调用
+     * @param iMaxKeySize: key的最大长度, <=255
+     * @param iMaxValueSize: value的最大长度, <=65535
+     */
+    void initDataSize(size_t iMaxKeySize, size_t iMaxValueSize)
+    {
+        this->_t.initDataSize(iMaxKeySize, iMaxValueSize);
+    }
+
+    /**
+     * 设置hash方式
+     * @param hashf
+     */
+    void setHashFunctor(TC_FlatHashMap::hash_functor hashf)
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        this->_t.setHashFunctor(hashf);
+    }
+
+    /**
+     * 元素个数
+     *
+     * @return size_t
+     */
+    size_t size()
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        return this->_t.size();
+    }
+
+    /**
+     * 槽位个数
+     *
+     * @return size_t
+     */
+    size_t getSlotCount()
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        return this->_t.getSlotCount();
+    }
+
+    /**
+     * 最多能存放的元素个数, 达到以后开始淘汰
+     *
+     * @return size_t
+     */
+    size_t getMaxElementCount()
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        return this->_t.getMaxElementCount();
+    }
+
+    /**
+     * 设置只读
+     * @param bReadOnly
+     */
+    void setReadOnly(bool bReadOnly)
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        this->_t.setReadOnly(bReadOnly);
+    }
+
+    /**
+     * 是否只读
+     *
+     * @return bool
+     */
+    bool isReadOnly()
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        return this->_t.isReadOnly();
+    }
+
+    /**
+     * 设置是否可以自动淘汰
+     * @param bAutoErase
+     */
+    void setAutoErase(bool bAutoErase)
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        this->_t.setAutoErase(bAutoErase);
+    }
+
+    /**
+     * 是否可以自动淘汰
+     *
+     * @return bool
+     */
+    bool isAutoErase()
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        return this->_t.isAutoErase();
+    }
+
+    /**
+     * 头部信息
+     *
+     * @return TC_FlatHashMap::tagMapHead&
+     */
+    TC_FlatHashMap::tagMapHead& getMapHead()   { return this->_t.getMapHead(); }
+
+    /**
+     * 清空hash map
+     */
+    void clear()
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        this->_t.clear();
+    }
+
+    /**
+     * 获取数据
+     * @param k
+     * @param v
+     *
+     * @return int:
+     *          TC_FlatHashMap::RT_NO_DATA: 没有数据
+     *          TC_FlatHashMap::RT_OK:获取数据成功
+     */
+    int get(const K& k, V &v)
+    {
+        string sk = encode(k);
+        string sv;
+
+        int ret;
+        {
+            TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+            ret = this->_t.get(sk, sv);
+        }
+
+        //解锁以后再解包
+        if(ret == TC_FlatHashMap::RT_OK)
+        {
+            tars::TarsInputStream<BufferReader> is;
+            is.setBuffer(sv.c_str(), sv.length());
+            v.readFrom(is);
+        }
+
+        return ret;
+    }
+
+    /**
+     * 设置数据, 满了时按照CLOCK淘汰数据
+     * @param k: 关键字
+     * @param v: 值
+     * @return int:
+     *          TC_FlatHashMap::RT_READONLY: map只读
+     *          TC_FlatHashMap::RT_DATA_TOO_LONG: 编码后超过最大长度
+     *          TC_FlatHashMap::RT_NO_MEMORY: 没有空间(不淘汰数据情况下会出现)
+     *          TC_FlatHashMap::RT_OK: 设置成功
+     */
+    int set(const K& k, const V& v)
+    {
+        return doSet(k, v, NULL);
+    }
+
+    /**
+     * 设置数据, 满了时按照CLOCK淘汰数据, 返回淘汰的数据
+     * @param k: 关键字
+     * @param v: 值
+     * @param vErased: 淘汰的数据
+     * @return int: 同set(k, v)
+     */
+    int set(const K& k, const V& v, vector<pair<K, V> > &vErased)
+    {
+        return doSet(k, v, &vErased);
+    }
+
+    /**
+     * 删除数据
+     * @param k, 关键字
+     * @return int:
+     *          TC_FlatHashMap::RT_READONLY: map只读
+     *          TC_FlatHashMap::RT_NO_DATA: 没有当前数据
+     *          TC_FlatHashMap::RT_OK: 删除数据成功
+     */
+    int del(const K& k)
+    {
+        string sk = encode(k);
+        TC_FlatHashMap::BlockData data;
+
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        return this->_t.del(sk, data);
+    }
+
+    /**
+     * 按照CLOCK淘汰一条数据
+     * @param k, 被淘汰数据的关键字
+     * @param v, 被淘汰数据的值
+     * @return int:
+     *          TC_FlatHashMap::RT_READONLY: map只读
+     *          TC_FlatHashMap::RT_NO_DATA: 没有数据
+     *          TC_FlatHashMap::RT_ERASE_OK: 淘汰成功
+     */
+    int erase(K &k, V &v)
+    {
+        TC_FlatHashMap::BlockData data;
+
+        int ret;
+        {
+            TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+            ret = this->_t.erase(data);
+        }
+
+        if(ret == TC_FlatHashMap::RT_ERASE_OK)
+        {
+            decode(data._key, data._value, k, v);
+        }
+
+        return ret;
+    }
+
+    /**
+     * 遍历所有数据, 遍历过程中一直加锁, f中不能再操作map
+     * @param f, void (const K &k, const V &v)
+     */
+    template<typename F>
+    void forEach(F f)
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+
+        this->_t.forEach([&](const string &sk, const string &sv)
+        {
+            K k;
+            V v;
+            decode(sk, sv, k, v);
+            f(k, v);
+        });
+    }
+
+    /**
+     * 描述
+     *
+     * @return string
+     */
+    string desc()
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        return this->_t.desc();
+    }
+
+protected:
+
+    template<typename T>
+    static string encode(const T &t)
+    {
+        tars::TarsOutputStream<BufferWriter> os;
+        t.writeTo(os);
+        return string(os.getBuffer(), os.getLength());
+    }
+
+    static void decode(const string &sk, const string &sv, K &k, V &v)
+    {
+        tars::TarsInputStream<BufferReader> isk;
+        isk.setBuffer(sk.c_str(), sk.length());
+        k.readFrom(isk);
+
+        tars::TarsInputStream<BufferReader> isv;
+        isv.setBuffer(sv.c_str(), sv.length());
+        v.readFrom(isv);
+    }
+
+    int doSet(const K& k, const V& v, vector<pair<K, V> > *pErased)
+    {
+        string sk = encode(k);
+        string sv = encode(v);
+
+        vector<TC_FlatHashMap::BlockData> vtData;
+
+        int ret;
+        {
+            TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+            ret = this->_t.set(sk, sv, vtData);
+        }
+
+        if(pErased != NULL)
+        {
+            for(size_t i = 0; i < vtData.size(); i++)
+            {
+                pair<K, V> kv;
+                decode(vtData[i]._key, vtData[i]._value, kv.first, kv.second);
+                pErased->push_back(kv);
+            }
+        }
+
+        return ret;
+    }
+};
+
+}
+
+#endif
@@ -21,6 +21,8 @@
 #include "util/tc_autoptr.h"
 #include "jmem/jmem_policy.h"
 #include "tup/Tars.h"
+#include <type_traits>
+#include <functional>
 
 namespace tars
 {
@@ -825,6 +827,7 @@ public:
     TarsHashMap()
     {
         _todo_of = NULL;
+        initStriped(StripedTag());
     }
 
     /**
@@ -1198,10 +1201,7 @@ public:
         string sk(osk.getBuffer(), osk.getLength());
         string sv;
 
-        {
-            TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
-            ret = this->_t.get(sk, sv, iSyncTime);
-        }
+        ret = doGet(sk, sv, iSyncTime, StripedTag());
 
         //读取到数据了, 解包
         if(ret == TC_HashMap::RT_OK)
@@ -1268,6 +1268,48 @@ public:
         return get(k, v, iSyncTime);
     }
 
+    /**
+     * 批量获取数据, 修改GET时间链
+     * 整批只加一次锁(分段锁每个分段加一次), 先预取所有key的hash桶和block, 解锁以后统一解包
+     * 没有数据的key如果设置了ToDoFunctor, 再按get(k, v)单独获取
+     * @param vk
+     * @param vv: 和vk一一对应, 对应的返回值不是RT_OK时是默认值
+     *
+     * @return vector<int>: 和vk一一对应, 每个key的返回值同get
+     */
+    vector<int> get(const vector<K> &vk, vector<V> &vv)
+    {
+        vector<string> vsk(vk.size());
+        for(size_t i = 0; i < vk.size(); i++)
+        {
+            vsk[i] = encode(vk[i]);
+        }
+
+        vector<string> vsv(vk.size());
+        vector<int> vret(vk.size(), TC_HashMap::RT_OK);
+
+        doGetBatch(vsk, vsv, vret, StripedTag());
+
+        vv.clear();
+        vv.resize(vk.size());
+
+        for(size_t i = 0; i < vk.size(); i++)
+        {
+            if(vret[i] == TC_HashMap::RT_OK)
+            {
+                tars::TarsInputStream<BufferReader> is;
+                is.setBuffer(vsv[i].c_str(), vsv[i].length());
+                vv[i].readFrom(is);
+            }
+            else if(vret[i] == TC_HashMap::RT_NO_DATA && _todo_of != NULL)
+            {
+                vret[i] = get(vk[i], vv[i]);
+            }
+        }
+
+        return vret;
+    }
+
     /**
      * 根据key, 获取相同hash值的所有数据
      * 注意:c匹配对象操作中, map是加锁的, 需要注意
@@ -1285,7 +1327,7 @@ public:
         TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
 
         this->_t.doUpdate();
-        size_t index = h % this->_t.getHashCount();
+        size_t index = this->_t.hashValueIndex(h);
         size_t iAddr = this->_t.item(index)->_iBlockAddr;
 
         TC_HashMap::Block block(&this->_t, iAddr);
@@ -1342,7 +1384,7 @@ public:
         TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
 
         this->_t.doUpdate();
-        size_t index = h % this->_t.getHashCount();
+        size_t index = this->_t.hashValueIndex(h);
         size_t iAddr = this->_t.item(index)->_iBlockAddr;
 
         TC_HashMap::Block block(&this->_t, iAddr);
@@ -1409,6 +1451,40 @@ public:
         return e;
     }
 
+    /**
+     * 迁移iStep个旧的hash桶, 可以在后台线程里调用
+     * 扩展内存同时增加hash桶以后(FileStorePolicy::expand)开始rehash, 每次get/set等操作也会迁移几个桶
+     * @param iStep
+     * @return size_t, 还没有迁移的旧hash桶个数, 0表示没有rehash或者已经完成
+     */
+    size_t rehash(size_t iStep)
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        return this->_t.rehash(iStep);
+    }
+
+    /**
+     * 设置每次操作顺便迁移的hash桶个数, 0表示只通过rehash迁移
+     * @param iStep
+     */
+    void setRehashStep(size_t iStep)
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        this->_t.setRehashStep(iStep);
+    }
+
+    /**
+     * 获取rehash进度
+     * @param iMigrated, 已经迁移完的旧hash桶个数
+     * @param iOldCount, 旧hash桶个数
+     * @param iNewCount, 新hash桶个数, 没有rehash时为0
+     */
+    void getRehashProgress(size_t &iMigrated, size_t &iOldCount, size_t &iNewCount)
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        this->_t.getRehashProgress(iMigrated, iOldCount, iNewCount);
+    }
+
     /**
      * 设置数据, 修改时间链, 内存不够时会自动淘汰老的数据
      * @param k: 关键字
@@ -1433,40 +1509,11 @@ public:
         int ret = TC_HashMap::RT_OK;
         vector<TC_HashMap::BlockData> vtData;
 
-        {
-            TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
-            ret = this->_t.set(sk, sv, bDirty, vtData);
-        }
+        ret = doWrite(sk, [&]{ return this->_t.set(sk, sv, bDirty, vtData); }, StripedTag());
 
         //操作淘汰数据
-        if(_todo_of)
-        {
-            for(size_t i = 0; i < vtData.size(); i++)
-            {
-                K tk;
-                V tv;
-                try
-                {
-                    tars::TarsInputStream<BufferReader> is;
-                    is.setBuffer(vtData[i]._key.c_str(), vtData[i]._key.length());
-                    tk.readFrom(is);
-
-                    is.setBuffer(vtData[i]._value.c_str(), vtData[i]._value.length());
-                    tv.readFrom(is);
-
-                    typename ToDoFunctor::DataRecord stDataRecord;
-                    stDataRecord._key       = tk;
-                    stDataRecord._value     = tv;
-                    stDataRecord._dirty     = vtData[i]._dirty;
-                    stDataRecord._iSyncTime = vtData[i]._synct;
+        syncErased(vtData);
 
-                    _todo_of->sync(stDataRecord);
-                }
-                catch(exception &ex)
-                {
-                }
-            }
-        }
         return ret;
     }
 
@@ -1488,42 +1535,41 @@ public:
         int ret = TC_HashMap::RT_OK;
         vector<TC_HashMap::BlockData> vtData;
 
-        {
-            TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
-            ret = this->_t.set(sk, vtData);
-        }
+        ret = doWrite(sk, [&]{ return this->_t.set(sk, vtData); }, StripedTag());
 
         //操作淘汰数据
-        if(_todo_of)
+        syncErased(vtData);
+
+        return ret;
+    }
+
+    /**
+     * 批量设置数据, 修改时间链, 内存不够时会自动淘汰老的数据
+     * 整批只加一次锁(分段锁每个分段加一次), 先预取所有key的hash桶和block
+     * @param vkv: 关键字和值
+     * @param bDirty: 是否是脏数据
+     *
+     * @return vector<int>: 和vkv一一对应, 每个的返回值同set
+     */
+    vector<int> set(const vector<pair<K, V> > &vkv, bool bDirty = true)
+    {
+        vector<string> vsk(vkv.size());
+        vector<string> vsv(vkv.size());
+        for(size_t i = 0; i < vkv.size(); i++)
         {
-            for(size_t i = 0; i < vtData.size(); i++)
-            {
-                K tk;
-                V tv;
+            vsk[i] = encode(vkv[i].first);
+            vsv[i] = encode(vkv[i].second);
+        }
 
-                try
-                {
-                    tars::TarsInputStream<BufferReader> is;
-                    is.setBuffer(vtData[i]._key.c_str(), vtData[i]._key.length());
-                    tk.readFrom(is);
+        vector<int> vret(vkv.size(), TC_HashMap::RT_OK);
+        vector<TC_HashMap::BlockData> vtData;
 
-                    is.setBuffer(vtData[i]._value.c_str(), vtData[i]._value.length());
-                    tv.readFrom(is);
+        doWriteBatch(vsk, [&](size_t i){ return this->_t.set(vsk[i], vsv[i], bDirty, vtData); }, vret, StripedTag());
 
-                    typename ToDoFunctor::DataRecord stDataRecord;
-                    stDataRecord._key       = tk;
-                    stDataRecord._value     = tv;
-                    stDataRecord._dirty     = vtData[i]._dirty;
-                    stDataRecord._iSyncTime = vtData[i]._synct;
+        //操作淘汰数据
+        syncErased(vtData);
 
-                    _todo_of->sync(stDataRecord);
-                }
-                catch(exception &ex)
-                {
-                }
-            }
-        }
-        return ret;
+        return vret;
     }
 
     /**
@@ -1548,10 +1594,7 @@ public:
         k.writeTo(os);
         string sk(os.getBuffer(), os.getLength());
 
-        {
-            TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
-            ret = this->_t.del(sk, data);
-        }
+        ret = doWrite(sk, [&]{ return this->_t.del(sk, data); }, StripedTag());
 
         if(ret != TC_HashMap::RT_OK && ret != TC_HashMap::RT_ONLY_KEY && ret != TC_HashMap::RT_NO_DATA)
         {
@@ -1602,10 +1645,7 @@ public:
         k.writeTo(os);
         string sk(os.getBuffer(), os.getLength());
 
-        {
-            TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
-            ret = this->_t.del(sk, data);
-        }
+        ret = doWrite(sk, [&]{ return this->_t.del(sk, data); }, StripedTag());
 
         if(ret != TC_HashMap::RT_OK)
         {
@@ -1630,6 +1670,53 @@ public:
         return ret;
     }
 
+    /**
+     * 批量删除数据, cache有数据的, todo的erase被调用
+     * 整批只加一次锁(分段锁每个分段加一次), 先预取所有key的hash桶和block
+     * @param vk
+     *
+     * @return vector<int>: 和vk一一对应, 每个key的返回值同erase
+     */
+    vector<int> erase(const vector<K> &vk)
+    {
+        vector<string> vsk(vk.size());
+        for(size_t i = 0; i < vk.size(); i++)
+        {
+            vsk[i] = encode(vk[i]);
+        }
+
+        vector<int> vret(vk.size(), TC_HashMap::RT_OK);
+        vector<TC_HashMap::BlockData> vData(vk.size());
+
+        doWriteBatch(vsk, [&](size_t i){ return this->_t.del(vsk[i], vData[i]); }, vret, StripedTag());
+
+        if(_todo_of)
+        {
+            for(size_t i = 0; i < vk.size(); i++)
+            {
+                if(vret[i] != TC_HashMap::RT_OK)
+                {
+                    continue;
+                }
+
+                V v;
+                tars::TarsInputStream<BufferReader> is;
+                is.setBuffer(vData[i]._value.c_str(), vData[i]._value.length());
+                v.readFrom(is);
+
+                typename ToDoFunctor::DataRecord stDataRecord;
+                stDataRecord._key       = vk[i];
+                stDataRecord._value     = v;
+                stDataRecord._dirty     = vData[i]._dirty;
+                stDataRecord._iSyncTime = vData[i]._synct;
+
+                _todo_of->erase(stDataRecord);
+            }
+        }
+
+        return vret;
+    }
+
     /**
      * 强制删除数据,不调用todo的erase被调用
      *
@@ -1651,10 +1738,7 @@ public:
         k.writeTo(os);
         string sk(os.getBuffer(), os.getLength());
 
-        {
-            TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
-            ret = this->_t.del(sk, data);
-        }
+        ret = doWrite(sk, [&]{ return this->_t.del(sk, data); }, StripedTag());
 
         if(ret != TC_HashMap::RT_OK)
         {
@@ -1696,7 +1780,7 @@ public:
         TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
 
         this->_t.doUpdate();
-        size_t index = h % this->_t.getHashCount();
+        size_t index = this->_t.hashValueIndex(h);
         size_t iAddr = this->_t.item(index)->_iBlockAddr;
 
         TC_HashMap::Block block(&this->_t, iAddr);
@@ -1763,7 +1847,7 @@ public:
         TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
 
         this->_t.doUpdate();
-        size_t index = h % this->_t.getHashCount();
+        size_t index = this->_t.hashValueIndex(h);
         size_t iAddr = this->_t.item(index)->_iBlockAddr;
 
         TC_HashMap::Block block(&this->_t, iAddr);
@@ -2326,6 +2410,403 @@ public:
         return JhmIterator(this->_t.hashIndex(iIndex), jlock);
     }
 
+protected:
+
+    template<typename T>
+    static string encode(const T &t)
+    {
+        tars::TarsOutputStream<BufferWriter> os;
+        t.writeTo(os);
+        return string(os.getBuffer(), os.getLength());
+    }
+
+    /**
+     * 淘汰的数据回调ToDoFunctor的sync
+     * @param vtData
+     */
+    void syncErased(const vector<TC_HashMap::BlockData> &vtData)
+    {
+        if(!_todo_of)
+        {
+            return;
+        }
+
+        for(size_t i = 0; i < vtData.size(); i++)
+        {
+            K tk;
+            V tv;
+
+            try
+            {
+                tars::TarsInputStream<BufferReader> is;
+                is.setBuffer(vtData[i]._key.c_str(), vtData[i]._key.length());
+                tk.readFrom(is);
+
+                is.setBuffer(vtData[i]._value.c_str(), vtData[i]._value.length());
+                tv.readFrom(is);
+
+                typename ToDoFunctor::DataRecord stDataRecord;
+                stDataRecord._key       = tk;
+                stDataRecord._value     = tv;
+                stDataRecord._dirty     = vtData[i]._dirty;
+                stDataRecord._iSyncTime = vtData[i]._synct;
+
+                _todo_of->sync(stDataRecord);
+            }
+            catch(exception &ex)
+            {
+            }
+        }
+    }
+
+    /**
+     * 是否是分段锁策略
+     */
+    typedef std::integral_constant<bool, std::is_base_of<ThreadStripedLockPolicy, LockPolicy>::value> StripedTag;
+
+    void initStriped(std::false_type)
+    {
+    }
+
+    void initStriped(std::true_type)
+    {
+        LockPolicy::mutex().setFlushFunctor(std::bind(&TarsHashMap::flushGet, this, std::placeholders::_1));
+    }
+
+    /**
+     * 批量刷新get延迟的Get链(需要持有全局锁)
+     * @param iHeld: 已经持有的分段
+     */
+    void flushGet(size_t iHeld)
+    {
+        vector<size_t> vtAddr;
+        size_t iGetCount = 0;
+        size_t iHitCount = 0;
+
+        LockPolicy::mutex().collect(iHeld, vtAddr, iGetCount, iHitCount);
+
+        if(!vtAddr.empty() || iGetCount != 0)
+        {
+            this->_t.refreshGet(vtAddr, iGetCount, iHitCount);
+        }
+    }
+
+    int doGet(const string &sk, string &sv, time_t &iSyncTime, std::false_type)
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        return this->_t.get(sk, sv, iSyncTime);
+    }
+
+    /**
+     * 分段锁: 只锁key所在的分段, Get链延迟刷新
+     */
+    int doGet(const string &sk, string &sv, time_t &iSyncTime, std::true_type)
+    {
+        typename LockPolicy::Mutex &m = LockPolicy::mutex();
+
+        int ret         = TC_HashMap::RT_OK;
+        bool bFlush     = false;
+
+        while(true)
+        {
+            size_t index    = this->_t.hashIndex(sk);
+            size_t s        = m.stripe(index);
+
+            TC_LockT<TC_ThreadMutex> lock(m.stripeMutex(s));
+
+            //加锁之前rehash迁移了这个桶, 重新计算
+            if(this->_t.hashIndex(sk) != index)
+            {
+                continue;
+            }
+
+            size_t iAddr = 0;
+            ret = this->_t.peek(sk, index, sv, iSyncTime, iAddr);
+            bFlush = m.record(s, iAddr, ret == TC_HashMap::RT_OK || ret == TC_HashMap::RT_ONLY_KEY);
+            break;
+        }
+
+        //积累的太多了, 没有修改操作在进行的话顺便刷新, 否则留给修改操作
+        if(bFlush)
+        {
+            TC_TryLockT<TC_ThreadMutex> lock(m.globalMutex());
+            if(lock.acquired())
+            {
+                flushGet((size_t)-1);
+            }
+        }
+
+        return ret;
+    }
+
+    /**
+     * 计算hash桶, 并按照分段分组
+     */
+    void groupByStripe(const vector<string> &vsk, vector<size_t> &vIndex, vector<vector<size_t> > &vGroup)
+    {
+        typename LockPolicy::Mutex &m = LockPolicy::mutex();
+
+        vIndex.resize(vsk.size());
+        vGroup.resize(LockPolicy::Mutex::STRIPE_COUNT);
+
+        for(size_t i = 0; i < vsk.size(); i++)
+        {
+            vIndex[i] = this->_t.hashIndex(vsk[i]);
+            vGroup[m.stripe(vIndex[i])].push_back(i);
+        }
+    }
+
+    void doGetBatch(const vector<string> &vsk, vector<string> &vsv, vector<int> &vret, std::false_type)
+    {
+        vector<size_t> vIndex(vsk.size());
+        for(size_t i = 0; i < vsk.size(); i++)
+        {
+            vIndex[i] = this->_t.hashIndex(vsk[i]);
+        }
+
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+
+        this->_t.prefetch(vIndex);
+
+        time_t iSyncTime;
+        for(size_t i = 0; i < vsk.size(); i++)
+        {
+            vret[i] = this->_t.get(vsk[i], vsv[i], iSyncTime);
+        }
+    }
+
+    /**
+     * 分段锁: 每个分段只加一次锁, Get链延迟刷新
+     */
+    void doGetBatch(const vector<string> &vsk, vector<string> &vsv, vector<int> &vret, std::true_type)
+    {
+        typename LockPolicy::Mutex &m = LockPolicy::mutex();
+
+        vector<size_t> vIndex;
+        vector<vector<size_t> > vGroup;
+        groupByStripe(vsk, vIndex, vGroup);
+
+        bool bFlush = false;
+        vector<size_t> vStripeIndex;
+        vector<size_t> vRetry;
+
+        for(size_t s = 0; s < vGroup.size(); s++)
+        {
+            const vector<size_t> &vPos = vGroup[s];
+            if(vPos.empty())
+            {
+                continue;
+            }
+
+            vStripeIndex.clear();
+            for(size_t j = 0; j < vPos.size(); j++)
+            {
+                vStripeIndex.push_back(vIndex[vPos[j]]);
+            }
+
+            TC_LockT<TC_ThreadMutex> lock(m.stripeMutex(s));
+
+            this->_t.prefetch(vStripeIndex);
+
+            for(size_t j = 0; j < vPos.size(); j++)
+            {
+                size_t i        = vPos[j];
+                size_t iAddr    = 0;
+                time_t iSyncTime;
+
+                //分组以后rehash迁移了这个桶, 稍后单独获取
+                if(this->_t.hashIndex(vsk[i]) != vIndex[i])
+                {
+                    vRetry.push_back(i);
+                    continue;
+                }
+
+                vret[i] = this->_t.peek(vsk[i], vIndex[i], vsv[i], iSyncTime, iAddr);
+                bFlush = m.record(s, iAddr, vret[i] == TC_HashMap::RT_OK || vret[i] == TC_HashMap::RT_ONLY_KEY) || bFlush;
+            }
+        }
+
+        for(size_t j = 0; j < vRetry.size(); j++)
+        {
+            time_t iSyncTime;
+            vret[vRetry[j]] = doGet(vsk[vRetry[j]], vsv[vRetry[j]], iSyncTime, std::true_type());
+        }
+
+        if(bFlush)
+        {
+            TC_TryLockT<TC_ThreadMutex> lock(m.globalMutex());
+            if(lock.acquired())
+            {
+                flushGet((size_t)-1);
+            }
+        }
+    }
+
+    template<typename F>
+    void doWriteBatch(const vector<string> &vsk, F f, vector<int> &vret, std::false_type)
+    {
+        vector<size_t> vIndex(vsk.size());
+        for(size_t i = 0; i < vsk.size(); i++)
+        {
+            vIndex[i] = this->_t.hashIndex(vsk[i]);
+        }
+
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+
+        this->_t.prefetch(vIndex);
+
+        for(size_t i = 0; i < vsk.size(); i++)
+        {
+            vret[i] = f(i);
+        }
+    }
+
+    /**
+     * 分段锁: 锁全局锁, 每个分段只加一次锁
+     * 需要淘汰其他桶的数据时, 该分段剩下的操作锁住所有分段按原来的顺序重做
+     */
+    template<typename F>
+    void doWriteBatch(const vector<string> &vsk, F f, vector<int> &vret, std::true_type)
+    {
+        typename LockPolicy::Mutex &m = LockPolicy::mutex();
+
+        vector<size_t> vIndex;
+        vector<vector<size_t> > vGroup;
+
+        vector<size_t> vRetry;
+        vector<size_t> vStripeIndex;
+
+        {
+            TC_LockT<TC_ThreadMutex> glock(m.globalMutex());
+
+            //持有全局锁时不会rehash, 分组才是稳定的
+            groupByStripe(vsk, vIndex, vGroup);
+
+            for(size_t s = 0; s < vGroup.size(); s++)
+            {
+                const vector<size_t> &vPos = vGroup[s];
+                if(vPos.empty())
+                {
+                    continue;
+                }
+
+                vStripeIndex.clear();
+                for(size_t j = 0; j < vPos.size(); j++)
+                {
+                    vStripeIndex.push_back(vIndex[vPos[j]]);
+                }
+
+                TC_LockT<TC_ThreadMutex> lock(m.stripeMutex(s));
+
+                //修改以后记录的地址可能失效, 先刷新
+                flushGet(s);
+
+                this->_t.prefetch(vStripeIndex);
+
+                this->_t.setLocalAutoErase(false);
+                try
+                {
+                    for(size_t j = 0; j < vPos.size(); j++)
+                    {
+                        vret[vPos[j]] = f(vPos[j]);
+                        if(vret[vPos[j]] == TC_HashMap::RT_NO_MEMORY)
+                        {
+                            //同一个key可能出现多次, 剩下的都要按顺序重做
+                            vRetry.insert(vRetry.end(), vPos.begin() + j, vPos.end());
+                            break;
+                        }
+                    }
+                }
+                catch(...)
+                {
+                    this->_t.setLocalAutoErase(true);
+                    throw;
+                }
+                this->_t.setLocalAutoErase(true);
+            }
+        }
+
+        if(!vRetry.empty())
+        {
+            TC_LockT<typename LockPolicy::Mutex> lock(m);
+
+            for(size_t j = 0; j < vRetry.size(); j++)
+            {
+                vret[vRetry[j]] = f(vRetry[j]);
+            }
+        }
+
+        tryRehash();
+    }
+
+    template<typename F>
+    int doWrite(const string &sk, F f, std::false_type)
+    {
+        TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        return f();
+    }
+
+    /**
+     * 分段锁: 锁全局锁和key所在的分段, 需要淘汰其他桶的数据时锁住所有分段重做
+     */
+    template<typename F>
+    int doWrite(const string &sk, F f, std::true_type)
+    {
+        typename LockPolicy::Mutex &m = LockPolicy::mutex();
+
+        int ret = TC_HashMap::RT_OK;
+
+        {
+            TC_LockT<TC_ThreadMutex> glock(m.globalMutex());
+
+            size_t s = m.stripe(this->_t.hashIndex(sk));
+
+            TC_LockT<TC_ThreadMutex> lock(m.stripeMutex(s));
+
+            //修改以后记录的地址可能失效, 先刷新
+            flushGet(s);
+
+            this->_t.setLocalAutoErase(false);
+            try
+            {
+                ret = f();
+            }
+            catch(...)
+            {
+                this->_t.setLocalAutoErase(true);
+                throw;
+            }
+            this->_t.setLocalAutoErase(true);
+        }
+
+        if(ret == TC_HashMap::RT_NO_MEMORY)
+        {
+            TC_LockT<typename LockPolicy::Mutex> lock(m);
+            ret = f();
+        }
+
+        tryRehash();
+
+        return ret;
+    }
+
+    /**
+     * 分段锁: 修改操作只锁了部分分段, 不会顺便rehash, 这里没人占用时锁住所有分段迁移几个桶
+     */
+    void tryRehash()
+    {
+        if(!this->_t.isRehashing())
+        {
+            return;
+        }
+
+        TC_TryLockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+        if(lock.acquired())
+        {
+            this->_t.rehash(this->_t.getRehashStep());
+        }
+    }
+
 protected:
 
     /**
@@ -1480,6 +1480,65 @@ public:
         return TC_Multi_HashMap::RT_LOAD_DATA_ERR;
     }
 
+    /**
+     * 批量获取数据, 修改GET时间链
+     * 整批只加一次锁, 先预取所有key的hash桶和block, 解锁以后统一解包
+     * 没有数据的key如果设置了ToDoFunctor, 再按get(mk, uk, v)单独获取
+     * @param vKey: 主key和联合key
+     * @param vs: 和vKey一一对应, 对应的返回值不是RT_OK时只有_mkey/_ukey有效
+     *
+     * @return vector<int>: 和vKey一一对应, 每个key的返回值同get(mk, uk, v)
+     */
+    vector<int> get(const vector<pair<MK, UK> > &vKey, vector<Value> &vs)
+    {
+        vector<pair<string, string> > vsKey(vKey.size());
+        for(size_t i = 0; i < vKey.size(); i++)
+        {
+            encodeKey(vKey[i], vsKey[i]);
+        }
+
+        vector<int> vret(vKey.size(), TC_Multi_HashMap::RT_OK);
+        vector<TC_Multi_HashMap::Value> vtv(vKey.size());
+
+        {
+            TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+
+            this->_t.prefetch(vsKey);
+
+            for(size_t i = 0; i < vsKey.size(); i++)
+            {
+                vret[i] = this->_t.get(vsKey[i].first, vsKey[i].second, vtv[i]);
+            }
+        }
+
+        vs.clear();
+        vs.resize(vKey.size());
+
+        for(size_t i = 0; i < vKey.size(); i++)
+        {
+            Value &v = vs[i];
+            v._mkey = vKey[i].first;
+            v._ukey = vKey[i].second;
+
+            if(vret[i] == TC_Multi_HashMap::RT_OK)
+            {
+                v._dirty = vtv[i]._data._dirty;
+                v._iSyncTime = vtv[i]._data._synct;
+                v._iVersion = vtv[i]._data._iVersion;
+
+                tars::TarsInputStream<BufferReader> is;
+                is.setBuffer(vtv[i]._data._value.c_str(), vtv[i]._data._value.length());
+                v._value.readFrom(is);
+            }
+            else if(vret[i] == TC_Multi_HashMap::RT_NO_DATA && _todo_of != NULL)
+            {
+                vret[i] = get(vKey[i].first, vKey[i].second, v);
+            }
+        }
+
+        return vret;
+    }
+
     /**
      * 根据hash值获取相同hash值的所有数据
      * 注意:c匹配对象操作中, map是加锁的, 需要注意
@@ -1890,6 +1949,53 @@ public:
         return ret;
     }
 
+    /**
+     * 批量设置数据, 修改时间链, 内存不够时会自动淘汰老的数据
+     * 整批只加一次锁, 先预取所有key的hash桶和block, 每个数据的返回值单独返回
+     * @param vKey: 主key和联合key
+     * @param vv: 值, 和vKey一一对应
+     * @param bDirty: 是否是脏数据
+     * @param eType: 插入的数据的类型, 同set(mk, uk, v, ...)
+     * @param bHead: 数据插入到主key链的头部还是尾部
+     *
+     * @return vector<int>: 和vKey一一对应, 每个的返回值同set(mk, uk, v, ...)
+     */
+    vector<int> set(const vector<pair<MK, UK> > &vKey, const vector<V> &vv, bool bDirty = true, 
+        TC_Multi_HashMap::DATATYPE eType = TC_Multi_HashMap::AUTO_DATA, bool bHead = true)
+    {
+        assert(vKey.size() == vv.size());
+
+        vector<pair<string, string> > vsKey(vKey.size());
+        vector<string> vsv(vv.size());
+        for(size_t i = 0; i < vKey.size(); i++)
+        {
+            encodeKey(vKey[i], vsKey[i]);
+
+            tars::TarsOutputStream<BufferWriter> vos;
+            vv[i].writeTo(vos);
+            vsv[i].assign(vos.getBuffer(), vos.getLength());
+        }
+
+        vector<int> vret(vKey.size(), TC_Multi_HashMap::RT_OK);
+        vector<TC_Multi_HashMap::Value> vtErased;
+
+        {
+            TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+
+            this->_t.prefetch(vsKey);
+
+            for(size_t i = 0; i < vsKey.size(); i++)
+            {
+                vret[i] = this->_t.set(vsKey[i].first, vsKey[i].second, vsv[i], 0, bDirty, eType, bHead, vtErased);
+            }
+        }
+
+        //操作淘汰数据
+        syncErased(vtErased);
+
+        return vret;
+    }
+
     /**
      * 删除数据
      * 无论cache是否有数据,todo的del都被调用
@@ -2096,6 +2202,70 @@ public:
         return ret;
     }
 
+    /**
+     * 批量删除数据, cache有数据的, todo的erase被调用
+     * 整批只加一次锁, 先预取所有key的hash桶和block
+     * @param vKey: 主key和联合key
+     *
+     * @return vector<int>: 和vKey一一对应, 每个key的返回值同erase(mk, uk)
+     */
+    vector<int> erase(const vector<pair<MK, UK> > &vKey)
+    {
+        vector<pair<string, string> > vsKey(vKey.size());
+        for(size_t i = 0; i < vKey.size(); i++)
+        {
+            encodeKey(vKey[i], vsKey[i]);
+        }
+
+        vector<int> vret(vKey.size(), TC_Multi_HashMap::RT_OK);
+        vector<TC_Multi_HashMap::Value> vData(vKey.size());
+
+        {
+            TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
+
+            this->_t.prefetch(vsKey);
+
+            for(size_t i = 0; i < vsKey.size(); i++)
+            {
+                vret[i] = this->_t.del(vsKey[i].first, vsKey[i].second, vData[i]);
+            }
+        }
+
+        if(_todo_of)
+        {
+            for(size_t i = 0; i < vKey.size(); i++)
+            {
+                if(vret[i] != TC_Multi_HashMap::RT_OK)
+                {
+                    continue;
+                }
+
+                try
+                {
+                    V tv;
+                    tars::TarsInputStream<BufferReader> is;
+                    is.setBuffer(vData[i]._data._value.c_str(), vData[i]._data._value.length());
+                    tv.readFrom(is);
+
+                    typename ToDoFunctor::DataRecord stDataRecord;
+                    stDataRecord._mkey      = vKey[i].first;
+                    stDataRecord._ukey      = vKey[i].second;
+                    stDataRecord._value     = tv;
+                    stDataRecord._iVersion  = vData[i]._data._iVersion;
+                    stDataRecord._dirty     = vData[i]._data._dirty;
+                    stDataRecord._iSyncTime = vData[i]._data._synct;
+
+                    _todo_of->erase(stDataRecord);
+                }
+                catch(exception &ex)
+                {
+                }
+            }
+        }
+
+        return vret;
+    }
+
     /**
      * 强制删除数据,不调用todo的erase被调用
      *
@@ -2723,6 +2893,69 @@ public:
         return JhmIterator(this->_t.hashEnd(), jlock); 
     }
 
+protected:
+
+    /**
+     * 编码主key和联合key
+     * @param key
+     * @param sKey
+     */
+    void encodeKey(const pair<MK, UK> &key, pair<string, string> &sKey)
+    {
+        tars::TarsOutputStream<BufferWriter> mos;
+        key.first.writeTo(mos);
+        sKey.first.assign(mos.getBuffer(), mos.getLength());
+
+        tars::TarsOutputStream<BufferWriter> uos;
+        key.second.writeTo(uos);
+        sKey.second.assign(uos.getBuffer(), uos.getLength());
+    }
+
+    /**
+     * 淘汰的数据回调ToDoFunctor的sync
+     * @param vtErased
+     */
+    void syncErased(const vector<TC_Multi_HashMap::Value> &vtErased)
+    {
+        if(!_todo_of)
+        {
+            return;
+        }
+
+        for(size_t i = 0; i < vtErased.size(); i++)
+        {
+            MK emk;
+            UK euk;
+            V tv;
+
+            try
+            {
+                tars::TarsInputStream<BufferReader> is;
+                is.setBuffer(vtErased[i]._mkey.c_str(), vtErased[i]._mkey.length());
+                emk.readFrom(is);
+
+                is.setBuffer(vtErased[i]._data._key.c_str(), vtErased[i]._data._key.length());
+                euk.readFrom(is);
+
+                is.setBuffer(vtErased[i]._data._value.c_str(), vtErased[i]._data._value.length());
+                tv.readFrom(is);
+
+                typename ToDoFunctor::DataRecord stDataRecord;
+                stDataRecord._mkey      = emk;
+                stDataRecord._ukey      = euk;
+                stDataRecord._value     = tv;
+                stDataRecord._iVersion  = vtErased[i]._data._iVersion;
+                stDataRecord._dirty     = vtErased[i]._data._dirty;
+                stDataRecord._iSyncTime = vtErased[i]._data._synct;
+
+                _todo_of->sync(stDataRecord);
+            }
+            catch(exception &ex)
+            {
+            }
+        }
+    }
+
 protected:
 
     /**
@@ -21,6 +21,9 @@
 #include "util/tc_sem_mutex.h"
 #include "util/tc_shm.h"
 #include "util/tc_mmap.h"
+#include <vector>
+#include <atomic>
+#include <functional>
 
 namespace tars
 {
@@ -125,13 +128,30 @@ public:
      * 扩展空间, 目前只对hashmap有效
      */
     int expand(size_t iSize)
+    {
+        return doExpand(iSize, [&](void *pAddr){ return _t.append(pAddr, iSize); });
+    }
+
+    /**
+     * 扩展空间, 同时增加hash桶的个数并开始增量rehash, 目前只对TC_HashMap有效
+     * @param iSize, 文件大小
+     * @param iHashCount, 新的hash桶个数, 0表示按照文件大小计算
+     */
+    int expand(size_t iSize, size_t iHashCount)
+    {
+        return doExpand(iSize, [&](void *pAddr){ return _t.append(pAddr, iSize, iHashCount); });
+    }
+
+protected:
+    template<typename F>
+    int doExpand(size_t iSize, F f)
     {
         TC_LockT<typename LockPolicy::Mutex> lock(LockPolicy::mutex());
 
         TC_Mmap m(false);
         m.mmap(_file.c_str(), iSize);
 
-        int ret = _t.append(m.getPointer(), iSize);
+        int ret = f(m.getPointer());
 
         if(ret == 0)
         {
@@ -182,6 +202,185 @@ protected:
     Mutex _mutex;
 };
 
+/**
+ * 分段线程锁策略(单进程多线程, 目前只有TarsHashMap支持分段加锁)
+ * mutex()加锁时锁住全局锁和所有分段, 和ThreadLockPolicy一样是独占的, 其他容器也可以使用
+ * TarsHashMap对它做了特殊处理:
+ * - get只锁key所在hash桶对应的分段, 不刷新Get链, 只记录下来, 之后批量刷新
+ * - set/del/erase锁全局锁(修改之间串行)和key所在的分段, 其他分段上的读可以并发
+ *   需要淘汰其他桶的数据时, 升级为锁住所有分段再执行
+ * - 其他操作都通过mutex()独占
+ */
+class ThreadStripedLockPolicy
+{
+public:
+    class Mutex
+    {
+    public:
+        /**
+         * 分段个数, 每次延迟刷新Get链的最大记录数
+         */
+        enum
+        {
+            STRIPE_COUNT    = 64,
+            MAX_PENDING     = 1024,
+        };
+
+        /**
+         * 独占加锁: 全局锁 + 所有分段, 加锁后先刷新延迟的Get链
+         */
+        void lock() const
+        {
+            _global.lock();
+            for(size_t i = 0; i < STRIPE_COUNT; i++)
+            {
+                _stripes[i]._mutex.lock();
+            }
+            if(_flush)
+            {
+                _flush(STRIPE_COUNT);
+            }
+        }
+
+        bool tryLock() const
+        {
+            if(!_global.tryLock())
+            {
+                return false;
+            }
+            for(size_t i = 0; i < STRIPE_COUNT; i++)
+            {
+                _stripes[i]._mutex.lock();
+            }
+            if(_flush)
+            {
+                _flush(STRIPE_COUNT);
+            }
+            return true;
+        }
+
+        void unlock() const
+        {
+            for(size_t i = STRIPE_COUNT; i > 0; i--)
+            {
+                _stripes[i - 1]._mutex.unlock();
+            }
+            _global.unlock();
+        }
+
+        /**
+         * hash桶对应的分段
+         * @param index
+         */
+        size_t stripe(size_t index) const               { return index % STRIPE_COUNT; }
+
+        /**
+         * 分段锁, 只能保护分段内的hash桶
+         */
+        TC_ThreadMutex &stripeMutex(size_t s) const     { return _stripes[s]._mutex; }
+
+        /**
+         * 全局锁, 修改操作之间串行
+         */
+        TC_ThreadMutex &globalMutex() const             { return _global; }
+
+        /**
+         * 记录一次读(需要持有分段s的锁)
+         * @param s
+         * @param iAddr: 命中的数据地址, 0表示没有命中
+         * @param bHit
+         * @return bool, 待刷新的记录太多了, 需要尽快刷新
+         */
+        bool record(size_t s, size_t iAddr, bool bHit) const
+        {
+            Stripe &st = _stripes[s];
+            st._bPending.store(true, std::memory_order_relaxed);
+            ++st._iGetCount;
+            if(bHit)
+            {
+                ++st._iHitCount;
+            }
+            if(iAddr != 0)
+            {
+                st._vtAddr.push_back(iAddr);
+            }
+            return st._vtAddr.size() >= MAX_PENDING;
+        }
+
+        /**
+         * 取出所有分段延迟的记录(需要持有全局锁)
+         * @param iHeld: 已经持有的分段, STRIPE_COUNT表示持有所有分段, (size_t)-1表示都没有持有, 没有持有的分段会临时加锁
+         * @param vtAddr
+         * @param iGetCount
+         * @param iHitCount
+         */
+        void collect(size_t iHeld, vector<size_t> &vtAddr, size_t &iGetCount, size_t &iHitCount) const
+        {
+            iGetCount = 0;
+            iHitCount = 0;
+
+            for(size_t i = 0; i < STRIPE_COUNT; i++)
+            {
+                Stripe &st = _stripes[i];
+
+                //没有记录的分段不用加锁, 之后再记录的地址在本次修改之后仍然有效
+                if(!st._bPending.load(std::memory_order_relaxed))
+                {
+                    continue;
+                }
+
+                bool bLock = (iHeld != STRIPE_COUNT && iHeld != i);
+                if(bLock)
+                {
+                    st._mutex.lock();
+                }
+
+                vtAddr.insert(vtAddr.end(), st._vtAddr.begin(), st._vtAddr.end());
+                st._vtAddr.clear();
+                iGetCount += st._iGetCount;
+                iHitCount += st._iHitCount;
+                st._iGetCount = 0;
+                st._iHitCount = 0;
+                st._bPending.store(false, std::memory_order_relaxed);
+
+                if(bLock)
+                {
+                    st._mutex.unlock();
+                }
+            }
+        }
+
+        /**
+         * 设置刷新函数, 参数是已经持有的分段(同collect)
+         * @param f
+         */
+        void setFlushFunctor(const std::function<void(size_t)> &f)  { _flush = f; }
+
+    protected:
+        struct Stripe
+        {
+            Stripe() : _iGetCount(0), _iHitCount(0), _bPending(false) { }
+
+            TC_ThreadMutex      _mutex;
+            vector<size_t>      _vtAddr;
+            size_t              _iGetCount;
+            size_t              _iHitCount;
+            std::atomic<bool>   _bPending;
+            //避免和相邻分段伪共享
+            char                _pad[64];
+        };
+
+        mutable TC_ThreadMutex          _global;
+        mutable Stripe                  _stripes[STRIPE_COUNT];
+        std::function<void(size_t)>     _flush;
+    };
+
+    Mutex &mutex()     { return _mutex; }
+
+protected:
+    Mutex _mutex;
+};
+
 /**
  * 进程锁策略
  */
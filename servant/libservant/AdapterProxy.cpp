@@ -21,6 +21,8 @@
 #include "servant/RemoteLogger.h"
 #include "tup/tup.h"
 #include "servant/StatF.h"
+#include "servant/CompressCodec.h"
+#include <cmath>
 
 // #ifdef TARS_OPENTRACKING
 // #include "servant/text_map_carrier.h"
@@ -46,6 +48,9 @@ protected:
 
 std::atomic<int> AdapterProxy::_idGen;
 
+//响应时间EWMA的衰减时间常数(毫秒)
+static const double RSP_TIME_DECAY_MS = 1000;
+
 AdapterProxy::AdapterProxy(ObjectProxy * pObjectProxy, const EndpointInfo &ep, Communicator* pCom)
 : _communicator(pCom)
 , _objectProxy(pObjectProxy)
@@ -150,6 +155,9 @@ std::shared_ptr<TC_OpenSSL> AdapterProxy::onOpensslCallback(TC_Transceiver* tran
 
 void AdapterProxy::onCloseCallback(TC_Transceiver* trans, TC_Transceiver::CloseReason reason, const string &err)
 {
+    //重连的可能是另外一个版本的服务端
+    _compressAck.clear();
+
     if(auto cb = _objectProxy->getRootServantProxy()->tars_get_push_callback())
     {
 		cb->onClose(trans->getConnectEndpoint());
@@ -344,6 +352,8 @@ int AdapterProxy::invoke_connection_serial(ReqMessage * msg)
 {
 	assert(msg->eType != ReqMessage::ONE_WAY);
 
+	compressRequest(msg);
+
 	msg->sReqData = _objectProxy->getRootServantProxy()->tars_get_protocol().requestFunc(msg->request, _trans.get());
 
 	msg->request.iRequestId = _timeoutQueue->generateId();
@@ -403,11 +413,22 @@ int AdapterProxy::invoke_connection_serial(ReqMessage * msg)
 
 int AdapterProxy::invoke_connection_parallel(ReqMessage * msg)
 {
+	compressRequest(msg);
+
 	msg->sReqData = _objectProxy->getRootServantProxy()->tars_get_protocol().requestFunc(msg->request, _trans.get());
 
+	//网络线程正在处理请求队列, tcp请求先进未发送队列, 处理完后和同一连接上的其他请求合并发送
+	CommunicatorEpoll *ce = _objectProxy->getCommunicatorEpoll();
+	bool bDefer = ce->isDeferSend() && _trans->getEndpoint().isTcp();
+	if (bDefer && !_deferSend)
+	{
+		_deferSend = true;
+		ce->addDeferSend(this);
+	}
+
 	//当前队列是空的, 且是连接复用模式, 交给连接发送数据
 	//连接连上 buffer不为空  发送数据成功
-	if (_timeoutQueue->sendListEmpty())
+	if (!bDefer && _timeoutQueue->sendListEmpty())
 	{
 		int ret = _trans->sendRequest(msg->sReqData);
 
@@ -546,6 +567,39 @@ void AdapterProxy::doInvoke_serial()
 
 void AdapterProxy::doInvoke_parallel()
 {
+	//tcp积压了多个请求, 一次放入发送buffer, writev合并发送
+	if (_timeoutQueue->getSendListSize() > 1 && _trans->getEndpoint().isTcp())
+	{
+		vector<ReqMessage*> msgs;
+		_timeoutQueue->getSends(msgs);
+
+		vector<shared_ptr<TC_NetWorkBuffer::Buffer>> buffs;
+		buffs.reserve(msgs.size());
+		for (auto msg : msgs)
+		{
+			buffs.push_back(msg->sReqData);
+		}
+
+		int iRet = _trans->sendRequests(buffs);
+
+		if (iRet == TC_Transceiver::eRetError || iRet == TC_Transceiver::eRetNotSend)
+		{
+			TLOGTARS("[AdapterProxy::doInvoke_parallel sendRequests not send, obj:" << _objectProxy->name() << ",desc:" << _trans->getConnectionString() << ",size:" << msgs.size() << ", ret:" << iRet << endl);
+			return;
+		}
+
+		//全部进入发送buffer了(eRetFull时剩余的数据等可写事件再发), 从队列里面清掉
+		for (auto msg : msgs)
+		{
+			_timeoutQueue->popSend(msg->eType == ReqMessage::ONE_WAY);
+			if (msg->eType == ReqMessage::ONE_WAY)
+			{
+				delete msg;
+			}
+		}
+		return;
+	}
+
 	while(!_timeoutQueue->sendListEmpty())
 	{
 		ReqMessage * msg = NULL;
@@ -583,6 +637,13 @@ void AdapterProxy::doInvoke_parallel()
 	}
 }
 
+void AdapterProxy::doDeferSend()
+{
+	_deferSend = false;
+
+	doInvoke();
+}
+
 void AdapterProxy::doInvoke()
 {
 	if(_objectProxy->getRootServantProxy()->tars_connection_serial() > 0)
@@ -879,6 +940,8 @@ void AdapterProxy::finishInvoke_parallel(shared_ptr<ResponsePacket> & rsp)
 
 void AdapterProxy::finishInvoke(shared_ptr<ResponsePacket> & rsp)
 {
+	uncompressResponse(rsp);
+
 	if(_objectProxy->getRootServantProxy()->tars_connection_serial() > 0)
 	{
 		finishInvoke_serial(rsp);
@@ -901,6 +964,9 @@ void AdapterProxy::finishInvoke(ReqMessage * msg)
     //stat 上报调用统计
     stat(msg);
 
+    //自适应负载均衡用的响应时间
+    updateRspTimeEwma(msg);
+
     //超时屏蔽统计,异常不算超时统计
     if (msg->eStatus != ReqMessage::REQ_EXC && !msg->bPush)
     {
@@ -1191,6 +1257,143 @@ void AdapterProxy::stat(ReqMessage * msg)
     }
 }
 
+void AdapterProxy::updateRspTimeEwma(ReqMessage * msg)
+{
+    if (msg->bPush || msg->eType == ReqMessage::ONE_WAY)
+    {
+        return;
+    }
+
+    double rspTime;
+    if (msg->eStatus == ReqMessage::REQ_RSP)
+    {
+        rspTime = (double)(msg->iEndTime >= msg->iBeginTime ? msg->iEndTime - msg->iBeginTime : 0);
+    }
+    else if (msg->eStatus == ReqMessage::REQ_TIME)
+    {
+        //超时按超时时间算
+        rspTime = (double)msg->request.iTimeout;
+    }
+    else
+    {
+        //网络异常由屏蔽逻辑处理
+        return;
+    }
+
+    int64_t now = msg->iEndTime;
+
+    //变慢时直接取最大值, 马上生效; 变快时按照时间衰减, 和请求频率无关
+    if (_rspTimeUpdate == 0 || rspTime >= _rspTimeEwma)
+    {
+        _rspTimeEwma = rspTime;
+    }
+    else
+    {
+        double w = exp(-(double)(now > _rspTimeUpdate ? now - _rspTimeUpdate : 0) / RSP_TIME_DECAY_MS);
+        _rspTimeEwma = _rspTimeEwma * w + rspTime * (1 - w);
+    }
+
+    _rspTimeUpdate = now;
+}
+
+void AdapterProxy::compressRequest(ReqMessage * msg)
+{
+    if (_compressAck.empty() || msg->bFromRpc || IS_MSG_TYPE(msg->request.iMessageType, tars::TARSMESSAGETYPECOMPRESS))
+    {
+        return;
+    }
+
+    auto it = msg->request.context.find(ServantProxy::CONTEXT_COMPRESS_KEY);
+    if (it == msg->request.context.end() || it->second != _compressAck)
+    {
+        return;
+    }
+
+    if (msg->request.sBuffer.size() < _objectProxy->getRootServantProxy()->tars_compress_threshold())
+    {
+        return;
+    }
+
+    CompressCodecPtr codec = CompressCodecFactory::getInstance()->getCodec(_compressAck);
+    if (!codec)
+    {
+        return;
+    }
+
+    int64_t begin = TC_Common::now2us();
+
+    vector<char> buffer;
+    if (!codec->compress(msg->request.sBuffer.data(), msg->request.sBuffer.size(), buffer))
+    {
+        TLOGERROR("[AdapterProxy::compressRequest compress error, " << _objectProxy->name() << ", codec:" << _compressAck << ", size:" << msg->request.sBuffer.size() << "]" << endl);
+        return;
+    }
+
+    _communicator->reportCompress(msg->request.sBuffer.size(), buffer.size(), TC_Common::now2us() - begin);
+
+    //压缩后没有变小就不压缩了
+    if (buffer.size() >= msg->request.sBuffer.size())
+    {
+        return;
+    }
+
+    msg->request.sBuffer.swap(buffer);
+
+    SET_MSG_TYPE(msg->request.iMessageType, tars::TARSMESSAGETYPECOMPRESS);
+}
+
+void AdapterProxy::uncompressResponse(shared_ptr<ResponsePacket> & rsp)
+{
+    auto it = rsp->status.find(ServantProxy::CONTEXT_COMPRESS_KEY);
+    if (it == rsp->status.end())
+    {
+        return;
+    }
+
+    _compressAck = it->second;
+
+    if (!IS_MSG_TYPE(rsp->iMessageType, tars::TARSMESSAGETYPECOMPRESS))
+    {
+        return;
+    }
+
+    CLR_MSG_TYPE(rsp->iMessageType, tars::TARSMESSAGETYPECOMPRESS);
+
+    CompressCodecPtr codec = CompressCodecFactory::getInstance()->getCodec(it->second);
+
+    vector<char> buffer;
+    if (!codec || !codec->uncompress(rsp->sBuffer.data(), rsp->sBuffer.size(), buffer))
+    {
+        TLOGERROR("[AdapterProxy::uncompressResponse uncompress error, " << _objectProxy->name() << ", codec:" << it->second << ", size:" << rsp->sBuffer.size() << "]" << endl);
+
+        rsp->iRet = TARSCLIENTDECODEERR;
+        rsp->sResultDesc = "uncompress response error, codec:" + it->second;
+        rsp->sBuffer.clear();
+        return;
+    }
+
+    rsp->sBuffer.swap(buffer);
+}
+
+double AdapterProxy::getRspTimeEwma()
+{
+    if (_rspTimeUpdate == 0)
+    {
+        return 0;
+    }
+
+    int64_t now = TNOWMS;
+
+    return _rspTimeEwma * exp(-(double)(now > _rspTimeUpdate ? now - _rspTimeUpdate : 0) / RSP_TIME_DECAY_MS);
+}
+
+double AdapterProxy::getLoadScore()
+{
+    double weight = _staticWeight > 0 ? _staticWeight : 100;
+
+    return (getRspTimeEwma() + 1) * (getInflight() + 1) / weight;
+}
+
 void AdapterProxy::merge(const StatMicMsgBody& inBody, StatMicMsgBody& outBody/*out*/)
 {
     outBody.count                += inBody.count;
@@ -85,12 +85,15 @@ int         ServerConfig::BackPacketLimit = 0;
 int         ServerConfig::BackPacketMin = 1024;
 int         ServerConfig::BakFlag = 0;
 int         ServerConfig::BakType = 0;
+std::string ServerConfig::EpollBackend = "epoll";
+size_t      ServerConfig::CompressThreshold = 1024;
 
 std::string ServerConfig::CA;
 std::string ServerConfig::Cert;
 std::string ServerConfig::Key;
 bool        ServerConfig::VerifyClient = false;
 std::string ServerConfig::Ciphers;
+bool        ServerConfig::Ktls = false;
 map<string, string> ServerConfig::Context;
 
 ServerBaseInfo ServerConfig::toServerBaseInfo()
@@ -125,12 +128,15 @@ ServerBaseInfo ServerConfig::toServerBaseInfo()
     serverBaseInfo.BackPacketMin = BackPacketMin;
     serverBaseInfo.BakFlag = BakFlag;
     serverBaseInfo.BakType = BakType;
+    serverBaseInfo.EpollBackend = EpollBackend;
+    serverBaseInfo.CompressThreshold = CompressThreshold;
 
     serverBaseInfo.CA = CA;
     serverBaseInfo.Cert = Cert;
     serverBaseInfo.Key = Key;
     serverBaseInfo.VerifyClient = VerifyClient;
     serverBaseInfo.Ciphers = Ciphers;
+    serverBaseInfo.Ktls = Ktls;
     serverBaseInfo.Context = Context;
 
     return serverBaseInfo;
@@ -506,6 +512,14 @@ bool Application::cmdConnections(const string& command, const string& params, st
 	            << endl;
         }
     }
+
+    //tcp聚合发送统计, buffers - syscalls即节省的系统调用次数
+    uint64_t sendBuffers = 0, sendSyscalls = 0;
+    TC_Transceiver::getSendStat(sendBuffers, sendSyscalls);
+
+    os << OUT_LINE << "\n" << TC_Common::outfill("[send buffers:" + TC_Common::tostr(sendBuffers) + "] [send syscalls:" + TC_Common::tostr(sendSyscalls)
+        + "] [syscalls saved:" + TC_Common::tostr(sendBuffers - sendSyscalls) + "]") << endl;
+
     os << OUT_LINE_LONG << endl;
 
     result = os.str();
@@ -802,6 +816,15 @@ void Application::main(const string &config)
         __out__.debug() << "config:" << ServerConfig::ConfigFile << endl;
         __out__.debug() << "config:" << config << endl;
 
+        //网络事件后端, 需要在创建通信器和网络线程之前设置
+        TC_Epoller::setDefaultBackend(TC_Epoller::backendFromName(_conf.get("/tars/application/server<epollbackend>", "epoll")));
+        if(TC_Epoller::getDefaultBackend() == TC_Epoller::EB_IO_URING && !TC_Epoller::isIoUringSupported())
+        {
+            __out__.info() << "io_uring not supported, use epoll." << endl;
+            TC_Epoller::setDefaultBackend(TC_Epoller::EB_EPOLL);
+        }
+        ServerConfig::EpollBackend = TC_Epoller::backendName(TC_Epoller::getDefaultBackend());
+
         //初始化Proxy部分
         initializeClient();
 
@@ -1006,6 +1029,8 @@ void Application::initializeAdapter()
 
         lsPtr->setProtocol(AppProtocol::parse);
 
+        lsPtr->setSliceProtocol(AppProtocol::parseSlice);
+
         adapters.push_back(lsPtr);
 
         //admin端口先做绑定, 服务就算一直卡着initialize, 也能被外部管理了.
@@ -1192,10 +1217,12 @@ void Application::outServer(ostream &os)
 	os << TC_Common::outfill("CoroutineStackSize(coroutinestack)") << ServerConfig::CoroutineStackSize << endl;
 	os << TC_Common::outfill("CloseCout(closecout)")          << ServerConfig::CloseCout << endl;
 	os << TC_Common::outfill("NetThread(netthread)")          << ServerConfig::NetThread << endl;
+	os << TC_Common::outfill("EpollBackend(epollbackend)")    << ServerConfig::EpollBackend << endl;
 	os << TC_Common::outfill("ManualListen(manuallisten)")       << ServerConfig::ManualListen << endl;
 	os << TC_Common::outfill("ReportFlow(reportflow)")                  << ServerConfig::ReportFlow<< endl;
 	os << TC_Common::outfill("BackPacketLimit(backpacketlimit)")  << ServerConfig::BackPacketLimit<< endl;
 	os << TC_Common::outfill("BackPacketMin(backpacketmin)")  << ServerConfig::BackPacketMin<< endl;
+	os << TC_Common::outfill("CompressThreshold(compressthreshold)")  << ServerConfig::CompressThreshold << endl;
     os << TC_Common::outfill("BakType(baktype)")  << ServerConfig::BakType << endl;
     os << TC_Common::outfill("BakFlag(bakflag)")  << ServerConfig::BakFlag << endl;
 
@@ -1205,6 +1232,7 @@ void Application::outServer(ostream &os)
 	os << TC_Common::outfill("Key(key)")                  << ServerConfig::Key << endl;
 	os << TC_Common::outfill("VerifyClient(verifyclient)")      << ServerConfig::VerifyClient << endl;
 	os << TC_Common::outfill("Ciphers(ciphers)")               << ServerConfig::Ciphers << endl;
+	os << TC_Common::outfill("Ktls(ktls)")                   << ServerConfig::Ktls << endl;
 #endif
 
 }
@@ -1278,6 +1306,7 @@ void Application::initializeServer()
 	ServerConfig::CloseCout        = _conf.get("/tars/application/server<closecout>","1")=="0"?0:1;
 	ServerConfig::BackPacketLimit  = TC_Common::strto<int>(_conf.get("/tars/application/server<backpacketlimit>", TC_Common::tostr(100*1024*1024)));
 	ServerConfig::BackPacketMin    = TC_Common::strto<int>(_conf.get("/tars/application/server<backpacketmin>", "1024"));
+	ServerConfig::CompressThreshold = TC_Common::toSize(_conf.get("/tars/application/server<compressthreshold>", "1K"), 1024);
 
 #if TARS_SSL
 	ServerConfig::CA                = _conf.get("/tars/application/server<ca>");
@@ -1285,9 +1314,10 @@ void Application::initializeServer()
 	ServerConfig::Key               = _conf.get("/tars/application/server<key>");
 	ServerConfig::VerifyClient      = _conf.get("/tars/application/server<verifyclient>","0")=="0"?false:true;
 	ServerConfig::Ciphers           = _conf.get("/tars/application/server<ciphers>");
+	ServerConfig::Ktls              = _conf.get("/tars/application/server<ktls>","0")=="0"?false:true;
 
 	if(!ServerConfig::Cert.empty()) {
-		_ctx = TC_OpenSSL::newCtx(ServerConfig::CA, ServerConfig::Cert, ServerConfig::Key, ServerConfig::VerifyClient, ServerConfig::Ciphers);
+		_ctx = TC_OpenSSL::newCtx(ServerConfig::CA, ServerConfig::Cert, ServerConfig::Key, ServerConfig::VerifyClient, ServerConfig::Ciphers, ServerConfig::Ktls);
 
 		if (!_ctx) {
 			TLOGERROR("[load server ssl error, ca:" << ServerConfig::CA << endl);
@@ -1361,6 +1391,9 @@ void Application::initializeServer()
     LocalRollLogger::getInstance()->setLogInfo(ServerConfig::Application, ServerConfig::ServerName, ServerConfig::LogPath, ServerConfig::LogSize, ServerConfig::LogNum, _applicationCommunicator, ServerConfig::Log);
     _epollServer->setLocalLogger(LocalRollLogger::getInstance()->logger());
 
+    //异步写日志时每个线程暂存的日志条数, 0不开启
+    LocalRollLogger::getInstance()->logger()->setStage(TC_Common::strto<size_t>(toDefault(_conf.get("/tars/application/server<logstage>"), "0")));
+
     //初始化是日志为同步
     LocalRollLogger::getInstance()->sync(true);
 
@@ -1435,8 +1468,10 @@ void Application::setAdapter(TC_EpollServer::BindAdapterPtr& adapter, const stri
 		bool verifyClient =
 			_conf.get("/tars/application/server/" + name + "<verifyclient>", "0") == "0" ? false : true;
 		string ciphers = _conf.get("/tars/application/server/" + name + "<ciphers>");
+		bool ktls =
+			_conf.get("/tars/application/server/" + name + "<ktls>", ServerConfig::Ktls ? "1" : "0") == "0" ? false : true;
 
-		shared_ptr<TC_OpenSSL::CTX> ctx = TC_OpenSSL::newCtx(ca, cert, key, verifyClient, ciphers);
+		shared_ptr<TC_OpenSSL::CTX> ctx = TC_OpenSSL::newCtx(ca, cert, key, verifyClient, ciphers, ktls);
 
 		if (!ctx) {
 			TLOGERROR("load server ssl error, cert:" << cert << endl);
@@ -1496,6 +1531,12 @@ vector<TC_EpollServer::BindAdapterPtr> Application::createAdapter()
 
             bindAdapter->setQueueCapacity(TC_Common::strto<int>(_conf.get(sLastPath + "<queuecap>", "1024")));
 
+            //网络线程和handle线程之间使用无锁队列, 值为队列容量, 0表示不使用
+            bindAdapter->enableLockFreeQueue(TC_Common::strto<size_t>(_conf.get(sLastPath + "<lockfreequeue>", "0")));
+
+            //协程模式下, 空闲的handle窃取其他handle还没有开始处理的请求
+            bindAdapter->enableCoroutineSteal(TC_Common::strto<bool>(_conf.get(sLastPath + "<coroutinesteal>", "0")));
+
             bindAdapter->setQueueTimeout(TC_Common::strto<int>(_conf.get(sLastPath + "<queuetimeout>", "10000")));
 
             bindAdapter->setProtocolName(_conf.get(sLastPath + "<protocol>", "tars"));
@@ -1507,6 +1548,8 @@ vector<TC_EpollServer::BindAdapterPtr> Application::createAdapter()
             if (bindAdapter->isTarsProtocol())
             {
                 bindAdapter->setProtocol(AppProtocol::parse);
+
+                bindAdapter->setSliceProtocol(AppProtocol::parseSlice);
             }
 
             //校验ssl正常初始化
@@ -1590,6 +1633,8 @@ void Application::outAdapter(ostream &os, const string &v, TC_EpollServer::BindA
     os << TC_Common::outfill("endpoint")         << lsPtr->getEndpoint().toString() << endl;
     os << TC_Common::outfill("maxconns")         << lsPtr->getMaxConns() << endl;
     os << TC_Common::outfill("queuecap")         << lsPtr->getQueueCapacity() << endl;
+    os << TC_Common::outfill("lockfreequeue")    << (lsPtr->getDataBuffer()->isLockFreeQueue() ? "true" : "false") << endl;
+    os << TC_Common::outfill("coroutinesteal")   << (lsPtr->getDataBuffer()->getSchedulerGroup() ? "true" : "false") << endl;
     os << TC_Common::outfill("queuetimeout")     << lsPtr->getQueueTimeout() << "ms" << endl;
     os << TC_Common::outfill("order")            << (lsPtr->getOrder() == TC_EpollServer::BindAdapter::ALLOW_DENY ? "allow,deny" : "deny,allow") << endl;
     os << TC_Common::outfill("allow")            << TC_Common::tostr(lsPtr->getAllow()) << endl;
@@ -184,11 +184,12 @@ void Communicator::setProperty(TC_Config& conf, const string& domain/* = CONFIG_
 			data["cert"]      = conf.get(CONFIG_ROOT_PATH + "/" + auths[i] + "<cert>");
 			data["key"]       = conf.get(CONFIG_ROOT_PATH + "/" + auths[i] + "<key>");
 			data["ciphers"]   = conf.get(CONFIG_ROOT_PATH + "/" + auths[i] + "<ciphers>");
+			data["ktls"]      = conf.get(CONFIG_ROOT_PATH + "/" + auths[i] + "<ktls>", getProperty("ktls", "0"));
 #if TARS_SSL
 
 			if(!data["ca"].empty())
 			{
-				shared_ptr<TC_OpenSSL::CTX> ctx = TC_OpenSSL::newCtx( data["ca"], data["cert"], data["key"], false, data["ciphers"]);
+				shared_ptr<TC_OpenSSL::CTX> ctx = TC_OpenSSL::newCtx( data["ca"], data["cert"], data["key"], false, data["ciphers"], data["ktls"] != "0");
 				if(!ctx)
 				{
 					TLOGERROR("[load obj:" << auths[i] << ", ssl error, ca:" << data["ca"] << endl);
@@ -294,9 +295,10 @@ void Communicator::initialize()
 	string cert = getProperty("cert");
 	string key  = getProperty("key");
 	string ciphers  = getProperty("ciphers");
+	bool ktls       = getProperty("ktls", "0") != "0";
 
 	if(!ca.empty()) {
-		_ctx = TC_OpenSSL::newCtx(ca, cert, key, false, ciphers);
+		_ctx = TC_OpenSSL::newCtx(ca, cert, key, false, ciphers, ktls);
 
         if (!_ctx)
         {
@@ -337,6 +339,8 @@ void Communicator::initialize()
 
 	bool merge = TC_Common::strto<bool>(getProperty("mergenetasync", "0"));
 
+    _sharded = TC_Common::strto<bool>(getProperty("sharded", "0"));
+
     //异步队列的大小
     size_t iAsyncQueueCap = TC_Common::strto<size_t>(getProperty("asyncqueuecap", "100000"));
     if(iAsyncQueueCap < 10000)
@@ -352,6 +356,9 @@ void Communicator::initialize()
     //stat总是有对象, 保证getStat返回的对象总是有效
     _statReport = new StatReport(this);
 
+    //分片模式, 业务线程上报不争用StatReport的锁
+    _statReport->setSharded(TC_Common::strto<bool>(getProperty("stat-sharded", "0")));
+
     _keepAliveInterval = TC_Common::strto<int64_t>(getProperty("keep-alive-interval", "0"))/1000;
     if (_keepAliveInterval<5 && _keepAliveInterval!=0)
     {
@@ -374,6 +381,10 @@ void Communicator::initialize()
 
     //异步队列数目上报
     _reportAsyncQueue= getStatReport()->createPropertyReport("asyncqueue", PropertyReport::avg());
+
+    //tars协议包压缩上报
+    _reportCompressRatio = getStatReport()->createPropertyReport("tars_compress_ratio", PropertyReport::avg());
+    _reportCompressTime = getStatReport()->createPropertyReport("tars_compress_time", PropertyReport::avg(), PropertyReport::max());
     
     //初始化统计上报接口
     string statObj = getProperty("stat", "");
@@ -506,6 +517,21 @@ shared_ptr<CommunicatorEpoll> Communicator::createSchedCommunicatorEpoll(size_t
 	return communicatorEpoll;
 }
 
+shared_ptr<CommunicatorEpoll> Communicator::createShardCommunicatorEpoll(size_t netThreadSeq,  const shared_ptr<ReqInfoQueue> &reqInfoQueue)
+{
+    assert(netThreadSeq < MAX_CLIENT_NOTIFYEVENT_NUM);
+
+	shared_ptr<CommunicatorEpoll> communicatorEpoll = std::make_shared<CommunicatorEpoll>(this, netThreadSeq);
+
+	communicatorEpoll->initializeShardEpoller();
+
+	communicatorEpoll->initNotify(netThreadSeq, reqInfoQueue);
+
+    _schedCommunicatorEpoll[netThreadSeq] = communicatorEpoll;
+
+	return communicatorEpoll;
+}
+
 void Communicator::eraseSchedCommunicatorEpoll(size_t netThreadSeq)
 {
     assert(netThreadSeq < MAX_CLIENT_NOTIFYEVENT_NUM);
@@ -528,7 +554,15 @@ void Communicator::reloadLocator()
     }
 
 	forEachSchedCommunicatorEpoll([](const shared_ptr<CommunicatorEpoll> &c){
-		c->_epoller->syncCallback(std::bind(&CommunicatorEpoll::loadObjectLocator, c.get()));
+		//分片通信器只在业务线程同步调用时处理, 不能同步等待
+		if (c->isShardCommunicatorEpoll())
+		{
+			c->_epoller->asyncCallback(std::bind(&CommunicatorEpoll::loadObjectLocator, c.get()));
+		}
+		else
+		{
+			c->_epoller->syncCallback(std::bind(&CommunicatorEpoll::loadObjectLocator, c.get()));
+		}
 	});
 
 }
@@ -600,6 +634,11 @@ string Communicator::getResourcesInfo()
     }
 
 	forEachSchedCommunicatorEpoll([&](const shared_ptr<CommunicatorEpoll> & c){
+		//分片通信器的业务线程可能一直空闲, 不能同步等待
+		if (c->isShardCommunicatorEpoll())
+		{
+			return;
+		}
 		os << OUT_LINE << endl;
 		c->_epoller->syncCallback(std::bind(&CommunicatorEpoll::getResourcesInfo, c.get(), std::ref(os)));
 	});
@@ -741,6 +780,19 @@ void Communicator::doStat()
     }
 }
 
+void Communicator::reportCompress(size_t srcLen, size_t dstLen, int64_t costUs)
+{
+    if (_reportCompressRatio && srcLen > 0)
+    {
+        _reportCompressRatio->report((int)(dstLen * 100 / srcLen));
+    }
+
+    if (_reportCompressTime)
+    {
+        _reportCompressTime->report((int)costUs);
+    }
+}
+
 ServantProxy* Communicator::getServantProxy(const string& objectName, const string& setName, bool rootServant)
 {
     Communicator::initialize();
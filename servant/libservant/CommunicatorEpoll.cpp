@@ -552,6 +552,10 @@ bool CommunicatorEpoll::handleNotify(const shared_ptr<TC_Epoller::EpollInfo> &da
 
     ReqMessage * msg = NULL;
 
+    //队列中的请求先放到各个连接的未发送队列, 处理完以后每个连接合并发送一次(嵌套调用时由外层发送)
+    bool bDefer = !_deferSend;
+    _deferSend = true;
+
     try
     {
         int64_t now = TNOWMS;
@@ -569,6 +573,11 @@ bool CommunicatorEpoll::handleNotify(const shared_ptr<TC_Epoller::EpollInfo> &da
             }
         }
 
+        if (bDefer)
+        {
+            flushDeferSend();
+        }
+
         if (pFDInfo->msgQueue->empty() && pFDInfo->autoDestroy)
         {
             delete pFDInfo;
@@ -584,14 +593,72 @@ bool CommunicatorEpoll::handleNotify(const shared_ptr<TC_Epoller::EpollInfo> &da
         TLOGERROR("[CommunicatorEpoll::handleNotify error]" <<endl);
     }
 
+    if (bDefer && _deferSend)
+    {
+        flushDeferSend();
+    }
+
     return true;
 }
 
+void CommunicatorEpoll::flushDeferSend()
+{
+    _deferSend = false;
+
+    vector<AdapterProxy*> adapters;
+    adapters.swap(_deferAdapters);
+
+    for (auto adapterProxy : adapters)
+    {
+        adapterProxy->doDeferSend();
+    }
+}
+
+void CommunicatorEpoll::initializeShardEpoller()
+{
+    _shard = true;
+
+    //调度器只用来持有epoller, 不注册成线程的调度器, 业务线程仍然是普通线程
+    _scheduler = std::make_shared<TC_CoroutineScheduler>();
+
+    initializeEpoller();
+}
+
+void CommunicatorEpoll::runUntil(const bool &fin)
+{
+	assert(_threadId == this_thread::get_id());
+
+    //持有调度器, 避免处理过程中通信器结束把epoller释放了
+    shared_ptr<TC_CoroutineScheduler> scheduler = _scheduler;
+
+    while (!fin && _scheduler && !_communicator->isTerminating())
+    {
+        _epoller->done(_timeoutCheckInterval);
+    }
+}
+
+void CommunicatorEpoll::runPending()
+{
+	assert(_threadId == this_thread::get_id());
+
+    shared_ptr<TC_CoroutineScheduler> scheduler = _scheduler;
+
+    if (_scheduler && !_communicator->isTerminating())
+    {
+        //有定时任务时done会等到下一个定时任务, 先唤醒一次, 保证不阻塞
+        _epoller->notify();
+        _epoller->done(0);
+    }
+}
+
 void CommunicatorEpoll::initializeEpoller()
 {
 	_threadId = this_thread::get_id();
 
-    _scheduler = TC_CoroutineScheduler::scheduler();
+    if (!_scheduler)
+    {
+        _scheduler = TC_CoroutineScheduler::scheduler();
+    }
 
      assert(_scheduler);
 
@@ -0,0 +1,67 @@
+﻿/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except 
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed 
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR 
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the 
+ * specific language governing permissions and limitations under the License.
+ */
+#include "servant/CompressCodec.h"
+#include "util/tc_gzip.h"
+
+namespace tars
+{
+
+#if TARS_GZIP
+const string &GZipCompressCodec::name() const
+{
+    static string s = "gzip";
+    return s;
+}
+
+bool GZipCompressCodec::compress(const char *src, size_t length, vector<char> &buffer)
+{
+    return TC_GZip::compress(src, length, buffer);
+}
+
+bool GZipCompressCodec::uncompress(const char *src, size_t length, vector<char> &buffer)
+{
+    return TC_GZip::uncompress(src, length, buffer);
+}
+#endif
+
+CompressCodecFactory::CompressCodecFactory()
+{
+#if TARS_GZIP
+    registerCodec(std::make_shared<GZipCompressCodec>());
+#endif
+}
+
+void CompressCodecFactory::registerCodec(const CompressCodecPtr &codec)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _codecs[codec->name()] = codec;
+}
+
+CompressCodecPtr CompressCodecFactory::getCodec(const string &name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _codecs.find(name);
+    if (it == _codecs.end())
+    {
+        return NULL;
+    }
+
+    return it->second;
+}
+
+}
@@ -18,7 +18,9 @@
 #include "servant/ServantHandle.h"
 #include "servant/BaseF.h"
 #include "servant/Application.h"
+#include "servant/CompressCodec.h"
 #include "tup/tup.h"
+#include "util/tc_http.h"
 #include <cerrno>
 
 namespace tars
@@ -112,7 +114,7 @@ const map<string, string>& Current::getRequestStatus() const
     return _request.status;
 }
 
-string Current::getFuncName() const
+const string &Current::getFuncName() const
 {
     return _request.sFuncName;
 }
@@ -155,6 +157,7 @@ const vector<char>& Current::getRequestBuffer() const
 {
 	if (_isTars)
 	{
+		materializeRequest();
 		return _request.sBuffer;
 	}
 	else
@@ -163,6 +166,119 @@ const vector<char>& Current::getRequestBuffer() const
 	}
 }
 
+pair<const char*, size_t> Current::getRequestData() const
+{
+	if (_isTars)
+	{
+		if (!_requestBody.empty())
+		{
+			return make_pair(_requestBody.data(), _requestBody.size());
+		}
+		return make_pair(_request.sBuffer.data(), _request.sBuffer.size());
+	}
+	else
+	{
+		return _data->getBufferPointer();
+	}
+}
+
+bool Current::decodeHttpRequest(TC_HttpRequest &request) const
+{
+	pair<const char*, size_t> data = getRequestData();
+
+	const shared_ptr<TC_HttpRequestParser> &parser = _data->httpParser();
+
+	if (!_isTars && parser && parser->packetLength() == data.second)
+	{
+		return request.decode(data.first, *parser);
+	}
+
+	return request.decode(data.first, data.second);
+}
+
+void Current::materializeRequest() const
+{
+	if (!_requestBody.empty())
+	{
+		_requestBody.toVector(_request.sBuffer);
+		_requestBody.clear();
+	}
+}
+
+bool Current::uncompressRequest()
+{
+	if (!IS_MSG_TYPE(_request.iMessageType, tars::TARSMESSAGETYPECOMPRESS))
+	{
+		return true;
+	}
+
+	//解压后业务看到的和没压缩的请求一样
+	CLR_MSG_TYPE(_request.iMessageType, tars::TARSMESSAGETYPECOMPRESS);
+
+	auto it = _request.context.find(ServantProxy::CONTEXT_COMPRESS_KEY);
+
+	CompressCodecPtr codec = (it == _request.context.end() ? NULL : CompressCodecFactory::getInstance()->getCodec(it->second));
+
+	pair<const char*, size_t> data = getRequestData();
+
+	vector<char> buffer;
+	if (!codec || !codec->uncompress(data.first, data.second, buffer))
+	{
+		return false;
+	}
+
+	_requestBody.clear();
+	_request.sBuffer.swap(buffer);
+
+	return true;
+}
+
+void Current::compressResponse(ResponsePacket &response)
+{
+	CLR_MSG_TYPE(response.iMessageType, tars::TARSMESSAGETYPECOMPRESS);
+
+	auto it = _request.context.find(ServantProxy::CONTEXT_COMPRESS_KEY);
+	if (it == _request.context.end())
+	{
+		return;
+	}
+
+	//不支持的算法不确认, 客户端就不会压缩请求包
+	CompressCodecPtr codec = CompressCodecFactory::getInstance()->getCodec(it->second);
+	if (!codec)
+	{
+		return;
+	}
+
+	response.status[ServantProxy::CONTEXT_COMPRESS_KEY] = it->second;
+
+	if (response.sBuffer.size() < ServerConfig::CompressThreshold)
+	{
+		return;
+	}
+
+	int64_t begin = TC_Common::now2us();
+
+	vector<char> buffer;
+	if (!codec->compress(response.sBuffer.data(), response.sBuffer.size(), buffer))
+	{
+		TLOGERROR("[Current::compressResponse compress error, " << _request.sServantName << ":" << _request.sFuncName << ", codec:" << it->second << "]" << endl);
+		return;
+	}
+
+	_servantHandle->getApplication()->getApplicationCommunicator()->reportCompress(response.sBuffer.size(), buffer.size(), TC_Common::now2us() - begin);
+
+	//压缩后没有变小就不压缩了
+	if (buffer.size() >= response.sBuffer.size())
+	{
+		return;
+	}
+
+	response.sBuffer.swap(buffer);
+
+	SET_MSG_TYPE(response.iMessageType, tars::TARSMESSAGETYPECOMPRESS);
+}
+
 bool Current::isResponse() const
 {
     return _response;
@@ -188,7 +304,10 @@ void Current::initialize(const shared_ptr<TC_EpollServer::RecvContext> &data)
 
     if (_isTars)
     {
-        initialize(_data->buffer());
+        if (_data->slice().empty() || !initializeSlice())
+        {
+            initialize(_data->buffer());
+        }
     }
     else
     {
@@ -196,6 +315,44 @@ void Current::initialize(const shared_ptr<TC_EpollServer::RecvContext> &data)
     }
 }
 
+bool Current::initializeSlice()
+{
+    const TC_NetWorkBuffer::Slice &slice = _data->slice();
+
+    TarsInputStream<BufferReader> is;
+
+    is.setBuffer(slice.data(), slice.size());
+
+    try
+    {
+        //字段和RequestPacket::readFrom一致, 只是sBuffer不copy
+        const char *body = NULL;
+        size_t length = 0;
+
+        is.read(_request.iVersion, 1, true);
+        is.read(_request.cPacketType, 2, true);
+        is.read(_request.iMessageType, 3, true);
+        is.read(_request.iRequestId, 4, true);
+        is.read(_request.sServantName, 5, true);
+        is.read(_request.sFuncName, 6, true);
+        is.readView(body, length, 7, true);
+        is.read(_request.iTimeout, 8, true);
+        is.read(_request.context, 9, true);
+        is.read(_request.status, 10, true);
+        is.read(_request.iFuncId, 11, false);
+
+        _requestBody = slice.sub(body - slice.data(), length);
+    }
+    catch (TarsDecodeMismatch &ex)
+    {
+        //sBuffer不是SimpleList编码, 按完整方式解析
+        _request.resetDefautlt();
+        return false;
+    }
+
+    return true;
+}
+
 void Current::initializeClose(const shared_ptr<TC_EpollServer::RecvContext> &data)
 {
 	_data = data;
@@ -299,6 +456,8 @@ void Current::sendResponse(int iRet, ResponsePacket &response,  const map<string
 
         response.iRet           = iRet;
 
+        compressResponse(response);
+
         TLOGTARS("Current::sendResponse :"
                    << response.iMessageType << "|"
                    << _request.sServantName << "|"
@@ -329,6 +329,10 @@ void QueryEpBase::setEndpoints(const string & sEndpoints, set<EndpointInfo> & se
         {
             _weightType = E_STATIC_WEIGHT;
         }
+        else if(iWeightType == 2)
+        {
+            _weightType = E_ADAPTIVE;
+        }
         else
         {
             _weightType = E_LOOP;
@@ -565,6 +569,10 @@ void QueryEpBase::doEndpoints(const vector<EndpointF>& activeEp, const vector<En
         {
             _weightType = E_STATIC_WEIGHT;
         }
+        else if(iWeightType == 2)
+        {
+            _weightType = E_ADAPTIVE;
+        }
         else
         {
             _weightType = E_LOOP;
@@ -704,10 +712,17 @@ EndpointManager::EndpointManager(ObjectProxy * pObjectProxy, Communicator* pComm
 ,_update(true)
 ,_updateWeightInterval(60)
 ,_lastSWeightPosition(0)
-,_consistentHashWeight(E_TC_CONHASH_KETAMAHASH)
-,_consistentHash(E_TC_CONHASH_KETAMAHASH)
+,_conHashLoadFactor(0)
 {
     setNetThreadProcess(true);
+
+    _conHashLoadFactor = TC_Common::strto<double>(_communicator->getProperty("conhash-load-factor", "0"));
+
+    //系数不大于1时没有余量, 不启用
+    if(_conHashLoadFactor <= 1)
+    {
+        _conHashLoadFactor = 0;
+    }
 }
 
 EndpointManager::~EndpointManager()
@@ -896,6 +911,10 @@ bool EndpointManager::selectAdapterProxy(ReqMessage * msg,AdapterProxy * & pAdap
 
         pAdapterProxy = getWeightedProxy(bStaticWeighted);
     }
+    else if(_weightType == E_ADAPTIVE)
+    {
+        pAdapterProxy = getAdaptiveProxy();
+    }
     else
     {
         //普通轮询模式
@@ -954,6 +973,46 @@ AdapterProxy * EndpointManager::getNextValidProxy()
     return adapterProxy;
 }
 
+AdapterProxy * EndpointManager::getAdaptiveProxy()
+{
+    //只有一个结点或者取不到两个可用结点时, 按轮询的逻辑处理异常结点
+    if (_activeProxys.size() < 2)
+    {
+        return getNextValidProxy();
+    }
+
+    size_t n = _activeProxys.size();
+    size_t a = (uint32_t)rand() % n;
+    size_t b = (uint32_t)rand() % (n - 1);
+    if (b >= a)
+    {
+        ++b;
+    }
+
+    AdapterProxy *pa = _activeProxys[a];
+    AdapterProxy *pb = _activeProxys[b];
+
+    bool va = pa->checkActive(false);
+    bool vb = pb->checkActive(false);
+
+    if (va && vb)
+    {
+        return pa->getLoadScore() <= pb->getLoadScore() ? pa : pb;
+    }
+
+    if (va)
+    {
+        return pa;
+    }
+
+    if (vb)
+    {
+        return pb;
+    }
+
+    return getNextValidProxy();
+}
+
 AdapterProxy* EndpointManager::getHashProxy(int64_t hashCode, bool bConsistentHash)
 {
     if(_weightType == E_STATIC_WEIGHT)
@@ -1110,31 +1169,22 @@ AdapterProxy* EndpointManager::getConHashProxyForWeight(int64_t hashCode, bool b
         TLOGTARS("[EndpointManager::getConHashProxyForWeight update bStatic:" << bStatic << ", objName:" << _objName << ", timecost(ms):" << (iEnd - iBegin) << endl);
     }
 
-    while(_consistentHashWeight.size() > 0)
+    while(_consistentHashWeight && _consistentHashWeight->ring.size() > 0)
     {
-        string sNode;
-
-        // 通过一致性hash取到对应的节点
-        _consistentHashWeight.getNodeName(hashCode, sNode);
-
-        auto it = _indexActiveProxys.find(sNode);
-        // 节点不存在，可能是下线或者服务不可用
-        if (it == _indexActiveProxys.end())
-        {
-            updateConHashProxyWeighted(bStatic, _lastConHashWeightProxys, _consistentHashWeight);
-            continue;
-        }
+        // 通过一致性hash取到对应的节点, 环随_sortActivProxys的变化重建, 节点一定存在
+        AdapterProxy *proxy = selectConHashProxy(hashCode, *_consistentHashWeight);
 
         //被hash到的节点在主控是active的才走在流程
-        if (it->second->isActiveInReg() && it->second->checkActive(true))
+        if (proxy->isActiveInReg() && proxy->checkActive(true))
         {
-            return it->second;
+            return proxy;
         }
         else
         {
-            TLOGWARN("[EndpointManager::getHashProxyForWeight, hash not active," << _objectProxy->name() << "@" << it->second->endpoint().desc() << endl);
+            TLOGWARN("[EndpointManager::getConHashProxyForWeight, hash not active," << _objectProxy->name() << "@" << proxy->endpoint().desc() << endl);
+            const string &sNode = proxy->endpoint().host();
             // 剔除节点再次hash
-            if (!it->second->isActiveInReg())
+            if (!proxy->isActiveInReg())
             {
                 // 如果在主控的注册状态不是active直接删除，如果状态有变更由updateEndpoints函数里重新添加
                 _indexActiveProxys.erase(sNode);
@@ -1145,7 +1195,7 @@ AdapterProxy* EndpointManager::getConHashProxyForWeight(int64_t hashCode, bool b
 
             if (_indexActiveProxys.empty())
             {
-                TLOGERROR("[EndpointManager::getConHashProxyForNormal activeEndpoints is empty]" << endl);
+                TLOGERROR("[EndpointManager::getConHashProxyForWeight activeEndpoints is empty]" << endl);
                 return NULL;
             }
         }
@@ -1358,9 +1408,25 @@ void EndpointManager::updateHashProxyWeighted(bool bStatic)
     }
 }
 
-void EndpointManager::updateConHashProxyWeighted(bool bStatic, map<string, AdapterProxy*> &mLastConHashProxys, TC_ConsistentHashNew &conHash)
+AdapterProxy* EndpointManager::selectConHashProxy(int64_t hashCode, const ConHashRing &conHash)
 {
-    conHash.clear();
+    unsigned int index = 0;
+
+    if(_conHashLoadFactor > 0)
+    {
+        conHash.ring.getIndex((uint32_t)hashCode, index, _conHashLoadFactor, [&](unsigned int i){ return conHash.proxys[i]->getInflight(); });
+    }
+    else
+    {
+        conHash.ring.getIndex((uint32_t)hashCode, index);
+    }
+
+    return conHash.proxys[index];
+}
+
+void EndpointManager::updateConHashProxyWeighted(bool bStatic, map<string, AdapterProxy*> &mLastConHashProxys, shared_ptr<ConHashRing> &conHash)
+{
+    conHash.reset();
     if(_sortActivProxys.empty())
     {    
         TLOGERROR("[EndpointManager::updateHashProxyWeighted indexActiveProxys is empty, bStatic:" << bStatic << "]" << endl);
@@ -1369,6 +1435,9 @@ void EndpointManager::updateConHashProxyWeighted(bool bStatic, map<string, Adapt
 
     mLastConHashProxys = _sortActivProxys;
 
+    //新建一个环, 构建完成后整体替换
+    shared_ptr<ConHashRing> newHash = std::make_shared<ConHashRing>();
+
     for (auto it = _sortActivProxys.begin(); it != _sortActivProxys.end(); ++it)
     {
         int iWeight = (bStatic ? (it->second->getWeight()) : 100);
@@ -1382,8 +1451,9 @@ void EndpointManager::updateConHashProxyWeighted(bool bStatic, map<string, Adapt
             // 同一服务有多个obj的情况
             // 同一hash值调用不同的obj会hash到不同的服务器
             // 因为addNode会根据desc(ip+port)计算md5,导致顺序不一致
-            // 一致性hash用host进行索引，不使用index，这里传0
-            conHash.addNode(it->second->endpoint().host(), 0, iWeight);
+            // 虚拟节点的位置只由host决定, 下标只用来找到对应的AdapterProxy
+            newHash->ring.addNode(it->second->endpoint().host(), (unsigned int)newHash->proxys.size(), iWeight);
+            newHash->proxys.push_back(it->second);
         }
         //防止多个服务节点权重同时更新时一致性哈希环多次更新
         it->second->resetWeightChanged();
@@ -1417,7 +1487,9 @@ void EndpointManager::updateConHashProxyWeighted(bool bStatic, map<string, Adapt
         _vRegProxys[i]->resetWeightChanged();
     }
 */
-    conHash.sortNode();
+    newHash->ring.sortNode();
+
+    conHash.swap(newHash);
 }
 
 AdapterProxy* EndpointManager::getHashProxyForNormal(int64_t hashCode)
@@ -1528,31 +1600,22 @@ AdapterProxy* EndpointManager::getConHashProxyForNormal(int64_t hashCode)
         TLOGTARS("[EndpointManager::getConHashProxyForNormal update _objName:" << _objName << "|timecost(ms):" << (iEnd - iBegin) << endl);
     }
 
-    while(_consistentHash.size() > 0)
+    while(_consistentHash && _consistentHash->ring.size() > 0)
     {
-        string sNode;
-
-        // 通过一致性hash取到对应的节点
-        _consistentHash.getNodeName(hashCode, sNode);
-
-        auto it = _indexActiveProxys.find(sNode);
-        // 节点不存在，可能是下线或者服务不可用
-        if (it == _indexActiveProxys.end())
-        {
-            updateConHashProxyWeighted(false, _lastConHashProxys, _consistentHash);
-            continue;
-        }
+        // 通过一致性hash取到对应的节点, 环随_sortActivProxys的变化重建, 节点一定存在
+        AdapterProxy *proxy = selectConHashProxy(hashCode, *_consistentHash);
 
         //被hash到的节点在主控是active的才走在流程
-        if (it->second->isActiveInReg() && it->second->checkActive(true))
+        if (proxy->isActiveInReg() && proxy->checkActive(true))
         {
-            return it->second;
+            return proxy;
         }
         else
         {
-            TLOGWARN("[EndpointManager::getConHashProxyForNormal, hash not active," << _objectProxy->name() << "@" << it->second->endpoint().desc() << endl);
+            TLOGWARN("[EndpointManager::getConHashProxyForNormal, hash not active," << _objectProxy->name() << "@" << proxy->endpoint().desc() << endl);
+            const string &sNode = proxy->endpoint().host();
             // 剔除节点再次hash
-            if (!it->second->isActiveInReg())
+            if (!proxy->isActiveInReg())
             {
                 // 如果在主控的注册状态不是active直接删除，如果状态有变更由updateEndpoints函数里重新添加
                 _indexActiveProxys.erase(sNode);
@@ -1563,7 +1626,7 @@ AdapterProxy* EndpointManager::getConHashProxyForNormal(int64_t hashCode)
 
             if (_indexActiveProxys.empty())
             {
-                TLOGERROR("[EndpointManager::getConHashProxyForNormal _activeEndpoints is empty]" << endl);
+                TLOGERROR("[EndpointManager::getConHashProxyForNormal activeEndpoints is empty]" << endl);
                 return NULL;
             }
         }
@@ -20,6 +20,8 @@
 namespace tars
 {
 
+std::atomic<uint64_t> PropertyReport::_idGen(0);
+
 string PropertyReport::sum::get()
 {
     string s = TC_Common::tostr(_d);
@@ -94,6 +96,17 @@ string PropertyReport::distr::get()
     return s;
 }
 
+void PropertyReport::distr::merge(distr &o)
+{
+    for(size_t i = 0; i < _result.size() && i < o._result.size(); ++i)
+    {
+        _result[i] += o._result[i];
+        o._result[i] = 0;
+    }
+    _max += o._max;
+    o._max = 0;
+}
+
 string PropertyReport::max::get()
 {
     string s = TC_Common::tostr(_d);
@@ -533,6 +533,22 @@ bool ServantHandle::checkValidSetInvoke(const CurrentPtr &current)
     return true;
 }
 
+bool ServantHandle::processCompress(const CurrentPtr &current)
+{
+    if (!current->uncompressRequest())
+    {
+        TLOGERROR("[ServantHandle::processCompress uncompress request error|"
+                          << current->getIp() << "|"
+                          << current->getServantName() << "|"
+                          << current->getFuncName() << "]" << endl);
+
+        current->sendResponse(TARSSERVERDECODEERR);
+        return false;
+    }
+
+    return true;
+}
+
 void ServantHandle::handleTarsProtocol(const CurrentPtr &current)
 {
     TLOGTARS("[ServantHandle::handleTarsProtocol current:"
@@ -550,6 +566,12 @@ void ServantHandle::handleTarsProtocol(const CurrentPtr &current)
         return;
     }
 
+    //压缩的请求包先解压
+    if (!processCompress(current))
+    {
+        return;
+    }
+
     //处理染色消息
     string dyeingKey;
     TarsDyeingSwitch dyeSwitch;
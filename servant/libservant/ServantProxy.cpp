@@ -177,6 +177,19 @@ ServantProxyThreadData::ServantProxyThreadData()
 ServantProxyThreadData::~ServantProxyThreadData()
 {
 //     LOG_CONSOLE_DEBUG << endl;
+    try
+    {
+		//批量调用没有flush就退出了线程, 把缓存的请求交给网络线程, 回调正常触发
+		if (_batchProxy)
+		{
+			flushBatch();
+		}
+	}
+	catch (exception &ex)
+	{
+		TLOGERROR("[ServantProxyThreadData::~ServantProxyThreadData flush batch error:" << ex.what() << "]" << endl);
+	}
+
     try
     {
 		//先释放公有的网络通信器的信息
@@ -247,6 +260,18 @@ void ServantProxyThreadData::erase(Communicator *communicator)
 	_communicatorEpollInfo.erase(communicator);
 	_schedCommunicatorEpollInfo.erase(communicator);
 
+	//通信器已经析构, 批量调用中没有flush的请求无法再发送, 直接丢弃
+	if (_batchCommunicator == communicator)
+	{
+		for (auto &msg : _batchMsgs)
+		{
+			delete msg.first;
+		}
+		_batchMsgs.clear();
+		_batchProxy = NULL;
+		_batchCommunicator = NULL;
+	}
+
 }
 
 shared_ptr<ServantProxyThreadData::CommunicatorEpollInfo> ServantProxyThreadData::getCommunicatorEpollInfo(Communicator *communicator)
@@ -285,6 +310,64 @@ shared_ptr<ServantProxyThreadData::SchedCommunicatorEpollInfo> ServantProxyThrea
 	return info;
 }
 
+size_t ServantProxyThreadData::flushBatch()
+{
+    //proxy可能只被这里引用了, 提交完再释放
+    ServantPrx proxy = _batchProxy;
+
+    _batchProxy = NULL;
+    _batchCommunicator = NULL;
+
+    vector<pair<ReqMessage*, shared_ptr<ReqInfoQueue>>> msgs;
+    msgs.swap(_batchMsgs);
+
+    vector<ReqMessage*> batch;
+
+    size_t i = 0;
+    while (i < msgs.size())
+    {
+        //同一个网络线程队列的请求一次放入
+        const shared_ptr<ReqInfoQueue> &pReqQ = msgs[i].second;
+
+        batch.clear();
+
+        size_t j = i;
+        for (; j < msgs.size() && msgs[j].second == pReqQ; ++j)
+        {
+            batch.push_back(msgs[j].first);
+        }
+
+        //放入队列后msg可能已经被网络线程处理完释放了, 先取出来
+        auto sched = msgs[i].first->sched;
+        auto ce    = msgs[i].first->pObjectProxy->getCommunicatorEpoll();
+
+        if (!pReqQ->push_back(batch))
+        {
+            TLOGERROR("[ServantProxyThreadData::flushBatch msgQueue push_back error thread seq:" << _reqQNo << ", batch size:" << batch.size() << "]" << endl);
+
+            for (size_t k = i; k < msgs.size(); ++k)
+            {
+                delete msgs[k].first;
+            }
+
+            throw TarsClientQueueException("client queue full");
+        }
+
+        if (sched)
+        {
+            ce->handle(_reqQNo);
+        }
+        else
+        {
+            ce->notify(_reqQNo);
+        }
+
+        i = j;
+    }
+
+    return msgs.size();
+}
+
 ThreadPrivateData ServantProxyThreadData::move()
 {
     ThreadPrivateData data = _data;
@@ -436,6 +519,8 @@ string ServantProxy::STATUS_SETNAME_VALUE = "STATUS_SETNAME_VALUE";
 
 string ServantProxy::STATUS_TRACE_KEY     = "STATUS_TRACE_KEY";
 
+string ServantProxy::CONTEXT_COMPRESS_KEY = "TARS_COMPRESS";
+
 ServantProxy::ServantProxy()
 {
 }
@@ -647,6 +732,14 @@ int ServantProxy::tars_async_timeout() const
     return _asyncTimeout;
 }
 
+void ServantProxy::tars_set_compress(const string &codec, size_t threshold)
+{
+    TC_LockT<TC_ThreadMutex> lock(*this);
+
+    _compressCodec = codec;
+    _compressThreshold = threshold;
+}
+
 void ServantProxy::tars_set_custom_callback(ServantProxy::custom_callback callback)
 {
     _callback = callback;
@@ -871,6 +964,55 @@ ServantProxyCallbackPtr ServantProxy::tars_get_push_callback()
 	return _pushCallback;
 }
 
+void ServantProxy::tars_batch_begin()
+{
+    ServantProxyThreadData *pSptd = ServantProxyThreadData::getData();
+    assert(pSptd != NULL);
+
+    if (pSptd->_batchProxy && pSptd->_batchProxy.get() != this)
+    {
+        pSptd->flushBatch();
+    }
+
+    pSptd->_batchProxy = this;
+    pSptd->_batchCommunicator = _communicator;
+}
+
+size_t ServantProxy::tars_batch_flush()
+{
+    ServantProxyThreadData *pSptd = ServantProxyThreadData::getData();
+    assert(pSptd != NULL);
+
+    if (pSptd->_batchProxy.get() != this)
+    {
+        return 0;
+    }
+
+    return pSptd->flushBatch();
+}
+
+ServantProxyBatch::ServantProxyBatch(const ServantPrx &proxy) : _proxy(proxy)
+{
+    _proxy->tars_batch_begin();
+}
+
+ServantProxyBatch::~ServantProxyBatch()
+{
+    try
+    {
+        _proxy->tars_batch_flush();
+    }
+    catch (exception &ex)
+    {
+        TLOGERROR("[ServantProxyBatch::~ServantProxyBatch flush error:" << ex.what() << "]" << endl);
+    }
+}
+
+size_t ServantProxyBatch::flush()
+{
+    return _proxy->tars_batch_flush();
+}
+
 void ServantProxy::invoke(ReqMessage *msg, bool bCoroAsync)
 {
     //线程私有数据
@@ -915,7 +1057,7 @@ void ServantProxy::invoke(ReqMessage *msg, bool bCoroAsync)
     shared_ptr<ReqInfoQueue> pReqQ;
 
     //选择网络线程
-    selectNetThreadInfo(pSptd, msg->pObjectProxy, pReqQ);
+    selectNetThreadInfo(pSptd, msg->pObjectProxy, pReqQ, msg->eType == ReqMessage::SYNC_CALL);
 
     //如果是按set规则调用
     if (msg->pObjectProxy && msg->pObjectProxy->isInvokeBySet())
@@ -974,6 +1116,13 @@ void ServantProxy::invoke(ReqMessage *msg, bool bCoroAsync)
         }
     }
 
+    //批量调用中, 异步请求等tars_batch_flush时一起放入队列
+    if (pSptd->_batchProxy && (pSptd->_batchProxy.get() == this || pSptd->_batchProxy.get() == msg->proxy) && msg->eType != ReqMessage::SYNC_CALL)
+    {
+        pSptd->_batchMsgs.push_back(std::make_pair(msg, pReqQ));
+        return;
+    }
+
     //通知网络线程
     bool bEmpty = false;
     bool bSync  = (msg->eType == ReqMessage::SYNC_CALL);
@@ -982,6 +1131,12 @@ void ServantProxy::invoke(ReqMessage *msg, bool bCoroAsync)
     auto sched = msg->sched;
     auto pObjectProxy = msg->pObjectProxy;
 
+    if (!sched && pObjectProxy->getCommunicatorEpoll()->isShardCommunicatorEpoll())
+    {
+        //独占通信器只在同步调用时才被驱动, 先处理空闲期间积压的网络事件(例如连接已被对端关闭), 避免请求发到失效的连接上
+        pObjectProxy->getCommunicatorEpoll()->runPending();
+    }
+
     if (!pReqQ->push_back(msg, bEmpty))
     {
         TLOGERROR("[ServantProxy::invoke msgQueue push_back error thread seq:" << pSptd->_reqQNo << "]" << endl);
@@ -992,9 +1147,9 @@ void ServantProxy::invoke(ReqMessage *msg, bool bCoroAsync)
         throw TarsClientQueueException("client queue full");
     }
 
-    if (sched)
+    if (sched || pObjectProxy->getCommunicatorEpoll()->isShardCommunicatorEpoll())
     {
-        //协程中, 直接发包了
+        //协程中或者分片模式的独占通信器, 直接发包了
         pObjectProxy->getCommunicatorEpoll()->handle(pSptd->_reqQNo);
     }
     else
@@ -1008,7 +1163,15 @@ void ServantProxy::invoke(ReqMessage *msg, bool bCoroAsync)
         {
         	assert(msg->pMonitor);
 
-			msg->pMonitor->wait();
+			if (pObjectProxy->getCommunicatorEpoll()->isShardCommunicatorEpoll())
+			{
+				//分片模式, 当前线程驱动网络事件直到请求结束
+				pObjectProxy->getCommunicatorEpoll()->runUntil(msg->pMonitor->bMonitorFin);
+			}
+			else
+			{
+				msg->pMonitor->wait();
+			}
 
 			if(!msg->pMonitor->bMonitorFin)
 			{
@@ -1079,7 +1242,8 @@ void ServantProxy::tars_invoke_async(char  cPacketType,
                                     const map<string, string>& context,
                                     const map<string, string>& status,
                                     const ServantProxyCallbackPtr& callback,
-                                    bool  bCoro)
+                                    bool  bCoro,
+                                    Int32 iFuncId)
 {
 	ReqMessage *msg = new ReqMessage();
 
@@ -1089,6 +1253,7 @@ void ServantProxy::tars_invoke_async(char  cPacketType,
     msg->request.iVersion = TARSVERSION;
     msg->request.cPacketType = (callback ? cPacketType : TARSONEWAY);
 	msg->request.sFuncName = sFuncName;
+	msg->request.iFuncId = iFuncId;
 	msg->request.sServantName = _objectProxy->name();
 
     buf.swap(msg->request.sBuffer);
@@ -1106,6 +1271,7 @@ void ServantProxy::tars_invoke_async(char  cPacketType,
 	checkDye(msg->request);
 	checkTrace(msg->request);
 	checkCookie(msg->request);
+	checkCompress(msg->request);
 	servant_invoke(msg, bCoro);
 }
 
@@ -1117,7 +1283,8 @@ void ServantProxy::tars_invoke_async(char  cPacketType,
                                     const map<string, string>& context,
                                     const map<string, string>& status,
                                     const ServantProxyCallbackPtr& callback,
-                                    bool  bCoro)
+                                    bool  bCoro,
+                                    Int32 iFuncId)
 {
     ReqMessage * msg = new ReqMessage();
 
@@ -1127,6 +1294,7 @@ void ServantProxy::tars_invoke_async(char  cPacketType,
     msg->request.iVersion = TARSVERSION;
     msg->request.cPacketType = (callback ? cPacketType : TARSONEWAY);
 	msg->request.sFuncName = sFuncName;
+	msg->request.iFuncId = iFuncId;
 	msg->request.sServantName = _objectProxy->name();
     msg->request.sBuffer = buf;
     msg->request.context      = context;
@@ -1142,6 +1310,7 @@ void ServantProxy::tars_invoke_async(char  cPacketType,
 	checkDye(msg->request);
 	checkTrace(msg->request);
 	checkCookie(msg->request);
+	checkCompress(msg->request);
 	servant_invoke(msg, bCoro);
 }
 
@@ -1149,7 +1318,8 @@ shared_ptr<ResponsePacket> ServantProxy::tars_invoke(char  cPacketType,
                               const string& sFuncName,
                               const vector<char>& buf,
                               const map<string, string>& context,
-                              const map<string, string>& status)
+                              const map<string, string>& status,
+                              Int32 iFuncId)
                             //   ResponsePacket& rsp)
 {
     ReqMessage *msg = new ReqMessage();
@@ -1159,6 +1329,7 @@ shared_ptr<ResponsePacket> ServantProxy::tars_invoke(char  cPacketType,
     msg->request.iVersion = TARSVERSION;
     msg->request.cPacketType = cPacketType;
 	msg->request.sFuncName = sFuncName;
+	msg->request.iFuncId = iFuncId;
     msg->request.sServantName = _objectProxy->name();
 
     msg->request.sBuffer = buf;
@@ -1175,6 +1346,7 @@ shared_ptr<ResponsePacket> ServantProxy::tars_invoke(char  cPacketType,
 	checkDye(msg->request);
 	checkTrace(msg->request);
 	checkCookie(msg->request);
+	checkCompress(msg->request);
 	servant_invoke(msg, false);
 
     shared_ptr<ResponsePacket> rsp = msg->response;
@@ -1191,7 +1363,8 @@ shared_ptr<ResponsePacket> ServantProxy::tars_invoke(char  cPacketType,
                               const string& sFuncName,
                               TarsOutputStream<BufferWriterVector>& buf,
                               const map<string, string>& context,
-                              const map<string, string>& status)
+                              const map<string, string>& status,
+                              Int32 iFuncId)
 {
     ReqMessage * msg = new ReqMessage();
 
@@ -1200,6 +1373,7 @@ shared_ptr<ResponsePacket> ServantProxy::tars_invoke(char  cPacketType,
     msg->request.iVersion = TARSVERSION;
     msg->request.cPacketType = cPacketType;
 	msg->request.sFuncName = sFuncName;
+	msg->request.iFuncId = iFuncId;
     msg->request.sServantName = _objectProxy->name();
 
     buf.swap(msg->request.sBuffer);
@@ -1210,6 +1384,7 @@ shared_ptr<ResponsePacket> ServantProxy::tars_invoke(char  cPacketType,
 	checkDye(msg->request);
 	checkTrace(msg->request);
 	checkCookie(msg->request);
+	checkCompress(msg->request);
 	servant_invoke(msg, false);
 
     shared_ptr<ResponsePacket> rsp = msg->response;
@@ -1657,20 +1832,27 @@ void ServantProxy::common_protocol_call_async(const string &funcName, const shar
 
 //
 //选取一个网络线程对应的信息
-void ServantProxy::selectNetThreadInfo(ServantProxyThreadData *pSptd, ObjectProxy *&pObjProxy, shared_ptr<ReqInfoQueue> &pReqQ)
+void ServantProxy::selectNetThreadInfo(ServantProxyThreadData *pSptd, ObjectProxy *&pObjProxy, shared_ptr<ReqInfoQueue> &pReqQ, bool bSync)
 {
-	if(pSptd->_sched && pSptd->_communicatorEpoll == NULL)
+	//处于业务线程中, 且当前业务线程是以协程模式启动; 或者分片模式下普通业务线程的同步调用
+	if((pSptd->_sched || (bSync && _communicator->isSharded())) && pSptd->_communicatorEpoll == NULL)
 	{
-		//处于业务线程中, 且当前业务线程是以协程模式启动;
 		auto schedCommunicatorEpollInfo = pSptd->getSchedCommunicatorEpollInfo(_communicator);
 
 		shared_ptr<CommunicatorEpoll> ce;
 
 		if (!schedCommunicatorEpollInfo->_communicator)
 		{
-			//当前协程没有关联过私有网络通信器, 需要新建!
+			//当前协程/线程没有关联过私有网络通信器, 需要新建!
 			pReqQ = std::make_shared<ReqInfoQueue>(_communicator->getCommunicatorEpoll(0)->getNoSendQueueLimit());
-			ce = _communicator->createSchedCommunicatorEpoll(pSptd->_reqQNo, pReqQ);
+			if (pSptd->_sched)
+			{
+				ce = _communicator->createSchedCommunicatorEpoll(pSptd->_reqQNo, pReqQ);
+			}
+			else
+			{
+				ce = _communicator->createShardCommunicatorEpoll(pSptd->_reqQNo, pReqQ);
+			}
 
 			schedCommunicatorEpollInfo->_communicator = _communicator;
 			schedCommunicatorEpollInfo->_info._reqQueue = pReqQ;
@@ -1803,6 +1985,14 @@ void ServantProxy::checkCookie(RequestPacket &req)
     });
 }
 
+void ServantProxy::checkCompress(RequestPacket &req)
+{
+    //单次调用在context里设置了的优先
+    if (!_compressCodec.empty())
+    {
+        req.context.insert(make_pair(ServantProxy::CONTEXT_COMPRESS_KEY, _compressCodec));
+    }
+}
 
 void ServantProxy::tars_endpoints(vector<EndpointInfo> &activeEndPoint, vector<EndpointInfo> &inactiveEndPoint)
 {
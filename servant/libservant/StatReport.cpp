@@ -30,6 +30,8 @@ namespace tars
 {
 //////////////////////////////////////////////////////////////////
 //
+std::atomic<uint64_t> StatReport::_idGen(0);
+
 StatReport::StatReport(Communicator* communicator)
 : _communicator(communicator)
 , _time(0)
@@ -37,6 +39,8 @@ StatReport::StatReport(Communicator* communicator)
 , _reportTimeout(5000)
 , _maxReportSize(MAX_REPORT_SIZE)
 , _terminate(false)
+, _id(++_idGen)
+, _sharded(false)
 {
 	srand(time(NULL));
 }
@@ -358,10 +362,24 @@ void StatReport::report(const string& strMasterName,
 
 void StatReport::submit(StatMicMsgHead& head, StatMicMsgBody& body, bool bFromClient)
 {
+    if (_sharded)
+    {
+        StatShard *shard = getShard();
+
+        TC_LockT<TC_SpinLock> lock(shard->_lock);
+
+        addMicBody(bFromClient ? shard->_client : shard->_server, head, body);
+
+        return;
+    }
+
     Lock lock(*this);
 
-    MapStatMicMsg& msg = (bFromClient == true)?_statMicMsgClient:_statMicMsgServer;
+    addMicBody(bFromClient ? _statMicMsgClient : _statMicMsgServer, head, body);
+}
 
+void StatReport::addMicBody(MapStatMicMsg &msg, StatMicMsgHead& head, StatMicMsgBody& body)
+{
     auto it = msg.find( head );
 
     if ( it != msg.end() )
@@ -389,6 +407,96 @@ void StatReport::submit(StatMicMsgHead& head, StatMicMsgBody& body, bool bFromCl
     }
 }
 
+StatReport::StatShard *StatReport::getShard()
+{
+    //线程退出时释放自己的引用, 剩下的数据由上报线程合并完后释放
+    static thread_local unordered_map<uint64_t, shared_ptr<StatShard> > shards;
+    static thread_local uint64_t lastId = 0;
+    static thread_local StatShard *lastShard = NULL;
+
+    if (lastId == _id)
+    {
+        return lastShard;
+    }
+
+    shared_ptr<StatShard> &shard = shards[_id];
+    if (!shard)
+    {
+        shard = std::make_shared<StatShard>();
+
+        Lock lock(*this);
+        _shards.push_back(shard);
+    }
+
+    lastId    = _id;
+    lastShard = shard.get();
+
+    return lastShard;
+}
+
+void StatReport::mergeMicMsg(MapStatMicMsg &old, MapStatMicMsg &add)
+{
+    for (auto iter = add.begin(); iter != add.end(); ++iter)
+    {
+        auto iterOld = old.find(iter->first);
+        if (iterOld == old.end())
+        {
+            old.insert(*iter);
+            continue;
+        }
+
+        StatMicMsgBody& stBody      = iterOld->second;
+        const StatMicMsgBody& body  = iter->second;
+        stBody.count                += body.count;
+        stBody.timeoutCount         += body.timeoutCount;
+        stBody.execCount            += body.execCount;
+        stBody.totalRspTime         += body.totalRspTime;
+        if (stBody.maxRspTime < body.maxRspTime)
+        {
+            stBody.maxRspTime = body.maxRspTime;
+        }
+        //非0最小值
+        if (stBody.minRspTime == 0 || (stBody.minRspTime > body.minRspTime && body.minRspTime != 0))
+        {
+            stBody.minRspTime = body.minRspTime;
+        }
+        for (auto it = body.intervalCount.begin(); it != body.intervalCount.end(); ++it)
+        {
+            stBody.intervalCount[it->first] += it->second;
+        }
+    }
+}
+
+void StatReport::mergeShards()
+{
+    Lock lock(*this);
+
+    for (auto it = _shards.begin(); it != _shards.end(); )
+    {
+        MapStatMicMsg client;
+        MapStatMicMsg server;
+
+        {
+            TC_LockT<TC_SpinLock> slock((*it)->_lock);
+            client.swap((*it)->_client);
+            server.swap((*it)->_server);
+        }
+
+        mergeMicMsg(_statMicMsgClient, client);
+        mergeMicMsg(_statMicMsgServer, server);
+
+        //线程已经退出, 数据也取完了
+        if (it->use_count() == 1)
+        {
+            it = _shards.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
 int StatReport::reportMicMsg(MapStatMicMsg& msg, bool bFromClient)
 {
     if (msg.empty()) return 0;
@@ -674,6 +782,8 @@ void StatReport::run()
 
             if(tNow - _time >= _reportInterval/1000)
             {
+                mergeShards();
+
                 reportMicMsg(_statMicMsgClient, true);
 
                 reportMicMsg(_statMicMsgServer, false);
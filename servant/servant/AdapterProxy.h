@@ -72,6 +72,11 @@ public:
      */
     void doInvoke();
 
+    /**
+     * 发送网络线程处理请求队列期间延迟的请求(见CommunicatorEpoll::handleNotify)
+     */
+    void doDeferSend();
+
     /**
      * server端的响应包返回
      */
@@ -207,6 +212,22 @@ public:
      */
     inline int getId() const { return _id; }
 
+    /**
+     * 在途请求数(等待发送和已发送还没有响应的)
+     */
+    inline size_t getInflight() { return _timeoutQueue->size(); }
+
+    /**
+     * 响应时间的EWMA(毫秒), 距离上次更新越久衰减越多, 慢节点一段时间后会重新被尝试
+     */
+    double getRspTimeEwma();
+
+    /**
+     * 负载分数, 越小越好, E_ADAPTIVE时用来选择节点
+     * (响应时间EWMA + 1) * (在途请求数 + 1) / 静态权重
+     */
+    double getLoadScore();
+
 	/**
 	 * 屏蔽结点
 	 */
@@ -228,6 +249,21 @@ public:
      */
     void stat(ReqMessage * msg);
 
+    /**
+     * 更新响应时间的EWMA
+     */
+    void updateRspTimeEwma(ReqMessage * msg);
+
+    /**
+     * 服务端已经确认支持请求里协商的压缩算法时, 压缩请求包
+     */
+    void compressRequest(ReqMessage * msg);
+
+    /**
+     * 记录服务端确认的压缩算法, 解压回包
+     */
+    void uncompressResponse(shared_ptr<ResponsePacket> & rsp);
+
 protected:
 
     //创建完网络句柄后的回调
@@ -422,11 +458,31 @@ private:
      */
     bool                                   _timeoutLogFlag;
 
+    /*
+     * 响应时间的EWMA(毫秒)
+     */
+    double                                 _rspTimeEwma = 0;
+
+    /*
+     * 上次更新响应时间EWMA的时间(毫秒), 0表示还没有响应
+     */
+    int64_t                                _rspTimeUpdate = 0;
+
+    /*
+     * 服务端回包确认支持的压缩算法, 连接断开后重新协商
+     */
+    string                                 _compressAck;
+
     /*
      * 非发送队列的大小限制，用于发送过载判断
      */
     size_t                                   _noSendQueueLimit;
 
+    /*
+     * 是否已经加入网络线程的延迟发送列表
+     */
+    bool                                     _deferSend = false;
+
     /*
      * 模块间调用统计信息的head信息
      */
@@ -70,6 +70,18 @@ public:
         return TC_NetWorkBuffer::parseBinary4<TARS_NET_MIN_PACKAGE_SIZE, TARS_NET_MAX_PACKAGE_SIZE>(in, out);
     }
 
+    /**
+     * 解析协议, 完整包直接引用接收buffer, 不copy数据
+     * @param in, 目前的buffer
+     * @param out, 一个完整的包
+     *
+     * @return int, 0表示没有接收完全, 1表示收到一个完整包
+     */
+    static TC_NetWorkBuffer::PACKET_TYPE parseSlice(TC_NetWorkBuffer &in, TC_NetWorkBuffer::Slice &out)
+    {
+        return TC_NetWorkBuffer::parseBinary4Slice<TARS_NET_MIN_PACKAGE_SIZE, TARS_NET_MAX_PACKAGE_SIZE>(in, out);
+    }
+
     /**
      *
      * @param T
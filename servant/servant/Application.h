@@ -134,12 +134,15 @@ struct SVT_DLL_API ServerBaseInfo
     int         BackPacketMin;       //回包速度检查
     int         BakFlag = 0;
     int         BakType = 0;
+    std::string EpollBackend;        //网络事件后端: epoll/io_uring
+    size_t      CompressThreshold;   //客户端协商了压缩时, 回包sBuffer超过该长度才压缩
 
     std::string CA;
     std::string Cert;
     std::string Key;
     bool VerifyClient;
     std::string Ciphers;
+    bool Ktls;
     map<string, string> Context;     //框架内部用, 传递节点名称(以域名形式部署时)
 };
 
@@ -177,11 +180,14 @@ struct SVT_DLL_API ServerConfig
 	static int         BackPacketMin;       //回包速度检查
     static int         BakFlag;             //是否启用是备机: 0: 非备机, 1: 备机
     static int         BakType;             //主备切换类型: 0 不需要主备切换，1：自动主从切换， 2：自动切换但是不屏蔽主控路由
+    static std::string EpollBackend;        //网络事件后端: epoll(默认)/io_uring(需要编译打开TARS_IO_URING, 内核不支持时回退为epoll)
+    static size_t      CompressThreshold;   //客户端协商了压缩时, 回包sBuffer超过该长度才压缩(默认1K)
 	static std::string CA;                  //ssl ca
 	static std::string Cert;                //ssl 证书
 	static std::string Key;                 //ssl 私钥
 	static bool VerifyClient;               //是否验证客户端
 	static std::string Ciphers;             //过滤的加密算法cd
+	static bool Ktls;                       //ssl握手后是否把会话密钥交给内核(kTLS), 内核不支持时自动回退
 
 	static map<string, string> Context;     //框架内部用, 传递节点名称(以域名形式部署时)
 
@@ -0,0 +1,214 @@
+﻿/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except 
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed 
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR 
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the 
+ * specific language governing permissions and limitations under the License.
+ */
+#pragma once
+
+#include "servant/ServantProxy.h"
+#include "promise/promise.h"
+
+/**
+ * C++20无栈协程(co_await)支持
+ *
+ * 说明:
+ * - 只有编译器支持协程(-std=c++20或者-fcoroutines)时才生效, 并定义TARS_CO_AWAIT, 否则这个文件为空
+ * - tars::Future<T>可以直接co_await, 结果就是get()的返回值, 有异常时在co_await处抛出
+ * - tars::Future<T>可以作为协程的返回类型, co_return的值/抛出的异常设置到Future上
+ * - tars2cpp生成的co_xxx接口返回Future, 协程里: auto rsp = co_await prx->co_testHello(...);
+ * - coInvoke直接等待ReqMessage完成, 不经过Future, 适合自己编解码的场景
+ * - 协程在回包的线程(异步回调线程, 或者setNetThreadProcess时的网络线程)上恢复执行, 不要在协程里做阻塞的调用
+ * - 每个等待中的请求只占用一个协程帧(几百字节), 不需要像TC_Coroutine那样为每个协程分配独立的栈
+ */
+#if defined(__cpp_impl_coroutine)
+
+#include <atomic>
+#include <coroutine>
+
+#define TARS_CO_AWAIT 1
+
+namespace tars
+{
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * 挂起和完成的竞争: 完成可能在挂起之前(同步回调)或之后(其他线程)发生,
+ * 先到的一方只设置标记, 后到的一方负责恢复协程(或者不挂起)
+ */
+struct CoAwaitState
+{
+    std::coroutine_handle<>  _handle;
+    std::atomic<bool>        _done{false};
+
+    /**
+     * 挂起方调用, 返回true表示需要挂起
+     */
+    bool suspend(std::coroutine_handle<> h)
+    {
+        _handle = h;
+        return !_done.exchange(true, std::memory_order_acq_rel);
+    }
+
+    /**
+     * 完成方调用
+     */
+    void complete()
+    {
+        if (_done.exchange(true, std::memory_order_acq_rel))
+        {
+            _handle.resume();
+        }
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Future的awaiter
+ */
+template <typename T>
+class FutureAwaiter
+{
+public:
+    FutureAwaiter(const Future<T> &future) : _future(future) {}
+
+    bool await_ready() const { return _future.isDone(); }
+
+    bool await_suspend(std::coroutine_handle<> h)
+    {
+        auto state = std::make_shared<CoAwaitState>();
+
+        //不能在suspend之后再访问this, 协程可能已经在其他线程恢复并销毁了awaiter
+        Future<T> future = _future;
+
+        future.then(Bind(&FutureAwaiter<T>::onDone, state));
+
+        return state->suspend(h);
+    }
+
+    typename promise::FutureTypeTraits<T>::LValueType await_resume() const { return _future.get(); }
+
+protected:
+    static void onDone(const std::shared_ptr<CoAwaitState> &state, const Future<T> &)
+    {
+        state->complete();
+    }
+
+protected:
+    Future<T> _future;
+};
+
+template <typename T>
+FutureAwaiter<T> operator co_await(const Future<T> &future)
+{
+    return FutureAwaiter<T>(future);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * 等待ReqMessage完成的回调对象
+ */
+class CoAwaitCallback : public ServantProxyCallback
+{
+public:
+    virtual int onDispatch(ReqMessagePtr msg)
+    {
+        _msg = msg;
+        _state.complete();
+        return 0;
+    }
+
+    ReqMessagePtr   _msg;
+    CoAwaitState    _state;
+};
+
+typedef TC_AutoPtr<CoAwaitCallback> CoAwaitCallbackPtr;
+
+/**
+ * 异步发送请求, co_await的结果是完成的ReqMessage(msg->response->iRet是服务端返回值, 超时等失败时response的iRet也会被设置)
+ */
+class CoInvokeAwaiter
+{
+public:
+    CoInvokeAwaiter(const ServantPrx &prx, const string &sFuncName, TarsOutputStream<BufferWriterVector> &os, const map<string, string> &context, const map<string, string> &status)
+    : _prx(prx), _funcName(sFuncName), _context(context), _status(status), _callback(new CoAwaitCallback())
+    {
+        _os.swap(os);
+    }
+
+    bool await_ready() const { return false; }
+
+    bool await_suspend(std::coroutine_handle<> h)
+    {
+        CoAwaitCallbackPtr callback = _callback;
+
+        //先加引用, 回调可能在tars_invoke_async返回前就已经恢复了协程
+        _prx->tars_invoke_async(TARSNORMAL, _funcName, _os, _context, _status, callback);
+
+        return callback->_state.suspend(h);
+    }
+
+    ReqMessagePtr await_resume() const { return _callback->_msg; }
+
+protected:
+    ServantPrx                              _prx;
+    string                                  _funcName;
+    TarsOutputStream<BufferWriterVector>    _os;
+    map<string, string>                     _context;
+    map<string, string>                     _status;
+    CoAwaitCallbackPtr                      _callback;
+};
+
+inline CoInvokeAwaiter coInvoke(const ServantPrx &prx, const string &sFuncName, TarsOutputStream<BufferWriterVector> &os, const map<string, string> &context = map<string, string>(), const map<string, string> &status = map<string, string>())
+{
+    return CoInvokeAwaiter(prx, sFuncName, os, context, status);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Future作为协程返回类型时的promise_type
+ */
+template <typename T>
+struct FuturePromiseBase
+{
+    Promise<T>  _promise;
+
+    Future<T> get_return_object() { return _promise.getFuture(); }
+
+    std::suspend_never initial_suspend() noexcept { return {}; }
+
+    std::suspend_never final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { _promise.setException(currentException()); }
+};
+
+template <typename T>
+struct FuturePromise : public FuturePromiseBase<T>
+{
+    void return_value(typename promise::FutureTypeTraits<T>::RValueType v) { this->_promise.setValue(v); }
+};
+
+template <>
+struct FuturePromise<void> : public FuturePromiseBase<void>
+{
+    void return_void() { this->_promise.set(); }
+};
+
+}
+
+template <typename T, typename... Args>
+struct std::coroutine_traits<tars::Future<T>, Args...>
+{
+    using promise_type = tars::FuturePromise<T>;
+};
+
+#endif
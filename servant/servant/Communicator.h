@@ -74,6 +74,11 @@ const static string CONFIG_ROOT_PATH = string("/tars/application/client");
  * 2 当业务线程处于普通线程中(不存在协程调度器), 只使用公有CommunicatorEpoll
  * - 轮询选择公有的CommunicatorEpoll的, 注意此时不选择私有CommunicatorEpoll来发送数据, 降低系统的复杂度
  * - 轮询的计数器保持在线程私有数据中
+ * 3 分片模式(配置sharded=1), 普通业务线程的同步调用也使用私有CommunicatorEpoll
+ * - 每个业务线程创建一个独占的CommunicatorEpoll(独立的epoller, 不启动协程), 有自己的ObjectProxy/AdapterProxy和连接
+ * - 同步调用直接在业务线程里发包, 等待回包时由业务线程驱动epoller, 整个调用在一个线程中完成, 没有跨线程的队列和notify
+ * - 异步/单向调用不阻塞业务线程, 没有线程驱动独占通信器, 仍然走公有CommunicatorEpoll
+ * - 独占通信器和协程内的私有通信器一样管理(同样不主动更新主控), 业务线程空闲时它的定时任务/通知要等到下次同步调用才处理
  *
  * 析构问题处理
  * - 通信器是管理客户端资源的对象
@@ -296,6 +301,14 @@ public:
      */
     StatReport * getStatReport();
 
+    /**
+     * 上报tars协议包的压缩率和压缩耗时
+     * @param srcLen, 压缩前长度
+     * @param dstLen, 压缩后长度
+     * @param costUs, 压缩耗时(微秒)
+     */
+    void reportCompress(size_t srcLen, size_t dstLen, int64_t costUs);
+
     /**
      * 重新加载属性
      */
@@ -340,6 +353,11 @@ public:
      */
     int64_t getKeepAliveInterval() { return _keepAliveInterval; }
 
+    /*
+     * 是否分片模式(sharded=1), 普通业务线程的同步调用使用线程独占的通信器
+     */
+    bool isSharded() const { return _sharded; }
+
     /**
      * get resource info
      * @return
@@ -461,6 +479,12 @@ protected:
 	 */
 	void eraseSchedCommunicatorEpoll(size_t netThreadSeq);
 
+	/**
+	 * 分片模式下, 创建一个普通业务线程独占的网络通信器(和协程内的私有通信器一样管理)
+	 * @return
+	 */
+	shared_ptr<CommunicatorEpoll> createShardCommunicatorEpoll(size_t netThreadSeq,  const shared_ptr<ReqInfoQueue> &reqInfoQueue);
+
 	/**
      * 框架内部需要直接访问通信器的类
      */
@@ -563,6 +587,11 @@ protected:
      */
     int64_t                _keepAliveInterval;
 
+    /*
+     * 分片模式
+     */
+    bool                   _sharded = false;
+
 	/**
 	 * ssl ctx
 	 */
@@ -584,6 +613,16 @@ protected:
      */
     PropertyReportPtr        _reportAsyncQueue;
 
+    /*
+     * 压缩率(压缩后/压缩前, 百分比)的统计上报的对象
+     */
+    PropertyReportPtr        _reportCompressRatio;
+
+    /*
+     * 压缩耗时(微秒)的统计上报的对象
+     */
+    PropertyReportPtr        _reportCompressTime;
+
     /*
      * 异步线程数目
      */
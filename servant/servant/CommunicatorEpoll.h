@@ -209,6 +209,23 @@ public:
 	 */
 	inline bool isSchedCommunicatorEpoll() const { return !_public; }
 
+	/**
+	 * 是否是分片模式下普通业务线程独占的通信器(见Communicator说明)
+	 * @return
+	 */
+	inline bool isShardCommunicatorEpoll() const { return _shard; }
+
+	/**
+	 * 分片模式下, 在业务线程中驱动网络事件, 直到fin为true或者通信器结束
+	 * @param fin
+	 */
+	void runUntil(const bool &fin);
+
+	/**
+	 * 分片模式下, 处理业务线程空闲期间积压的网络事件(例如对端已经关闭了连接), 不等待
+	 */
+	void runPending();
+
 	/**
 	 * 初始化notify
 	 */
@@ -231,6 +248,18 @@ public:
 	 */
 	const std::thread::id &getThreadId() const { return _threadId; }
 
+	/**
+	 * 是否正在处理请求队列(handleNotify), 这期间tcp连接复用的请求先不发送
+	 * @return
+	 */
+	inline bool isDeferSend() const { return _deferSend; }
+
+	/**
+	 * 添加延迟发送的adapter, 请求队列处理完后每个adapter合并发送一次
+	 * @param adapterProxy
+	 */
+	inline void addDeferSend(AdapterProxy *adapterProxy) { _deferAdapters.push_back(adapterProxy); }
+
 protected:
 
 	/**
@@ -259,6 +288,11 @@ protected:
      */
     void initializeEpoller();
 
+    /**
+     * 初始化分片模式的epoller, 使用独立的调度器(不启动协程), 由业务线程同步调用时驱动
+     */
+    void initializeShardEpoller();
+
     /**
      * 上报数据
      * @param pmStatMicMsg
@@ -295,6 +329,11 @@ protected:
      */
     bool handleNotify(const shared_ptr<TC_Epoller::EpollInfo> & data);
 
+	/**
+	 * 发送handleNotify中延迟的请求
+	 */
+	void flushDeferSend();
+
     /**
      * 处理超时
      * @param pi
@@ -364,6 +403,11 @@ protected:
      */
     bool 				   _public = false;
 
+    /**
+     * 是否分片模式下业务线程独占的通信器
+     */
+    bool                   _shard = false;
+
     /**
      * notify
      */
@@ -455,6 +499,16 @@ protected:
      */
     vector<int64_t> _timerIds;
 
+	/**
+	 * 处理请求队列中, 延迟发送
+	 */
+	bool _deferSend = false;
+
+	/**
+	 * 延迟发送的adapter
+	 */
+	vector<AdapterProxy*> _deferAdapters;
+
 	/**
 	 * 锁
 	 */
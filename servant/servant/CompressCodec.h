@@ -0,0 +1,112 @@
+﻿/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except 
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed 
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR 
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the 
+ * specific language governing permissions and limitations under the License.
+ */
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include "util/tc_singleton.h"
+#include "servant/Global.h"
+#include "tup/TarsType.h"
+
+namespace tars
+{
+
+/**
+ * sBuffer已压缩的消息类型标志位(iMessageType)
+ * BaseF.tars中的TARSMESSAGETYPE*由协议子模块生成, 这里单独定义, 取值不与其冲突
+ */
+const tars::Int32 TARSMESSAGETYPECOMPRESS = 512;
+
+/**
+ * tars协议请求/响应包sBuffer的压缩算法接口
+ * 客户端在请求的context里带上ServantProxy::CONTEXT_COMPRESS_KEY(值为算法名称), 表示支持该算法,
+ * 服务端支持时在回包的status里带上同样的key确认, 之后双方超过阈值的sBuffer都会压缩, 并设置TARSMESSAGETYPECOMPRESS
+ */
+class SVT_DLL_API CompressCodec
+{
+public:
+    virtual ~CompressCodec() {}
+
+    /**
+     * 算法名称, 协商时使用
+     */
+    virtual const string &name() const = 0;
+
+    /**
+     * 压缩
+     * @param src
+     * @param length
+     * @param buffer, 输出
+     * @return bool, 成功失败
+     */
+    virtual bool compress(const char *src, size_t length, vector<char> &buffer) = 0;
+
+    /**
+     * 解压
+     * @param src
+     * @param length
+     * @param buffer, 输出
+     * @return bool, 成功失败
+     */
+    virtual bool uncompress(const char *src, size_t length, vector<char> &buffer) = 0;
+};
+
+typedef shared_ptr<CompressCodec> CompressCodecPtr;
+
+#if TARS_GZIP
+/**
+ * gzip压缩(TC_GZip)
+ */
+class SVT_DLL_API GZipCompressCodec : public CompressCodec
+{
+public:
+    virtual const string &name() const;
+
+    virtual bool compress(const char *src, size_t length, vector<char> &buffer);
+
+    virtual bool uncompress(const char *src, size_t length, vector<char> &buffer);
+};
+#endif
+
+/**
+ * 压缩算法的注册和查找, 编译打开TARS_GZIP时缺省注册了gzip
+ */
+class SVT_DLL_API CompressCodecFactory : public TC_Singleton<CompressCodecFactory>
+{
+public:
+    CompressCodecFactory();
+
+    /**
+     * 注册压缩算法, 同名的会被替换
+     * @param codec
+     */
+    void registerCodec(const CompressCodecPtr &codec);
+
+    /**
+     * 获取压缩算法
+     * @param name
+     * @return CompressCodecPtr, 不支持返回NULL
+     */
+    CompressCodecPtr getCodec(const string &name);
+
+protected:
+    std::mutex                                      _mutex;
+
+    std::unordered_map<string, CompressCodecPtr>    _codecs;
+};
+
+}
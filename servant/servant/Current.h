@@ -25,6 +25,7 @@ namespace tars
 {
 
 class ServantHandle;
+class TC_HttpRequest;
 
 //////////////////////////////////////////////////////////////
 /**
@@ -137,6 +138,20 @@ public:
      */
     const vector<char> &getRequestBuffer() const;
 
+    /**
+     * 获取请求buffer的地址和长度(tars协议时直接引用网络接收buffer, 不copy数据)
+     * 返回的数据在Current生命周期内有效
+     * @return pair<const char*, size_t>
+     */
+    pair<const char*, size_t> getRequestData() const;
+
+    /**
+     * 把请求解析成http请求
+     * 协议是TC_NetWorkBuffer::parseHttp时直接使用协议解析的结果, 不再重复解析头部
+     * @return bool
+     */
+    bool decodeHttpRequest(TC_HttpRequest &request) const;
+
     /**
      * 获取服务Servant名称
      * @return string
@@ -166,7 +181,13 @@ public:
      * 函数名称(仅TARS协议有效)
      * @return string
      */
-    string getFuncName() const;
+    const string &getFuncName() const;
+
+    /**
+     * 函数id(仅TARS协议有效), 客户端没有设置时为0, 参见tarsFuncId
+     * @return tars::Int32
+     */
+    Int32 getFuncId() const { return _request.iFuncId; }
 
     /**
      * 请求ID(仅TARS协议有效)
@@ -206,7 +227,7 @@ public:
 	 * 获取RequestPacket
 	 * @return
 	 */
-	const RequestPacket &getBasePacket() const { return _request; }
+	const RequestPacket &getBasePacket() const { materializeRequest(); return _request; }
 
     /**
      * tars协议的发送响应数据(仅TARS协议有效)
@@ -317,6 +338,29 @@ protected:
      */
     void initialize(const vector<char> &sRecvBuffer);
 
+    /**
+     * 直接从接收的slice解析请求包, sBuffer只引用不copy
+     * @return false: 不能按slice解析(需要走完整解析)
+     */
+    bool initializeSlice();
+
+    /**
+     * 把引用的sBuffer copy到_request中(兼容getRequestBuffer/getBasePacket)
+     */
+    void materializeRequest() const;
+
+    /**
+     * 请求包是压缩的(TARSMESSAGETYPECOMPRESS)就解压
+     * @return false: 不支持的压缩算法或者解压失败
+     */
+    bool uncompressRequest();
+
+    /**
+     * 客户端协商了压缩时, 回包确认压缩算法, 超过阈值的sBuffer压缩
+     * @param response
+     */
+    void compressResponse(ResponsePacket &response);
+
 //    /**
 //     * 服务端上报状态，针对单向调用及TUP调用
 //     */
@@ -357,7 +401,12 @@ protected:
     /**
      * 客户端请求包
      */
-    RequestPacket            _request;
+    mutable RequestPacket    _request;
+
+    /**
+     * 请求包的sBuffer(引用网络接收buffer)
+     */
+    mutable TC_NetWorkBuffer::Slice _requestBody;
 
     /**
      * 响应
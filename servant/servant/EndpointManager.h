@@ -20,7 +20,7 @@
 #include "servant/QueryF.h"
 #include "servant/AppProtocol.h"
 #include "util/tc_spin_lock.h"
-#include "util/tc_consistent_hash_new.h"
+#include "util/tc_consistent_hash_ring.h"
 
 namespace tars
 {
@@ -43,6 +43,7 @@ enum  EndpointWeightType
 {
     E_LOOP          = 0,
     E_STATIC_WEIGHT = 1,
+    E_ADAPTIVE      = 2,    //随机取两个节点, 选负载分数(响应时间EWMA, 在途请求数, 静态权重)小的
 };
 
 ////////////////////////////////////////////////////////////////////////
@@ -393,6 +394,11 @@ private:
      */
     AdapterProxy * getNextValidProxy();
 
+    /*
+     * 自适应选取一个结点: 随机取两个可用结点, 选负载分数小的
+     */
+    AdapterProxy * getAdaptiveProxy();
+
     /*
      * 根据hash值选取一个结点
      */
@@ -424,6 +430,22 @@ private:
      */
     bool checkHashStaticWeightChange(bool bStatic);
 
+    /*
+     * 一致性hash环, 节点变化时整体重建替换
+     */
+    struct ConHashRing
+    {
+        TC_ConsistentHashRing   ring;
+
+        //环上节点下标对应的节点
+        vector<AdapterProxy*>   proxys;
+    };
+
+    /*
+     * 从一致性hash环上选取节点, 设置了conhash-load-factor时按有界负载选取
+     */
+    AdapterProxy* selectConHashProxy(int64_t hashCode, const ConHashRing &conHash);
+
     /*
      * 判断静态权重节点是否有变化
      */
@@ -437,7 +459,7 @@ private:
     /*
      * 更新一致性hash方法的静态权重节点信息
      */
-    void updateConHashProxyWeighted(bool bStatic, map<string, AdapterProxy*> &mLastConHashProxys, TC_ConsistentHashNew &conHash);
+    void updateConHashProxyWeighted(bool bStatic, map<string, AdapterProxy*> &mLastConHashProxys, shared_ptr<ConHashRing> &conHash);
 
     /*
      * 根据后端服务的权重值选取一个结点
@@ -553,7 +575,7 @@ private:
     /*
      * 一致性hash静态权重时使用
      */
-    TC_ConsistentHashNew          _consistentHashWeight;
+    shared_ptr<ConHashRing>       _consistentHashWeight;
 
     /*
      * 一致性hash普通使用
@@ -563,7 +585,13 @@ private:
     /*
      * 一致性hash普通使用
      */
-    TC_ConsistentHashNew          _consistentHash;
+    shared_ptr<ConHashRing>       _consistentHash;
+
+    /*
+     * 一致性hash有界负载的系数(按在途请求数), 节点负载超过ceil(系数 * 平均负载)时顺延到环上下一个节点
+     * 0表示不启用, 配置项conhash-load-factor, 一般取1.25
+     */
+    double                        _conHashLoadFactor;
 
     struct OutterUpdate
     {
@@ -22,6 +22,9 @@
 #include <tuple>
 #include <vector>
 #include <string>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
 
 using namespace std;
 
@@ -39,6 +42,8 @@ namespace tars
 class SVT_DLL_API PropertyReport : public TC_HandleBase
 {
 public:
+    PropertyReport() : _id(++_idGen) { }
+
     /**
      * 设置该属性的服务名称，如果不设置则为当前服务
      */
@@ -61,6 +66,7 @@ public:
         string get();
         string desc()               { return "Sum"; }
         void   set(int o)           { _d += o; }
+        void   merge(sum &o)        { _d += o._d; o.clear(); }
     protected:
         void   clear()              { _d  = 0; }
     private:
@@ -77,6 +83,7 @@ public:
         string desc()               { return "Avg"; }
         string get();
         void   set(int o)           { _sum += o;++_count; }
+        void   merge(avg &o)        { _sum += o._sum; _count += o._count; o.clear(); }
     protected:
         void clear()                { _sum = 0; _count = 0; }
     private:
@@ -95,6 +102,7 @@ public:
         string desc()               { return "Distr"; }
         void   set(int o);
         string get();
+        void   merge(distr &o);
     protected:
         void clear()                { _result.clear(); _max = 0;}
     private:
@@ -113,6 +121,7 @@ public:
         string desc()               { return "Max"; }
         string get();
         void   set(int o)           { _d < o?_d = o:1; }
+        void   merge(max &o)        { set(o._d); o.clear(); }
     protected:
         void   clear()              { _d = 0; }
     private:
@@ -129,6 +138,7 @@ public:
         string desc()               { return "Min"; }
         string get();
         void   set(int o);
+        void   merge(min &o)        { set(o._d); o.clear(); }
     protected:
         void   clear()              { _d = 0; }
     private:
@@ -145,6 +155,7 @@ public:
         string desc()               { return "Count"; }
         string get();
         void   set(int o)           { _d++; }
+        void   merge(count &o)      { _d += o._d; o.clear(); }
     protected:
         void   clear()              { _d = 0; }
     private:
@@ -156,8 +167,23 @@ public:
     virtual void report(int iValue)             = 0;
     virtual vector<pair<string, string> > get() = 0;
 
+    /**
+     * 设置分片模式: 每个线程report到自己的分片, get时(上报线程)再合并各分片
+     * 策略都支持merge时才生效
+     */
+    virtual void setSharded(bool bSharded)      { }
+
+    /**
+     * 是否分片模式
+     */
+    virtual bool isSharded() const              { return false; }
+
 protected:
     std::string _sMasterName;   //属性所属服务名称
+
+    uint64_t    _id;            //唯一标识, 用于线程找到自己的分片
+
+    static std::atomic<uint64_t> _idGen;
 };
 
 typedef TC_AutoPtr<PropertyReport> PropertyReportPtr;
@@ -175,7 +201,9 @@ public:
     using PropertyReportData = std::tuple<Params...>;
 
     PropertyReportImp(Params&&... args) :
-        _propertyReportData(std::forward<Params>(args)...)
+        _propertyReportData(std::forward<Params>(args)...),
+        _prototype(createPrototype(MergeTag())),
+        _sharded(false)
     {
     }
 
@@ -194,8 +222,14 @@ public:
     */
     void report(int iValue) override
     {
+        if (_sharded.load(std::memory_order_relaxed))
+        {
+            reportShard(iValue, MergeTag());
+            return;
+        }
+
         TC_LockT<TC_ThreadMutex> lock(*this);
-        Helper<std::tuple_size<decltype(_propertyReportData)>::value>::Report(*this, iValue);
+        Helper<std::tuple_size<decltype(_propertyReportData)>::value>::Report(_propertyReportData, iValue);
     }
 
 
@@ -207,19 +241,74 @@ public:
     vector<pair<string, string> > get() override
     {
         TC_LockT<TC_ThreadMutex> lock(*this);
+        mergeShards(MergeTag());
         return Helper<std::tuple_size<decltype(_propertyReportData)>::value>::Get(*this);
     }
 
+    /**
+     * 设置分片模式, 有策略不支持merge时保持加锁模式
+     * @param bSharded
+     */
+    void setSharded(bool bSharded) override
+    {
+        _sharded = bSharded && MergeTag::value;
+    }
+
+    bool isSharded() const override
+    {
+        return _sharded;
+    }
+
 private:
+    // 策略是否有merge
+    template <typename T>
+    struct HasMerge
+    {
+        template <typename U> static char test(decltype(&U::merge));
+        template <typename U> static int  test(...);
+
+        enum { value = (sizeof(test<T>(0)) == sizeof(char)) };
+    };
+
+    template <typename... Ts>
+    struct CanMerge : std::true_type
+    {
+    };
+
+    template <typename T, typename... Ts>
+    struct CanMerge<T, Ts...> : std::integral_constant<bool, HasMerge<T>::value && CanMerge<Ts...>::value>
+    {
+    };
+
+    typedef std::integral_constant<bool, CanMerge<Params...>::value> MergeTag;
+
+    /**
+     * 线程的分片, 只有所属线程和get会加锁, 基本没有竞争
+     */
+    struct Shard
+    {
+        Shard(const PropertyReportData &data) : _data(data) { }
+
+        TC_SpinLock         _lock;
+        PropertyReportData  _data;
+    };
+
     // report helper
     template <int N, typename DUMMY = void>
     struct Helper
     {
-        static void Report(PropertyReportImp<Params...>& pp, int iValue)
+        static void Report(PropertyReportData& data, int iValue)
         {
             static_assert(N >= 1, "Obviously success");
-            Helper<N - 1, DUMMY>::Report(pp, iValue);
-            pp.template SetResult<N - 1>(iValue);
+            Helper<N - 1, DUMMY>::Report(data, iValue);
+            std::get<N - 1>(data).set(iValue);
+        }
+
+        static void Merge(PropertyReportData& data, PropertyReportData& shard)
+        {
+            static_assert(N >= 1, "Obviously success");
+            Helper<N - 1, DUMMY>::Merge(data, shard);
+            std::get<N - 1>(data).merge(std::get<N - 1>(shard));
         }
 
         static std::vector<std::pair<std::string, std::string>> Get(PropertyReportImp<Params...>& pp)
@@ -237,7 +326,11 @@ private:
     struct Helper<0, DUMMY>
     {
         // base template
-        static void Report(PropertyReportImp<Params...>&, int  )
+        static void Report(PropertyReportData&, int  )
+        {
+        }
+
+        static void Merge(PropertyReportData&, PropertyReportData& )
         {
         }
 
@@ -248,15 +341,99 @@ private:
         }
     };
 
-    template <int I>
-    void SetResult(int iValue)
+    PropertyReportData *createPrototype(std::true_type)
+    {
+        return new PropertyReportData(_propertyReportData);
+    }
+
+    PropertyReportData *createPrototype(std::false_type)
+    {
+        return NULL;
+    }
+
+    void reportShard(int iValue, std::true_type)
+    {
+        Shard *shard = getShard();
+
+        TC_LockT<TC_SpinLock> lock(shard->_lock);
+        Helper<std::tuple_size<decltype(_propertyReportData)>::value>::Report(shard->_data, iValue);
+    }
+
+    void reportShard(int, std::false_type)
+    {
+    }
+
+    Shard *getShard()
+    {
+        //线程退出时释放自己的引用, 剩下的数据由get合并完后释放
+        static thread_local std::unordered_map<uint64_t, std::shared_ptr<Shard> > shards;
+        static thread_local uint64_t lastId = 0;
+        static thread_local Shard *lastShard = NULL;
+
+        if (lastId == _id)
+        {
+            return lastShard;
+        }
+
+        std::shared_ptr<Shard> &shard = shards[_id];
+        if (!shard)
+        {
+            shard = std::make_shared<Shard>(*_prototype);
+
+            TC_LockT<TC_ThreadMutex> lock(*this);
+            _shards.push_back(shard);
+        }
+
+        lastId    = _id;
+        lastShard = shard.get();
+
+        return lastShard;
+    }
+
+    void mergeShards(std::true_type)
+    {
+        for (auto it = _shards.begin(); it != _shards.end(); )
+        {
+            {
+                TC_LockT<TC_SpinLock> lock((*it)->_lock);
+                Helper<std::tuple_size<decltype(_propertyReportData)>::value>::Merge(_propertyReportData, (*it)->_data);
+            }
+
+            //线程已经退出, 数据也合并完了
+            if (it->use_count() == 1)
+            {
+                it = _shards.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void mergeShards(std::false_type)
     {
-        std::get<I>(_propertyReportData).set(iValue);
     }
+
     /**
      * 状态报告数据
      */
     PropertyReportData  _propertyReportData;
+
+    /**
+     * 分片的初始数据(带策略的构造参数)
+     */
+    std::unique_ptr<PropertyReportData> _prototype;
+
+    /**
+     * 是否分片模式
+     */
+    std::atomic<bool>   _sharded;
+
+    /**
+     * 各线程的分片
+     */
+    std::vector<std::shared_ptr<Shard> > _shards;
 };
 
 }
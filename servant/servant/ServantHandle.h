@@ -194,6 +194,14 @@ protected:
      */
 	bool checkValidSetInvoke(const CurrentPtr &current);
 
+    /**
+     * 解压压缩的请求包
+     *
+     * @param current
+     * @return bool 解压失败已经回包, 返回false
+     */
+    bool processCompress(const CurrentPtr &current);
+
     /**
      * 上报监控统计
      * @param data
@@ -35,6 +35,7 @@ namespace tars
 
 class CommunicatorEpoll;
 class EndpointInfo;
+class ServantProxy;
 
 
 ///////////////////////////////////////////
@@ -232,6 +233,13 @@ public:
 	 */
 	shared_ptr<SchedCommunicatorEpollInfo> getSchedCommunicatorEpollInfo(Communicator *communicator);
 
+	/**
+	 * 提交批量调用中缓存的请求(tars_batch_flush/线程退出时调用)
+	 * @return 提交的请求数
+	 * @throw TarsClientQueueException, 网络线程队列满了, 没放入的请求被丢弃
+	 */
+	size_t flushBatch();
+
 protected:
 	/**
 	 * communicator对应的公用网路通信器
@@ -265,6 +273,15 @@ public:
 	 */
 	CommunicatorEpoll   	*_communicatorEpoll = NULL;
 
+	/**
+	 * 批量调用中的proxy(tars_batch_begin), 该proxy的异步调用先缓存在_batchMsgs中
+	 * tars_batch_flush时按网络线程队列一次放入并只通知一次
+	 * 持有proxy的引用, 批量调用没结束时proxy不会析构; 线程退出时提交没有flush的请求, 通信器析构时丢弃
+	 */
+	ServantPrx              _batchProxy;
+	Communicator            *_batchCommunicator = NULL;
+	vector<pair<ReqMessage*, shared_ptr<ReqInfoQueue>>> _batchMsgs;
+
     ///////////////////////////////////////////////////////////////////////////////////////
     /**
      * 调用链追踪信息
@@ -796,6 +813,8 @@ public:
 
     static string STATUS_TRACE_KEY; //trace信息
 
+    static string CONTEXT_COMPRESS_KEY; //压缩协商, 请求的context里是客户端支持的压缩算法, 回包的status里是服务端确认的算法
+
 ///////////////////////////////////////////////////////////////////
 /**
  * socket选项
@@ -1127,6 +1146,21 @@ public:
      */
     int tars_async_timeout() const;
 
+    /**
+     * 开启tars协议请求/响应包的压缩, 对该proxy上所有方法都有效(需要在调用前设置)
+     * 服务端回包确认支持该算法后, 超过阈值的请求包才会压缩; 服务端不支持时和原来一样
+     * 单次调用也可以在context里设置CONTEXT_COMPRESS_KEY开启
+     * @param codec, 压缩算法名称(CompressCodecFactory里注册的, 比如gzip), 为空关闭
+     * @param threshold, 请求包sBuffer小于该长度不压缩
+     */
+    void tars_set_compress(const string &codec, size_t threshold = 1024);
+
+    /**
+     * 请求包压缩的阈值
+     * @return size_t
+     */
+    size_t tars_compress_threshold() const { return _compressThreshold; }
+
     /**
      * 主动更新端口
      * @param active
@@ -1163,6 +1197,21 @@ public:
      */
     ServantProxyCallbackPtr tars_get_push_callback();
 
+    /**
+     * 开始批量调用: 当前线程之后通过该proxy发起的异步/单向调用先缓存起来,
+     * 调用tars_batch_flush时一次放入网络线程队列, 只唤醒一次网络线程, 网络线程对同一个连接的请求合并发送
+     * 同步调用不受影响; 同一个线程同时只能有一个proxy处于批量调用中, 开始新的批量调用会先flush之前的
+     */
+    void tars_batch_begin();
+
+    /**
+     * 结束批量调用, 把缓存的请求交给网络线程
+     * 建议用ServantProxyBatch, 中途抛异常时也会flush
+     * @return 提交的请求数
+     * @throw TarsClientQueueException, 网络线程队列满了, 没放入的请求被丢弃
+     */
+    size_t tars_batch_flush();
+
 	/**
 	 * 超时策略获取和设置
 	 * @return CheckTimeoutInfo&
@@ -1214,12 +1263,14 @@ public:
 
     /**
      * TARS协议同步方法调用
+     * iFuncId: 函数id(tarsFuncId(sFuncName)), 非0时服务端可以直接按id分发, 不需要匹配函数名
      */
     shared_ptr<ResponsePacket> tars_invoke(char cPacketType,
                             const string& sFuncName,
                             tars::TarsOutputStream<tars::BufferWriterVector>& buf,
                             const map<string, string>& context,
-                            const map<string, string>& status);
+                            const map<string, string>& status,
+                            Int32 iFuncId = 0);
 
     /**
      * TARS协议同步方法调用
@@ -1228,7 +1279,8 @@ public:
                             const string& sFuncName,
                             const vector<char>& buf,
                             const map<string, string>& context,
-                            const map<string, string>& status);
+                            const map<string, string>& status,
+                            Int32 iFuncId = 0);
 
     /**
      * TARS协议异步方法调用
@@ -1239,7 +1291,8 @@ public:
                                   const map<string, string>& context,
                                   const map<string, string>& status,
                                   const ServantProxyCallbackPtr& callback,
-                                  bool bCoro = false);
+                                  bool bCoro = false,
+                                  Int32 iFuncId = 0);
 
     /**
      * TARS协议异步方法调用
@@ -1250,7 +1303,8 @@ public:
                                   const map<string, string>& context,
                                   const map<string, string>& status,
                                   const ServantProxyCallbackPtr& callback,
-                                  bool bCoro = false);
+                                  bool bCoro = false,
+                                  Int32 iFuncId = 0);
 	/**
 	 * 获取所有objectproxy(包括子servant), 该函数主要给自动测试使用!
 	 * @return
@@ -1316,9 +1370,10 @@ private:
     /**
      * 选取一个网络线程对应的信息
      * @param pSptd
+     * @param bSync, 是否同步调用(分片模式下普通线程的同步调用使用独占通信器)
      * @return void
      */
-    void selectNetThreadInfo(ServantProxyThreadData *pSptd, ObjectProxy *&pObjProxy, shared_ptr<ReqInfoQueue> &pReqQ);
+    void selectNetThreadInfo(ServantProxyThreadData *pSptd, ObjectProxy *&pObjProxy, shared_ptr<ReqInfoQueue> &pReqQ, bool bSync);
     /**
      * 检查是否需要设置染色消息
      * @param  req
@@ -1354,6 +1409,12 @@ private:
      */
     void checkCookie(RequestPacket &req);
 
+    /**
+     * 检查是否需要协商压缩
+     * @param  req
+     */
+    void checkCompress(RequestPacket &req);
+
     /**
      * 关闭连接
      * @param communicatorEpoll
@@ -1410,6 +1471,16 @@ private:
      */
     int                         _connectionSerial = 0;
 
+    /**
+     * 压缩算法, 为空不压缩
+     */
+    string                      _compressCodec;
+
+    /**
+     * 请求包压缩的阈值
+     */
+    size_t                      _compressThreshold = 1024;
+
     /**
      * 短连接使用http使用
      */
@@ -1482,4 +1553,30 @@ private:
 
 
 };
+
+/**
+ * 批量调用的RAII封装: 构造时tars_batch_begin, 析构时tars_batch_flush
+ * 中途抛异常跳过了flush时, 缓存的请求仍然会交给网络线程, 回调正常触发
+ *
+ * {
+ *     ServantProxyBatch batch(prx);
+ *     for(...) prx->async_xxx(cb, ...);
+ * }
+ */
+class SVT_DLL_API ServantProxyBatch
+{
+public:
+    explicit ServantProxyBatch(const ServantPrx &proxy);
+
+    ~ServantProxyBatch();
+
+    /**
+     * 提前提交, 之后析构时不再提交
+     * @return 提交的请求数
+     */
+    size_t flush();
+
+protected:
+    ServantPrx _proxy;
+};
 }
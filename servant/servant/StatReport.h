@@ -17,6 +17,7 @@
 
 #include "util/tc_thread.h"
 #include "util/tc_readers_writer_data.h"
+#include "util/tc_spin_lock.h"
 #include "servant/PropertyReport.h"
 #include "servant/StatF.h"
 #include "servant/PropertyF.h"
@@ -170,6 +171,8 @@ public:
 
          PropertyReportPtr srPtr = new PropertyReportImp<decltype(args)...>(std::forward<Args>(args)...);
 
+         srPtr->setSharded(_sharded);
+
          _statPropMsg[strProperty] = srPtr;
 
          return srPtr;
@@ -191,6 +194,19 @@ public:
      */
     void addStatInterv(int  iInterv);
 
+    /**
+     * 设置分片模式(需要在上报前设置):
+     * 每个线程的调用数据和属性数据先记录到自己的分片, 上报线程每个周期合并一次,
+     * report不再争用StatReport的锁
+     * @param bSharded
+     */
+    void setSharded(bool bSharded) { _sharded = bSharded; }
+
+    /**
+     * 是否分片模式
+     */
+    bool isSharded() const { return _sharded; }
+
     /**
      * 重置关注时间点.
      * @return
@@ -253,6 +269,26 @@ private:
      */
     int reportMicMsg(MapStatMicMsg &msg, bool bFromClient);
 
+    /**
+     * 一次调用数据合并到msg
+     * @param msg
+     * @param head
+     * @param body
+     */
+    void addMicBody(MapStatMicMsg &msg, StatMicMsgHead& head, StatMicMsgBody& body);
+
+    /**
+     * 合并分片里已经汇总过的数据, min/max等和addMicBody的规则一致
+     * @param old
+     * @param add
+     */
+    void mergeMicMsg(MapStatMicMsg &old, MapStatMicMsg &add);
+
+    /**
+     * 分片模式下, 把各线程分片的数据合并到_statMicMsgClient/_statMicMsgServer
+     */
+    void mergeShards();
+
     /**
      * 上报属性信息  Prop = property
      * @return int
@@ -263,6 +299,24 @@ private:
     void addMicMsg(MapStatMicMsg & old, MapStatMicMsg & add);
 
 	friend class CommunicatorEpoll;
+
+    /**
+     * 线程的分片, 只有所属线程和上报线程会加锁, 基本没有竞争
+     */
+    struct StatShard
+    {
+        TC_SpinLock     _lock;
+
+        MapStatMicMsg   _client;
+
+        MapStatMicMsg   _server;
+    };
+
+    /**
+     * 当前线程的分片
+     */
+    StatShard *getShard();
+
 private:
     Communicator*   _communicator;
 
@@ -298,6 +352,13 @@ private:
 
     map<string, PropertyReportPtr>          _statPropMsg;
 
+    uint64_t            _id;
+
+    bool                _sharded;
+
+    vector<shared_ptr<StatShard> >          _shards;
+
+    static std::atomic<uint64_t>            _idGen;
 };
 
 //typedef TC_AutoPtr<StatReport> StatReportPtr;
@@ -43,6 +43,7 @@ namespace tars
             iTimeout = 0;
             context.clear();
             status.clear();
+            iFuncId = 0;
         }
         template<typename WriterT>
         void writeTo(tars::TarsOutputStream<WriterT>& _os) const
@@ -57,6 +58,10 @@ namespace tars
             _os.write(iTimeout, 8);
             _os.write(context, 9);
             _os.write(status, 10);
+            if (iFuncId != 0)
+            {
+                _os.write(iFuncId, 11);
+            }
         }
         template<typename ReaderT>
         void readFrom(tars::TarsInputStream<ReaderT>& _is)
@@ -72,6 +77,7 @@ namespace tars
             _is.read(iTimeout, 8, true);
             _is.read(context, 9, true);
             _is.read(status, 10, true);
+            _is.read(iFuncId, 11, false);
         }
         tars::JsonValueObjPtr writeToJson() const
         {
@@ -86,6 +92,7 @@ namespace tars
             p->value["iTimeout"] = tars::JsonOutput::writeJson(iTimeout);
             p->value["context"] = tars::JsonOutput::writeJson(context);
             p->value["status"] = tars::JsonOutput::writeJson(status);
+            p->value["iFuncId"] = tars::JsonOutput::writeJson(iFuncId);
             return p;
         }
         string writeToJsonString() const
@@ -112,6 +119,7 @@ namespace tars
             tars::JsonInput::readJson(iTimeout,pObj->value["iTimeout"], true);
             tars::JsonInput::readJson(context,pObj->value["context"], true);
             tars::JsonInput::readJson(status,pObj->value["status"], true);
+            tars::JsonInput::readJson(iFuncId,pObj->value["iFuncId"], false);
         }
         void readFromJsonString(const string & str)
         {
@@ -130,6 +138,7 @@ namespace tars
             _ds.display(iTimeout,"iTimeout");
             _ds.display(context,"context");
             _ds.display(status,"status");
+            _ds.display(iFuncId,"iFuncId");
             return _os;
         }
         ostream& displaySimple(ostream& _os, int _level=0) const
@@ -144,7 +153,8 @@ namespace tars
             _ds.displaySimple(sBuffer, true);
             _ds.displaySimple(iTimeout, true);
             _ds.displaySimple(context, true);
-            _ds.displaySimple(status, false);
+            _ds.displaySimple(status, true);
+            _ds.displaySimple(iFuncId, false);
             return _os;
         }
     public:
@@ -158,10 +168,11 @@ namespace tars
         tars::Int32 iTimeout;
         map<std::string, std::string> context;
         map<std::string, std::string> status;
+        tars::Int32 iFuncId;
     };
     inline bool operator==(const RequestPacket&l, const RequestPacket&r)
     {
-        return l.iVersion == r.iVersion && l.cPacketType == r.cPacketType && l.iMessageType == r.iMessageType && l.iRequestId == r.iRequestId && l.sServantName == r.sServantName && l.sFuncName == r.sFuncName && l.sBuffer == r.sBuffer && l.iTimeout == r.iTimeout && l.context == r.context && l.status == r.status;
+        return l.iVersion == r.iVersion && l.cPacketType == r.cPacketType && l.iMessageType == r.iMessageType && l.iRequestId == r.iRequestId && l.sServantName == r.sServantName && l.sFuncName == r.sFuncName && l.sBuffer == r.sBuffer && l.iTimeout == r.iTimeout && l.context == r.context && l.status == r.status && l.iFuncId == r.iFuncId;
     }
     inline bool operator!=(const RequestPacket&l, const RequestPacket&r)
     {
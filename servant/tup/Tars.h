@@ -47,6 +47,14 @@
     #include "tup/TarsType.h"
 #endif
 
+#ifdef __APPLE__
+#include "TarsArena.h"
+#elif defined ANDROID  // android
+#include "TarsArena.h"
+#else
+    #include "tup/TarsArena.h"
+#endif
+
 
 #ifndef tars_likely
 #if defined(__GNUC__) && __GNUC__ >= 4
@@ -936,12 +944,7 @@ public:
 	/// 跳到当前结构的结束
 	void skipToStructEnd()
 	{
-		uint8_t headType = 0;
-		do
-		{
-			readFromHeadNoTag(*this, headType);
-			skipField(headType);
-		}while (headType != TarsHeadeStructEnd);
+		ReaderT::_cur = skipFieldBuf(ReaderT::_buf + ReaderT::_cur, ReaderT::_buf + ReaderT::_buf_len, TarsHeadeStructBegin) - ReaderT::_buf;
 	}
 
 	/// 跳过一个字段
@@ -955,78 +958,83 @@ public:
 	/// 跳过一个字段，不包含头信息
 	void skipField(uint8_t type)
 	{
+		ReaderT::_cur = skipFieldBuf(ReaderT::_buf + ReaderT::_cur, ReaderT::_buf + ReaderT::_buf_len, type) - ReaderT::_buf;
+	}
+
+	/**
+	 * 直接在缓冲区上跳过一个字段(不包含头信息), 返回字段结束的位置
+	 * 定长类型查表, 变长类型每段只做一次边界检查, 不经过readBuf/read(size, 0)
+	 */
+	static const char *skipFieldBuf(const char *p, const char *end, uint8_t type)
+	{
+		//各类型值的长度, -1为变长
+		static const int8_t fixedSize[16] = { 1, 2, 4, 8, 4, 8, -1, -1, -1, -1, -1, 0, 0, -1, -1, -1 };
+
+		int8_t n = fixedSize[type & 0x0F];
+		if (tars_likely(n >= 0))
+		{
+			checkBuf(p, end, n);
+			return p + n;
+		}
+
 		switch (type)
 		{
-			case TarsHeadeChar:
-				TarsReadHeadSkip(*this, sizeof(Char));
-				break;
-			case TarsHeadeShort:
-				TarsReadHeadSkip(*this, sizeof(Short));
-				break;
-			case TarsHeadeInt32:
-				TarsReadHeadSkip(*this, sizeof(Int32));
-				break;
-			case TarsHeadeInt64:
-				TarsReadHeadSkip(*this, sizeof(Int64));
-				break;
-			case TarsHeadeFloat:
-				TarsReadHeadSkip(*this, sizeof(Float));
-				break;
-			case TarsHeadeDouble:
-				TarsReadHeadSkip(*this, sizeof(Double));
-				break;
 			case TarsHeadeString1:
 			{
-				size_t len = 0;
-				TarsReadTypeBuf(*this, len, uint8_t);
-				TarsReadHeadSkip(*this, len);
+				checkBuf(p, end, 1);
+				size_t len = (uint8_t)*p;
+				checkBuf(++p, end, len);
+				return p + len;
 			}
-				break;
 			case TarsHeadeString4:
 			{
-				uint32_t len = 0;
-				TarsReadTypeBuf(*this, len, uint32_t);
-				len = ntohl((uint32_t)len);
-				TarsReadHeadSkip(*this, len);
+				checkBuf(p, end, 4);
+				uint32_t len;
+				::memcpy(&len, p, sizeof(len));
+				len = ntohl(len);
+				p += sizeof(len);
+				checkBuf(p, end, len);
+				return p + len;
 			}
-				break;
 			case TarsHeadeMap:
-			{
-				UInt32 size = 0;
-				read(size, 0);
-				for (UInt32 i = 0; i < size * 2; ++i)
-					skipField();
-			}
-				break;
 			case TarsHeadeList:
 			{
 				UInt32 size = 0;
-				read(size, 0);
-				for (UInt32 i = 0; i < size; ++i)
-					skipField();
+				p = readSizeBuf(p, end, size);
+				//每个元素至少有一个字节的头
+				uint64_t count = (type == TarsHeadeMap) ? (uint64_t)size * 2 : size;
+				checkBuf(p, end, count);
+				uint8_t headType;
+				for (uint64_t i = 0; i < count; ++i)
+				{
+					p = skipNextBuf(p, end, headType);
+				}
+				return p;
 			}
-				break;
 			case TarsHeadeSimpleList:
 			{
-				uint8_t headType = 0, headTag = 0;
-				readFromHead(*this, headType, headTag);
+				uint8_t headType;
+				p = skipHeadBuf(p, end, headType);
 				if (tars_unlikely(headType != TarsHeadeChar))
 				{
 					char s[64];
-					snprintf(s, sizeof(s), "skipField with invalid type, type value: %d, %d, %d.", type, headType, headTag);
+					snprintf(s, sizeof(s), "skipField with invalid type, type value: %d, %d.", type, headType);
 					throw TarsDecodeMismatch(s);
 				}
 				UInt32 size = 0;
-				read(size, 0);
-				TarsReadHeadSkip(*this, size);
+				p = readSizeBuf(p, end, size);
+				checkBuf(p, end, size);
+				return p + size;
 			}
-				break;
 			case TarsHeadeStructBegin:
-				skipToStructEnd();
-				break;
-			case TarsHeadeStructEnd:
-			case TarsHeadeZeroTag:
-				break;
+			{
+				uint8_t headType;
+				do
+				{
+					p = skipNextBuf(p, end, headType);
+				} while (headType != TarsHeadeStructEnd);
+				return p;
+			}
 			default:
 			{
 				char s[64];
@@ -1036,6 +1044,108 @@ public:
 		}
 	}
 
+protected:
+	/// 跳过一个字段(包含头信息), 定长类型和短字符串不走递归
+	static const char *skipNextBuf(const char *p, const char *end, uint8_t &type)
+	{
+		//各类型值的长度, -1为变长, -2为String1(长度在第一个字节)
+		static const int8_t stepSize[16] = { 1, 2, 4, 8, 4, 8, -2, -1, -1, -1, -1, 0, 0, -1, -1, -1 };
+
+		checkBuf(p, end, 1);
+		uint8_t h = (uint8_t)*p;
+		type = h & 0x0F;
+		p += ((h >> 4) == 15) ? 2 : 1;
+
+		int8_t n = stepSize[type];
+		if (tars_likely(n != -1))
+		{
+			//定长类型和短字符串统一计算长度, 减少类型交替时的分支预测失败
+			size_t len = (n == -2) ? (size_t)1 + (uint8_t)(p < end ? *p : 0) : (size_t)n;
+			checkBuf(p, end, len);
+			return p + len;
+		}
+		return skipFieldBuf(p, end, type);
+	}
+
+	static void checkBuf(const char *p, const char *end, uint64_t len)
+	{
+		if (tars_unlikely(p > end || (uint64_t)(end - p) < len))
+		{
+			char s[64];
+			snprintf(s, sizeof(s), "buffer overflow when skip, over %u.", (uint32_t)len);
+			throw TarsDecodeException(s);
+		}
+	}
+
+	/// 跳过头信息, 返回类型
+	static const char *skipHeadBuf(const char *p, const char *end, uint8_t &type)
+	{
+		checkBuf(p, end, 1);
+		type = (uint8_t)*p & 0x0F;
+		if (tars_unlikely(((uint8_t)*p >> 4) == 15))
+		{
+			checkBuf(p, end, 2);
+			return p + 2;
+		}
+		return p + 1;
+	}
+
+	/// 读取map/list的长度, 长度的tag必须是0
+	static const char *readSizeBuf(const char *p, const char *end, UInt32 &size)
+	{
+		checkBuf(p, end, 1);
+		uint8_t type = (uint8_t)*p & 0x0F;
+		if (tars_unlikely(((uint8_t)*p >> 4) != 0))
+		{
+			char s[64];
+			snprintf(s, sizeof(s), "require field not exist, tag: 0, headTag: %d", ((uint8_t)*p >> 4));
+			throw TarsDecodeRequireNotExist(s);
+		}
+		++p;
+
+		switch (type)
+		{
+			case TarsHeadeZeroTag:
+				size = 0;
+				return p;
+			case TarsHeadeChar:
+				checkBuf(p, end, sizeof(Char));
+				size = (UInt32)(Char)*p;
+				return p + sizeof(Char);
+			case TarsHeadeShort:
+			{
+				Short n;
+				checkBuf(p, end, sizeof(n));
+				::memcpy(&n, p, sizeof(n));
+				size = (UInt32)(Short)ntohs(n);
+				return p + sizeof(n);
+			}
+			case TarsHeadeInt32:
+			{
+				Int32 n;
+				checkBuf(p, end, sizeof(n));
+				::memcpy(&n, p, sizeof(n));
+				size = (UInt32)(Int32)ntohl(n);
+				return p + sizeof(n);
+			}
+			case TarsHeadeInt64:
+			{
+				Int64 n;
+				checkBuf(p, end, sizeof(n));
+				::memcpy(&n, p, sizeof(n));
+				size = (UInt32)tars_ntohll(n);
+				return p + sizeof(n);
+			}
+			default:
+			{
+				char s[64];
+				snprintf(s, sizeof(s), "read 'Int64' type mismatch, tag: 0, get type: %d.", type);
+				throw TarsDecodeMismatch(s);
+			}
+		}
+	}
+
+public:
 	/// 读取一个指定类型的数据（基本类型）
 	template<typename T>
 	inline T readByType()
@@ -1324,7 +1434,8 @@ public:
 		}
 	}
 
-	void read(std::string& s, uint8_t tag, bool isRequire = true)
+	template<typename Traits, typename Alloc>
+	void read(std::basic_string<char, Traits, Alloc>& s, uint8_t tag, bool isRequire = true)
 	{
 		uint8_t headType = 0, headTag = 0;
 		bool skipFlag = false;
@@ -1445,7 +1556,7 @@ public:
 						std::pair<K, V> pr;
 						read(pr.first, 0);
 						read(pr.second, 1);
-						m.insert(pr);
+						m.insert(std::move(pr));
 					}
 				}
 					break;
@@ -1492,7 +1603,7 @@ public:
 						std::pair<K, V> pr;
 						read(pr.first, 0);
 						read(pr.second, 1);
-						m.insert(pr);
+						m.insert(std::move(pr));
 					}
 				}
 					break;
@@ -1679,6 +1790,57 @@ public:
 		}
 	}
 
+	/**
+	 * 读取vector<char>字段, 不copy数据, 返回字段在输入buffer中的地址和长度
+	 * 只支持SimpleList编码(vector<char>的标准编码), 其他编码抛TarsDecodeMismatch, 调用者可回退到read
+	 * 字段不存在时, data=NULL, len=0
+	 */
+	void readView(const char *&data, size_t &len, uint8_t tag, bool isRequire = true)
+	{
+		data = NULL;
+		len = 0;
+
+		uint8_t headType = 0, headTag = 0;
+		bool skipFlag = false;
+		TarsSkipToTag(skipFlag, tag, headType, headTag);
+		if (tars_likely(skipFlag))
+		{
+			uint8_t hheadType, hheadTag;
+			if (tars_unlikely(headType != TarsHeadeSimpleList))
+			{
+				char s[128];
+				snprintf(s, sizeof(s), "type mismatch, tag: %d, type: %d", tag, headType);
+				throw TarsDecodeMismatch(s);
+			}
+			readFromHead(*this, hheadType, hheadTag);
+			if (tars_unlikely(hheadType != TarsHeadeChar))
+			{
+				char s[128];
+				snprintf(s, sizeof(s), "type mismatch, tag: %d, type: %d, %d, %d", tag, headType, hheadType, hheadTag);
+				throw TarsDecodeMismatch(s);
+			}
+			UInt32 size = 0;
+			read(size, 0);
+			if (tars_unlikely(size > this->size()))
+			{
+				char s[128];
+				snprintf(s, sizeof(s), "invalid size, tag: %d, type: %d, %d, size: %d", tag, headType, hheadType, size);
+				throw TarsDecodeInvalidValue(s);
+			}
+
+			data = this->base() + this->tellp();
+			len = size;
+
+			this->skip(size);
+		}
+		else if (tars_unlikely(isRequire))
+		{
+			char s[128];
+			snprintf(s, sizeof(s), "require field not exist, tag: %d, headTag: %d", tag, headTag);
+			throw TarsDecodeRequireNotExist(s);
+		}
+	}
+
 	template<typename T, typename Alloc>
 	void read(std::vector<T, Alloc>& v, uint8_t tag, bool isRequire = true)
 	{
@@ -2161,27 +2323,38 @@ public:
 
 	void write(const std::string& s, uint8_t tag)
 	{
-		if (tars_unlikely(s.size() > 255))
+		writeString(s.data(), s.size(), tag);
+	}
+
+	template<typename Traits, typename Alloc>
+	void write(const std::basic_string<char, Traits, Alloc>& s, uint8_t tag)
+	{
+		writeString(s.data(), s.size(), tag);
+	}
+
+	void writeString(const char *str, size_t len, uint8_t tag)
+	{
+		if (tars_unlikely(len > 255))
 		{
-			if (tars_unlikely(s.size() > TARS_MAX_STRING_LENGTH))
+			if (tars_unlikely(len > TARS_MAX_STRING_LENGTH))
 			{
 				char ss[128];
-				snprintf(ss, sizeof(ss), "invalid string size, tag: %d, size: %u", tag, (uint32_t)s.size());
+				snprintf(ss, sizeof(ss), "invalid string size, tag: %d, size: %u", tag, (uint32_t)len);
 				throw TarsDecodeInvalidValue(ss);
 			}
 			TarsWriteToHead(*this, TarsHeadeString4, tag);
-			uint32_t n = htonl((uint32_t)s.size());
+			uint32_t n = htonl((uint32_t)len);
 			TarsWriteUInt32TTypeBuf(*this, n, (*this)._len);
 
-			TarsWriteTypeBuf(*this, s.data(), s.size());
+			TarsWriteTypeBuf(*this, str, len);
 		}
 		else
 		{
 			TarsWriteToHead(*this, TarsHeadeString1, tag);
-			uint8_t n = (uint8_t)s.size();
+			uint8_t n = (uint8_t)len;
 			TarsWriteUInt8TTypeBuf(*this, n, (*this)._len);
 
-			TarsWriteTypeBuf(*this, s.data(), s.size());
+			TarsWriteTypeBuf(*this, str, len);
 		}
 	}
 
@@ -2357,6 +2530,27 @@ public:
 		TarsWriteToHead(*this, TarsHeadeStructEnd, 0);
 	}
 };
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * 函数名对应的id(FNV-1a), 用于RequestPacket::iFuncId, 客户端和服务端(tars2cpp --hash-dispatch)必须一致
+ * 不会返回0(0表示没有id)
+ */
+inline Int32 tarsFuncId(const char *name, size_t length)
+{
+	UInt32 h = 2166136261u;
+	for (size_t i = 0; i < length; ++i)
+	{
+		h ^= (unsigned char)name[i];
+		h *= 16777619u;
+	}
+	return (Int32)(h == 0 ? 1 : h);
+}
+
+inline Int32 tarsFuncId(const std::string &name)
+{
+	return tarsFuncId(name.data(), name.size());
+}
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 }
 
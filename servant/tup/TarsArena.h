@@ -0,0 +1,303 @@
+﻿/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except 
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed 
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR 
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the 
+ * specific language governing permissions and limitations under the License.
+ */
+
+#ifndef __TARS_ARENA_H__
+#define __TARS_ARENA_H__
+
+#include <vector>
+#include <map>
+#include <string>
+#include <memory>
+#include <new>
+#include <limits>
+#include <type_traits>
+#include <stddef.h>
+#include <stdlib.h>
+
+namespace tars
+{
+//////////////////////////////////////////////////////////////////////
+/**
+ * 解码用的单调内存池: 只分配不单独释放, reset/析构时整体回收
+ * 大结构(map<string, vector<string> >之类)解码时每个string/vector元素都要malloc一次,
+ * 用arena后这些分配都变成在块内移动指针
+ *
+ * 用法:
+ *   TarsArena arena;
+ *   {
+ *       TarsArena::Scope scope(arena);
+ *       Rsp rsp;                    //成员类型是TarsArenaString/TarsArenaVector/TarsArenaMap
+ *       rsp.readFrom(is);
+ *       ...
+ *   }
+ *   arena.reset();                  //rsp已经析构, 块保留下来给下一个请求用
+ *
+ * Scope范围内默认构造的TarsArenaAllocator都从当前arena分配, 所以容器最好也在Scope内构造;
+ * Scope外拷贝出来的数据走普通的堆分配, 不依赖arena的生命周期
+ * 非线程安全, 一个线程/请求一个arena
+ */
+class TarsArena
+{
+public:
+	/**
+	 * @param blockSize, 每次向系统申请的块大小
+	 */
+	explicit TarsArena(size_t blockSize = 16 * 1024)
+	: _blockSize(blockSize < 256 ? 256 : blockSize)
+	, _index(0)
+	, _allocated(0)
+	{
+	}
+
+	~TarsArena()
+	{
+		release();
+	}
+
+	/**
+	 * 分配内存
+	 * @param n
+	 * @param align
+	 * @return void*
+	 */
+	void *allocate(size_t n, size_t align = sizeof(void*))
+	{
+		_allocated += n;
+
+		//大块单独申请, 避免浪费当前块
+		if (n + align > _blockSize / 2)
+		{
+			Block *b = newBlock(n + align);
+			_large.push_back(b);
+			b->used = n + align;
+			return alignUp(b->data(), align);
+		}
+
+		for (;;)
+		{
+			if (_index < _blocks.size())
+			{
+				Block *b = _blocks[_index];
+				char *p = alignUp(b->data() + b->used, align);
+				if (p + n <= b->data() + b->size)
+				{
+					b->used = p + n - b->data();
+					return p;
+				}
+				++_index;
+			}
+			else
+			{
+				_blocks.push_back(newBlock(_blockSize));
+			}
+		}
+	}
+
+	/**
+	 * 回收所有已分配的内存, 普通块保留下来复用, 大块释放
+	 * 调用前必须保证从arena分配的对象都不再使用
+	 */
+	void reset()
+	{
+		for (size_t i = 0; i < _blocks.size(); i++)
+		{
+			_blocks[i]->used = 0;
+		}
+		for (size_t i = 0; i < _large.size(); i++)
+		{
+			::free(_large[i]);
+		}
+		_large.clear();
+		_index = 0;
+		_allocated = 0;
+	}
+
+	/**
+	 * 释放所有内存
+	 */
+	void release()
+	{
+		reset();
+		for (size_t i = 0; i < _blocks.size(); i++)
+		{
+			::free(_blocks[i]);
+		}
+		_blocks.clear();
+	}
+
+	/**
+	 * 自上次reset以来分配出去的字节数
+	 */
+	size_t allocated() const { return _allocated; }
+
+	/**
+	 * 向系统申请的块数(包括大块)
+	 */
+	size_t blockCount() const { return _blocks.size() + _large.size(); }
+
+	/**
+	 * 当前线程正在使用的arena, 没有则为NULL
+	 */
+	static TarsArena *current() { return currentRef(); }
+
+	/**
+	 * 在作用域内把arena设置为当前线程的arena, 可以嵌套
+	 */
+	class Scope
+	{
+	public:
+		explicit Scope(TarsArena &arena) : _prev(currentRef()) { currentRef() = &arena; }
+		~Scope() { currentRef() = _prev; }
+
+	private:
+		Scope(const Scope &);
+		Scope &operator=(const Scope &);
+
+		TarsArena *_prev;
+	};
+
+protected:
+	struct Block
+	{
+		size_t  size;
+		size_t  used;
+
+		char *data() { return (char*)(this + 1); }
+	};
+
+	static Block *newBlock(size_t size)
+	{
+		Block *b = (Block*)::malloc(sizeof(Block) + size);
+		if (b == NULL)
+		{
+			throw std::bad_alloc();
+		}
+		b->size = size;
+		b->used = 0;
+		return b;
+	}
+
+	static char *alignUp(char *p, size_t align)
+	{
+		return (char*)(((size_t)p + align - 1) & ~(align - 1));
+	}
+
+	static TarsArena *&currentRef()
+	{
+		static thread_local TarsArena *arena = NULL;
+		return arena;
+	}
+
+private:
+	TarsArena(const TarsArena &);
+	TarsArena &operator=(const TarsArena &);
+
+protected:
+	size_t              _blockSize;
+	std::vector<Block*> _blocks;
+	std::vector<Block*> _large;
+	size_t              _index;
+	size_t              _allocated;
+};
+
+//////////////////////////////////////////////////////////////////////
+/**
+ * 从TarsArena分配的stl分配器
+ * 默认构造时绑定当前线程的arena(TarsArena::Scope), 没有arena时退化为普通的new/delete
+ * 拷贝构造容器时重新绑定当前线程的arena, 因此在Scope外拷贝出来的数据不会引用arena
+ */
+template<typename T>
+class TarsArenaAllocator
+{
+public:
+	typedef T               value_type;
+	typedef T*              pointer;
+	typedef const T*        const_pointer;
+	typedef T&              reference;
+	typedef const T&        const_reference;
+	typedef size_t          size_type;
+	typedef ptrdiff_t       difference_type;
+
+	typedef std::false_type propagate_on_container_copy_assignment;
+	typedef std::true_type  propagate_on_container_move_assignment;
+	typedef std::true_type  propagate_on_container_swap;
+
+	template<typename U>
+	struct rebind
+	{
+		typedef TarsArenaAllocator<U> other;
+	};
+
+	TarsArenaAllocator() : _arena(TarsArena::current()) {}
+
+	explicit TarsArenaAllocator(TarsArena *arena) : _arena(arena) {}
+
+	template<typename U>
+	TarsArenaAllocator(const TarsArenaAllocator<U> &a) : _arena(a.arena()) {}
+
+	T *allocate(size_t n, const void * = 0)
+	{
+		if (_arena)
+		{
+			return (T*)_arena->allocate(n * sizeof(T), alignof(T));
+		}
+		return (T*)::operator new(n * sizeof(T));
+	}
+
+	void deallocate(T *p, size_t)
+	{
+		if (!_arena)
+		{
+			::operator delete(p);
+		}
+	}
+
+	size_t max_size() const { return std::numeric_limits<size_t>::max() / sizeof(T); }
+
+	template<typename U, typename... Args>
+	void construct(U *p, Args&&... args) { ::new((void*)p) U(std::forward<Args>(args)...); }
+
+	template<typename U>
+	void destroy(U *p) { p->~U(); }
+
+	TarsArenaAllocator select_on_container_copy_construction() const { return TarsArenaAllocator(); }
+
+	TarsArena *arena() const { return _arena; }
+
+protected:
+	TarsArena *_arena;
+};
+
+template<typename T, typename U>
+inline bool operator==(const TarsArenaAllocator<T> &a, const TarsArenaAllocator<U> &b) { return a.arena() == b.arena(); }
+
+template<typename T, typename U>
+inline bool operator!=(const TarsArenaAllocator<T> &a, const TarsArenaAllocator<U> &b) { return a.arena() != b.arena(); }
+
+/**
+ * tars2cpp --arena生成的结构体使用的类型
+ */
+typedef std::basic_string<char, std::char_traits<char>, TarsArenaAllocator<char> > TarsArenaString;
+
+template<typename T>
+using TarsArenaVector = std::vector<T, TarsArenaAllocator<T> >;
+
+template<typename K, typename V, typename Cmp = std::less<K> >
+using TarsArenaMap = std::map<K, V, Cmp, TarsArenaAllocator<std::pair<const K, V> > >;
+
+}
+
+#endif
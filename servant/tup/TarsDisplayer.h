@@ -135,6 +135,15 @@ public:
         return *this;
     }
 
+    template <typename Traits, typename Alloc>
+    TarsDisplayer& display(const std::basic_string<char, Traits, Alloc>& s, const char * fieldName)
+    {
+        ps(fieldName);
+        _os.write(s.data(), s.size());
+        _os << std::endl;
+        return *this;
+    }
+
     TarsDisplayer& display(const char *s, const size_t len, const char * fieldName)
     {
         ps(fieldName);
@@ -283,6 +292,14 @@ public:
         return *this;
     }
 
+    template <typename Traits, typename Alloc>
+    TarsDisplayer& displaySimple(const std::basic_string<char, Traits, Alloc>& n, bool bSep)
+    {
+        _os.write(n.data(), n.size());
+        _os << (bSep ? "|" : "");
+        return *this;
+    }
+
     TarsDisplayer& displaySimple(const char * n, const size_t len, bool bSep)
     {
         for(unsigned i=0;i< len; i++) {
@@ -33,6 +33,9 @@ void usage()
     cout << "  --tarsMaster                                create get registry info interface" << endl;
     cout << "  --currentPriority						   use current path first." << endl;
     cout << "  --without-trace                             不需要调用链追踪逻辑" << endl;
+    cout << "  --hash-dispatch                             按函数名hash(函数id)分发, 替代函数名查找" << endl;
+    cout << "                                              (命中后仍比较一次函数名, 函数名和id不一致的请求返回TARSSERVERNOFUNCERR)" << endl;
+    cout << "  --arena                                     结构体的string/vector/map使用TarsArena分配器(不生成json/xml/sql)" << endl;
     cout << "  tars2cpp support type: bool byte short int long float double vector map" << endl;
     exit(0);
 }
@@ -128,6 +131,9 @@ int main(int argc, char* argv[])
         t2c.setTrace(true);
     }
 
+    // 按函数id分发
+    t2c.setHashDispatch(option.hasParam("hash-dispatch"));
+
     if (option.hasParam("xml"))
     {
         vector<string> vXmlIntf;
@@ -151,6 +157,15 @@ int main(int argc, char* argv[])
     //     }
     // }
 
+    // arena分配器的类型没有json/xml/sql的编解码
+    if (option.hasParam("arena"))
+    {
+        t2c.setArena(true);
+        t2c.setJsonSupport(false);
+        t2c.setSqlSupport(false);
+        t2c.setXmlSupport(false, vector<string>());
+    }
+
     t2c.setTarsMaster(option.hasParam("tarsMaster"));
 
     try
@@ -37,6 +37,8 @@ Tars2Cpp::Tars2Cpp()
 // , _unknownField(false)
 , _tarsMaster(false)
 , _bTrace(true)
+, _bHashDispatch(false)
+, _bArena(false)
 {
 
 }
@@ -684,6 +686,29 @@ string Tars2Cpp::MD5(const StructPtr& pPtr) const
     return "\"" + tars::TC_MD5::md5str(s) + "\"";
 }
 
+string Tars2Cpp::tostrArena(const TypePtr& pPtr) const
+{
+    BuiltinPtr bPtr = BuiltinPtr::dynamicCast(pPtr);
+    if (bPtr && bPtr->kind() == Builtin::KindString && !bPtr->isArray())
+    {
+        return _namespace + "::TarsArenaString";
+    }
+
+    VectorPtr vPtr = VectorPtr::dynamicCast(pPtr);
+    if (vPtr && !vPtr->isArray() && !vPtr->isPointer())
+    {
+        return _namespace + "::TarsArenaVector<" + tostrArena(vPtr->getTypePtr()) + " >";
+    }
+
+    MapPtr mPtr = MapPtr::dynamicCast(pPtr);
+    if (mPtr)
+    {
+        return _namespace + "::TarsArenaMap<" + tostrArena(mPtr->getLeftTypePtr()) + ", " + tostrArena(mPtr->getRightTypePtr()) + " >";
+    }
+
+    return tostr(pPtr);
+}
+
 /////////////////////////////////////////////////////////////////////
 string Tars2Cpp::tostrEnum(const EnumPtr& pPtr) const
 {
@@ -1100,7 +1125,7 @@ string Tars2Cpp::generateH(const StructPtr& pPtr, const string& namespaceId) con
         {
             s << TAB << _namespace + "::" << "UInt32 " << member[j]->getId() << "Len" << ";" << endl;
         }
-        s << TAB << tostr(member[j]->getTypePtr()) << " " << member[j]->getId() << toStrSuffix(member[j]) << ";" << endl;
+        s << TAB << (_bArena ? tostrArena(member[j]->getTypePtr()) : tostr(member[j]->getTypePtr())) << " " << member[j]->getId() << toStrSuffix(member[j]) << ";" << endl;
 
     }
 
@@ -1698,11 +1723,98 @@ string Tars2Cpp::generateInitValue(const TypeIdPtr& pPtr) const
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////
+int32_t Tars2Cpp::funcId(const string &name)
+{
+    //FNV-1a, 必须和Tars.h中的tarsFuncId一致
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < name.size(); ++i)
+    {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return (int32_t)(h == 0 ? 1 : h);
+}
+
+bool Tars2Cpp::isHashDispatch(const InterfacePtr &pPtr) const
+{
+    if (!_bHashDispatch)
+    {
+        return false;
+    }
+
+    vector<OperationPtr>& vOperation = pPtr->getAllOperationPtr();
+
+    map<int32_t, string> ids;
+    for (size_t i = 0; i < vOperation.size(); i++)
+    {
+        int32_t id = funcId(vOperation[i]->getId());
+
+        auto it = ids.find(id);
+        if (it != ids.end())
+        {
+            cerr << "[warn] " << pPtr->getId() << ": function id conflict between " << it->second << " and " << vOperation[i]->getId() << ", dispatch by function name" << endl;
+            return false;
+        }
+        ids[id] = vOperation[i]->getId();
+    }
+
+    return true;
+}
+
+string Tars2Cpp::generateFuncIdArg(const OperationPtr &pPtr) const
+{
+    if (!_bHashDispatch)
+    {
+        return "";
+    }
+
+    return ", " + tars::TC_Common::tostr(funcId(pPtr->getId()));
+}
+
+string Tars2Cpp::generateHashDispatch(const InterfacePtr &pPtr, const string &funcName, const string &funcId, string (Tars2Cpp::*dispatch)(const OperationPtr &, const string &) const) const
+{
+    ostringstream s;
+
+    vector<OperationPtr>& vOperation = pPtr->getAllOperationPtr();
+
+    s << TAB << "const ::std::string &_funcName_ = " << funcName << ";" << endl;
+    s << TAB << "tars::Int32 _funcId_ = " << funcId << ";" << endl;
+    //对方没有带函数id时用函数名计算
+    s << TAB << "if(_funcId_ == 0) _funcId_ = tars::tarsFuncId(_funcName_);" << endl;
+
+    s << TAB << "switch(_funcId_)" << endl;
+    s << TAB << "{" << endl;
+    INC_TAB;
+
+    for (size_t i = 0; i < vOperation.size(); i++)
+    {
+        s << TAB << "case " << Tars2Cpp::funcId(vOperation[i]->getId()) << ": //" << vOperation[i]->getId() << endl;
+        s << TAB << "{" << endl;
+        INC_TAB;
+
+        //函数名和id不一致(hash冲突或者错误的请求)时不分发, 避免按错误的函数名处理和上报
+        s << TAB << "if(_funcName_ != \"" << vOperation[i]->getId() << "\") return tars::TARSSERVERNOFUNCERR;" << endl;
+
+        s << (this->*dispatch)(vOperation[i], pPtr->getId()) << endl;
+
+        DEL_TAB;
+        s << TAB << "}" << endl;
+    }
+
+    DEL_TAB;
+    s << TAB << "}" << endl;
+
+    s << TAB << "return tars::TARSSERVERNOFUNCERR;" << endl;
+
+    return s.str();
+}
+
 string Tars2Cpp::generateServantDispatch(const OperationPtr& pPtr, const string& cn) const
 {
     ostringstream s;
     s << TAB << _namespace + "::TarsInputStream<" + _namespace + "::BufferReader> _is;" << endl;
-    s << TAB << "_is.setBuffer(_current->getRequestBuffer());" << endl;
+    s << TAB << "std::pair<const char*, size_t> _requestData_ = _current->getRequestData();" << endl;
+    s << TAB << "_is.setBuffer(_requestData_.first, _requestData_.second);" << endl;
 
     vector<ParamDeclPtr>& vParamDecl = pPtr->getAllParamDeclPtr();
 
@@ -2221,7 +2333,7 @@ string Tars2Cpp::generateHAsync(const OperationPtr& pPtr, const string& cn) cons
         s << TAB << "}" << endl;
     }
 
-    s << TAB << "tars_invoke_async(tars::TARSNORMAL,\"" << pPtr->getId() << "\", _os, context, _mStatus, callback);" << endl;
+    s << TAB << "tars_invoke_async(tars::TARSNORMAL,\"" << pPtr->getId() << "\", _os, context, _mStatus, callback" << (_bHashDispatch ? ", false" + generateFuncIdArg(pPtr) : "") << ");" << endl;
     DEL_TAB;
     s << TAB << "}" << endl;
     s << TAB << endl;
@@ -2265,13 +2377,40 @@ string Tars2Cpp::generateHAsync(const OperationPtr& pPtr, const string& cn) cons
         s << TAB << "_mStatus.insert(std::make_pair(ServantProxy::STATUS_GRID_KEY, " << os.str() << "));" << endl;
     }
 
-    s << TAB << "tars_invoke_async(tars::TARSNORMAL,\"" << pPtr->getId() << "\", _os, context, _mStatus, callback);" << endl;
+    s << TAB << "tars_invoke_async(tars::TARSNORMAL,\"" << pPtr->getId() << "\", _os, context, _mStatus, callback" << (_bHashDispatch ? ", false" + generateFuncIdArg(pPtr) : "") << ");" << endl;
     s << endl;
     s << TAB << "return promise.getFuture();" << endl;
     DEL_TAB;
     s << TAB << "}" << endl;
     s << endl;
 
+    //C++20协程(co_await)的函数声明, 返回的Future在协程里直接co_await
+    s << "#ifdef TARS_CO_AWAIT" << endl;
+    s << TAB << "tars::Future< " << cn <<"PrxCallbackPromise::Promise" << sStruct << "Ptr > co_" << pPtr->getId() << "(";
+    for(size_t i = 0; i < vParamDecl.size(); i++)
+    {
+        if (!vParamDecl[i]->isOut())
+        {
+            s << generateParamDecl(vParamDecl[i]) << ",";
+        }
+    }
+    s << "const map<string, string>& context = TARS_CONTEXT())" << endl;
+    s << TAB << "{" << endl;
+    INC_TAB;
+    s << TAB << "return promise_async_" << pPtr->getId() << "(";
+    for(size_t i = 0; i < vParamDecl.size(); i++)
+    {
+        if (!vParamDecl[i]->isOut())
+        {
+            s << vParamDecl[i]->getTypeIdPtr()->getId() << ", ";
+        }
+    }
+    s << "context);" << endl;
+    DEL_TAB;
+    s << TAB << "}" << endl;
+    s << "#endif" << endl;
+    s << endl;
+
     //协程并行异步的函数声明
     s << TAB << "void coro_" << pPtr->getId() << "(";
     s << cn << "CoroPrxCallbackPtr callback,";
@@ -2315,7 +2454,7 @@ string Tars2Cpp::generateHAsync(const OperationPtr& pPtr, const string& cn) cons
         s << TAB << "_mStatus.insert(std::make_pair(ServantProxy::STATUS_GRID_KEY, " << os.str() << "));" << endl;
     }
 
-    s << TAB << "tars_invoke_async(tars::TARSNORMAL,\"" << pPtr->getId() << "\", _os, context, _mStatus, callback, true);" << endl;
+    s << TAB << "tars_invoke_async(tars::TARSNORMAL,\"" << pPtr->getId() << "\", _os, context, _mStatus, callback, true" << generateFuncIdArg(pPtr) << ");" << endl;
     DEL_TAB;
     s << TAB << "}" << endl;
 
@@ -2434,7 +2573,7 @@ string Tars2Cpp::generateH(const OperationPtr& pPtr, bool bVirtual, const string
         }
 
         // s << TAB << "tars_invoke(tars::TARSNORMAL,\"" << pPtr->getId() << "\", _os.getByteBuffer(), context, _mStatus, rep);" << endl;
-        s << TAB << "shared_ptr<" + _namespace + "::ResponsePacket> rep = tars_invoke(tars::TARSNORMAL,\"" << pPtr->getId() << "\", _os, context, _mStatus);" << endl;
+        s << TAB << "shared_ptr<" + _namespace + "::ResponsePacket> rep = tars_invoke(tars::TARSNORMAL,\"" << pPtr->getId() << "\", _os, context, _mStatus" << generateFuncIdArg(pPtr) << ");" << endl;
         s << TAB << "if(pResponseContext)" << endl;
         s << TAB << "{" << endl;
         INC_TAB;
@@ -2975,30 +3114,37 @@ string Tars2Cpp::generateH(const InterfacePtr &pPtr, const NamespacePtr &nPtr) c
 	s << TAB << "auto it = _msg_->response->status.find(\"TARS_FUNC\");" << endl;
 
 //	s << TAB << "pair<string*, string*> r = equal_range(" << dname << ", " << dname << "+" << vOperation.size() << ", string(_msg_->request.sFuncName));" << endl;
-	s << TAB << "pair<string*, string*> r = equal_range(" << dname << ", " << dname << "+" << vOperation.size() << ", (it==_msg_->response->status.end())?_msg_->request.sFuncName:it->second);" << endl;
-
-    s << TAB << "if(r.first == r.second) return tars::TARSSERVERNOFUNCERR;" << endl;
+    if (isHashDispatch(pPtr))
+    {
+        s << generateHashDispatch(pPtr, "(it==_msg_->response->status.end())?_msg_->request.sFuncName:it->second", "(it==_msg_->response->status.end())?_msg_->request.iFuncId:0", &Tars2Cpp::generateDispatchAsync);
+    }
+    else
+    {
+        s << TAB << "pair<string*, string*> r = equal_range(" << dname << ", " << dname << "+" << vOperation.size() << ", (it==_msg_->response->status.end())?_msg_->request.sFuncName:it->second);" << endl;
 
-    s << TAB << "switch(r.first - " << dname << ")" << endl;
-    s << TAB << "{" << endl;
-    INC_TAB;
+        s << TAB << "if(r.first == r.second) return tars::TARSSERVERNOFUNCERR;" << endl;
 
-    for (size_t i = 0; i < vOperation.size(); i++)
-    {
-        s << TAB << "case " << i << ":" << endl;
+        s << TAB << "switch(r.first - " << dname << ")" << endl;
         s << TAB << "{" << endl;
         INC_TAB;
 
-        s << generateDispatchAsync(vOperation[i], pPtr->getId()) << endl;
+        for (size_t i = 0; i < vOperation.size(); i++)
+        {
+            s << TAB << "case " << i << ":" << endl;
+            s << TAB << "{" << endl;
+            INC_TAB;
+
+            s << generateDispatchAsync(vOperation[i], pPtr->getId()) << endl;
+
+            DEL_TAB;
+            s << TAB << "}" << endl;
+        }
 
         DEL_TAB;
         s << TAB << "}" << endl;
-    }
 
-    DEL_TAB;
-    s << TAB << "}" << endl;
-
-    s << TAB << "return tars::TARSSERVERNOFUNCERR;" << endl;
+        s << TAB << "return tars::TARSSERVERNOFUNCERR;" << endl;
+    }
     DEL_TAB;
     s << TAB << "}" << endl;
 
@@ -3048,25 +3194,32 @@ string Tars2Cpp::generateH(const InterfacePtr &pPtr, const NamespacePtr &nPtr) c
     DEL_TAB;
     s << TAB << "};" << endl;
     s << endl;
-    s << TAB << "pair<string*, string*> r = equal_range(" << dname << ", " << dname << "+" << vOperation.size() << ", string(_msg_->request.sFuncName));" << endl;
-    s << TAB << "if(r.first == r.second) return tars::TARSSERVERNOFUNCERR;" << endl;
-    s << TAB << "switch(r.first - " << dname << ")" << endl;
-    s << TAB << "{" << endl;
-    INC_TAB;
-    for(size_t i = 0; i < vOperation.size(); i++)
+    if (isHashDispatch(pPtr))
     {
-        s << TAB << "case " << i << ":" << endl;
+        s << generateHashDispatch(pPtr, "_msg_->request.sFuncName", "_msg_->request.iFuncId", &Tars2Cpp::generateDispatchPromiseAsync);
+    }
+    else
+    {
+        s << TAB << "pair<string*, string*> r = equal_range(" << dname << ", " << dname << "+" << vOperation.size() << ", string(_msg_->request.sFuncName));" << endl;
+        s << TAB << "if(r.first == r.second) return tars::TARSSERVERNOFUNCERR;" << endl;
+        s << TAB << "switch(r.first - " << dname << ")" << endl;
         s << TAB << "{" << endl;
         INC_TAB;
-        s << generateDispatchPromiseAsync(vOperation[i], pPtr->getId()) << endl;
+        for(size_t i = 0; i < vOperation.size(); i++)
+        {
+            s << TAB << "case " << i << ":" << endl;
+            s << TAB << "{" << endl;
+            INC_TAB;
+            s << generateDispatchPromiseAsync(vOperation[i], pPtr->getId()) << endl;
+            DEL_TAB;
+            s << TAB << "}" << endl;
+        }
         DEL_TAB;
         s << TAB << "}" << endl;
+        s << TAB << "return tars::TARSSERVERNOFUNCERR;" << endl;
     }
     DEL_TAB;
     s << TAB << "}" << endl;
-    s << TAB << "return tars::TARSSERVERNOFUNCERR;" << endl;
-    DEL_TAB;
-    s << TAB << "}" << endl;
     s << endl;
     DEL_TAB;
     s << TAB << "};" << endl;
@@ -3122,30 +3275,37 @@ string Tars2Cpp::generateH(const InterfacePtr &pPtr, const NamespacePtr &nPtr) c
 
     s << endl;
 
-    s << TAB << "pair<string*, string*> r = equal_range(" << dname << ", " << dname << "+" << vOperation.size() << ", string(_msg_->request.sFuncName));" << endl;
-
-    s << TAB << "if(r.first == r.second) return tars::TARSSERVERNOFUNCERR;" << endl;
+    if (isHashDispatch(pPtr))
+    {
+        s << generateHashDispatch(pPtr, "_msg_->request.sFuncName", "_msg_->request.iFuncId", &Tars2Cpp::generateDispatchCoroAsync);
+    }
+    else
+    {
+        s << TAB << "pair<string*, string*> r = equal_range(" << dname << ", " << dname << "+" << vOperation.size() << ", string(_msg_->request.sFuncName));" << endl;
 
-    s << TAB << "switch(r.first - " << dname << ")" << endl;
-    s << TAB << "{" << endl;
-    INC_TAB;
+        s << TAB << "if(r.first == r.second) return tars::TARSSERVERNOFUNCERR;" << endl;
 
-    for (size_t i = 0; i < vOperation.size(); i++)
-    {
-        s << TAB << "case " << i << ":" << endl;
+        s << TAB << "switch(r.first - " << dname << ")" << endl;
         s << TAB << "{" << endl;
         INC_TAB;
 
-        s << generateDispatchCoroAsync(vOperation[i], pPtr->getId()) << endl;
+        for (size_t i = 0; i < vOperation.size(); i++)
+        {
+            s << TAB << "case " << i << ":" << endl;
+            s << TAB << "{" << endl;
+            INC_TAB;
+
+            s << generateDispatchCoroAsync(vOperation[i], pPtr->getId()) << endl;
+
+            DEL_TAB;
+            s << TAB << "}" << endl;
+        }
 
         DEL_TAB;
         s << TAB << "}" << endl;
-    }
 
-    DEL_TAB;
-    s << TAB << "}" << endl;
-
-    s << TAB << "return tars::TARSSERVERNOFUNCERR;" << endl;
+        s << TAB << "return tars::TARSSERVERNOFUNCERR;" << endl;
+    }
     DEL_TAB;
     s << TAB << "}" << endl;
 
@@ -3265,30 +3425,37 @@ string Tars2Cpp::generateH(const InterfacePtr &pPtr, const NamespacePtr &nPtr) c
 
     s << endl;
 
-    s << TAB << "pair<string*, string*> r = equal_range(" << dname << ", " << dname << "+" << vOperation.size() << ", _current->getFuncName());" << endl;
-
-    s << TAB << "if(r.first == r.second) return tars::TARSSERVERNOFUNCERR;" << endl;
+    if (isHashDispatch(pPtr))
+    {
+        s << generateHashDispatch(pPtr, "_current->getFuncName()", "_current->getFuncId()", &Tars2Cpp::generateServantDispatch);
+    }
+    else
+    {
+        s << TAB << "pair<string*, string*> r = equal_range(" << dname << ", " << dname << "+" << vOperation.size() << ", _current->getFuncName());" << endl;
 
-    s << TAB << "switch(r.first - " << dname << ")" << endl;
-    s << TAB << "{" << endl;
-    INC_TAB;
+        s << TAB << "if(r.first == r.second) return tars::TARSSERVERNOFUNCERR;" << endl;
 
-    for (size_t i = 0; i < vOperation.size(); i++)
-    {
-        s << TAB << "case " << i << ":" << endl;
+        s << TAB << "switch(r.first - " << dname << ")" << endl;
         s << TAB << "{" << endl;
         INC_TAB;
 
-        s << generateServantDispatch(vOperation[i], pPtr->getId()) << endl;
+        for (size_t i = 0; i < vOperation.size(); i++)
+        {
+            s << TAB << "case " << i << ":" << endl;
+            s << TAB << "{" << endl;
+            INC_TAB;
+
+            s << generateServantDispatch(vOperation[i], pPtr->getId()) << endl;
+
+            DEL_TAB;
+            s << TAB << "}" << endl;
+        }
 
         DEL_TAB;
         s << TAB << "}" << endl;
-    }
 
-    DEL_TAB;
-    s << TAB << "}" << endl;
-
-    s << TAB << "return tars::TARSSERVERNOFUNCERR;" << endl;
+        s << TAB << "return tars::TARSSERVERNOFUNCERR;" << endl;
+    }
     DEL_TAB;
     s << TAB << "}" << endl;
 
@@ -3480,6 +3647,7 @@ void Tars2Cpp::generateH(const ContextPtr &pPtr) const
             s << "#include \"servant/ServantProxy.h\"" << endl;
             s << "#include \"servant/Servant.h\"" << endl;
             s << "#include \"promise/promise.h\"" << endl;
+            s << "#include \"servant/CoAwait.h\"" << endl;
 
             break;
         }
@@ -96,6 +96,19 @@ public:
     */
     void setTrace(bool bTrace) { _bTrace = bTrace; }
 
+    /**
+    * 按函数id(函数名hash)分发, 替代函数名二分查找
+    * switch命中后仍比较一次函数名: 多一次字符串比较, 换来函数名和id不一致的请求不会按错误的函数处理和上报
+    * @param bHashDispatch
+    */
+    void setHashDispatch(bool bHashDispatch) { _bHashDispatch = bHashDispatch; }
+
+    /**
+    * 结构体的string/vector/map成员使用TarsArena分配器
+    * @param bArena
+    */
+    void setArena(bool bArena) { _bArena = bArena; }
+
     //下面是编解码的源码生成
 protected:
     /**
@@ -257,6 +270,14 @@ protected:
      */
     string tostrEnum(const EnumPtr &pPtr) const;
 
+    /**
+     * 生成结构体成员的类型描述, --arena时string/vector/map使用arena分配器
+     * @param pPtr
+     *
+     * @return string
+     */
+    string tostrArena(const TypePtr &pPtr) const;
+
     /**
      * 获取定长数组的坐标
      * @param pPtr
@@ -384,6 +405,41 @@ protected:
      */
     string generateServantDispatch(const OperationPtr& pPtr, const string& cn) const;
 
+    /**
+     * 函数id, 和Tars.h中的tarsFuncId一致
+     * @param name
+     *
+     * @return int32_t
+     */
+    static int32_t funcId(const string &name);
+
+    /**
+     * 接口是否按函数id分发(函数id有冲突时还是按函数名分发)
+     * @param pPtr
+     *
+     * @return bool
+     */
+    bool isHashDispatch(const InterfacePtr &pPtr) const;
+
+    /**
+     * 客户端调用时带上的函数id参数
+     * @param pPtr
+     *
+     * @return string
+     */
+    string generateFuncIdArg(const OperationPtr &pPtr) const;
+
+    /**
+     * 生成按函数id分发的源码
+     * @param pPtr
+     * @param funcName, 获取函数名的表达式
+     * @param funcId, 获取函数id的表达式
+     * @param dispatch, 生成每个函数分发的源码
+     *
+     * @return string
+     */
+    string generateHashDispatch(const InterfacePtr &pPtr, const string &funcName, const string &funcId, string (Tars2Cpp::*dispatch)(const OperationPtr &, const string &) const) const;
+
     /**
      * 生成操作的servant的头文件源码
      * @param pPtr
@@ -521,6 +577,10 @@ private:
     bool _tarsMaster;
 
     bool _bTrace;
+
+    bool _bHashDispatch;
+
+    bool _bArena;
 };
 
 #endif
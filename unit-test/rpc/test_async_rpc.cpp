@@ -50,6 +50,103 @@ TEST_F(HelloTest, rpcASyncServerCommunicatorInCoroutine)
 	});
 }
 
+TEST_F(HelloTest, rpcASyncBatch)
+{
+	transServerCommunicator([&](Communicator *comm){
+		atomic<int> callback_count{0};
+
+		HelloPrx prx = getObj<HelloPrx>(comm, "HelloAdapter");
+		prx->tars_ping();
+
+		uint64_t buffers1, syscalls1;
+		TC_Transceiver::getSendStat(buffers1, syscalls1);
+
+		//批量调用, flush时一次交给网络线程, 同一个连接上的请求合并发送
+		prx->tars_batch_begin();
+		for (int j = 0; j < _count; ++j)
+		{
+			HelloPrxCallbackPtr p(new ClientHelloCallback(TC_Common::now2us(), j, _count, _buffer, callback_count));
+
+			prx->async_testHello(p, j, _buffer);
+		}
+
+		ASSERT_TRUE(callback_count == 0);
+		ASSERT_TRUE(prx->tars_batch_flush() == (size_t)_count);
+		ASSERT_TRUE(prx->tars_batch_flush() == 0);
+
+		waitForFinish(callback_count, _count);
+
+		ASSERT_TRUE(callback_count == _count);
+
+		uint64_t buffers2, syscalls2;
+		TC_Transceiver::getSendStat(buffers2, syscalls2);
+
+		LOG_CONSOLE_DEBUG << "batch count:" << _count << ", send buffers:" << buffers2 - buffers1 << ", send syscalls:" << syscalls2 - syscalls1 << endl;
+
+		//请求(以及服务端的回包)合并发送
+		ASSERT_TRUE(syscalls2 - syscalls1 < (uint64_t)_count);
+		ASSERT_TRUE(syscalls2 - syscalls1 < buffers2 - buffers1);
+	});
+}
+
+TEST_F(HelloTest, rpcASyncBatchGuard)
+{
+	transServerCommunicator([&](Communicator *comm){
+		atomic<int> callback_count{0};
+
+		HelloPrx prx = getObj<HelloPrx>(comm, "HelloAdapter");
+
+		//中途抛异常, 析构时仍然提交
+		try
+		{
+			ServantProxyBatch batch(prx);
+			for (int j = 0; j < _count; ++j)
+			{
+				HelloPrxCallbackPtr p(new ClientHelloCallback(TC_Common::now2us(), j, _count, _buffer, callback_count));
+
+				prx->async_testHello(p, j, _buffer);
+			}
+
+			throw std::runtime_error("batch error");
+		}
+		catch (std::runtime_error &)
+		{
+		}
+
+		ASSERT_TRUE(prx->tars_batch_flush() == 0);
+
+		waitForFinish(callback_count, _count);
+
+		ASSERT_TRUE(callback_count == _count);
+	});
+}
+
+TEST_F(HelloTest, rpcASyncBatchThreadExit)
+{
+	transServerCommunicator([&](Communicator *comm){
+		atomic<int> callback_count{0};
+
+		HelloPrx prx = getObj<HelloPrx>(comm, "HelloAdapter");
+
+		//线程退出时没有flush, 缓存的请求在线程数据析构时提交
+		std::thread th([&]()
+		{
+			prx->tars_batch_begin();
+			for (int j = 0; j < _count; ++j)
+			{
+				HelloPrxCallbackPtr p(new ClientHelloCallback(TC_Common::now2us(), j, _count, _buffer, callback_count));
+
+				prx->async_testHello(p, j, _buffer);
+			}
+		});
+		th.join();
+
+		waitForFinish(callback_count, _count);
+
+		ASSERT_TRUE(callback_count == _count);
+	});
+}
+
 TEST_F(HelloTest, rpcASyncAllocCommunicator)
 {
 	transAllocCommunicator([&](Communicator *comm){
@@ -0,0 +1,147 @@
+#include "hello_test.h"
+#include "server/RpcServer.h"
+#include "servant/CoAwait.h"
+
+//只有编译器支持C++20协程时才有效, unit-test/CMakeLists.txt中这个文件单独用-std=c++20编译
+#ifdef TARS_CO_AWAIT
+
+//顺序调用count次, 每次在回包线程上恢复执行
+static Future<int> coHello(HelloPrx prx, int count, string s)
+{
+	int succ = 0;
+	for (int i = 0; i < count; i++)
+	{
+		HelloPrxCallbackPromise::PromisetestHelloPtr rsp = co_await prx->co_testHello(i, s);
+		if (rsp->_ret == 0 && rsp->r == s)
+		{
+			++succ;
+		}
+	}
+	co_return succ;
+}
+
+//失败时返回异常的错误码
+static Future<int> coTimeout(HelloPrx prx, int timeout)
+{
+	try
+	{
+		co_await prx->co_testTimeout(timeout);
+	}
+	catch (Exception &ex)
+	{
+		co_return ex.code();
+	}
+	co_return 0;
+}
+
+static Future<int> coHelloError(HelloPrx prx)
+{
+	try
+	{
+		co_await prx->co_testHello(0, "hello");
+	}
+	catch (Exception &ex)
+	{
+		co_return ex.code();
+	}
+	co_return 0;
+}
+
+//自己编解码, 直接等待ReqMessage
+static Future<string> coInvokeHello(HelloPrx prx, string sFuncName, string s)
+{
+	TarsOutputStream<BufferWriterVector> os;
+	os.write(0, 1);
+	os.write(s, 2);
+
+	ReqMessagePtr msg = co_await coInvoke(prx, sFuncName, os);
+	if (msg->response->iRet != TARSSERVERSUCCESS)
+	{
+		co_return "error:" + TC_Common::tostr(msg->response->iRet);
+	}
+
+	TarsInputStream<BufferReader> is;
+	is.setBuffer(msg->response->sBuffer);
+
+	int ret = -1;
+	string r;
+	is.read(ret, 0, true);
+	is.read(r, 3, true);
+	co_return r;
+}
+
+template <typename T>
+static bool waitFuture(const Future<T> &f, int64_t ms)
+{
+	int64_t start = TNOWMS;
+	while (!f.isDone() && TNOWMS - start < ms)
+	{
+		TC_Common::msleep(10);
+	}
+	return f.isDone();
+}
+
+TEST_F(HelloTest, rpcCoAwait)
+{
+	shared_ptr<Communicator> comm = getCommunicator();
+
+	RpcServer rpc1Server;
+	startServer(rpc1Server, RPC1_CONFIG());
+
+	HelloPrx prx = comm->stringToProxy<HelloPrx>("TestApp.RpcServer.HelloObj@tcp -h 127.0.0.1 -p 9990");
+
+	//多个协程并发, 每个协程内顺序调用
+	vector<Future<int>> rs;
+	for (int i = 0; i < 10; i++)
+	{
+		rs.push_back(coHello(prx, 100, _buffer));
+	}
+	for (auto &r : rs)
+	{
+		ASSERT_TRUE(waitFuture(r, 10000));
+		ASSERT_TRUE(r.get() == 100);
+	}
+
+	Future<string> f1 = coInvokeHello(prx, "testHello", "hello");
+	ASSERT_TRUE(waitFuture(f1, 10000));
+	ASSERT_TRUE(f1.get() == "hello");
+
+	//服务端没有这个函数, 通过ReqMessage返回错误码
+	Future<string> f2 = coInvokeHello(prx, "testNoFunc", "hello");
+	ASSERT_TRUE(waitFuture(f2, 10000));
+	ASSERT_TRUE(f2.get() == "error:" + TC_Common::tostr(TARSSERVERNOFUNCERR));
+
+	stopServer(rpc1Server);
+}
+
+TEST_F(HelloTest, rpcCoAwaitException)
+{
+	shared_ptr<Communicator> comm = getCommunicator();
+
+	RpcServer rpc1Server;
+	startServer(rpc1Server, RPC1_CONFIG());
+
+	//超时, 异常在co_await处抛出
+	HelloPrx prx = comm->stringToProxy<HelloPrx>("TestApp.RpcServer.HelloObj@tcp -h 127.0.0.1 -p 9990");
+	prx->tars_async_timeout(500);
+
+	Future<int> f1 = coTimeout(prx, 2);
+	ASSERT_TRUE(waitFuture(f1, 10000));
+	ASSERT_TRUE(f1.get() == TARSINVOKETIMEOUT);
+
+	//服务端返回错误
+	HelloPrx noPrx = comm->stringToProxy<HelloPrx>("TestApp.RpcServer.NoObj@tcp -h 127.0.0.1 -p 9990");
+
+	Future<int> f2 = coHelloError(noPrx);
+	ASSERT_TRUE(waitFuture(f2, 10000));
+	ASSERT_TRUE(f2.get() == TARSSERVERNOSERVANTERR);
+
+	//协程没有捕获的异常设置到返回的Future上
+	Future<int> f3 = coHello(noPrx, 1, "hello");
+	ASSERT_TRUE(waitFuture(f3, 10000));
+	ASSERT_TRUE(f3.hasException());
+
+	stopServer(rpc1Server);
+}
+
+#endif
@@ -0,0 +1,88 @@
+﻿
+#include "hello_test.h"
+#include "server/RpcServer.h"
+#include "servant/CompressCodec.h"
+#include "util/tc_gzip.h"
+
+#include <atomic>
+
+//统计调用次数的压缩算法, 客户端和服务端在同一个进程里, 共用一个
+class CountCompressCodec : public CompressCodec
+{
+public:
+	virtual const string &name() const
+	{
+		static string s = "count";
+		return s;
+	}
+
+	virtual bool compress(const char *src, size_t length, vector<char> &buffer)
+	{
+		++_compress;
+		return TC_GZip::compress(src, length, buffer);
+	}
+
+	virtual bool uncompress(const char *src, size_t length, vector<char> &buffer)
+	{
+		++_uncompress;
+		return TC_GZip::uncompress(src, length, buffer);
+	}
+
+	std::atomic<int> _compress{0};
+	std::atomic<int> _uncompress{0};
+};
+
+TEST_F(HelloTest, rpcCompress)
+{
+	shared_ptr<CountCompressCodec> codec = std::make_shared<CountCompressCodec>();
+	CompressCodecFactory::getInstance()->registerCodec(codec);
+
+	shared_ptr<Communicator> comm = getCommunicator();
+
+	RpcServer rpc1Server;
+	startServer(rpc1Server, RPC1_CONFIG());
+
+	HelloPrx prx = comm->stringToProxy<HelloPrx>("TestApp.RpcServer.HelloObj@tcp -h 127.0.0.1 -p 9990");
+	prx->tars_set_compress("count", 1024);
+
+	string big(100 * 1024, 'a');
+	string out;
+
+	//第一次调用还没有协商, 只有回包压缩
+	ASSERT_TRUE(prx->testHello(0, big, out) == 0);
+	ASSERT_TRUE(out == big);
+	ASSERT_TRUE(codec->_compress == 1);
+	ASSERT_TRUE(codec->_uncompress == 1);
+
+	//服务端确认后请求也压缩
+	ASSERT_TRUE(prx->testHello(1, big, out) == 0);
+	ASSERT_TRUE(out == big);
+	ASSERT_TRUE(codec->_compress == 3);
+	ASSERT_TRUE(codec->_uncompress == 3);
+
+	//小于阈值的不压缩
+	ASSERT_TRUE(prx->testHello(2, "hello", out) == 0);
+	ASSERT_TRUE(out == "hello");
+	ASSERT_TRUE(codec->_compress == 3);
+
+	//服务端不支持的算法不确认, 一直不压缩
+	prx->tars_set_compress("unknown", 1024);
+	ASSERT_TRUE(prx->testHello(3, big, out) == 0);
+	ASSERT_TRUE(out == big);
+	ASSERT_TRUE(codec->_compress == 3);
+	ASSERT_TRUE(codec->_uncompress == 3);
+
+	//关闭后单次调用通过context开启
+	prx->tars_set_compress("", 1024);
+	ASSERT_TRUE(prx->testHello(4, big, out) == 0);
+	ASSERT_TRUE(codec->_compress == 3);
+
+	map<string, string> context;
+	context[ServantProxy::CONTEXT_COMPRESS_KEY] = "count";
+	ASSERT_TRUE(prx->testHello(5, big, out, context) == 0);
+	ASSERT_TRUE(out == big);
+	ASSERT_TRUE(codec->_compress == 5);
+	ASSERT_TRUE(codec->_uncompress == 5);
+
+	stopServer(rpc1Server);
+}
@@ -0,0 +1,76 @@
+#include "hello_test.h"
+#include "server/HashHello.h"
+
+struct HashHelloCallback : public HashHelloPrxCallback
+{
+	HashHelloCallback(std::atomic<int> &count) : callback_count(count) {}
+
+	virtual void callback_testHello(tars::Int32 ret, const std::string &r)
+	{
+		if (ret == 0 && r == "hello")
+		{
+			++callback_count;
+		}
+	}
+
+	virtual void callback_testHello_exception(tars::Int32 ret)
+	{
+		LOG_CONSOLE_DEBUG << "callback exception:" << ret << endl;
+	}
+
+	std::atomic<int> &callback_count;
+};
+
+//不带函数id, 服务端按函数名计算id分发
+static string invokeHello(HashHelloPrx prx, const string &sFuncName, const string &s, tars::Int32 iFuncId)
+{
+	TarsOutputStream<BufferWriterVector> os;
+	os.write(0, 1);
+	os.write(s, 2);
+
+	shared_ptr<ResponsePacket> rsp = prx->tars_invoke(TARSNORMAL, sFuncName, os, map<string, string>(), map<string, string>(), iFuncId);
+
+	TarsInputStream<BufferReader> is;
+	is.setBuffer(rsp->sBuffer);
+
+	int ret = -1;
+	string r;
+	is.read(ret, 0, true);
+	is.read(r, 3, true);
+	return r;
+}
+
+TEST_F(HelloTest, rpcHashDispatch)
+{
+	transServerCommunicator([&](Communicator *comm){
+
+		HashHelloPrx prx = getObj<HashHelloPrx>(comm, "HashHelloAdapter");
+
+		//生成的代码带上tars2cpp计算的函数id, 必须和tarsFuncId一致
+		int funcId = 0;
+		ASSERT_TRUE(prx->testFuncId(funcId) == 0);
+		ASSERT_TRUE(funcId == tars::tarsFuncId("testFuncId"));
+
+		string r;
+		ASSERT_TRUE(prx->testHello(0, "hello", r) == 0);
+		ASSERT_TRUE(r == "hello");
+
+		//没有函数id
+		ASSERT_TRUE(invokeHello(prx, "testHello", "hello", 0) == "hello");
+		ASSERT_TRUE(invokeHello(prx, "testHello", "hello", tars::tarsFuncId("testHello")) == "hello");
+
+		//函数名和id不一致, 不能按id对应的函数分发
+		ASSERT_THROW(invokeHello(prx, "testHello", "hello", tars::tarsFuncId("testFuncId")), TarsServerNoFuncException);
+		ASSERT_THROW(invokeHello(prx, "testNoFunc", "hello", tars::tarsFuncId("testHello")), TarsServerNoFuncException);
+		ASSERT_THROW(invokeHello(prx, "testNoFunc", "hello", 0), TarsServerNoFuncException);
+
+		//回包按函数id分发到回调
+		std::atomic<int> callback_count{0};
+		for (int i = 0; i < 10; i++)
+		{
+			prx->async_testHello(new HashHelloCallback(callback_count), i, "hello");
+		}
+		waitForFinish(callback_count, 10);
+		ASSERT_TRUE(callback_count == 10);
+	});
+}
@@ -0,0 +1,86 @@
+﻿
+#include "hello_test.h"
+#include "server/RpcServer.h"
+
+#include <thread>
+#include <algorithm>
+
+//多个线程同步调用, 返回所有调用的耗时(微秒), 从小到大排序
+static vector<int64_t> invokeLatency(HelloPrx prx, const string &buffer, int threads, int count)
+{
+	vector<vector<int64_t>> costs(threads);
+	vector<std::thread*> vt;
+
+	for (int i = 0; i < threads; i++)
+	{
+		vt.push_back(new std::thread([&, i]()
+		{
+			string out;
+			for (int j = 0; j < count; j++)
+			{
+				int64_t start = TC_Common::now2us();
+				int ret = prx->testHello(j, buffer, out);
+				costs[i].push_back(TC_Common::now2us() - start);
+				ASSERT_TRUE(ret == 0);
+			}
+		}));
+	}
+
+	for (auto t : vt)
+	{
+		t->join();
+		delete t;
+	}
+
+	vector<int64_t> all;
+	for (auto &c : costs)
+	{
+		all.insert(all.end(), c.begin(), c.end());
+	}
+	std::sort(all.begin(), all.end());
+	return all;
+}
+
+static int64_t percentile(const vector<int64_t> &v, double p)
+{
+	size_t i = (size_t)(v.size() * p / 100);
+	return v[(std::min)(i, v.size() - 1)];
+}
+
+TEST_F(HelloTest, adaptiveLoadBalance)
+{
+	shared_ptr<Communicator> comm = getCommunicator();
+
+	RpcServer rpc1Server;
+	startServer(rpc1Server, RPC1_CONFIG());
+
+	RpcServer rpc2Server;
+	startServer(rpc2Server, RPC2_CONFIG());
+
+	RpcServer rpc3Server;
+	startServer(rpc3Server, RPC3_CONFIG());
+
+	//三个节点中的一个变慢
+	rpc1Server.setDelay(20);
+
+	const int threads = 4;
+	const int count = 500;
+
+	//-v 0: 轮询, -v 2: 自适应
+	HelloPrx loopPrx = comm->stringToProxy<HelloPrx>("TestApp.RpcServer.HelloObj@tcp -h 127.0.0.1 -p 9990 -v 0:tcp -h 127.0.0.1 -p 9991 -v 0:tcp -h 127.0.0.1 -p 9992 -v 0");
+	HelloPrx adaptivePrx = comm->stringToProxy<HelloPrx>("TestApp.RpcServer.HelloObj@tcp -h 127.0.0.1 -p 9990 -v 2:tcp -h 127.0.0.1 -p 9991 -v 2:tcp -h 127.0.0.1 -p 9992 -v 2");
+
+	vector<int64_t> loop = invokeLatency(loopPrx, _buffer, threads, count);
+	vector<int64_t> adaptive = invokeLatency(adaptivePrx, _buffer, threads, count);
+
+	LOG_CONSOLE_DEBUG << "loop, p50: " << percentile(loop, 50) << "us, p99: " << percentile(loop, 99) << "us" << endl;
+	LOG_CONSOLE_DEBUG << "adaptive, p50: " << percentile(adaptive, 50) << "us, p99: " << percentile(adaptive, 99) << "us" << endl;
+
+	//轮询有三分之一的请求到慢节点, 自适应只有少量探测请求到慢节点
+	ASSERT_TRUE(percentile(loop, 99) >= 20 * 1000);
+	ASSERT_TRUE(percentile(adaptive, 99) < 20 * 1000);
+
+	stopServer(rpc1Server);
+	stopServer(rpc2Server);
+	stopServer(rpc3Server);
+}
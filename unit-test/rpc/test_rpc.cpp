@@ -52,6 +52,33 @@ TEST_F(HelloTest, rpcSyncServerCommunicatorInCoroutine)
 //	});
 //}
 
+TEST_F(HelloTest, rpcSyncShardCommunicator)
+{
+	shared_ptr<Communicator> c = getCommunicator();
+	c->setProperty("sharded", "1");
+
+	transGlobalCommunicator([&](Communicator *comm){
+		//每个业务线程独占通信器, 同步调用在业务线程中完成
+		vector<std::thread*> threads;
+		for (int i = 0; i < 4; i++)
+		{
+			threads.push_back(new std::thread([&](){
+				checkSync(comm);
+				checkASync(comm);
+				checkSync(comm);
+			}));
+		}
+
+		for (auto th : threads)
+		{
+			th->join();
+			delete th;
+		}
+
+		checkSync(comm);
+	}, c.get());
+}
+
 TEST_F(HelloTest, rpcSyncComplexCommunicator)
 {
 	shared_ptr<Communicator> c = getCommunicator();
@@ -94,4 +94,40 @@ TEST_F(HelloTest, ssl3ASyncServerCommunicatorInCoroutine)
 	});
 }
 
+//不同大小的包(跨多个tls record), 收到的内容要和发送的一致
+static void checkKtlsPayload(HelloPrx prx)
+{
+	vector<size_t> sizes = { 1, 100, 16 * 1024 - 1, 16 * 1024 + 1, 100 * 1024, 1024 * 1024 };
+
+	for (size_t i = 0; i < sizes.size(); i++)
+	{
+		string buffer(sizes[i], 0);
+		for (size_t j = 0; j < buffer.size(); j++)
+		{
+			buffer[j] = (char)(j * 131 + i);
+		}
+
+		string out;
+		ASSERT_TRUE(prx->testHello((int)i, buffer, out) == 0);
+		ASSERT_TRUE(out == buffer);
+	}
+}
+
+//server和client都开启ktls, 内核没有tls模块时回退到openssl
+TEST_F(HelloTest, sslKtlsSyncServerCommunicator)
+{
+	transServerCommunicator([&](Communicator *comm){
+		checkSync(comm, "SSLHello4Adapter");
+		checkKtlsPayload(getObj<HelloPrx>(comm, "SSLHello4Adapter"));
+	});
+}
+
+TEST_F(HelloTest, sslKtlsASyncServerCommunicatorInCoroutine)
+{
+	transInCoroutineServerCommunicator([&](Communicator *comm){
+		checkASync(comm, "SSLHello4Adapter");
+		checkKtlsPayload(getObj<HelloPrx>(comm, "SSLHello4Adapter"));
+	});
+}
+
 #endif
\ No newline at end of file
@@ -114,4 +114,236 @@ TEST_F(HelloTest, statReportInCoroutine)
 
 	stopServer(hs);
     tarsMockUtil.stopFramework();
+}
+
+//分片模式: 多个线程report, 上报线程合并各分片后上报, 次数/耗时/时间分布都不能丢
+TEST_F(HelloTest, statReportSharded)
+{
+	TarsMockUtil tarsMockUtil;
+	tarsMockUtil.startFramework();
+
+	_clientStatData.clear();
+
+	shared_ptr<Communicator> c = getCommunicator();
+	c->setProperty("stat-sharded", "1");
+
+	StatReport *stat = c->getStatReport();
+	ASSERT_TRUE(stat->isSharded());
+
+	const string slaveName = "TestApp.StatShardServer.StatShardObj";
+	const int threads = 4;
+	const int count = 3000;
+	const vector<int> timePoint = { 5, 10, 50, 100, 200, 500, 1000, 2000, 3000 };
+
+	//按接口统计期望值, 失败的调用耗时按0计入时间分布(和StatReport::report一致)
+	map<string, StatMicMsgBody> expect;
+	for (int t = 0; t < threads; t++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			StatMicMsgBody &body = expect["func" + TC_Common::tostr(i % 3)];
+
+			int rspTime = 0;
+			if (i % 10 == 0)
+			{
+				body.timeoutCount++;
+			}
+			else if (i % 10 == 1)
+			{
+				body.execCount++;
+			}
+			else
+			{
+				rspTime = (i * 7 + t) % 2500 + 1;
+				body.count++;
+				body.totalRspTime += rspTime;
+				body.maxRspTime = std::max(body.maxRspTime, rspTime);
+				body.minRspTime = (body.minRspTime == 0) ? rspTime : std::min(body.minRspTime, rspTime);
+			}
+
+			auto it = std::upper_bound(timePoint.begin(), timePoint.end(), rspTime);
+			if (it != timePoint.end())
+			{
+				body.intervalCount[*it]++;
+			}
+		}
+	}
+
+	vector<std::thread*> vt;
+	for (int t = 0; t < threads; t++)
+	{
+		vt.push_back(new std::thread([=]()
+		{
+			for (int i = 0; i < count; i++)
+			{
+				StatReport::StatResult result = StatReport::STAT_SUCC;
+				int rspTime = 0;
+				if (i % 10 == 0)
+				{
+					result = StatReport::STAT_TIMEOUT;
+				}
+				else if (i % 10 == 1)
+				{
+					result = StatReport::STAT_EXCE;
+				}
+				else
+				{
+					rspTime = (i * 7 + t) % 2500 + 1;
+				}
+
+				stat->report("TestApp.StatShardClient", "127.0.0.1", slaveName, "127.0.0.1", 10000, "func" + TC_Common::tostr(i % 3), result, rspTime, 0);
+			}
+		}));
+	}
+
+	for (auto th : vt)
+	{
+		th->join();
+		delete th;
+	}
+
+	//等上报(report-interval=10000), 同一个接口可能分在多次上报中
+	map<string, StatMicMsgBody> actual;
+	int64_t total = 0;
+	for (int wait = 0; wait < 30 && total < threads * count; wait++)
+	{
+		TC_Common::sleep(1);
+
+		actual.clear();
+		total = 0;
+
+		auto data = _clientStatData;
+		for (auto &r : data)
+		{
+			for (auto &e : r)
+			{
+				if (e.first.slaveName != slaveName)
+				{
+					continue;
+				}
+
+				StatMicMsgBody &body = actual[e.first.interfaceName];
+				body.count          += e.second.count;
+				body.timeoutCount   += e.second.timeoutCount;
+				body.execCount      += e.second.execCount;
+				body.totalRspTime   += e.second.totalRspTime;
+				body.maxRspTime     = std::max(body.maxRspTime, e.second.maxRspTime);
+				if (body.minRspTime == 0 || (e.second.minRspTime != 0 && e.second.minRspTime < body.minRspTime))
+				{
+					body.minRspTime = e.second.minRspTime;
+				}
+				for (auto &ic : e.second.intervalCount)
+				{
+					body.intervalCount[ic.first] += ic.second;
+				}
+
+				total += e.second.count + e.second.timeoutCount + e.second.execCount;
+			}
+		}
+	}
+
+	ASSERT_TRUE(total == threads * count);
+	ASSERT_TRUE(actual.size() == expect.size());
+
+	for (auto &e : expect)
+	{
+		const StatMicMsgBody &body = actual[e.first];
+
+		ASSERT_TRUE(body.count == e.second.count);
+		ASSERT_TRUE(body.timeoutCount == e.second.timeoutCount);
+		ASSERT_TRUE(body.execCount == e.second.execCount);
+		ASSERT_TRUE(body.totalRspTime == e.second.totalRspTime);
+		ASSERT_TRUE(body.maxRspTime == e.second.maxRspTime);
+		ASSERT_TRUE(body.minRspTime == e.second.minRspTime);
+
+		for (auto &ic : e.second.intervalCount)
+		{
+			auto it = body.intervalCount.find(ic.first);
+			ASSERT_TRUE(it != body.intervalCount.end());
+			ASSERT_TRUE(it->second == ic.second);
+		}
+	}
+
+	c.reset();
+	tarsMockUtil.stopFramework();
+}
+
+//没有merge的自定义策略, 不能分片
+class PropertyLast
+{
+public:
+	string desc() { return "Last"; }
+	string get() { return TC_Common::tostr(_d); }
+	void set(int o) { _d = o; }
+private:
+	int _d = 0;
+};
+
+TEST_F(HelloTest, propertyReportSharded)
+{
+	vector<int> range = {10, 100, 1000};
+
+	PropertyReportPtr locked = new PropertyReportImp<PropertyReport::sum, PropertyReport::avg, PropertyReport::max, PropertyReport::min, PropertyReport::count, PropertyReport::distr>(
+		PropertyReport::sum(), PropertyReport::avg(), PropertyReport::max(), PropertyReport::min(), PropertyReport::count(), PropertyReport::distr(range));
+
+	PropertyReportPtr sharded = new PropertyReportImp<PropertyReport::sum, PropertyReport::avg, PropertyReport::max, PropertyReport::min, PropertyReport::count, PropertyReport::distr>(
+		PropertyReport::sum(), PropertyReport::avg(), PropertyReport::max(), PropertyReport::min(), PropertyReport::count(), PropertyReport::distr(range));
+
+	sharded->setSharded(true);
+	ASSERT_TRUE(sharded->isSharded());
+
+	PropertyReportPtr custom = new PropertyReportImp<PropertyReport::sum, PropertyLast>(PropertyReport::sum(), PropertyLast());
+	custom->setSharded(true);
+	ASSERT_FALSE(custom->isSharded());
+
+	for (int loop = 0; loop < 3; loop++)
+	{
+		vector<std::thread*> threads;
+		for (int t = 0; t < 4; t++)
+		{
+			threads.push_back(new std::thread([=]()
+			{
+				for (int i = 1; i <= 10000; i++)
+				{
+					int v = (i * (t + 1) + loop) % 2000;
+					locked->report(v);
+					sharded->report(v);
+				}
+			}));
+		}
+
+		for (auto th : threads)
+		{
+			th->join();
+			delete th;
+		}
+
+		//线程都退出了, 分片的数据合并后和加锁模式一致
+		vector<pair<string, string>> v1 = locked->get();
+		vector<pair<string, string>> v2 = sharded->get();
+
+		ASSERT_TRUE(v1 == v2);
+		ASSERT_TRUE(v2[4].second == "40000");
+	}
+
+	//已经取走的数据不会再出现
+	vector<pair<string, string>> v = sharded->get();
+	ASSERT_TRUE(v == locked->get());
+	ASSERT_TRUE(v[0].second == "0");
+
+	int64_t start = TNOWUS;
+	for (int i = 0; i < 1000000; i++)
+	{
+		locked->report(i);
+	}
+	int64_t us1 = TNOWUS - start;
+
+	start = TNOWUS;
+	for (int i = 0; i < 1000000; i++)
+	{
+		sharded->report(i);
+	}
+	int64_t us2 = TNOWUS - start;
+
+	LOG_CONSOLE_DEBUG << "property report, locked: " << us1 << "us, sharded: " << us2 << "us" << endl;
 }
\ No newline at end of file
@@ -0,0 +1,13 @@
+﻿#include "HashHelloImp.h"
+
+int HashHelloImp::testHello(int index, const string &s, string &r, CurrentPtr current)
+{
+	r = s;
+	return 0;
+}
+
+int HashHelloImp::testFuncId(int &funcId, CurrentPtr current)
+{
+	funcId = current->getFuncId();
+	return 0;
+}
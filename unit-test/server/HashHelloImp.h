@@ -0,0 +1,29 @@
+﻿#ifndef _HASH_HELLO_IMP_H_
+#define _HASH_HELLO_IMP_H_
+
+#include "HashHello.h"
+
+using namespace std;
+using namespace tars;
+using namespace Test;
+
+/////////////////////////////////////////////////////////////////////////
+/**
+ * 按函数id分发(tars2cpp --hash-dispatch)的servant
+ */
+class HashHelloImp : public HashHello
+{
+public:
+    virtual void initialize() {}
+
+    virtual void destroy() {}
+
+    virtual int testHello(int index, const string &s, string &r, CurrentPtr current);
+
+    /**
+     * 返回客户端带上来的函数id
+     */
+    virtual int testFuncId(int &funcId, CurrentPtr current);
+};
+/////////////////////////////////////////////////////////////////////////
+#endif
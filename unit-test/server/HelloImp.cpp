@@ -1,5 +1,6 @@
 ﻿#include "HelloImp.h"
 #include "HelloServer.h"
+#include "RpcServer.h"
 #include "servant/RemoteLogger.h"
 #include "Push.h"
 
@@ -97,6 +98,12 @@ int HelloImp::testHello(int index, const string& s, string& r, CurrentPtr curren
 //	{
 //	}
 	++hello_count;
+
+	RpcServer *server = dynamic_cast<RpcServer*>(getApplication());
+	if(server && server->getDelay() > 0)
+	{
+		TC_Common::msleep(server->getDelay());
+	}
 //    LOG_CONSOLE_DEBUG << hello_count << ", fd:" << current->getFd() << ", " << current->getIp() << ":" << current->getPort() << endl;
 
 	r = s;
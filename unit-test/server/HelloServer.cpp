@@ -4,6 +4,7 @@
 #include "HttpImp.h"
 #include "CustomImp.h"
 #include "PushImp.h"
+#include "HashHelloImp.h"
 
 #include <thread>
 // #include "gperftools/profiler.h"
@@ -85,6 +86,7 @@ HelloServer::initialize()
 	addServant<HelloImp>(_serverBaseInfo.Application + "." + _serverBaseInfo.ServerName + ".SSL1Obj");
 	addServant<HelloImp>(_serverBaseInfo.Application + "." + _serverBaseInfo.ServerName + ".SSL2Obj");
 	addServant<HelloImp>(_serverBaseInfo.Application + "." + _serverBaseInfo.ServerName + ".SSL3Obj");
+	addServant<HelloImp>(_serverBaseInfo.Application + "." + _serverBaseInfo.ServerName + ".SSL4Obj");
 	addServant<HelloImp>(_serverBaseInfo.Application + "." + _serverBaseInfo.ServerName + ".AuthObj");
 	addServant<HelloImp>(_serverBaseInfo.Application + "." + _serverBaseInfo.ServerName + ".UdpObj");
 	addServant<HelloImp>(_serverBaseInfo.Application + "." + _serverBaseInfo.ServerName + ".UdpIpv6Obj");
@@ -92,6 +94,8 @@ HelloServer::initialize()
 	addServant<PushImp>(_serverBaseInfo.Application + "." + _serverBaseInfo.ServerName + ".PushObj");
 	addServantProtocol(_serverBaseInfo.Application + "." + _serverBaseInfo.ServerName + ".PushObj", parse);
 
+	addServant<HashHelloImp>(_serverBaseInfo.Application + "." + _serverBaseInfo.ServerName + ".HashHelloObj");
+
 	pushThread = new PushInfoThread();
 	pushThread->start();
 }
@@ -11,12 +11,8 @@ HttpImp::HttpImp()
 
 int HttpImp::doRequest(tars::CurrentPtr current, vector<char>& response)
 {
-    const vector<char>& request = current->getRequestBuffer();
-
-    // LOG_CONSOLE_DEBUG << string(request.data(), request.size()) << endl;
-
     TC_HttpRequest req;
-    req.decode(request);
+    current->decodeHttpRequest(req);
 
     TC_HttpResponse rsp;
     rsp.setResponse(200, "OK", req.getContent());
@@ -26,7 +26,16 @@ public:
      **/
     virtual void destroyApp();
 
+    /**
+     * HelloObj::testHello处理前等待的毫秒数, 模拟变慢的节点
+     **/
+    void setDelay(int ms) { _delay = ms; }
+
+    int getDelay() const { return _delay; }
+
 protected:
     virtual void run();
 
+    std::atomic<int> _delay{0};
+
 };
@@ -0,0 +1,109 @@
+﻿#include "servant/CoAwait.h"
+#include "util/tc_common.h"
+#include "util/tc_logger.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace std;
+using namespace tars;
+
+//只有编译器支持C++20协程时才有效
+#ifdef TARS_CO_AWAIT
+
+class CoAwaitTest : public testing::Test
+{
+public:
+	//添加日志
+	static void SetUpTestCase()
+	{
+	}
+	static void TearDownTestCase()
+	{
+	}
+	virtual void SetUp()   //TEST跑之前会执行SetUp
+	{
+	}
+	virtual void TearDown() //TEST跑完之后会执行TearDown
+	{
+	}
+};
+
+static Future<int> coAdd(Future<int> a, Future<int> b)
+{
+	int x = co_await a;
+	int y = co_await b;
+	co_return x + y;
+}
+
+static Future<void> coThrow(Future<int> a)
+{
+	co_await a;
+	throw Exception("co_await exception");
+}
+
+TEST_F(CoAwaitTest, testFuture)
+{
+	Promise<int> p1;
+	Promise<int> p2;
+	p2.setValue(5);
+
+	//p2已经完成, 不挂起; p1在其他线程完成后恢复
+	Future<int> r = coAdd(p1.getFuture(), p2.getFuture());
+	ASSERT_FALSE(r.isDone());
+
+	std::thread t([&]{ TC_Common::msleep(20); p1.setValue(3); });
+	t.join();
+
+	ASSERT_TRUE(r.isDone());
+	ASSERT_TRUE(r.get() == 8);
+
+	//异常设置到返回的Future上
+	Future<void> f = coThrow(p2.getFuture());
+	ASSERT_TRUE(f.hasException());
+
+	//等待的Future有异常时, 在co_await处抛出
+	Promise<int> p3;
+	Future<int> r2 = coAdd(p3.getFuture(), p2.getFuture());
+	p3.setException(ExceptionPtr(new Exception("error")));
+	ASSERT_TRUE(r2.hasException());
+}
+
+TEST_F(CoAwaitTest, testConcurrent)
+{
+	const int count = 100000;
+
+	Promise<int> one;
+	one.setValue(1);
+
+	vector<Promise<int>> ps(count);
+	vector<Future<int>> rs;
+	rs.reserve(count);
+
+	int64_t start = TNOWUS;
+	for (auto &p : ps)
+	{
+		rs.push_back(coAdd(p.getFuture(), one.getFuture()));
+	}
+
+	//其他线程完成
+	std::thread t([&]{
+		for (int i = 0; i < count; i++)
+		{
+			ps[i].setValue(i);
+		}
+	});
+	t.join();
+
+	int64_t sum = 0;
+	for (auto &r : rs)
+	{
+		ASSERT_TRUE(r.isDone());
+		sum += r.get();
+	}
+	ASSERT_TRUE(sum == (int64_t)count * (count - 1) / 2 + count);
+
+	LOG_CONSOLE_DEBUG << count << " pending coroutines, cost: " << TNOWUS - start << "us" << endl;
+}
+
+#endif
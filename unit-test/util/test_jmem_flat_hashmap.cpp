@@ -0,0 +1,403 @@
+﻿#include "jmem/jmem_flat_hashmap.h"
+#include "jmem/jmem_hashmap.h"
+#include "util/tc_common.h"
+#include "util/tc_file.h"
+#include "util/tc_logger.h"
+#include "gtest/gtest.h"
+
+#include <map>
+#include <set>
+
+using namespace std;
+using namespace tars;
+
+class JmemFlatHashMapTest : public testing::Test
+{
+public:
+	//添加日志
+	static void SetUpTestCase()
+	{
+	}
+	static void TearDownTestCase()
+	{
+	}
+	virtual void SetUp()   //TEST跑之前会执行SetUp
+	{
+	}
+	virtual void TearDown() //TEST跑完之后会执行TearDown
+	{
+	}
+};
+
+//和tars2cpp生成的结构一样的编解码
+struct FlatKey
+{
+	Int32 id = 0;
+
+	template<typename WriterT>
+	void writeTo(TarsOutputStream<WriterT>& _os) const
+	{
+		_os.write(id, 0);
+	}
+
+	template<typename ReaderT>
+	void readFrom(TarsInputStream<ReaderT>& _is)
+	{
+		_is.read(id, 0, true);
+	}
+};
+
+struct FlatValue
+{
+	string data;
+
+	template<typename WriterT>
+	void writeTo(TarsOutputStream<WriterT>& _os) const
+	{
+		_os.write(data, 0);
+	}
+
+	template<typename ReaderT>
+	void readFrom(TarsInputStream<ReaderT>& _is)
+	{
+		_is.read(data, 0, true);
+	}
+};
+
+static FlatKey makeKey(int id)
+{
+	FlatKey k;
+	k.id = id;
+	return k;
+}
+
+static FlatValue makeValue(int id)
+{
+	FlatValue v;
+	v.data = "value_" + TC_Common::tostr(id) + string(id % 100, 'a' + id % 26);
+	return v;
+}
+
+typedef TarsFlatHashMap<FlatKey, FlatValue, ThreadLockPolicy, MemStorePolicy> FlatMap;
+
+struct TestFlatMap
+{
+	TestFlatMap(size_t iSize) : buff(iSize)
+	{
+		map.initDataSize(16, 128);
+		map.create(buff.data(), buff.size());
+	}
+
+	vector<char>	buff;
+	FlatMap			map;
+};
+
+TEST_F(JmemFlatHashMapTest, testSetGet)
+{
+	TestFlatMap t(1024 * 1024);
+	FlatMap &map = t.map;
+
+	ASSERT_TRUE(map.getSlotCount() % TC_FlatHashMap::GROUP_SIZE == 0);
+	ASSERT_TRUE(map.getMaxElementCount() > 1000);
+
+	for (int id = 0; id < 1000; id++)
+	{
+		ASSERT_TRUE(map.set(makeKey(id), makeValue(id)) == TC_FlatHashMap::RT_OK);
+	}
+	ASSERT_TRUE(map.size() == 1000);
+
+	FlatValue v;
+	for (int id = 0; id < 1000; id++)
+	{
+		ASSERT_TRUE(map.get(makeKey(id), v) == TC_FlatHashMap::RT_OK);
+		ASSERT_TRUE(v.data == makeValue(id).data);
+	}
+	ASSERT_TRUE(map.get(makeKey(1000), v) == TC_FlatHashMap::RT_NO_DATA);
+
+	//原地修改
+	ASSERT_TRUE(map.set(makeKey(1), makeValue(99)) == TC_FlatHashMap::RT_OK);
+	ASSERT_TRUE(map.get(makeKey(1), v) == TC_FlatHashMap::RT_OK && v.data == makeValue(99).data);
+	ASSERT_TRUE(map.size() == 1000);
+
+	ASSERT_TRUE(map.del(makeKey(1)) == TC_FlatHashMap::RT_OK);
+	ASSERT_TRUE(map.del(makeKey(1)) == TC_FlatHashMap::RT_NO_DATA);
+	ASSERT_TRUE(map.get(makeKey(1), v) == TC_FlatHashMap::RT_NO_DATA);
+	ASSERT_TRUE(map.size() == 999);
+
+	//超过最大长度
+	FlatValue big;
+	big.data = string(200, 'a');
+	ASSERT_TRUE(map.set(makeKey(1), big) == TC_FlatHashMap::RT_DATA_TOO_LONG);
+
+	map.setReadOnly(true);
+	ASSERT_TRUE(map.set(makeKey(1), makeValue(1)) == TC_FlatHashMap::RT_READONLY);
+	ASSERT_TRUE(map.del(makeKey(2)) == TC_FlatHashMap::RT_READONLY);
+	ASSERT_TRUE(map.get(makeKey(2), v) == TC_FlatHashMap::RT_OK);
+	map.setReadOnly(false);
+
+	size_t n = 0;
+	map.forEach([&](const FlatKey &k, const FlatValue &v)
+	{
+		ASSERT_TRUE(v.data == makeValue(k.id).data);
+		++n;
+	});
+	ASSERT_TRUE(n == 999);
+
+	map.clear();
+	ASSERT_TRUE(map.size() == 0);
+	ASSERT_TRUE(map.get(makeKey(2), v) == TC_FlatHashMap::RT_NO_DATA);
+}
+
+TEST_F(JmemFlatHashMapTest, testClock)
+{
+	TestFlatMap t(64 * 1024);
+	FlatMap &map = t.map;
+
+	const int max = (int)map.getMaxElementCount();
+
+	//不淘汰时满了返回RT_NO_MEMORY
+	map.setAutoErase(false);
+	for (int id = 0; id < max; id++)
+	{
+		ASSERT_TRUE(map.set(makeKey(id), makeValue(id)) == TC_FlatHashMap::RT_OK);
+	}
+	ASSERT_TRUE(map.set(makeKey(max), makeValue(max)) == TC_FlatHashMap::RT_NO_MEMORY);
+	map.setAutoErase(true);
+
+	//第一圈清除所有访问标记, 前一半再访问一次, 淘汰的都是后一半
+	vector<pair<FlatKey, FlatValue> > vErased;
+	ASSERT_TRUE(map.set(makeKey(max), makeValue(max), vErased) == TC_FlatHashMap::RT_OK);
+	ASSERT_TRUE(vErased.size() == 1);
+	ASSERT_TRUE(vErased[0].second.data == makeValue(vErased[0].first.id).data);
+	ASSERT_TRUE(map.size() == (size_t)max);
+
+	int first = vErased[0].first.id;
+
+	FlatValue v;
+	for (int id = 0; id < max / 2; id++)
+	{
+		map.get(makeKey(id), v);
+	}
+
+	set<int> erased;
+	for (int id = max + 1; id < max + max / 4; id++)
+	{
+		vErased.clear();
+		ASSERT_TRUE(map.set(makeKey(id), makeValue(id), vErased) == TC_FlatHashMap::RT_OK);
+		ASSERT_TRUE(vErased.size() == 1);
+		erased.insert(vErased[0].first.id);
+	}
+
+	for (int id = 0; id < max / 2; id++)
+	{
+		if (id != first)
+		{
+			ASSERT_TRUE(erased.count(id) == 0);
+			ASSERT_TRUE(map.get(makeKey(id), v) == TC_FlatHashMap::RT_OK);
+		}
+	}
+	ASSERT_TRUE(map.size() == (size_t)max);
+
+	FlatKey k;
+	ASSERT_TRUE(map.erase(k, v) == TC_FlatHashMap::RT_ERASE_OK);
+	ASSERT_TRUE(v.data == makeValue(k.id).data);
+	ASSERT_TRUE(map.size() == (size_t)max - 1);
+}
+
+TEST_F(JmemFlatHashMapTest, testRandom)
+{
+	TestFlatMap t(256 * 1024);
+	FlatMap &map = t.map;
+
+	const int keys = (int)map.getMaxElementCount() * 2;
+
+	std::map<int, string> expect;
+
+	srand(1);
+	size_t rebuilt = 0;
+	for (int loop = 0; loop < 200000; loop++)
+	{
+		int id = rand() % keys;
+		int op = rand() % 10;
+
+		size_t deleted = map.getMapHead()._iDeletedCount;
+
+		if (op < 5)
+		{
+			vector<pair<FlatKey, FlatValue> > vErased;
+			FlatValue v = makeValue(rand());
+			ASSERT_TRUE(map.set(makeKey(id), v, vErased) == TC_FlatHashMap::RT_OK);
+			expect[id] = v.data;
+			for (auto &kv : vErased)
+			{
+				ASSERT_TRUE(expect[kv.first.id] == kv.second.data);
+				expect.erase(kv.first.id);
+			}
+		}
+		else if (op < 8)
+		{
+			int ret = map.del(makeKey(id));
+			ASSERT_TRUE(ret == (expect.erase(id) ? TC_FlatHashMap::RT_OK : TC_FlatHashMap::RT_NO_DATA));
+		}
+		else
+		{
+			FlatValue v;
+			int ret = map.get(makeKey(id), v);
+			auto it = expect.find(id);
+			ASSERT_TRUE(ret == (it == expect.end() ? TC_FlatHashMap::RT_NO_DATA : TC_FlatHashMap::RT_OK));
+			ASSERT_TRUE(it == expect.end() || it->second == v.data);
+		}
+
+		if (map.getMapHead()._iDeletedCount + 1 < deleted)
+		{
+			++rebuilt;
+		}
+
+		ASSERT_TRUE(map.size() == expect.size());
+	}
+
+	//删除标记多了以后整理过
+	ASSERT_TRUE(rebuilt > 0);
+
+	size_t n = 0;
+	map.forEach([&](const FlatKey &k, const FlatValue &v)
+	{
+		ASSERT_TRUE(expect[k.id] == v.data);
+		++n;
+	});
+	ASSERT_TRUE(n == expect.size());
+}
+
+//可以直接查找槽位
+class SlotFlatHashMap : public TC_FlatHashMap
+{
+public:
+	size_t findSlot(const string &k) { return find(k, hashValue(k)); }
+};
+
+TEST_F(JmemFlatHashMapTest, testRecover)
+{
+	vector<char> buff(64 * 1024);
+
+	SlotFlatHashMap map;
+	map.initDataSize(16, 16);
+	map.create(buff.data(), buff.size());
+
+	vector<TC_FlatHashMap::BlockData> vtData;
+	for (int i = 0; i < 100; i++)
+	{
+		ASSERT_TRUE(map.set("key_" + TC_Common::tostr(i), "value_" + TC_Common::tostr(i), vtData) == TC_FlatHashMap::RT_OK);
+	}
+
+	//修改到一半退出, 计数也没有更新
+	map.getMapHead()._cModifyStatus = 1;
+	map.getMapHead()._iModifySlot = map.findSlot("key_1");
+	map.getMapHead()._iElementCount = 101;
+
+	{
+		SlotFlatHashMap map2;
+		map2.connect(buff.data(), buff.size());
+		ASSERT_TRUE(map2.size() == 99);
+
+		string v;
+		ASSERT_TRUE(map2.get("key_1", v) == TC_FlatHashMap::RT_NO_DATA);
+		ASSERT_TRUE(map2.get("key_2", v) == TC_FlatHashMap::RT_OK && v == "value_2");
+		ASSERT_TRUE(map2.getMapHead()._cModifyStatus == 0);
+	}
+
+	//整理到一半退出, 清空
+	map.getMapHead()._cModifyStatus = 2;
+	{
+		SlotFlatHashMap map2;
+		map2.connect(buff.data(), buff.size());
+		ASSERT_TRUE(map2.size() == 0);
+	}
+
+	//大小不一致
+	SlotFlatHashMap map3;
+	ASSERT_THROW(map3.connect(buff.data(), buff.size() - 1), TC_FlatHashMap_Exception);
+}
+
+TEST_F(JmemFlatHashMapTest, testFileStore)
+{
+	typedef TarsFlatHashMap<FlatKey, FlatValue, ThreadLockPolicy, FileStorePolicy> map_type;
+
+	string file = "./test_jmem_flat_hashmap.dat";
+	TC_File::removeFile(file, false);
+
+	{
+		map_type map;
+		map.initDataSize(16, 128);
+		map.initStore(file.c_str(), 1024 * 1024);
+
+		for (int id = 0; id < 1000; id++)
+		{
+			ASSERT_TRUE(map.set(makeKey(id), makeValue(id)) == TC_FlatHashMap::RT_OK);
+		}
+	}
+
+	{
+		map_type map;
+		map.initStore(file.c_str(), 1024 * 1024);
+		ASSERT_TRUE(map.size() == 1000);
+
+		FlatValue v;
+		for (int id = 0; id < 1000; id++)
+		{
+			ASSERT_TRUE(map.get(makeKey(id), v) == TC_FlatHashMap::RT_OK);
+			ASSERT_TRUE(v.data == makeValue(id).data);
+		}
+	}
+
+	TC_File::removeFile(file, false);
+}
+
+template<typename M>
+static void benchmark(M &map, const string &name, int keys, int count)
+{
+	vector<FlatKey> vk;
+	srand(1);
+	for (int i = 0; i < count; i++)
+	{
+		vk.push_back(makeKey(rand() % keys));
+	}
+
+	int64_t start = TNOWUS;
+	for (int id = 0; id < keys; id++)
+	{
+		map.set(makeKey(id), makeValue(id));
+	}
+	int64_t us1 = TNOWUS - start;
+
+	FlatValue v;
+	size_t hit = 0;
+	start = TNOWUS;
+	for (int i = 0; i < count; i++)
+	{
+		hit += map.get(vk[i], v) == 0;
+	}
+	int64_t us2 = TNOWUS - start;
+
+	LOG_CONSOLE_DEBUG << name << ", keys: " << keys << ", set: " << (int64_t)keys * 1000000 / (us1 + 1) << "/s, get: "
+		<< (int64_t)count * 1000000 / (us2 + 1) << "/s, hit: " << hit * 100 / count << "%" << endl;
+}
+
+TEST_F(JmemFlatHashMapTest, testBenchmark)
+{
+	const size_t size = 32 * 1024 * 1024;
+	const int keys = 100000;
+	const int count = 1000000;
+
+	{
+		TestFlatMap t(size);
+		benchmark(t.map, "TarsFlatHashMap", keys, count);
+	}
+
+	{
+		vector<char> buff(size);
+		TarsHashMap<FlatKey, FlatValue, ThreadLockPolicy, MemStorePolicy> map;
+		map.initDataBlockSize(64, 256, 2.0);
+		map.create(buff.data(), buff.size());
+		benchmark(map, "TarsHashMap", keys, count);
+	}
+}
@@ -0,0 +1,808 @@
+﻿#include "jmem/jmem_hashmap.h"
+#include "jmem/jmem_multi_hashmap.h"
+#include "util/tc_common.h"
+#include "util/tc_file.h"
+#include "util/tc_logger.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <atomic>
+#include <set>
+
+using namespace std;
+using namespace tars;
+
+class JmemHashMapTest : public testing::Test
+{
+public:
+	//添加日志
+	static void SetUpTestCase()
+	{
+	}
+	static void TearDownTestCase()
+	{
+	}
+	virtual void SetUp()   //TEST跑之前会执行SetUp
+	{
+	}
+	virtual void TearDown() //TEST跑完之后会执行TearDown
+	{
+	}
+};
+
+//和tars2cpp生成的结构一样的编解码
+struct TestKey
+{
+	Int32 id = 0;
+
+	template<typename WriterT>
+	void writeTo(TarsOutputStream<WriterT>& _os) const
+	{
+		_os.write(id, 0);
+	}
+
+	template<typename ReaderT>
+	void readFrom(TarsInputStream<ReaderT>& _is)
+	{
+		_is.read(id, 0, true);
+	}
+};
+
+struct TestValue
+{
+	string data;
+
+	template<typename WriterT>
+	void writeTo(TarsOutputStream<WriterT>& _os) const
+	{
+		_os.write(data, 0);
+	}
+
+	template<typename ReaderT>
+	void readFrom(TarsInputStream<ReaderT>& _is)
+	{
+		_is.read(data, 0, true);
+	}
+};
+
+static TestKey makeKey(int id)
+{
+	TestKey k;
+	k.id = id;
+	return k;
+}
+
+//数据长度不一样, 有的需要多个chunk
+static TestValue makeValue(int id)
+{
+	TestValue v;
+	v.data = "value_" + TC_Common::tostr(id) + string(id % 200, 'a' + id % 26);
+	return v;
+}
+
+template<typename LockPolicy>
+struct TestMap
+{
+	typedef TarsHashMap<TestKey, TestValue, LockPolicy, MemStorePolicy> map_type;
+
+	TestMap(size_t iSize) : buff(iSize)
+	{
+		map.initDataBlockSize(64, 256, 2.0);
+		map.create(buff.data(), buff.size());
+	}
+
+	vector<char>	buff;
+	map_type		map;
+};
+
+typedef TestMap<ThreadStripedLockPolicy> StripedMap;
+
+TEST_F(JmemHashMapTest, testStripedGetChain)
+{
+	StripedMap t(4 * 1024 * 1024);
+
+	for (int i = 0; i < 100; i++)
+	{
+		ASSERT_TRUE(t.map.set(makeKey(i), makeValue(i)) == TC_HashMap::RT_OK);
+	}
+	ASSERT_TRUE(t.map.size() == 100);
+
+	size_t iGetCount = t.map.getMapHead()._iGetCount;
+	size_t iHitCount = t.map.getMapHead()._iHitCount;
+
+	TestValue v;
+	ASSERT_TRUE(t.map.get(makeKey(50), v) == TC_HashMap::RT_OK);
+	ASSERT_TRUE(v.data == makeValue(50).data);
+	ASSERT_TRUE(t.map.get(makeKey(20), v) == TC_HashMap::RT_OK);
+	ASSERT_TRUE(t.map.get(makeKey(1000), v) == TC_HashMap::RT_NO_DATA);
+
+	//迭代器独占加锁, 延迟的Get链先刷新了, get过的在最前面(不同分段之间的先后顺序不保证)
+	{
+		set<int> ids;
+		auto it = t.map.beginGetTime();
+		TestKey k;
+		ASSERT_TRUE(it->get(k, v) == TC_HashMap::RT_OK);
+		ids.insert(k.id);
+		++it;
+		ASSERT_TRUE(it->get(k, v) == TC_HashMap::RT_OK);
+		ids.insert(k.id);
+		ASSERT_TRUE(ids == set<int>({20, 50}));
+	}
+
+	ASSERT_TRUE(t.map.getMapHead()._iGetCount == iGetCount + 3);
+	ASSERT_TRUE(t.map.getMapHead()._iHitCount == iHitCount + 2);
+
+	//只有key
+	ASSERT_TRUE(t.map.set(makeKey(200)) == TC_HashMap::RT_OK);
+	ASSERT_TRUE(t.map.get(makeKey(200), v) == TC_HashMap::RT_ONLY_KEY);
+
+	//修改后之前记录的地址失效, 修改前要先刷新
+	ASSERT_TRUE(t.map.get(makeKey(30), v) == TC_HashMap::RT_OK);
+	ASSERT_TRUE(t.map.del(makeKey(30)) == TC_HashMap::RT_OK);
+	ASSERT_TRUE(t.map.get(makeKey(30), v) == TC_HashMap::RT_NO_DATA);
+	ASSERT_TRUE(t.map.set(makeKey(30), makeValue(31)) == TC_HashMap::RT_OK);
+	ASSERT_TRUE(t.map.get(makeKey(30), v) == TC_HashMap::RT_OK);
+	ASSERT_TRUE(v.data == makeValue(31).data);
+	ASSERT_TRUE(t.map.erase(makeKey(30)) == TC_HashMap::RT_OK);
+	ASSERT_TRUE(t.map.size() == 100);
+}
+
+//检查链表和元素个数一致
+template<typename M>
+static size_t checkChain(M &map)
+{
+	size_t n = 0;
+	for (auto it = map.beginGetTime(); it != map.end(); ++it)
+	{
+		++n;
+	}
+
+	size_t m = 0;
+	for (auto it = map.beginSetTime(); it != map.end(); ++it)
+	{
+		++m;
+	}
+
+	EXPECT_TRUE(n == m);
+	return n;
+}
+
+TEST_F(JmemHashMapTest, testStripedConcurrent)
+{
+	//内存比较小, set时会淘汰其他桶的数据
+	StripedMap t(512 * 1024);
+
+	const int threads = 4;
+	const int keys = 20000;
+
+	std::atomic<int> errors{0};
+	std::atomic<int> gets{0};
+
+	vector<std::thread> vt;
+	for (int n = 0; n < threads; n++)
+	{
+		vt.push_back(std::thread([&, n]()
+		{
+			srand(n + 1);
+			TestValue v;
+			for (int i = 0; i < 50000; i++)
+			{
+				int id = rand() % keys;
+				int op = rand() % 10;
+				if (op < 7)
+				{
+					int ret = t.map.get(makeKey(id), v);
+					if (ret == TC_HashMap::RT_OK)
+					{
+						++gets;
+						if (v.data != makeValue(id).data)
+						{
+							++errors;
+						}
+					}
+				}
+				else if (op < 9)
+				{
+					int ret = t.map.set(makeKey(id), makeValue(id));
+					if (ret != TC_HashMap::RT_OK)
+					{
+						++errors;
+					}
+				}
+				else
+				{
+					t.map.del(makeKey(id));
+				}
+			}
+		}));
+	}
+
+	for (auto &th : vt)
+	{
+		th.join();
+	}
+
+	ASSERT_TRUE(errors == 0);
+	ASSERT_TRUE(gets > 0);
+	ASSERT_TRUE(t.map.size() > 0);
+	ASSERT_TRUE(checkChain(t.map) == t.map.size());
+
+	//剩下的数据都正确
+	TestValue v;
+	size_t n = 0;
+	for (int id = 0; id < keys; id++)
+	{
+		if (t.map.get(makeKey(id), v) == TC_HashMap::RT_OK)
+		{
+			ASSERT_TRUE(v.data == makeValue(id).data);
+			++n;
+		}
+	}
+	ASSERT_TRUE(n == t.map.size());
+}
+
+template<typename M>
+static void checkBatch(M &map)
+{
+	vector<pair<TestKey, TestValue> > vkv;
+	for (int i = 0; i < 300; i++)
+	{
+		vkv.push_back(make_pair(makeKey(i), makeValue(i)));
+	}
+	//同一个key出现多次, 按顺序生效
+	vkv.push_back(make_pair(makeKey(10), makeValue(1000)));
+
+	vector<int> vret = map.set(vkv);
+	ASSERT_TRUE(vret.size() == vkv.size());
+	for (auto ret : vret)
+	{
+		ASSERT_TRUE(ret == TC_HashMap::RT_OK);
+	}
+	ASSERT_TRUE(map.size() == 300);
+
+	vector<TestKey> vk;
+	for (int i = 0; i < 400; i += 2)
+	{
+		vk.push_back(makeKey(i));
+	}
+
+	vector<TestValue> vv;
+	vret = map.get(vk, vv);
+	ASSERT_TRUE(vret.size() == vk.size() && vv.size() == vk.size());
+	for (size_t i = 0; i < vk.size(); i++)
+	{
+		int id = vk[i].id;
+		if (id >= 300)
+		{
+			ASSERT_TRUE(vret[i] == TC_HashMap::RT_NO_DATA);
+			ASSERT_TRUE(vv[i].data.empty());
+		}
+		else
+		{
+			ASSERT_TRUE(vret[i] == TC_HashMap::RT_OK);
+			ASSERT_TRUE(vv[i].data == makeValue(id == 10 ? 1000 : id).data);
+		}
+	}
+
+	//和逐个get结果一致
+	TestValue v;
+	ASSERT_TRUE(map.get(makeKey(20), v) == TC_HashMap::RT_OK && v.data == vv[10].data);
+
+	vret = map.erase(vk);
+	for (size_t i = 0; i < vk.size(); i++)
+	{
+		ASSERT_TRUE(vret[i] == (vk[i].id >= 300 ? TC_HashMap::RT_NO_DATA : TC_HashMap::RT_OK));
+	}
+	ASSERT_TRUE(map.size() == 150);
+	ASSERT_TRUE(map.get(makeKey(20), v) == TC_HashMap::RT_NO_DATA);
+	ASSERT_TRUE(map.get(makeKey(21), v) == TC_HashMap::RT_OK);
+	ASSERT_TRUE(checkChain(map) == map.size());
+}
+
+TEST_F(JmemHashMapTest, testBatch)
+{
+	{
+		TestMap<ThreadLockPolicy> t(4 * 1024 * 1024);
+		checkBatch(t.map);
+	}
+
+	{
+		StripedMap t(4 * 1024 * 1024);
+		checkBatch(t.map);
+	}
+
+	//内存不够, 批量set时需要淘汰
+	{
+		StripedMap t(256 * 1024);
+
+		vector<pair<TestKey, TestValue> > vkv;
+		for (int i = 0; i < 5000; i++)
+		{
+			vkv.push_back(make_pair(makeKey(i), makeValue(i)));
+		}
+
+		vector<int> vret = t.map.set(vkv);
+		for (auto ret : vret)
+		{
+			ASSERT_TRUE(ret == TC_HashMap::RT_OK);
+		}
+		ASSERT_TRUE(t.map.size() < vkv.size());
+		ASSERT_TRUE(checkChain(t.map) == t.map.size());
+	}
+}
+
+TEST_F(JmemHashMapTest, testMultiBatch)
+{
+	typedef TarsMultiHashMap<TestKey, TestKey, TestValue, ThreadLockPolicy, MemStorePolicy> map_type;
+
+	vector<char> buff(4 * 1024 * 1024);
+	map_type map;
+	map.initDataBlockSize(64, 256, 2.0);
+	map.create(buff.data(), buff.size());
+
+	vector<pair<TestKey, TestKey> > vKey;
+	vector<TestValue> vv;
+	for (int i = 0; i < 100; i++)
+	{
+		vKey.push_back(make_pair(makeKey(i / 10), makeKey(i)));
+		vv.push_back(makeValue(i));
+	}
+
+	vector<int> vret = map.set(vKey, vv, false);
+	ASSERT_TRUE(vret.size() == vKey.size());
+	for (auto ret : vret)
+	{
+		ASSERT_TRUE(ret == TC_Multi_HashMap::RT_OK);
+	}
+	ASSERT_TRUE(map.size() == vKey.size());
+	ASSERT_TRUE(map.checkDirty(makeKey(0), makeKey(0)) == TC_Multi_HashMap::RT_OK);
+
+	vKey.push_back(make_pair(makeKey(1), makeKey(1000)));
+
+	vector<map_type::Value> vs;
+	vret = map.get(vKey, vs);
+	ASSERT_TRUE(vret.size() == vKey.size() && vs.size() == vKey.size());
+	for (size_t i = 0; i < 100; i++)
+	{
+		ASSERT_TRUE(vret[i] == TC_Multi_HashMap::RT_OK);
+		ASSERT_TRUE(vs[i]._mkey.id == (int)i / 10 && vs[i]._ukey.id == (int)i);
+		ASSERT_TRUE(vs[i]._value.data == makeValue(i).data);
+	}
+	ASSERT_TRUE(vret[100] != TC_Multi_HashMap::RT_OK);
+	ASSERT_TRUE(vs[100]._ukey.id == 1000);
+
+	//删除偶数的, 不存在的key返回RT_NO_DATA
+	vector<pair<TestKey, TestKey> > vErase;
+	for (int i = 0; i < 100; i += 2)
+	{
+		vErase.push_back(make_pair(makeKey(i / 10), makeKey(i)));
+	}
+	vErase.push_back(make_pair(makeKey(1), makeKey(1000)));
+
+	vret = map.erase(vErase);
+	ASSERT_TRUE(vret.size() == vErase.size());
+	for (size_t i = 0; i + 1 < vErase.size(); i++)
+	{
+		ASSERT_TRUE(vret[i] == TC_Multi_HashMap::RT_OK);
+	}
+	ASSERT_TRUE(vret.back() == TC_Multi_HashMap::RT_NO_DATA);
+	ASSERT_TRUE(map.size() == 50);
+
+	vKey.pop_back();
+	vret = map.get(vKey, vs);
+	for (size_t i = 0; i < vKey.size(); i++)
+	{
+		ASSERT_TRUE(vret[i] == (i % 2 == 0 ? TC_Multi_HashMap::RT_NO_DATA : TC_Multi_HashMap::RT_OK));
+	}
+
+	//覆盖已有的数据
+	for (size_t i = 0; i < vv.size(); i++)
+	{
+		vv[i].data += "_new";
+	}
+	vret = map.set(vKey, vv);
+	for (auto ret : vret)
+	{
+		ASSERT_TRUE(ret == TC_Multi_HashMap::RT_OK);
+	}
+	ASSERT_TRUE(map.size() == vKey.size());
+
+	vret = map.get(vKey, vs);
+	for (size_t i = 0; i < vKey.size(); i++)
+	{
+		ASSERT_TRUE(vret[i] == TC_Multi_HashMap::RT_OK);
+		ASSERT_TRUE(vs[i]._value.data == makeValue(i).data + "_new");
+		ASSERT_TRUE(vs[i]._dirty);
+	}
+}
+
+//数据都在, 各种遍历方式的个数一致
+template<typename M>
+static void checkRehash(M &map, int keys)
+{
+	TestValue v;
+	for (int id = 0; id < keys; id++)
+	{
+		ASSERT_TRUE(map.get(makeKey(id), v) == TC_HashMap::RT_OK);
+		ASSERT_TRUE(v.data == makeValue(id).data);
+	}
+	ASSERT_TRUE(map.size() == (size_t)keys);
+	ASSERT_TRUE(checkChain(map) == map.size());
+
+	size_t n = 0;
+	for (auto it = map.begin(); it != map.end(); ++it)
+	{
+		++n;
+	}
+	ASSERT_TRUE(n == map.size());
+
+	n = 0;
+	for (auto it = map.hashBegin(); it != map.hashEnd(); ++it)
+	{
+		vector<pair<TestKey, TestValue> > vv;
+		it->get(vv);
+		n += vv.size();
+	}
+	ASSERT_TRUE(n == map.size());
+}
+
+TEST_F(JmemHashMapTest, testRehash)
+{
+	typedef TarsHashMap<TestKey, TestValue, ThreadLockPolicy, FileStorePolicy> map_type;
+
+	string file = "./test_jmem_rehash.dat";
+	TC_File::removeFile(file, false);
+
+	const int keys = 800;
+
+	{
+		map_type map;
+		map.initDataBlockSize(64, 256, 2.0);
+		map.initStore(file.c_str(), 1024 * 1024);
+
+		for (int id = 0; id < keys; id++)
+		{
+			ASSERT_TRUE(map.set(makeKey(id), makeValue(id)) == TC_HashMap::RT_OK);
+		}
+
+		size_t iHashCount = map.getHashCount();
+
+		ASSERT_TRUE(map.expand(4 * 1024 * 1024, 0) == 0);
+
+		//不迁移时数据都在
+		map.setRehashStep(0);
+		checkRehash(map, keys);
+
+		size_t iMigrated, iOldCount, iNewCount;
+		map.getRehashProgress(iMigrated, iOldCount, iNewCount);
+		ASSERT_TRUE(iMigrated == 0 && iOldCount == iHashCount && iNewCount > iHashCount * 3);
+
+		//每次操作迁移一个桶
+		map.setRehashStep(1);
+		for (int id = keys; id < keys + 100; id++)
+		{
+			ASSERT_TRUE(map.set(makeKey(id), makeValue(id)) == TC_HashMap::RT_OK);
+		}
+		map.getRehashProgress(iMigrated, iOldCount, iNewCount);
+		ASSERT_TRUE(iMigrated == 100);
+
+		//迁移过程中读写正常
+		for (int id = keys + 100; id < keys * 2; id++)
+		{
+			ASSERT_TRUE(map.set(makeKey(id), makeValue(id)) == TC_HashMap::RT_OK);
+			if (id % 100 == 0)
+			{
+				checkRehash(map, id + 1);
+			}
+		}
+
+		while (map.rehash(100) != 0);
+
+		map.getRehashProgress(iMigrated, iOldCount, iNewCount);
+		ASSERT_TRUE(iNewCount == 0 && iOldCount > iHashCount * 3);
+		ASSERT_TRUE(map.getHashCount() == iOldCount);
+		checkRehash(map, keys * 2);
+
+		//再扩展一次
+		iHashCount = map.getHashCount();
+		ASSERT_TRUE(map.expand(8 * 1024 * 1024, iHashCount * 2) == 0);
+		map.rehash(iHashCount / 2);
+		checkRehash(map, keys * 2);
+	}
+
+	//重新连接, 继续迁移
+	{
+		map_type map;
+		map.initDataBlockSize(64, 256, 2.0);
+		map.initStore(file.c_str(), 8 * 1024 * 1024);
+
+		checkRehash(map, keys * 2);
+
+		size_t iMigrated, iOldCount, iNewCount;
+		map.getRehashProgress(iMigrated, iOldCount, iNewCount);
+		ASSERT_TRUE(iMigrated > 0 && iNewCount != 0);
+
+		map.setRehashStep(0);
+		ASSERT_TRUE(map.erase(makeKey(0)) == TC_HashMap::RT_OK);
+		size_t iNow;
+		map.getRehashProgress(iNow, iOldCount, iNewCount);
+		ASSERT_TRUE(iNow == iMigrated);
+
+		while (map.rehash(100) != 0);
+		ASSERT_TRUE(map.set(makeKey(0), makeValue(0)) == TC_HashMap::RT_OK);
+		checkRehash(map, keys * 2);
+	}
+
+	TC_File::removeFile(file, false);
+}
+
+struct RehashMap : public TC_HashMap
+{
+	using TC_HashMap::rehashBlock;
+};
+
+TEST_F(JmemHashMapTest, testRehashRecover)
+{
+	const size_t size = 1024 * 1024;
+	const int keys = 2000;
+
+	vector<char> buff(size * 2);
+
+	RehashMap map;
+	map.initDataBlockSize(64, 256, 2.0);
+	map.create(buff.data(), size);
+
+	vector<TC_HashMap::BlockData> vtData;
+	for (int id = 0; id < keys; id++)
+	{
+		ASSERT_TRUE(map.set(TC_Common::tostr(id), makeValue(id).data, true, vtData) == TC_HashMap::RT_OK);
+	}
+	ASSERT_TRUE(map.size() == (size_t)keys);
+
+	ASSERT_TRUE(map.append(buff.data(), size * 2, 0) == 0);
+	ASSERT_TRUE(map.isRehashing());
+
+	//找一个有多个数据的桶, 模拟迁移了一半进程退出
+	size_t index = 0;
+	while (map.item(index)->_iListCount < 2)
+	{
+		++index;
+	}
+	ASSERT_TRUE(map.rehash(index) != 0);
+
+	map.getMapHead()._iRehashIndex = index * 2 + 1;
+	map.rehashBlock(index);
+
+	//重新连接, 第一次操作先把这个桶迁移完
+	TC_HashMap map2;
+	map2.connect(buff.data(), size * 2);
+	map2.setRehashStep(0);
+
+	string v;
+	ASSERT_TRUE(map2.get(TC_Common::tostr(0), v) == TC_HashMap::RT_OK);
+
+	size_t iMigrated, iOldCount, iNewCount;
+	map2.getRehashProgress(iMigrated, iOldCount, iNewCount);
+	ASSERT_TRUE(iMigrated == index + 1);
+	ASSERT_TRUE((map2.getMapHead()._iRehashIndex & 1) == 0);
+
+	for (int id = 0; id < keys; id++)
+	{
+		ASSERT_TRUE(map2.get(TC_Common::tostr(id), v) == TC_HashMap::RT_OK);
+		ASSERT_TRUE(v == makeValue(id).data);
+	}
+
+	while (map2.rehash(100) != 0);
+	ASSERT_TRUE(!map2.isRehashing());
+	ASSERT_TRUE(map2.size() == (size_t)keys);
+
+	for (int id = 0; id < keys; id++)
+	{
+		ASSERT_TRUE(map2.get(TC_Common::tostr(id), v) == TC_HashMap::RT_OK);
+		ASSERT_TRUE(v == makeValue(id).data);
+	}
+}
+
+TEST_F(JmemHashMapTest, testStripedRehash)
+{
+	typedef TarsHashMap<TestKey, TestValue, ThreadStripedLockPolicy, FileStorePolicy> map_type;
+
+	string file = "./test_jmem_rehash_striped.dat";
+	TC_File::removeFile(file, false);
+
+	const int threads = 4;
+	const int keys = 2000;
+
+	map_type map;
+	map.initDataBlockSize(64, 256, 2.0);
+	map.initStore(file.c_str(), 1024 * 1024);
+
+	for (int id = 0; id < keys / 2; id++)
+	{
+		ASSERT_TRUE(map.set(makeKey(id), makeValue(id)) == TC_HashMap::RT_OK);
+	}
+
+	std::atomic<int> errors{0};
+	std::atomic<bool> stop{false};
+
+	vector<std::thread> vt;
+	for (int n = 0; n < threads; n++)
+	{
+		vt.push_back(std::thread([&, n]()
+		{
+			srand(n + 1);
+			TestValue v;
+			while (!stop)
+			{
+				int id = rand() % keys;
+				if (rand() % 10 < 7)
+				{
+					//前一半一直都在
+					int ret = map.get(makeKey(id), v);
+					if ((id < keys / 2 && ret != TC_HashMap::RT_OK) || (ret == TC_HashMap::RT_OK && v.data != makeValue(id).data))
+					{
+						++errors;
+					}
+				}
+				else if (id >= keys / 2)
+				{
+					if (map.set(makeKey(id), makeValue(id)) != TC_HashMap::RT_OK)
+					{
+						++errors;
+					}
+				}
+			}
+		}));
+	}
+
+	ASSERT_TRUE(map.expand(4 * 1024 * 1024, 0) == 0);
+	while (map.rehash(10) != 0)
+	{
+		std::this_thread::yield();
+	}
+
+	stop = true;
+	for (auto &th : vt)
+	{
+		th.join();
+	}
+
+	ASSERT_TRUE(errors == 0);
+	ASSERT_TRUE(checkChain(map) == map.size());
+
+	TestValue v;
+	for (int id = 0; id < keys / 2; id++)
+	{
+		ASSERT_TRUE(map.get(makeKey(id), v) == TC_HashMap::RT_OK && v.data == makeValue(id).data);
+	}
+
+	TC_File::removeFile(file, false);
+}
+
+template<typename M>
+static int64_t benchmark(M &map, int threads, int count, int keys)
+{
+	for (int id = 0; id < keys; id++)
+	{
+		map.set(makeKey(id), makeValue(id));
+	}
+
+	int64_t start = TNOWUS;
+
+	vector<std::thread> vt;
+	for (int n = 0; n < threads; n++)
+	{
+		vt.push_back(std::thread([&, n]()
+		{
+			srand(n + 1);
+			TestValue v;
+			for (int i = 0; i < count; i++)
+			{
+				int id = rand() % keys;
+				//读多写少
+				if (i % 10 == 0)
+				{
+					map.set(makeKey(id), makeValue(id));
+				}
+				else
+				{
+					map.get(makeKey(id), v);
+				}
+			}
+		}));
+	}
+
+	for (auto &th : vt)
+	{
+		th.join();
+	}
+
+	return TNOWUS - start;
+}
+
+TEST_F(JmemHashMapTest, testBenchmark)
+{
+	const int threads = (std::max)(4, (int)std::thread::hardware_concurrency());
+	const int count = 100000;
+	const int keys = 10000;
+	const size_t size = 16 * 1024 * 1024;
+
+	{
+		TestMap<ThreadLockPolicy> t(size);
+		int64_t us = benchmark(t.map, threads, count, keys);
+		LOG_CONSOLE_DEBUG << "ThreadLockPolicy, threads: " << threads << ", " << (int64_t)threads * count * 1000000 / (us + 1) << " ops/s" << endl;
+	}
+
+	{
+		TestMap<SemLockPolicy> t(size);
+		t.map.initLock(0x3a5e1c27);
+		int64_t us = benchmark(t.map, threads, count, keys);
+		LOG_CONSOLE_DEBUG << "SemLockPolicy, threads: " << threads << ", " << (int64_t)threads * count * 1000000 / (us + 1) << " ops/s" << endl;
+	}
+
+	{
+		TestMap<ThreadStripedLockPolicy> t(size);
+		int64_t us = benchmark(t.map, threads, count, keys);
+		ASSERT_TRUE(checkChain(t.map) == t.map.size());
+		LOG_CONSOLE_DEBUG << "ThreadStripedLockPolicy, threads: " << threads << ", " << (int64_t)threads * count * 1000000 / (us + 1) << " ops/s" << endl;
+	}
+}
+
+template<typename M>
+static void benchmarkBatch(M &map, const string &name)
+{
+	const int keys = 100000;
+	const int batch = 200;
+	const int count = 200;
+
+	vector<pair<TestKey, TestValue> > vkv;
+	for (int id = 0; id < keys; id++)
+	{
+		vkv.push_back(make_pair(makeKey(id), makeValue(id)));
+	}
+	map.set(vkv);
+
+	vector<vector<TestKey> > vvk(count);
+	srand(1);
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = 0; j < batch; j++)
+		{
+			vvk[i].push_back(makeKey(rand() % keys));
+		}
+	}
+
+	int64_t start = TNOWUS;
+	TestValue v;
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = 0; j < batch; j++)
+		{
+			map.get(vvk[i][j], v);
+		}
+	}
+	int64_t us1 = TNOWUS - start;
+
+	start = TNOWUS;
+	vector<TestValue> vv;
+	for (int i = 0; i < count; i++)
+	{
+		map.get(vvk[i], vv);
+	}
+	int64_t us2 = TNOWUS - start;
+
+	LOG_CONSOLE_DEBUG << name << ", " << batch << " keys, get one by one: " << us1 / count << "us, batch get: " << us2 / count << "us" << endl;
+}
+
+TEST_F(JmemHashMapTest, testBatchBenchmark)
+{
+	{
+		TestMap<ThreadLockPolicy> t(64 * 1024 * 1024);
+		benchmarkBatch(t.map, "ThreadLockPolicy");
+	}
+
+	{
+		TestMap<ThreadStripedLockPolicy> t(64 * 1024 * 1024);
+		benchmarkBatch(t.map, "ThreadStripedLockPolicy");
+	}
+}
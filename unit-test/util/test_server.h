@@ -98,6 +98,28 @@ protected:
 /**
  * 处理类, 每个处理线程一个对象
  */
+class TcpSliceHandle : public TC_EpollServer::Handle
+{
+public:
+
+	virtual void handle(const shared_ptr<TC_EpollServer::RecvContext> &data)
+	{
+		//slice protocol解析的包直接引用接收buffer
+		if(data->slice().empty())
+		{
+			close(data);
+			return;
+		}
+
+		shared_ptr<TC_EpollServer::SendContext> send = data->createSendContext();
+
+		auto p = data->getBufferPointer();
+
+		send->buffer()->addBuffer(p.first, p.second);
+		sendResponse(send);
+	}
+};
+
 class TcpQueueHandle : public TC_EpollServer::Handle
 {
 public:
@@ -233,6 +255,34 @@ public:
 		_epollServer->bind(lsPtr);
 	}
 
+	void bindTcpSlice(const std::string &str, int maxConnections = 10240)
+	{
+		TC_EpollServer::BindAdapterPtr lsPtr = _epollServer->createBindAdapter<TcpSliceHandle>("TcpSliceAdapter", str, 5);
+
+		//设置最大连接数
+		lsPtr->setMaxConns(maxConnections);
+		//设置协议解析器
+		lsPtr->setProtocol(TC_NetWorkBuffer::parseBinary4<8, 1024*1024>);
+		lsPtr->setSliceProtocol(TC_NetWorkBuffer::parseBinary4Slice<8, 1024*1024>);
+		//绑定对象
+		_epollServer->bind(lsPtr);
+	}
+
+	void bindTcpLockFree(const std::string &str, size_t capacity)
+	{
+		TC_EpollServer::BindAdapterPtr lsPtr = _epollServer->createBindAdapter<TcpHandle>("TcpLockFreeAdapter", str, 5);
+
+		//使用无锁队列
+		lsPtr->enableLockFreeQueue(capacity);
+
+		//设置最大连接数
+		lsPtr->setMaxConns(10240);
+		//设置协议解析器
+		lsPtr->setProtocol(parseLine);
+		//绑定对象
+		_epollServer->bind(lsPtr);
+	}
+
 	void bindTcpQueue(const std::string &str)
 	{
         TC_EpollServer::BindAdapterPtr lsPtr = _epollServer->createBindAdapter<TcpQueueHandle>("TcpQueueAdapter", str, 5);
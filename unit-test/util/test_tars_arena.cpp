@@ -0,0 +1,315 @@
+﻿#include "tup/Tars.h"
+#include "util/tc_common.h"
+#include "util/tc_logger.h"
+#include "gtest/gtest.h"
+#include "TarsArenaRsp.h"
+
+#include <sstream>
+
+using namespace std;
+using namespace tars;
+
+class TarsArenaTest : public testing::Test
+{
+public:
+	//添加日志
+	static void SetUpTestCase()
+	{
+	}
+	static void TearDownTestCase()
+	{
+	}
+	virtual void SetUp()   //TEST跑之前会执行SetUp
+	{
+	}
+	virtual void TearDown() //TEST跑完之后会执行TearDown
+	{
+	}
+};
+
+//统计堆分配次数的分配器, 行为和std::allocator一致
+static size_t g_allocCount = 0;
+
+template<typename T>
+struct CountAllocator
+{
+	typedef T value_type;
+
+	template<typename U>
+	struct rebind
+	{
+		typedef CountAllocator<U> other;
+	};
+
+	CountAllocator() {}
+
+	template<typename U>
+	CountAllocator(const CountAllocator<U> &) {}
+
+	T *allocate(size_t n)
+	{
+		++g_allocCount;
+		return (T*)::operator new(n * sizeof(T));
+	}
+
+	void deallocate(T *p, size_t)
+	{
+		::operator delete(p);
+	}
+};
+
+template<typename T, typename U>
+bool operator==(const CountAllocator<T> &, const CountAllocator<U> &) { return true; }
+
+template<typename T, typename U>
+bool operator!=(const CountAllocator<T> &, const CountAllocator<U> &) { return false; }
+
+//和TarsArenaRsp.tars中TestRsp一样的编解码, 容器类型由分配器决定, 用于生成测试数据和对比普通的分配器
+template<template<typename> class A>
+struct TestRsp
+{
+	typedef std::basic_string<char, std::char_traits<char>, A<char> > S;
+	typedef std::vector<S, A<S> > V;
+	typedef std::map<S, V, std::less<S>, A<std::pair<const S, V> > > M;
+
+	Int32 iRet = 0;
+	M mData;
+	V vKeys;
+
+	template<typename WriterT>
+	void writeTo(TarsOutputStream<WriterT>& _os) const
+	{
+		_os.write(iRet, 0);
+		_os.write(mData, 1);
+		_os.write(vKeys, 2);
+	}
+
+	template<typename ReaderT>
+	void readFrom(TarsInputStream<ReaderT>& _is)
+	{
+		_is.read(iRet, 0, true);
+		_is.read(mData, 1, false);
+		_is.read(vKeys, 2, false);
+	}
+};
+
+static vector<char> createResponse(size_t count)
+{
+	TestRsp<std::allocator> rsp;
+	rsp.iRet = 1;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		string key = "key_" + TC_Common::tostr(i) + "_abcdefghijklmnopqrstuvwxyz";
+		rsp.vKeys.push_back(key);
+		rsp.mData[TC_Common::tostr(i % (count / 10 + 1))].push_back(key);
+	}
+
+	TarsOutputStream<BufferWriterVector> os;
+	rsp.writeTo(os);
+	return os.getByteBuffer();
+}
+
+TEST_F(TarsArenaTest, testArena)
+{
+	TarsArena arena(1024);
+
+	ASSERT_TRUE(TarsArena::current() == NULL);
+
+	char *p1 = (char*)arena.allocate(10, 1);
+	char *p2 = (char*)arena.allocate(8, 8);
+	ASSERT_TRUE(((size_t)p2 & 7) == 0);
+	ASSERT_TRUE(p2 > p1);
+	ASSERT_TRUE(arena.blockCount() == 1);
+
+	//大块单独申请
+	arena.allocate(4096);
+	ASSERT_TRUE(arena.blockCount() == 2);
+
+	for (int i = 0; i < 100; i++)
+	{
+		arena.allocate(100);
+	}
+	size_t blocks = arena.blockCount();
+	ASSERT_TRUE(blocks > 2);
+
+	//reset后块复用, 大块释放
+	arena.reset();
+	ASSERT_TRUE(arena.allocated() == 0);
+	ASSERT_TRUE(arena.blockCount() == blocks - 1);
+
+	for (int i = 0; i < 100; i++)
+	{
+		arena.allocate(100);
+	}
+	ASSERT_TRUE(arena.blockCount() == blocks - 1);
+
+	{
+		TarsArena::Scope scope(arena);
+		ASSERT_TRUE(TarsArena::current() == &arena);
+
+		TarsArena inner;
+		{
+			TarsArena::Scope scope2(inner);
+			ASSERT_TRUE(TarsArena::current() == &inner);
+		}
+		ASSERT_TRUE(TarsArena::current() == &arena);
+	}
+	ASSERT_TRUE(TarsArena::current() == NULL);
+}
+
+TEST_F(TarsArenaTest, testAllocator)
+{
+	TarsArena arena;
+
+	TarsArenaString out;
+	ASSERT_TRUE(out.get_allocator().arena() == NULL);
+
+	{
+		TarsArena::Scope scope(arena);
+
+		TarsArenaVector<TarsArenaString> v;
+		ASSERT_TRUE(v.get_allocator().arena() == &arena);
+
+		v.resize(10);
+		for (size_t i = 0; i < v.size(); i++)
+		{
+			ASSERT_TRUE(v[i].get_allocator().arena() == &arena);
+			v[i] = "abcdefghijklmnopqrstuvwxyz0123456789";
+		}
+		ASSERT_TRUE(arena.allocated() > 0);
+
+		//拷贝出Scope之外的数据用堆分配
+		out = v[0];
+		ASSERT_TRUE(out.get_allocator().arena() == NULL);
+	}
+
+	TarsArenaVector<TarsArenaString> heap;
+	heap.push_back(out);
+	ASSERT_TRUE(heap.get_allocator().arena() == NULL);
+	ASSERT_TRUE(heap[0] == "abcdefghijklmnopqrstuvwxyz0123456789");
+
+	arena.reset();
+	ASSERT_TRUE(out == "abcdefghijklmnopqrstuvwxyz0123456789");
+}
+
+TEST_F(TarsArenaTest, testDecode)
+{
+	vector<char> buff = createResponse(1000);
+
+	TestRsp<std::allocator> expect;
+	{
+		TarsInputStream<BufferReader> is;
+		is.setBuffer(buff);
+		expect.readFrom(is);
+	}
+
+	//tars2cpp --arena生成的结构, Scope之外用堆分配
+	{
+		TestArena::TestRsp rsp;
+
+		TarsInputStream<BufferReader> is;
+		is.setBuffer(buff);
+		rsp.readFrom(is);
+
+		ASSERT_TRUE(rsp.vKeys.get_allocator().arena() == NULL);
+		ASSERT_TRUE(rsp.vKeys.size() == expect.vKeys.size());
+	}
+
+	TarsArena arena;
+	{
+		TarsArena::Scope scope(arena);
+
+		TestArena::TestRsp rsp;
+
+		TarsInputStream<BufferReader> is;
+		is.setBuffer(buff);
+		rsp.readFrom(is);
+
+		ASSERT_TRUE(rsp.mData.get_allocator().arena() == &arena);
+		ASSERT_TRUE(rsp.vKeys.get_allocator().arena() == &arena);
+		ASSERT_TRUE(rsp.vKeys[0].get_allocator().arena() == &arena);
+		ASSERT_TRUE(arena.allocated() > 0);
+		ASSERT_TRUE(rsp.iRet == expect.iRet);
+		ASSERT_TRUE(rsp.vKeys.size() == expect.vKeys.size());
+		for (size_t i = 0; i < rsp.vKeys.size(); i++)
+		{
+			ASSERT_TRUE(string(rsp.vKeys[i].data(), rsp.vKeys[i].size()) == expect.vKeys[i]);
+		}
+
+		ASSERT_TRUE(rsp.mData.size() == expect.mData.size());
+		auto it = expect.mData.begin();
+		for (auto &kv : rsp.mData)
+		{
+			ASSERT_TRUE(string(kv.first.data(), kv.first.size()) == it->first);
+			ASSERT_TRUE(kv.second.size() == it->second.size());
+			++it;
+		}
+
+		//重新编码结果一致
+		TarsOutputStream<BufferWriterVector> os;
+		rsp.writeTo(os);
+		ASSERT_TRUE(os.getByteBuffer() == buff);
+
+		ostringstream ds;
+		rsp.display(ds);
+		ASSERT_TRUE(ds.str().find(expect.vKeys[0]) != string::npos);
+
+		//拷贝比较
+		TestArena::TestRsp copy = rsp;
+		ASSERT_TRUE(copy == rsp);
+	}
+}
+
+TEST_F(TarsArenaTest, testBenchmark)
+{
+	vector<char> buff = createResponse(5000);
+
+	const int count = 200;
+
+	{
+		int64_t start = TNOWUS;
+		for (int i = 0; i < count; i++)
+		{
+			TestRsp<std::allocator> rsp;
+			TarsInputStream<BufferReader> is;
+			is.setBuffer(buff);
+			rsp.readFrom(is);
+		}
+		int64_t us = TNOWUS - start;
+
+		g_allocCount = 0;
+		{
+			TestRsp<CountAllocator> rsp;
+			TarsInputStream<BufferReader> is;
+			is.setBuffer(buff);
+			rsp.readFrom(is);
+		}
+
+		LOG_CONSOLE_DEBUG << "std::allocator, decode: " << count * 1000000 / (us + 1) << "/s, " << us / count << "us/decode, alloc count: " << g_allocCount << "/decode" << endl;
+	}
+
+	{
+		TarsArena arena(64 * 1024);
+
+		int64_t start = TNOWUS;
+		size_t blocks = 0;
+		for (int i = 0; i < count; i++)
+		{
+			{
+				TarsArena::Scope scope(arena);
+
+				TestArena::TestRsp rsp;
+				TarsInputStream<BufferReader> is;
+				is.setBuffer(buff);
+				rsp.readFrom(is);
+			}
+
+			blocks = arena.blockCount();
+			arena.reset();
+		}
+		int64_t us = TNOWUS - start;
+
+		LOG_CONSOLE_DEBUG << "TarsArena, decode: " << count * 1000000 / (us + 1) << "/s, " << us / count << "us/decode, alloc count: <=" << blocks << "/decode" << endl;
+	}
+}
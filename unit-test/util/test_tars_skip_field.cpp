@@ -0,0 +1,275 @@
+﻿#include "tup/Tars.h"
+#include "servant/StatF.h"
+#include "servant/PropertyF.h"
+#include "util/tc_common.h"
+#include "util/tc_logger.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tars;
+
+class TarsSkipFieldTest : public testing::Test
+{
+public:
+	//添加日志
+	static void SetUpTestCase()
+	{
+	}
+	static void TearDownTestCase()
+	{
+	}
+	virtual void SetUp()   //TEST跑之前会执行SetUp
+	{
+	}
+	virtual void TearDown() //TEST跑完之后会执行TearDown
+	{
+	}
+};
+
+//原来逐个DataHead读取的跳过实现, 用于对比
+template<typename ReaderT>
+static void legacySkipField(TarsInputStream<ReaderT> &is, uint8_t type);
+
+template<typename ReaderT>
+static void legacySkipField(TarsInputStream<ReaderT> &is)
+{
+	uint8_t headType = 0;
+	readFromHeadNoTag(is, headType);
+	legacySkipField(is, headType);
+}
+
+template<typename ReaderT>
+static void legacySkipField(TarsInputStream<ReaderT> &is, uint8_t type)
+{
+	switch (type)
+	{
+		case TarsHeadeChar: TarsReadHeadSkip(is, sizeof(Char)); break;
+		case TarsHeadeShort: TarsReadHeadSkip(is, sizeof(Short)); break;
+		case TarsHeadeInt32: TarsReadHeadSkip(is, sizeof(Int32)); break;
+		case TarsHeadeInt64: TarsReadHeadSkip(is, sizeof(Int64)); break;
+		case TarsHeadeFloat: TarsReadHeadSkip(is, sizeof(Float)); break;
+		case TarsHeadeDouble: TarsReadHeadSkip(is, sizeof(Double)); break;
+		case TarsHeadeString1:
+		{
+			size_t len = 0;
+			TarsReadTypeBuf(is, len, uint8_t);
+			TarsReadHeadSkip(is, len);
+			break;
+		}
+		case TarsHeadeString4:
+		{
+			uint32_t len = 0;
+			TarsReadTypeBuf(is, len, uint32_t);
+			len = ntohl((uint32_t)len);
+			TarsReadHeadSkip(is, len);
+			break;
+		}
+		case TarsHeadeMap:
+		{
+			UInt32 size = 0;
+			is.read(size, 0);
+			for (UInt32 i = 0; i < size * 2; ++i)
+				legacySkipField(is);
+			break;
+		}
+		case TarsHeadeList:
+		{
+			UInt32 size = 0;
+			is.read(size, 0);
+			for (UInt32 i = 0; i < size; ++i)
+				legacySkipField(is);
+			break;
+		}
+		case TarsHeadeSimpleList:
+		{
+			uint8_t headType = 0, headTag = 0;
+			readFromHead(is, headType, headTag);
+			//SimpleList的元素头固定是tag 0的char
+			EXPECT_TRUE(headType == TarsHeadeChar);
+			EXPECT_TRUE(headTag == 0);
+			UInt32 size = 0;
+			is.read(size, 0);
+			TarsReadHeadSkip(is, size);
+			break;
+		}
+		case TarsHeadeStructBegin:
+		{
+			uint8_t headType = 0;
+			do
+			{
+				readFromHeadNoTag(is, headType);
+				legacySkipField(is, headType);
+			} while (headType != TarsHeadeStructEnd);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+//上报给stat/property的包: tag 0是map, 老版本的服务端只认识tag 1
+static vector<char> createStatPayload(size_t count)
+{
+	map<StatMicMsgHead, StatMicMsgBody> stat;
+	for (size_t i = 0; i < count; i++)
+	{
+		StatMicMsgHead head;
+		head.masterName = "Test.ClientServer";
+		head.slaveName = "Test.HelloServer.HelloObj";
+		head.interfaceName = "testHello" + TC_Common::tostr(i);
+		head.masterIp = "192.168.0.1";
+		head.slaveIp = "192.168.0.2";
+		head.slavePort = 10000 + i;
+		head.tarsVersion = "3.0.0";
+
+		StatMicMsgBody body;
+		body.count = i;
+		body.timeoutCount = i % 3;
+		body.execCount = i % 5;
+		body.intervalCount[100] = i;
+		body.intervalCount[500] = i * 2;
+		body.intervalCount[1000] = i * 3;
+		body.totalRspTime = i * 10;
+		body.maxRspTime = 100;
+		body.minRspTime = 1;
+
+		stat[head] = body;
+	}
+
+	map<StatPropMsgHead, StatPropMsgBody> prop;
+	for (size_t i = 0; i < count; i++)
+	{
+		StatPropMsgHead head;
+		head.moduleName = "Test.HelloServer";
+		head.ip = "192.168.0.1";
+		head.propertyName = "queue_size" + TC_Common::tostr(i);
+
+		StatPropMsgBody body;
+		for (int j = 0; j < 4; j++)
+		{
+			StatPropInfo info;
+			info.policy = "Avg";
+			info.value = TC_Common::tostr(i * j);
+			body.vInfo.push_back(info);
+		}
+		prop[head] = body;
+	}
+
+	TarsOutputStream<BufferWriterVector> os;
+	os.write(stat, 0);
+	os.write(prop, 1);
+	os.write(vector<char>(100, 'a'), 2);
+	os.write((Int64)1, 3);
+	return os.getByteBuffer();
+}
+
+TEST_F(TarsSkipFieldTest, testSkip)
+{
+	vector<char> buff = createStatPayload(100);
+
+	//逐个字段跳过, 位置和原来的实现一致
+	TarsInputStream<BufferReader> is1;
+	TarsInputStream<BufferReader> is2;
+	is1.setBuffer(buff);
+	is2.setBuffer(buff);
+
+	while (!is1.hasEnd())
+	{
+		is1.skipField();
+		legacySkipField(is2);
+		ASSERT_TRUE(is1.tellp() == is2.tellp());
+	}
+	ASSERT_TRUE(is1.tellp() == buff.size());
+
+	//跳到后面的tag
+	TarsInputStream<BufferReader> is;
+	is.setBuffer(buff);
+	Int64 n = 0;
+	is.read(n, 3, true);
+	ASSERT_TRUE(n == 1);
+
+	//跳过结构
+	StatMicMsgHead head;
+	head.interfaceName = "testHello";
+	StatMicMsgBody body;
+	TarsOutputStream<BufferWriterVector> os;
+	os.write(head, 0);
+	os.write(body, 1);
+	os.write(string("end"), 2);
+
+	is.setBuffer(os.getByteBuffer());
+	string s;
+	is.read(s, 2, true);
+	ASSERT_TRUE(s == "end");
+}
+
+TEST_F(TarsSkipFieldTest, testOverflow)
+{
+	vector<char> buff = createStatPayload(10);
+
+	//截断的包跳过时抛异常, 不越界
+	for (size_t len = 0; len < buff.size(); len += 7)
+	{
+		TarsInputStream<BufferReader> is;
+		is.setBuffer(buff.data(), len);
+		ASSERT_THROW(
+			while (true) { is.skipField(); if (is.hasEnd()) throw TarsDecodeException("end"); },
+			TarsDecodeException);
+		ASSERT_TRUE(is.tellp() <= len);
+	}
+
+	//list长度远超包长
+	TarsOutputStream<BufferWriterVector> os;
+	DataHead::writeTo(os, TarsHeadeList, 0);
+	os.write((Int32)0x7fffffff, 0);
+	os.write((Int32)1, 0);
+
+	TarsInputStream<BufferReader> is;
+	is.setBuffer(os.getByteBuffer());
+	ASSERT_THROW(is.skipField(), TarsDecodeException);
+}
+
+TEST_F(TarsSkipFieldTest, testBenchmark)
+{
+	vector<char> buff = createStatPayload(1000);
+
+	const int count = 200;
+
+	int64_t start = TNOWUS;
+	for (int i = 0; i < count; i++)
+	{
+		TarsInputStream<BufferReader> is;
+		is.setBuffer(buff);
+		while (!is.hasEnd())
+		{
+			legacySkipField(is);
+		}
+	}
+	int64_t us1 = TNOWUS - start;
+
+	start = TNOWUS;
+	for (int i = 0; i < count; i++)
+	{
+		TarsInputStream<BufferReader> is;
+		is.setBuffer(buff);
+		while (!is.hasEnd())
+		{
+			is.skipField();
+		}
+	}
+	int64_t us2 = TNOWUS - start;
+
+	//老服务端只读最后一个tag, 前面的StatF/PropertyF数据都要跳过
+	start = TNOWUS;
+	for (int i = 0; i < count; i++)
+	{
+		TarsInputStream<BufferReader> is;
+		is.setBuffer(buff);
+		Int64 n = 0;
+		is.read(n, 3, true);
+	}
+	int64_t us3 = TNOWUS - start;
+
+	LOG_CONSOLE_DEBUG << "payload: " << buff.size() << " bytes, legacy skip: " << us1 / count << "us, table skip: " << us2 / count
+		<< "us, skip to tag: " << us3 / count << "us, " << (double)buff.size() * count / (us2 + 1) << "MB/s" << endl;
+}
@@ -0,0 +1,190 @@
+﻿#include "util/tc_consistent_hash_ring.h"
+#include "util/tc_common.h"
+#include "util/tc_logger.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace tars;
+
+class UtilConsistentHashRingTest : public testing::Test
+{
+public:
+	//添加日志
+	static void SetUpTestCase()
+	{
+	}
+	static void TearDownTestCase()
+	{
+	}
+	virtual void SetUp()   //TEST跑之前会执行SetUp
+	{
+	}
+	virtual void TearDown() //TEST跑完之后会执行TearDown
+	{
+	}
+};
+
+//和EndpointManager一样: 节点名是ip, 每个权重单位ketama生成4个虚拟节点
+template<typename T>
+static void buildRing(T &conHash, size_t nodes, int weight)
+{
+	conHash.clear();
+	for (size_t i = 0; i < nodes; i++)
+	{
+		conHash.addNode("192.168." + TC_Common::tostr(i / 256) + "." + TC_Common::tostr(i % 256), i, weight);
+	}
+	conHash.sortNode();
+}
+
+TEST_F(UtilConsistentHashRingTest, testCompatible)
+{
+	for (auto hashType : {E_TC_CONHASH_KETAMAHASH, E_TC_CONHASH_DEFAULTHASH})
+	{
+		TC_ConsistentHashNew oldHash(hashType);
+		TC_ConsistentHashRing ring(hashType);
+
+		unsigned int index = 0;
+		ASSERT_TRUE(ring.getIndex((uint32_t)1, index) == -1);
+
+		buildRing(oldHash, 20, 25);
+		buildRing(ring, 20, 25);
+
+		ASSERT_TRUE(ring.size() == oldHash.size());
+		ASSERT_TRUE(ring.nodeCount() == 20);
+
+		srand(1);
+		for (int i = 0; i < 100000; i++)
+		{
+			uint32_t hashcode = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+			if (i < 3)
+			{
+				//环的两端
+				hashcode = (i == 0 ? 0 : (i == 1 ? 1 : 0xFFFFFFFF));
+			}
+
+			unsigned int i1 = 0, i2 = 0;
+			ASSERT_TRUE(oldHash.getIndex(hashcode, i1) == 0);
+			ASSERT_TRUE(ring.getIndex(hashcode, i2) == 0);
+			ASSERT_TRUE(i1 == i2);
+		}
+
+		unsigned int i1 = 0, i2 = 0;
+		oldHash.getIndex(string("abc"), i1);
+		ring.getIndex(string("abc"), i2);
+		ASSERT_TRUE(i1 == i2);
+	}
+}
+
+TEST_F(UtilConsistentHashRingTest, testBoundedLoad)
+{
+	TC_ConsistentHashRing ring;
+	buildRing(ring, 10, 25);
+
+	vector<size_t> loads(10, 0);
+	auto load = [&](unsigned int i) { return loads[i]; };
+
+	//没有负载时和普通查找一致
+	for (uint32_t hashcode = 0; hashcode < 0xFFFF0000; hashcode += 0x10001)
+	{
+		unsigned int i1 = 0, i2 = 0;
+		ring.getIndex(hashcode, i1);
+		ring.getIndex(hashcode, i2, 1.25, load);
+		ASSERT_TRUE(i1 == i2);
+	}
+
+	//热点key: 都是同一个hash值, 负载分摊到其他节点, 每个节点不超过上限
+	const double c = 1.25;
+	unsigned int hot = 0;
+	ring.getIndex((uint32_t)12345, hot);
+
+	size_t total = 0;
+	for (int i = 0; i < 1000; i++)
+	{
+		unsigned int index = 0;
+		ring.getIndex((uint32_t)12345, index, c, load);
+
+		ASSERT_TRUE(loads[index] < (size_t)ceil(c * (total + 1) / loads.size()));
+
+		++loads[index];
+		++total;
+	}
+
+	size_t maxLoad = *max_element(loads.begin(), loads.end());
+	ASSERT_TRUE(maxLoad <= (size_t)ceil(c * total / loads.size()));
+	ASSERT_TRUE(loads[hot] == maxLoad);
+
+	//负载下降后回到原来的节点
+	loads.assign(loads.size(), 0);
+	unsigned int index = 0;
+	ring.getIndex((uint32_t)12345, index, c, load);
+	ASSERT_TRUE(index == hot);
+}
+
+TEST_F(UtilConsistentHashRingTest, testBenchmark)
+{
+	//1k和10k个虚拟节点
+	for (size_t nodes : {10, 100})
+	{
+		const int weight = 25;
+		const int buildCount = 100;
+		const int count = 1000000;
+
+		TC_ConsistentHashNew oldHash(E_TC_CONHASH_KETAMAHASH);
+		TC_ConsistentHashRing ring(E_TC_CONHASH_KETAMAHASH);
+
+		int64_t start = TC_Common::now2us();
+		for (int i = 0; i < buildCount; i++)
+		{
+			buildRing(oldHash, nodes, weight);
+		}
+		int64_t oldBuild = (TC_Common::now2us() - start) / buildCount;
+
+		start = TC_Common::now2us();
+		for (int i = 0; i < buildCount; i++)
+		{
+			buildRing(ring, nodes, weight);
+		}
+		int64_t ringBuild = (TC_Common::now2us() - start) / buildCount;
+
+		vector<uint32_t> hashcodes(count);
+		for (int i = 0; i < count; i++)
+		{
+			hashcodes[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+		}
+
+		//EndpointManager原来按节点名查找
+		size_t sum = 0;
+		string sNode;
+		start = TC_Common::now2us();
+		for (int i = 0; i < count; i++)
+		{
+			oldHash.getNodeName(hashcodes[i], sNode);
+			sum += sNode.size();
+		}
+		int64_t oldLookup = TC_Common::now2us() - start;
+
+		unsigned int index = 0;
+		start = TC_Common::now2us();
+		for (int i = 0; i < count; i++)
+		{
+			ring.getIndex(hashcodes[i], index);
+			sum += index;
+		}
+		int64_t ringLookup = TC_Common::now2us() - start;
+
+		vector<size_t> loads(nodes, 10);
+		start = TC_Common::now2us();
+		for (int i = 0; i < count; i++)
+		{
+			ring.getIndex(hashcodes[i], index, 1.25, [&](unsigned int n) { return loads[n]; });
+			sum += index;
+		}
+		int64_t boundedLookup = TC_Common::now2us() - start;
+
+		LOG_CONSOLE_DEBUG << "virtual nodes: " << ring.size() << ", rebuild: TC_ConsistentHashNew " << oldBuild << "us, TC_ConsistentHashRing " << ringBuild << "us"
+			<< ", lookup: TC_ConsistentHashNew " << oldLookup * 1000 / count << "ns, TC_ConsistentHashRing " << ringLookup * 1000 / count
+			<< "ns, bounded " << boundedLookup * 1000 / count << "ns, " << sum % 2 << endl;
+	}
+}
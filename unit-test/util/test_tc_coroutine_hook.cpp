@@ -0,0 +1,464 @@
+﻿#include "util/tc_coroutine.h"
+#include "util/tc_coroutine_hook.h"
+#include "util/tc_clientsocket.h"
+#include "util/tc_common.h"
+#include "util/tc_logger.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+//只有打开TARS_CORO_HOOK编译时才有效
+#if TARGET_PLATFORM_LINUX && TARS_CORO_HOOK
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace std;
+using namespace tars;
+
+class UtilCoroutineHookTest : public testing::Test
+{
+public:
+	//添加日志
+	static void SetUpTestCase()
+	{
+	}
+	static void TearDownTestCase()
+	{
+	}
+	virtual void SetUp()   //TEST跑之前会执行SetUp
+	{
+	}
+	virtual void TearDown() //TEST跑完之后会执行TearDown
+	{
+	}
+};
+
+//阻塞的echo服务, 每个连接一个线程, 回包前延迟
+class DelayEchoServer
+{
+public:
+	DelayEchoServer(int delayMs) : _delay(delayMs)
+	{
+		_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+
+		int on = 1;
+		::setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+		struct sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+		addr.sin_port = 0;
+		::bind(_fd, (struct sockaddr*)&addr, sizeof(addr));
+		::listen(_fd, 128);
+
+		socklen_t len = sizeof(addr);
+		::getsockname(_fd, (struct sockaddr*)&addr, &len);
+		_port = ntohs(addr.sin_port);
+
+		_thread = std::thread([this]()
+		{
+			while (true)
+			{
+				int cfd = ::accept(_fd, NULL, NULL);
+				if (cfd < 0)
+				{
+					break;
+				}
+
+				std::thread([this, cfd]()
+				{
+					char buff[1024];
+					ssize_t n;
+					while ((n = ::recv(cfd, buff, sizeof(buff), 0)) > 0)
+					{
+						std::this_thread::sleep_for(std::chrono::milliseconds(_delay));
+						::send(cfd, buff, n, 0);
+					}
+					::close(cfd);
+				}).detach();
+			}
+		});
+	}
+
+	~DelayEchoServer()
+	{
+		::shutdown(_fd, SHUT_RDWR);
+		::close(_fd);
+		_thread.join();
+	}
+
+	int port() const { return _port; }
+
+protected:
+	int			_fd;
+	int			_port;
+	int			_delay;
+	std::thread	_thread;
+};
+
+static int64_t runCoroutines(size_t count, const std::function<void(size_t)> &func)
+{
+	int64_t start = TNOWMS;
+
+	std::thread th([&]()
+	{
+		auto scheduler = TC_CoroutineScheduler::create();
+		scheduler->setPoolStackSize(count, 128 * 1024);
+		scheduler->setNoCoroutineCallback([](TC_CoroutineScheduler *s){ s->terminate(); });
+
+		for (size_t i = 0; i < count; i++)
+		{
+			scheduler->go(std::bind(func, i));
+		}
+
+		scheduler->run();
+
+		TC_CoroutineScheduler::reset();
+	});
+	th.join();
+
+	return TNOWMS - start;
+}
+
+TEST_F(UtilCoroutineHookTest, testSleep)
+{
+	std::atomic<int> done{0};
+
+	//10个协程各sleep 100ms, 并发执行
+	int64_t cost = runCoroutines(10, [&](size_t i)
+	{
+		ASSERT_TRUE(TC_CoroutineHook::isHooked());
+
+		if (i % 3 == 0)
+		{
+			usleep(100 * 1000);
+		}
+		else if (i % 3 == 1)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+		else
+		{
+			struct timespec ts = {0, 100 * 1000 * 1000};
+			nanosleep(&ts, NULL);
+		}
+		++done;
+	});
+
+	ASSERT_TRUE(done == 10);
+	ASSERT_TRUE(cost < 500);
+
+	//不在协程中不hook
+	ASSERT_FALSE(TC_CoroutineHook::isHooked());
+	int64_t start = TNOWMS;
+	usleep(20 * 1000);
+	ASSERT_TRUE(TNOWMS - start >= 20);
+}
+
+TEST_F(UtilCoroutineHookTest, testSocket)
+{
+	DelayEchoServer server(100);
+
+	const size_t count = 10;
+	std::atomic<int> done{0};
+
+	//原生的阻塞socket调用
+	int64_t cost = runCoroutines(count, [&](size_t i)
+	{
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		ASSERT_TRUE(fd >= 0);
+
+		//对业务仍然是阻塞的
+		ASSERT_TRUE((fcntl(fd, F_GETFL, 0) & O_NONBLOCK) == 0);
+
+		struct sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+		addr.sin_port = htons(server.port());
+		ASSERT_TRUE(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+
+		string data = "hello" + TC_Common::tostr(i);
+		ASSERT_TRUE(send(fd, data.c_str(), data.size(), 0) == (ssize_t)data.size());
+
+		char buff[1024];
+		ssize_t n = recv(fd, buff, sizeof(buff), 0);
+		ASSERT_TRUE(n == (ssize_t)data.size());
+		ASSERT_TRUE(string(buff, n) == data);
+
+		//接收超时
+		struct timeval tv = {0, 50 * 1000};
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+		int64_t start = TNOWMS;
+		ASSERT_TRUE(read(fd, buff, sizeof(buff)) == -1 && errno == EAGAIN);
+		ASSERT_TRUE(TNOWMS - start >= 40);
+
+		close(fd);
+		++done;
+	});
+
+	ASSERT_TRUE(done == (int)count);
+	ASSERT_TRUE(cost < 100 * (int)count / 2);
+
+	LOG_CONSOLE_DEBUG << count << " blocking requests(100ms) in coroutines, cost: " << cost << "ms" << endl;
+
+	//不在协程中创建的socket不处理
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	ASSERT_TRUE((fcntl(fd, F_GETFL, 0) & O_NONBLOCK) == 0);
+	close(fd);
+}
+
+TEST_F(UtilCoroutineHookTest, testTCPClient)
+{
+	DelayEchoServer server(100);
+
+	const size_t count = 10;
+	std::atomic<int> done{0};
+
+	//TC_TCPClient内部用自己的TC_Epoller等待
+	int64_t cost = runCoroutines(count, [&](size_t i)
+	{
+		TC_TCPClient client;
+		client.init("127.0.0.1", server.port(), 3000);
+
+		string data = "hello" + TC_Common::tostr(i);
+		char buff[1024];
+		size_t len = sizeof(buff);
+		ASSERT_TRUE(client.sendRecv(data.c_str(), data.size(), buff, len) == TC_ClientSocket::EM_SUCCESS);
+		ASSERT_TRUE(string(buff, len) == data);
+		++done;
+	});
+
+	ASSERT_TRUE(done == (int)count);
+	ASSERT_TRUE(cost < 100 * (int)count / 2);
+}
+
+TEST_F(UtilCoroutineHookTest, testGethostbyname)
+{
+	std::atomic<int> done{0};
+
+	runCoroutines(5, [&](size_t i)
+	{
+		struct hostent *host = gethostbyname("localhost");
+		ASSERT_TRUE(host != NULL);
+		ASSERT_TRUE(host->h_addrtype == AF_INET);
+		++done;
+	});
+
+	ASSERT_TRUE(done == 5);
+}
+
+TEST_F(UtilCoroutineHookTest, testPollFile)
+{
+	std::atomic<int> done{0};
+
+	//普通文件不能加入epoll, 退回到系统poll, 不能等到超时
+	runCoroutines(1, [&](size_t i)
+	{
+		FILE *fp = tmpfile();
+		ASSERT_TRUE(fp != NULL);
+
+		struct pollfd pfd;
+		pfd.fd = fileno(fp);
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+
+		int64_t start = TNOWMS;
+		ASSERT_TRUE(poll(&pfd, 1, 1000) == 1);
+		ASSERT_TRUE(pfd.revents & POLLIN);
+
+		//直接在协程中等待
+		ASSERT_TRUE(TC_CoroutineHook::wait(pfd.fd, POLLIN, 1000) == 1);
+		ASSERT_TRUE(TNOWMS - start < 500);
+
+		fclose(fp);
+		++done;
+	});
+
+	ASSERT_TRUE(done == 1);
+}
+
+TEST_F(UtilCoroutineHookTest, testPollRegisteredFd)
+{
+	std::atomic<int> done{0};
+
+	runCoroutines(1, [&](size_t i)
+	{
+		int fds[2];
+		ASSERT_TRUE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+		//业务自己已经把句柄注册到调度器的epoll中
+		TC_Epoller *epoller = TC_CoroutineScheduler::scheduler()->getEpoller();
+
+		int fired = 0;
+		map<uint32_t, TC_Epoller::EpollInfo::EVENT_CALLBACK> callbacks;
+		callbacks[EPOLLIN] = [&](const shared_ptr<TC_Epoller::EpollInfo> &) { ++fired; return true; };
+
+		shared_ptr<TC_Epoller::EpollInfo> info = epoller->createEpollInfo(fds[0]);
+		info->registerCallback(callbacks, EPOLLIN);
+
+		std::thread writer([&]()
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			ASSERT_TRUE(::write(fds[1], "a", 1) == 1);
+		});
+
+		//同一个句柄已经在epoll中, 且fds中也有重复的句柄
+		struct pollfd pfd[2];
+		pfd[0].fd = fds[0];
+		pfd[0].events = POLLIN;
+		pfd[0].revents = 0;
+		pfd[1] = pfd[0];
+
+		int64_t start = TNOWMS;
+		ASSERT_TRUE(poll(pfd, 2, 1000) == 2);
+		ASSERT_TRUE(pfd[0].revents & POLLIN);
+		ASSERT_TRUE(TNOWMS - start < 500);
+
+		writer.join();
+
+		char c;
+		ASSERT_TRUE(::read(fds[0], &c, 1) == 1);
+
+		//业务原来的注册不受影响
+		fired = 0;
+		ASSERT_TRUE(::write(fds[1], "b", 1) == 1);
+		usleep(50 * 1000);
+		ASSERT_TRUE(fired > 0);
+		ASSERT_TRUE(::read(fds[0], &c, 1) == 1);
+
+		epoller->releaseEpollInfo(info);
+		::close(fds[0]);
+		::close(fds[1]);
+		++done;
+	});
+
+	ASSERT_TRUE(done == 1);
+}
+
+TEST_F(UtilCoroutineHookTest, testSendtoFull)
+{
+	std::atomic<int> done{0};
+
+	int receiver = -1;
+	size_t queued = 0;
+
+	runCoroutines(2, [&](size_t i)
+	{
+		if(i == 0)
+		{
+			struct sockaddr_un addr;
+			memset(&addr, 0, sizeof(addr));
+			addr.sun_family = AF_UNIX;
+			string name = "tars_hook_sendto_" + TC_Common::tostr(getpid());
+			memcpy(addr.sun_path + 1, name.c_str(), name.size());
+			socklen_t len = offsetof(struct sockaddr_un, sun_path) + 1 + name.size();
+
+			int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+			ASSERT_TRUE(bind(fd, (struct sockaddr*)&addr, len) == 0);
+
+			int sender = socket(AF_UNIX, SOCK_DGRAM, 0);
+			ASSERT_TRUE(connect(sender, (struct sockaddr*)&addr, len) == 0);
+
+			//非阻塞写满接收队列
+			int flags = fcntl(sender, F_GETFL, 0);
+			fcntl(sender, F_SETFL, flags | O_NONBLOCK);
+			while(sendto(sender, "fill", 4, 0, NULL, 0) == 4)
+			{
+				++queued;
+			}
+			ASSERT_TRUE(errno == EAGAIN);
+			fcntl(sender, F_SETFL, flags);
+
+			receiver = fd;
+
+			//阻塞语义: 等对方读走一个包后整包发出
+			int64_t start = TNOWMS;
+			ASSERT_TRUE(sendto(sender, "last", 4, 0, NULL, 0) == 4);
+			ASSERT_TRUE(TNOWMS - start >= 50);
+
+			char buff[16];
+			size_t count = 0;
+			string last;
+			fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+			ssize_t n;
+			while((n = recv(fd, buff, sizeof(buff), 0)) > 0)
+			{
+				last.assign(buff, n);
+				++count;
+			}
+			ASSERT_TRUE(count == queued);
+			ASSERT_TRUE(last == "last");
+
+			close(sender);
+			close(fd);
+		}
+		else
+		{
+			while(receiver < 0)
+			{
+				usleep(10 * 1000);
+			}
+			usleep(100 * 1000);
+
+			char buff[16];
+			ASSERT_TRUE(recv(receiver, buff, sizeof(buff), 0) == 4);
+		}
+		++done;
+	});
+
+	ASSERT_TRUE(done == 2);
+	ASSERT_TRUE(queued > 0);
+}
+
+TEST_F(UtilCoroutineHookTest, testCloseInWait)
+{
+	DelayEchoServer server(100);
+
+	std::atomic<int> done{0};
+	int fd = -1;
+
+	//一个协程阻塞在recv上, 另一个协程close了句柄
+	runCoroutines(2, [&](size_t i)
+	{
+		if(i == 0)
+		{
+			fd = socket(AF_INET, SOCK_STREAM, 0);
+
+			struct sockaddr_in addr;
+			memset(&addr, 0, sizeof(addr));
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+			addr.sin_port = htons(server.port());
+			ASSERT_TRUE(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+
+			struct timeval tv = {0, 200 * 1000};
+			setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+			char buff[1024];
+			ASSERT_TRUE(recv(fd, buff, sizeof(buff), 0) == -1);
+		}
+		else
+		{
+			while(fd < 0)
+			{
+				usleep(10 * 1000);
+			}
+			usleep(50 * 1000);
+			close(fd);
+		}
+		++done;
+	});
+
+	ASSERT_TRUE(done == 2);
+}
+
+#endif
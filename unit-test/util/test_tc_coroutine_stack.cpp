@@ -0,0 +1,222 @@
+﻿#include "util/tc_coroutine.h"
+#include "util/tc_common.h"
+#include "util/tc_logger.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace std;
+using namespace tars;
+
+class UtilCoroutineStackTest : public testing::Test
+{
+public:
+	//添加日志
+	static void SetUpTestCase()
+	{
+	}
+	static void TearDownTestCase()
+	{
+	}
+	virtual void SetUp()   //TEST跑之前会执行SetUp
+	{
+	}
+	virtual void TearDown() //TEST跑完之后会执行TearDown
+	{
+	}
+};
+
+//在栈上使用size字节
+static void useStack(size_t size, char fill)
+{
+	char *buff = (char*)alloca(size);
+	memset(buff, fill, size);
+	asm volatile("" : : "r"(buff) : "memory");
+}
+
+//跑完所有协程, 返回结束前的统计
+static TC_CoroutineScheduler::StackStat runScheduler(const std::function<void(TC_CoroutineScheduler*)> &setup, size_t count, const std::function<void(TC_CoroutineScheduler*, size_t)> &func)
+{
+	TC_CoroutineScheduler::StackStat stat;
+
+	std::thread th([&]()
+	{
+		auto scheduler = TC_CoroutineScheduler::create();
+		scheduler->setPoolStackSize(count + 10, 128 * 1024);
+		setup(scheduler.get());
+
+		scheduler->setNoCoroutineCallback([&](TC_CoroutineScheduler *s)
+		{
+			stat = s->getStackStat();
+			s->terminate();
+		});
+
+		for (size_t i = 0; i < count; i++)
+		{
+			scheduler->go(std::bind(func, scheduler.get(), i));
+		}
+
+		scheduler->run();
+
+		TC_CoroutineScheduler::reset();
+	});
+	th.join();
+
+	return stat;
+}
+
+#if TARGET_PLATFORM_LINUX
+
+TEST_F(UtilCoroutineStackTest, testStackTraits)
+{
+	stack_context s_ctx = stack_traits::allocate(128 * 1024);
+
+	//mmap之后没有提交
+	ASSERT_TRUE(stack_traits::used(s_ctx) == 0);
+
+	memset((char*)s_ctx.sp - 64 * 1024, 1, 64 * 1024);
+	ASSERT_TRUE(stack_traits::used(s_ctx) == 64 * 1024);
+
+	stack_traits::trim(s_ctx, 8 * 1024, false);
+	ASSERT_TRUE(stack_traits::used(s_ctx) == 8 * 1024);
+
+	//栈顶保留的数据不变
+	ASSERT_TRUE(*((char*)s_ctx.sp - 1) == 1);
+
+	stack_traits::deallocate(s_ctx);
+}
+
+#endif
+
+TEST_F(UtilCoroutineStackTest, testStackPool)
+{
+	const size_t count = 1000;
+
+	std::atomic<size_t> done{0};
+
+	//栈在协程结束后复用, 空闲栈不限制
+	auto stat = runScheduler([](TC_CoroutineScheduler *){}, count, [&](TC_CoroutineScheduler *s, size_t i)
+	{
+		useStack(32 * 1024, (char)i);
+		s->sleep(10);
+		++done;
+	});
+
+	ASSERT_TRUE(done == count);
+	ASSERT_TRUE(stat.stacks == count);
+	ASSERT_TRUE(stat.freeStacks == count);
+#if TARGET_PLATFORM_LINUX
+	ASSERT_TRUE(stat.highWater >= 32 * 1024 && stat.highWater < 128 * 1024);
+#endif
+
+	//一个协程结束后再启动下一个, 只需要一个栈
+	done = 0;
+	stat = runScheduler([](TC_CoroutineScheduler *){}, 1, [&](TC_CoroutineScheduler *s, size_t)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			s->go([&]() { useStack(1024, 0); ++done; });
+			s->yield();
+		}
+	});
+
+	ASSERT_TRUE(done == count);
+	ASSERT_TRUE(stat.stacks <= 3);
+
+	//限制空闲栈个数
+	done = 0;
+	stat = runScheduler([](TC_CoroutineScheduler *s){ s->setStackPool(100, 4096); }, count, [&](TC_CoroutineScheduler *s, size_t i)
+	{
+		useStack(32 * 1024, (char)i);
+		s->sleep(10);
+		++done;
+	});
+
+	ASSERT_TRUE(done == count);
+	ASSERT_TRUE(stat.stacks == 100);
+	ASSERT_TRUE(stat.freeStacks == 100);
+}
+
+TEST_F(UtilCoroutineStackTest, testSharedStack)
+{
+	const size_t count = 1000;
+
+	std::atomic<size_t> done{0};
+	std::atomic<size_t> error{0};
+
+	auto stat = runScheduler([](TC_CoroutineScheduler *s){ s->setSharedStack(4); }, count, [&](TC_CoroutineScheduler *s, size_t i)
+	{
+		//换出换入以后栈上的数据不变
+		char buff[4096];
+		memset(buff, (char)i, sizeof(buff));
+
+		for (int loop = 0; loop < 3; loop++)
+		{
+			s->sleep(5);
+
+			for (size_t j = 0; j < sizeof(buff); j++)
+			{
+				if (buff[j] != (char)i)
+				{
+					++error;
+					break;
+				}
+			}
+		}
+
+		//在共享栈的协程里再启动协程
+		if (i % 10 == 0)
+		{
+			s->go([&, i]()
+			{
+				string str = TC_Common::tostr(i);
+				s->yield();
+				if (str != TC_Common::tostr(i))
+				{
+					++error;
+				}
+				++done;
+			});
+		}
+
+		++done;
+	});
+
+	ASSERT_TRUE(error == 0);
+	ASSERT_TRUE(done == count + count / 10);
+	ASSERT_TRUE(stat.stacks == 0);
+	ASSERT_TRUE(stat.copies > 0);
+	ASSERT_TRUE(stat.savedSize == 0);
+	ASSERT_TRUE(stat.highWater >= 4096);
+
+	LOG_CONSOLE_DEBUG << "shared stack, high water: " << stat.highWater << ", copies: " << stat.copies << endl;
+}
+
+TEST_F(UtilCoroutineStackTest, testMemory)
+{
+	const size_t count = 10000;
+
+	//大量挂起的协程, 每个使用少量的栈
+	for (int shared = 0; shared < 2; shared++)
+	{
+		size_t saved = 0;
+		size_t stacks = 0;
+
+		int64_t start = TNOWMS;
+		auto stat = runScheduler([&](TC_CoroutineScheduler *s){ if (shared) s->setSharedStack(1); }, count, [&](TC_CoroutineScheduler *s, size_t i)
+		{
+			useStack(2048, (char)i);
+			s->sleep(100);
+
+			if (i == 0)
+			{
+				auto st = s->getStackStat();
+				saved = st.savedSize;
+				stacks = st.stacks;
+			}
+		});
+
+		LOG_CONSOLE_DEBUG << (shared ? "shared" : "private") << " stack, coroutines: " << count << ", stacks: " << stacks
+			<< ", saved: " << saved / 1024 << "KB, high water: " << stat.highWater << ", copies: " << stat.copies << ", cost: " << TNOWMS - start << "ms" << endl;
+	}
+}
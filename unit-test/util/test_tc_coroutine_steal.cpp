@@ -0,0 +1,253 @@
+﻿#include "util/tc_coroutine.h"
+#include "util/tc_work_steal_deque.h"
+#include "util/tc_common.h"
+#include "util/tc_logger.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <set>
+
+using namespace std;
+using namespace tars;
+
+class UtilCoroutineStealTest : public testing::Test
+{
+public:
+	//添加日志
+	static void SetUpTestCase()
+	{
+	}
+	static void TearDownTestCase()
+	{
+	}
+	virtual void SetUp()   //TEST跑之前会执行SetUp
+	{
+	}
+	virtual void TearDown() //TEST跑完之后会执行TearDown
+	{
+	}
+};
+
+TEST_F(UtilCoroutineStealTest, testDeque)
+{
+	TC_WorkStealDeque<size_t> deque(2);
+
+	size_t v;
+	ASSERT_FALSE(deque.pop(v));
+	ASSERT_FALSE(deque.steal(v));
+
+	//扩容
+	for (size_t i = 0; i < 100; i++)
+	{
+		deque.push(i);
+	}
+	ASSERT_TRUE(deque.size() == 100);
+	ASSERT_TRUE(deque.capacity() >= 100);
+
+	//所有者后进先出, 窃取方先进先出
+	ASSERT_TRUE(deque.pop(v) && v == 99);
+	ASSERT_TRUE(deque.steal(v) && v == 0);
+	ASSERT_TRUE(deque.steal(v) && v == 1);
+	ASSERT_TRUE(deque.pop(v) && v == 98);
+	ASSERT_TRUE(deque.size() == 96);
+
+	while (deque.pop(v))
+	{
+	}
+	ASSERT_TRUE(deque.empty());
+	ASSERT_FALSE(deque.steal(v));
+}
+
+TEST_F(UtilCoroutineStealTest, testDequeConcurrent)
+{
+	TC_WorkStealDeque<size_t> deque(16);
+
+	const size_t count = 200000;
+
+	std::atomic<bool> finish{false};
+	vector<vector<size_t>> stolen(3);
+	vector<std::thread*> thieves;
+
+	for (size_t i = 0; i < stolen.size(); i++)
+	{
+		thieves.push_back(new std::thread([&, i]()
+		{
+			size_t v;
+			while (!finish || !deque.empty())
+			{
+				if (deque.steal(v))
+				{
+					stolen[i].push_back(v);
+				}
+			}
+		}));
+	}
+
+	//所有者一边放一边取
+	vector<size_t> popped;
+	size_t v;
+	for (size_t i = 1; i <= count; i++)
+	{
+		deque.push(i);
+		if (i % 3 == 0 && deque.pop(v))
+		{
+			popped.push_back(v);
+		}
+	}
+	finish = true;
+
+	for (auto th : thieves)
+	{
+		th->join();
+		delete th;
+	}
+
+	//每个数据只被取走一次
+	vector<bool> seen(count + 1, false);
+	size_t total = 0;
+	stolen.push_back(popped);
+	for (auto &vs : stolen)
+	{
+		for (auto n : vs)
+		{
+			ASSERT_TRUE(n >= 1 && n <= count);
+			ASSERT_FALSE(seen[n]);
+			seen[n] = true;
+			++total;
+		}
+	}
+	ASSERT_TRUE(total == count);
+}
+
+//handle线程: 一个调度器收到一批慢请求, 另一个空闲
+static int64_t runBurst(bool steal, size_t count, uint64_t &steals)
+{
+	shared_ptr<TC_CoroutineSchedulerGroup> group;
+	if (steal)
+	{
+		group = std::make_shared<TC_CoroutineSchedulerGroup>(2);
+	}
+
+	std::atomic<size_t> done{0};
+	std::atomic<int> ready{0};
+	shared_ptr<TC_CoroutineScheduler> schedulers[2];
+
+	int64_t start = TNOWMS;
+
+	std::thread *threads[2];
+	for (int i = 0; i < 2; i++)
+	{
+		threads[i] = new std::thread([&, i]()
+		{
+			schedulers[i] = TC_CoroutineScheduler::create();
+			schedulers[i]->setPoolStackSize(1000, 64 * 1024);
+			if (group)
+			{
+				schedulers[i]->setGroup(group);
+			}
+			++ready;
+			while (ready != 2)
+			{
+				std::this_thread::yield();
+			}
+
+			if (i == 0)
+			{
+				schedulers[i]->go([&]()
+				{
+					for (size_t n = 0; n < count; n++)
+					{
+						schedulers[0]->post([&]()
+						{
+							//阻塞的慢请求
+							std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+							if (++done == count)
+							{
+								schedulers[0]->terminate();
+								schedulers[1]->terminate();
+							}
+						});
+					}
+				});
+			}
+
+			schedulers[i]->run();
+
+			TC_CoroutineScheduler::reset();
+		});
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		threads[i]->join();
+		delete threads[i];
+	}
+
+	steals = group ? group->getSteals() : 0;
+
+	if (group)
+	{
+		EXPECT_TRUE(group->getPosts(0) == count);
+		EXPECT_TRUE(group->getSteals(1) == group->getStolen(0));
+		EXPECT_TRUE(group->getSteals(0) == 0);
+	}
+
+	EXPECT_TRUE(done == count);
+
+	return TNOWMS - start;
+}
+
+TEST_F(UtilCoroutineStealTest, testGroup)
+{
+	//没有分组时, post等同于go
+	{
+		shared_ptr<TC_CoroutineScheduler> scheduler = std::make_shared<TC_CoroutineScheduler>();
+		scheduler->setPoolStackSize(10, 64 * 1024);
+
+		int n = 0;
+		scheduler->go([&]()
+		{
+			ASSERT_TRUE(scheduler->post([&]() { ++n; scheduler->terminate(); }));
+		});
+		scheduler->run();
+		ASSERT_TRUE(n == 1);
+	}
+
+	//有分组时post不占用协程, getPostFreeSize要扣掉窃取队列中还没有启动的任务
+	{
+		shared_ptr<TC_CoroutineSchedulerGroup> group = std::make_shared<TC_CoroutineSchedulerGroup>(1);
+		shared_ptr<TC_CoroutineScheduler> scheduler = std::make_shared<TC_CoroutineScheduler>();
+		scheduler->setPoolStackSize(10, 64 * 1024);
+		scheduler->setGroup(group);
+
+		int n = 0;
+		scheduler->go([&]()
+		{
+			uint32_t freeSize = scheduler->getFreeSize();
+			ASSERT_TRUE(freeSize == 9);
+			ASSERT_TRUE(scheduler->getPostFreeSize() == freeSize);
+
+			for (uint32_t i = 0; i < freeSize; i++)
+			{
+				ASSERT_TRUE(scheduler->post([&]() { if (++n == 9) { scheduler->terminate(); } }));
+			}
+
+			ASSERT_TRUE(scheduler->getFreeSize() == freeSize);
+			ASSERT_TRUE(scheduler->getPostFreeSize() == 0);
+		});
+		scheduler->run();
+		ASSERT_TRUE(n == 9);
+	}
+
+	const size_t count = 200;
+
+	uint64_t steals = 0;
+	int64_t ms1 = runBurst(false, count, steals);
+	ASSERT_TRUE(steals == 0);
+
+	int64_t ms2 = runBurst(true, count, steals);
+	ASSERT_TRUE(steals > 0);
+
+	LOG_CONSOLE_DEBUG << "burst of " << count << " slow tasks, no steal: " << ms1 << "ms, steal: " << ms2 << "ms, steals: " << steals << endl;
+}
@@ -293,4 +293,167 @@ TEST_F(UtilEpollTest, testEpollAsyncCallback)
 	epoller.loop(200);
 
 	start.join();
-}
\ No newline at end of file
+}
+
+TEST_F(UtilEpollTest, ioUringOUTEvents)
+{
+	TC_Epoller epoller;
+	epoller.setBackend(TC_Epoller::EB_IO_URING);
+	epoller.create(1024);
+
+	if(epoller.getBackend() != TC_Epoller::EB_IO_URING)
+	{
+		LOG_CONSOLE_DEBUG << "io_uring not supported, skip" << endl;
+		return;
+	}
+
+	TC_Socket fd;
+	fd.createSocket(SOCK_DGRAM, AF_INET);
+
+	shared_ptr<TC_Epoller::EpollInfo> epollInfo = epoller.createEpollInfo(fd.getfd());
+
+	int out = 0;
+
+	map<uint32_t, TC_Epoller::EpollInfo::EVENT_CALLBACK> callbacks;
+
+	callbacks[EPOLLOUT] = [&](const shared_ptr<TC_Epoller::EpollInfo> &epollInfo){
+		++out;
+		return true;
+	};
+
+	epollInfo->registerCallback(callbacks, EPOLLIN | EPOLLOUT);
+
+	std::thread start([&]{
+		TC_Common::msleep(5);
+
+		int i = 100;
+		while(i--) {
+
+			int l = out;
+			epollInfo->mod(EPOLLOUT);
+			TC_Common::msleep(5);
+			ASSERT_TRUE(out - l == 1);
+		}
+
+		TC_Common::msleep(5);
+
+		epoller.terminate();
+	});
+
+	epoller.loop(1000);
+
+	start.join();
+}
+
+TEST_F(UtilEpollTest, ioUringNotify)
+{
+	TC_Epoller epoller;
+	epoller.setBackend(TC_Epoller::EB_IO_URING);
+	epoller.create(1024);
+
+	bool idle = false;
+
+	epoller.idle([&]{
+		idle = true;
+	});
+
+	std::thread start([&]{
+		TC_Common::msleep(5);
+
+		epoller.notify();
+
+		TC_Common::msleep(5);
+
+		ASSERT_TRUE(idle);
+
+		epoller.terminate();
+	});
+
+	epoller.loop(10000);
+
+	start.join();
+}
+
+//udp ping-pong, 比较epoll与io_uring后端每秒处理的事件数
+static int64_t pingPong(TC_Epoller::EPOLLER_BACKEND backend, int pairs, int ms)
+{
+	TC_Epoller epoller;
+	epoller.setBackend(backend);
+	epoller.create(1024);
+
+	vector<shared_ptr<TC_Socket>> sockets;
+	vector<shared_ptr<TC_Epoller::EpollInfo>> infos;
+
+	int64_t count = 0;
+
+	map<uint32_t, TC_Epoller::EpollInfo::EVENT_CALLBACK> callbacks;
+	callbacks[EPOLLIN] = [&](const shared_ptr<TC_Epoller::EpollInfo> &info){
+		TC_Socket *s = (TC_Socket*)info->cookie();
+		char buff[64];
+		while(s->recv(buff, sizeof(buff)) > 0)
+		{
+			++count;
+			s->send(buff, 1);
+		}
+		return true;
+	};
+
+	for(int i = 0; i < pairs; i++)
+	{
+		shared_ptr<TC_Socket> a = std::make_shared<TC_Socket>();
+		shared_ptr<TC_Socket> b = std::make_shared<TC_Socket>();
+		a->createSocket(SOCK_DGRAM, AF_INET);
+		b->createSocket(SOCK_DGRAM, AF_INET);
+		a->bind("127.0.0.1", 0);
+		b->bind("127.0.0.1", 0);
+
+		string ip;
+		uint16_t port;
+		b->getSockName(ip, port);
+		a->connect(ip, port);
+		a->getSockName(ip, port);
+		b->connect(ip, port);
+
+		a->setblock(false);
+		b->setblock(false);
+
+		for(auto s : {a, b})
+		{
+			sockets.push_back(s);
+			auto info = epoller.createEpollInfo(s->getfd());
+			info->cookie(s.get());
+			info->registerCallback(callbacks, EPOLLIN);
+			infos.push_back(info);
+		}
+
+		a->send("a", 1);
+	}
+
+	epoller.postDelayed(ms, [&](){ epoller.terminate(); });
+
+	epoller.loop(1000);
+
+	for(auto info : infos)
+	{
+		epoller.releaseEpollInfo(info);
+	}
+
+	return count * 1000 / ms;
+}
+
+TEST_F(UtilEpollTest, ioUringBenchmark)
+{
+	if(!TC_Epoller::isIoUringSupported())
+	{
+		LOG_CONSOLE_DEBUG << "io_uring not supported, skip" << endl;
+		return;
+	}
+
+	int64_t e = pingPong(TC_Epoller::EB_EPOLL, 64, 500);
+	int64_t u = pingPong(TC_Epoller::EB_IO_URING, 64, 500);
+
+	LOG_CONSOLE_DEBUG << "udp ping-pong(64 pairs), epoll: " << e << "/s, io_uring: " << u << "/s" << endl;
+
+	ASSERT_TRUE(e > 0);
+	ASSERT_TRUE(u > 0);
+}
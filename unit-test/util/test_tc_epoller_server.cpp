@@ -9,6 +9,8 @@ static TC_Endpoint TEST_HOST_EP("tcp -h 127.0.0.1 -p 19089 -t 10000");
 static TC_Endpoint LINE_HOST_EP("tcp -h 127.0.0.1 -p 19099 -t 10000");
 static TC_Endpoint QUEUE_HOST_EP("tcp -h 127.0.0.1 -p 19019 -t 10000");
 static TC_Endpoint UDP_HOST_EP("udp -h 127.0.0.1 -p 18085 -t 10000");
+static TC_Endpoint SLICE_HOST_EP("tcp -h 127.0.0.1 -p 19029 -t 10000");
+static TC_Endpoint LOCKFREE_HOST_EP("tcp -h 127.0.0.1 -p 19039 -t 10000");
 
 class UtilEpollServerTest : public testing::Test
 {
@@ -110,6 +112,37 @@ TEST_F(UtilEpollServerTest, RunTcp)
 	}
 }
 
+TEST_F(UtilEpollServerTest, RunTcpSlice)
+{
+	for(int i = 0; i <= TC_EpollServer::NET_THREAD_MERGE_HANDLES_CO; i++)
+	{
+		MyTcpServer server;
+		server.initialize();
+		server._epollServer->setOpenCoroutine((TC_EpollServer::SERVER_OPEN_COROUTINE)i);
+		server.bindTcpSlice(SLICE_HOST_EP.toString(), 10);
+		server.waitForShutdown();
+
+		TC_TCPClient client(SLICE_HOST_EP.getHost(), SLICE_HOST_EP.getPort(), SLICE_HOST_EP.getTimeout());
+
+		for (size_t length = 10; length <= 1000000; length *= 10)
+		{
+			string body = string(length, 'a' + length % 26) + "\n";
+
+			uint32_t header = htonl(body.size() + sizeof(uint32_t));
+
+			string packet = string((const char*)&header, sizeof(header)) + body;
+
+			string recvBuffer;
+			int iRet = client.sendRecvBySep(packet.c_str(), packet.size(), recvBuffer, "\n");
+
+			ASSERT_TRUE(iRet == 0);
+			ASSERT_TRUE(recvBuffer == body);
+		}
+
+		stopServer(server);
+	}
+}
+
 TEST_F(UtilEpollServerTest, RunEnableManualListen)
 {
 //	int i = 0;
@@ -170,6 +203,89 @@ TEST_F(UtilEpollServerTest, RunLine)
 	}
 }
 
+TEST_F(UtilEpollServerTest, RunLinePipeline)
+{
+	for(int i = 0; i <= TC_EpollServer::NET_THREAD_MERGE_HANDLES_CO; i++)
+	{
+		MyTcpServer server;
+
+		startServer(server, (TC_EpollServer::SERVER_OPEN_COROUTINE) i);
+
+		uint64_t buffers = 0, syscalls = 0;
+		TC_Transceiver::getSendStat(buffers, syscalls);
+
+		TC_TCPClient client(LINE_HOST_EP.getHost(), LINE_HOST_EP.getPort(), LINE_HOST_EP.getTimeout());
+
+		//一次发送多个包, 回包会聚合发送
+		string sendBuffer;
+		for (int j = 0; j < 1000; j++)
+		{
+			sendBuffer += "line-" + TC_Common::tostr(j) + "\r\n";
+		}
+
+		ASSERT_TRUE(client.send(sendBuffer.c_str(), sendBuffer.size()) == 0);
+
+		vector<char> recvBuffer(sendBuffer.size());
+		ASSERT_TRUE(client.recvLength(recvBuffer.data(), recvBuffer.size()) == 0);
+
+		//处理线程可能乱序回包
+		vector<string> sendLines = TC_Common::sepstr<string>(sendBuffer, "\r\n");
+		vector<string> recvLines = TC_Common::sepstr<string>(string(recvBuffer.data(), recvBuffer.size()), "\r\n");
+		std::sort(sendLines.begin(), sendLines.end());
+		std::sort(recvLines.begin(), recvLines.end());
+		ASSERT_TRUE(sendLines == recvLines);
+
+		//等待网络线程更新统计
+		TC_Common::msleep(100);
+
+		uint64_t buffers2 = 0, syscalls2 = 0;
+		TC_Transceiver::getSendStat(buffers2, syscalls2);
+		//聚合发送时系统调用次数一定少于发送的块数
+		ASSERT_TRUE(syscalls2 - syscalls < buffers2 - buffers);
+
+		LOG_CONSOLE_DEBUG << "mode:" << i << ", send buffers:" << buffers2 - buffers << ", syscalls:" << syscalls2 - syscalls << endl;
+
+		stopServer(server);
+	}
+}
+
+TEST_F(UtilEpollServerTest, RunLockFreeQueue)
+{
+	for(int i = 0; i <= TC_EpollServer::NET_THREAD_MERGE_HANDLES_CO; i++)
+	{
+		MyTcpServer server;
+		server.initialize();
+		server._epollServer->setOpenCoroutine((TC_EpollServer::SERVER_OPEN_COROUTINE)i);
+		//队列较小, 覆盖队列满时的情况
+		server.bindTcpLockFree(LOCKFREE_HOST_EP.toString(), 16);
+		server.waitForShutdown();
+
+		bool merge = (i == TC_EpollServer::NET_THREAD_MERGE_HANDLES_THREAD || i == TC_EpollServer::NET_THREAD_MERGE_HANDLES_CO);
+		ASSERT_TRUE(server._epollServer->getBindAdapter("TcpLockFreeAdapter")->getDataBuffer()->isLockFreeQueue() == !merge);
+
+		TC_TCPClient client(LOCKFREE_HOST_EP.getHost(), LOCKFREE_HOST_EP.getPort(), LOCKFREE_HOST_EP.getTimeout());
+
+		string sendBuffer;
+		for (int j = 0; j < 1000; j++)
+		{
+			sendBuffer += "line-" + TC_Common::tostr(j) + "\r\n";
+		}
+
+		ASSERT_TRUE(client.send(sendBuffer.c_str(), sendBuffer.size()) == 0);
+
+		vector<char> recvBuffer(sendBuffer.size());
+		ASSERT_TRUE(client.recvLength(recvBuffer.data(), recvBuffer.size()) == 0);
+
+		vector<string> sendLines = TC_Common::sepstr<string>(sendBuffer, "\r\n");
+		vector<string> recvLines = TC_Common::sepstr<string>(string(recvBuffer.data(), recvBuffer.size()), "\r\n");
+		std::sort(sendLines.begin(), sendLines.end());
+		std::sort(recvLines.begin(), recvLines.end());
+		ASSERT_TRUE(sendLines == recvLines);
+
+		stopServer(server);
+	}
+}
+
 TEST_F(UtilEpollServerTest, AcceptCallback)
 {
 
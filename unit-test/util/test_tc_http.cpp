@@ -890,6 +890,314 @@ TEST_F(UtilHttpTest, testIncrementDecode3)
 }
 
 
+static string createParserRequest(const string &body, bool chunked)
+{
+	string s = "POST /a/b?name=value&ccc=ddd HTTP/1.1\r\n";
+	s += "Host: www.qq.com\r\n";
+	s += "Accept: application/xml,application/xhtml+xml,text/html;q=0.9,text/plain;q=0.8,image/png,*/*;q=0.5\r\n";
+	s += "Accept-Charset: utf-8,gb2321;q=0.7,*;q=0.7\r\n";
+	s += "Accept-Encoding: gzip\r\n";
+	s += "Cookie: a=1; b=2\r\n";
+	s += "X-Custom :  value  \r\n";
+	s += "Connection: keep-alive\r\n";
+	s += "User-Agent: E71/SymbianOS/9.1 Series60/3.0\r\n";
+
+	if (!chunked)
+	{
+		s += "Content-Length: " + TC_Common::tostr(body.size()) + "\r\n\r\n";
+		return s + body;
+	}
+
+	s += "Transfer-Encoding: chunked\r\n\r\n";
+
+	stringstream data;
+	for (size_t pos = 0; pos < body.size(); pos += 7)
+	{
+		string chunk = body.substr(pos, 7);
+		data << hex << chunk.size() << "\r\n" << chunk << "\r\n";
+	}
+	data << 0 << "\r\n\r\n";
+
+	return s + data.str();
+}
+
+TEST_F(UtilHttpTest, testRequestParser)
+{
+	string body = "abdefghigkabdefghigkabdefghigk";
+
+	for (auto chunked : { false, true })
+	{
+		string s = createParserRequest(body, chunked);
+
+		//一次收全
+		TC_HttpRequestParser parser;
+		ASSERT_TRUE(parser.parse(s.c_str(), s.size()) == TC_NetWorkBuffer::PACKET_FULL);
+		ASSERT_TRUE(parser.packetLength() == s.size());
+		ASSERT_TRUE(parser.isChunked() == chunked);
+		ASSERT_TRUE(parser.contentLength() == body.size());
+		ASSERT_TRUE(parser.requestType() == TC_HttpRequest::REQUEST_POST);
+
+		const char *data = s.c_str();
+		ASSERT_TRUE(TC_HttpRequestParser::str(data, parser.method()) == "POST");
+		ASSERT_TRUE(TC_HttpRequestParser::str(data, parser.url()) == "/a/b?name=value&ccc=ddd");
+		ASSERT_TRUE(TC_HttpRequestParser::str(data, parser.version()) == "HTTP/1.1");
+		ASSERT_TRUE(parser.getHeader(data, TC_HttpRequestParser::HEADER_HOST) == "www.qq.com");
+		ASSERT_TRUE(parser.getHeader(data, TC_HttpRequestParser::HEADER_COOKIE) == "a=1; b=2");
+		ASSERT_TRUE(parser.findHeader(TC_HttpRequestParser::HEADER_UPGRADE) == NULL);
+		ASSERT_TRUE(parser.getHeader(data, "x-custom") == "value");
+		ASSERT_TRUE(parser.getHeader(data, "accept-charset") == "utf-8,gb2321;q=0.7,*;q=0.7");
+		ASSERT_TRUE(parser.findHeader(data, "Not-Exists") == NULL);
+
+		string content;
+		parser.getContent(data, content);
+		ASSERT_TRUE(content == body);
+
+		//和原来的decode结果一致
+		TC_HttpRequest request1;
+		ASSERT_TRUE(request1.decode(s));
+
+		TC_HttpRequest request2;
+		ASSERT_TRUE(request2.decode(data, parser));
+		ASSERT_TRUE(request1.getRequestUrl() == request2.getRequestUrl());
+		ASSERT_TRUE(request1.getURL().getURL() == request2.getURL().getURL());
+		ASSERT_TRUE(request1.getHeadLength() == request2.getHeadLength());
+		ASSERT_TRUE(request1.getContent() == request2.getContent());
+		ASSERT_TRUE(request1.getContentLength() == request2.getContentLength());
+		ASSERT_TRUE(request1.getHeaders().size() == request2.getHeaders().size());
+		ASSERT_TRUE(request1.getHeader("Host") == request2.getHeader("Host"));
+		ASSERT_TRUE(request2.isPOST());
+
+		//逐个字节收到
+		TC_HttpRequestParser incr;
+		for (size_t len = 0; len < s.size(); len++)
+		{
+			ASSERT_TRUE(incr.parse(s.c_str(), len) == TC_NetWorkBuffer::PACKET_LESS);
+			ASSERT_TRUE(incr.scanned() <= len);
+		}
+		ASSERT_TRUE(incr.parse(s.c_str(), s.size()) == TC_NetWorkBuffer::PACKET_FULL);
+		ASSERT_TRUE(incr.packetLength() == s.size());
+		ASSERT_TRUE(incr.headers().size() == parser.headers().size());
+
+		//分段收到, 每次数据都搬到新的内存
+		TC_HttpRequestParser seg;
+		for (size_t len = 13; len < s.size() + 13; len += 13)
+		{
+			string part = s.substr(0, len);
+			TC_NetWorkBuffer::PACKET_TYPE ret = seg.parse(part.c_str(), part.size());
+			ASSERT_TRUE(ret == (part.size() == s.size() ? TC_NetWorkBuffer::PACKET_FULL : TC_NetWorkBuffer::PACKET_LESS));
+		}
+		ASSERT_TRUE(seg.getHeader(s.c_str(), TC_HttpRequestParser::HEADER_USER_AGENT) == "E71/SymbianOS/9.1 Series60/3.0");
+	}
+}
+
+TEST_F(UtilHttpTest, testRequestParserError)
+{
+	vector<string> data;
+	data.push_back("HELLO WORLD\r\n\r\n");
+	data.push_back("0123456789abcdef");
+	data.push_back("GET /\r\n\r\n");
+	data.push_back("GET / XTTP/1.1\r\n\r\n");
+	data.push_back("POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n");
+	data.push_back("POST / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n");
+	data.push_back("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n");
+	data.push_back("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabcd\r\n");
+
+	for (auto &s : data)
+	{
+		TC_HttpRequestParser parser;
+		ASSERT_TRUE(parser.parse(s.c_str(), s.size()) == TC_NetWorkBuffer::PACKET_ERR);
+
+		TC_NetWorkBuffer buff(NULL);
+		buff.addBuffer(s);
+		ASSERT_TRUE(buff.checkHttp() == TC_NetWorkBuffer::PACKET_ERR);
+	}
+
+	//方法名还没收全
+	TC_HttpRequestParser parser;
+	ASSERT_TRUE(parser.parse("GE", 2) == TC_NetWorkBuffer::PACKET_LESS);
+}
+
+TEST_F(UtilHttpTest, testRequestParserPipeline)
+{
+	string body = "abdefghigk";
+
+	string s1 = createParserRequest(body, false);
+	string s2 = createParserRequest(body + body, true);
+	string s3 = "GET /index.html HTTP/1.1\r\nHost: www.qq.com\r\n\r\n";
+
+	string s = s1 + s2 + s3;
+
+	//分段收到多个请求, 每次只取一个完整的请求
+	TC_NetWorkBuffer buff(NULL);
+
+	vector<vector<char>> out;
+	for (size_t pos = 0; pos < s.size(); pos += 100)
+	{
+		buff.addBuffer(s.substr(pos, 100));
+
+		while (true)
+		{
+			vector<char> o;
+			TC_NetWorkBuffer::PACKET_TYPE ret = TC_NetWorkBuffer::parseHttp(buff, o);
+			ASSERT_TRUE(ret != TC_NetWorkBuffer::PACKET_ERR);
+			if (ret != TC_NetWorkBuffer::PACKET_FULL)
+			{
+				ASSERT_TRUE(buff.takeHttpParser() == NULL);
+				break;
+			}
+
+			//解析结果跟着请求走, 可以直接decode
+			shared_ptr<TC_HttpRequestParser> parser = buff.takeHttpParser();
+			ASSERT_TRUE(parser != NULL);
+			ASSERT_TRUE(parser->packetLength() == o.size());
+			ASSERT_TRUE(buff.takeHttpParser() == NULL);
+
+			TC_HttpRequest request;
+			ASSERT_TRUE(request.decode(o.data(), *parser));
+			ASSERT_TRUE(request.getHeader("Host") == "www.qq.com");
+
+			out.push_back(o);
+		}
+	}
+
+	ASSERT_TRUE(buff.empty());
+	ASSERT_TRUE(out.size() == 3);
+	ASSERT_TRUE(string(out[0].data(), out[0].size()) == s1);
+	ASSERT_TRUE(string(out[1].data(), out[1].size()) == s2);
+	ASSERT_TRUE(string(out[2].data(), out[2].size()) == s3);
+
+	TC_HttpRequest request;
+	ASSERT_TRUE(request.decode(out[1]));
+	ASSERT_TRUE(request.getContent() == body + body);
+	ASSERT_TRUE(request.decode(out[2]));
+	ASSERT_TRUE(request.isGET());
+	ASSERT_TRUE(request.getRequest() == "/index.html");
+}
+
+TEST_F(UtilHttpTest, testCheckHttpReuse)
+{
+	string body = "abdefghigk";
+
+	string s1 = createParserRequest(body, false);
+	string s2 = createParserRequest(body + body, true);
+
+	TC_NetWorkBuffer buff(NULL);
+
+	//checkHttp完整后, 数据不经过parseHttp直接取走
+	buff.addBuffer(s1);
+	ASSERT_TRUE(buff.checkHttp() == TC_NetWorkBuffer::PACKET_FULL);
+	vector<char> o = buff.getBuffers();
+	buff.clearBuffers();
+	ASSERT_TRUE(string(o.data(), o.size()) == s1);
+
+	//同一个buffer收到下一个(更长的)请求, 要重新解析
+	buff.addBuffer(s2.substr(0, s1.size()));
+	ASSERT_TRUE(buff.checkHttp() == TC_NetWorkBuffer::PACKET_LESS);
+	buff.addBuffer(s2.substr(s1.size()));
+	ASSERT_TRUE(buff.checkHttp() == TC_NetWorkBuffer::PACKET_FULL);
+
+	o.clear();
+	ASSERT_TRUE(TC_NetWorkBuffer::parseHttp(buff, o) == TC_NetWorkBuffer::PACKET_FULL);
+	ASSERT_TRUE(string(o.data(), o.size()) == s2);
+	ASSERT_TRUE(buff.empty());
+
+	shared_ptr<TC_HttpRequestParser> parser = buff.takeHttpParser();
+	ASSERT_TRUE(parser != NULL);
+
+	TC_HttpRequest request;
+	ASSERT_TRUE(request.decode(o.data(), *parser));
+	ASSERT_TRUE(request.getContent() == body + body);
+
+	//同样长度的请求
+	buff.addBuffer(s1);
+	ASSERT_TRUE(buff.checkHttp() == TC_NetWorkBuffer::PACKET_FULL);
+	buff.clearBuffers();
+	buff.addBuffer(s1);
+	ASSERT_TRUE(buff.checkHttp() == TC_NetWorkBuffer::PACKET_FULL);
+	o.clear();
+	ASSERT_TRUE(TC_NetWorkBuffer::parseHttp(buff, o) == TC_NetWorkBuffer::PACKET_FULL);
+	parser = buff.takeHttpParser();
+	ASSERT_TRUE(request.decode(o.data(), *parser));
+	ASSERT_TRUE(request.getContent() == body);
+
+	//错误的请求之后可以继续解析
+	buff.addBuffer(string("HELLO WORLD\r\n\r\n"));
+	ASSERT_TRUE(buff.checkHttp() == TC_NetWorkBuffer::PACKET_ERR);
+	buff.clearBuffers();
+	buff.addBuffer(s1);
+	ASSERT_TRUE(buff.checkHttp() == TC_NetWorkBuffer::PACKET_FULL);
+}
+
+TEST_F(UtilHttpTest, testRequestParserBenchmark)
+{
+	string s = createParserRequest(string(1024, 'a'), false);
+
+	const int count = 100000;
+
+	//一次收全
+	int64_t start = TNOWUS;
+	for (int i = 0; i < count; i++)
+	{
+		TC_HttpRequest request;
+		request.checkRequest(s.c_str(), s.size());
+		request.decode(s.c_str(), s.size());
+	}
+	int64_t us1 = TNOWUS - start;
+
+	start = TNOWUS;
+	TC_HttpRequestParser parser;
+	for (int i = 0; i < count; i++)
+	{
+		parser.reset();
+		parser.parse(s.c_str(), s.size());
+		parser.getHeader(s.c_str(), TC_HttpRequestParser::HEADER_HOST);
+	}
+	int64_t us2 = TNOWUS - start;
+
+	start = TNOWUS;
+	for (int i = 0; i < count; i++)
+	{
+		parser.reset();
+		parser.parse(s.c_str(), s.size());
+
+		TC_HttpRequest request;
+		request.decode(s.c_str(), parser);
+	}
+	int64_t us3 = TNOWUS - start;
+
+	LOG_CONSOLE_DEBUG << "checkRequest+decode: " << us1 * 1000 / count << "ns, parser: " << us2 * 1000 / count << "ns, parser+decode: " << us3 * 1000 / count << "ns" << endl;
+
+	//每次收到64字节, 每次都检查是否完整
+	const int segCount = 10000;
+
+	start = TNOWUS;
+	for (int i = 0; i < segCount; i++)
+	{
+		TC_NetWorkBuffer buff(NULL);
+		for (size_t pos = 0; pos < s.size(); pos += 64)
+		{
+			buff.addBuffer(s.substr(pos, 64));
+			TC_HttpRequest::checkRequest(buff);
+		}
+	}
+	us1 = TNOWUS - start;
+
+	start = TNOWUS;
+	for (int i = 0; i < segCount; i++)
+	{
+		TC_NetWorkBuffer buff(NULL);
+		for (size_t pos = 0; pos < s.size(); pos += 64)
+		{
+			buff.addBuffer(s.substr(pos, 64));
+			buff.checkHttp();
+		}
+	}
+	us2 = TNOWUS - start;
+
+	LOG_CONSOLE_DEBUG << "segmented(64 bytes), checkRequest: " << us1 * 1000 / segCount << "ns, checkHttp: " << us2 * 1000 / segCount << "ns" << endl;
+}
+
+
 #if TARS_HTTPS
 TEST_F(UtilHttpTest, testBaidus)   //此时使用的是TEST_F宏
 {
@@ -0,0 +1,203 @@
+﻿#include "util/tc_logger.h"
+#include "util/tc_common.h"
+#include "util/tc_file.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+using namespace tars;
+
+class UtilLoggerStageTest : public testing::Test
+{
+public:
+	//添加日志
+	static void SetUpTestCase()
+	{
+	}
+	static void TearDownTestCase()
+	{
+	}
+	virtual void SetUp()   //TEST跑之前会执行SetUp
+	{
+		TC_File::removeFile("./stage_test.log", false);
+	}
+	virtual void TearDown() //TEST跑完之后会执行TearDown
+	{
+		TC_File::removeFile("./stage_test.log", false);
+	}
+};
+
+TEST_F(UtilLoggerStageTest, testStage)
+{
+	TC_LoggerStage stage(5);
+
+	ASSERT_TRUE(stage.empty());
+
+	//容量取2的幂: 8
+	for (int i = 0; i < 8; i++)
+	{
+		string s = "line" + TC_Common::tostr(i);
+		ASSERT_TRUE(stage.push(i, s.c_str(), s.size()));
+	}
+	ASSERT_FALSE(stage.push(0, "x", 1));
+
+	deque<pair<size_t, string> > ds;
+	ASSERT_TRUE(stage.pop(ds) == 8);
+	ASSERT_TRUE(stage.empty());
+	for (int i = 0; i < 8; i++)
+	{
+		ASSERT_TRUE(ds[i].first == (size_t)i);
+		ASSERT_TRUE(ds[i].second == "line" + TC_Common::tostr(i));
+	}
+
+	//长日志, 以及回绕
+	string large(TC_LoggerStage::RECORD_SIZE * 3, 'a');
+	ds.clear();
+	for (int i = 0; i < 20; i++)
+	{
+		ASSERT_TRUE(stage.push(0, large.c_str(), large.size()));
+		ASSERT_TRUE(stage.push(0, "b", 1));
+		ASSERT_TRUE(stage.pop(ds) == 2);
+	}
+	ASSERT_TRUE(ds.size() == 40);
+	ASSERT_TRUE(ds[38].second == large);
+	ASSERT_TRUE(ds[39].second == "b");
+}
+
+TEST_F(UtilLoggerStageTest, testOverflow)
+{
+	TC_LoggerStage stage(2);
+
+	ASSERT_FALSE(stage.isOverflow(0));
+
+	//放到公共队列以后, 要再完成两次flush才能继续用暂存队列
+	stage.setOverflow(5);
+	ASSERT_TRUE(stage.isOverflow(5));
+	ASSERT_TRUE(stage.isOverflow(6));
+	ASSERT_FALSE(stage.isOverflow(7));
+	ASSERT_FALSE(stage.isOverflow(6));
+}
+
+static void checkLogger(size_t stage, int threads, int count, int groupThreads)
+{
+	TC_LoggerThreadGroup group;
+	group.start(groupThreads);
+
+	TC_RollLogger logger;
+	logger.init("./stage_test", 100 * 1024 * 1024, 1);
+	logger.modFlag(TC_RollLogger::HAS_MTIME);
+	logger.setupThread(&group);
+	logger.setStage(stage);
+
+	string large(TC_LoggerStage::RECORD_SIZE * 2, 'x');
+
+	vector<std::thread*> vt;
+	for (int t = 0; t < threads; t++)
+	{
+		vt.push_back(new std::thread([&, t](){
+			for (int i = 0; i < count; i++)
+			{
+				logger.debug() << "thread:" << t << "|seq:" << i << "|" << (i % 100 == 0 ? large : "") << endl;
+			}
+		}));
+	}
+
+	for (auto th : vt)
+	{
+		th->join();
+		delete th;
+	}
+
+	logger.unSetupThread();
+
+	vector<string> lines = TC_Common::sepstr<string>(TC_File::load2str("./stage_test.log"), "\n");
+	ASSERT_TRUE(lines.size() == (size_t)(threads * count));
+
+	//每个线程的日志都在, 顺序不变
+	vector<int> next(threads, 0);
+	for (auto &line : lines)
+	{
+		vector<string> v = TC_Common::sepstr<string>(line, "|", true);
+		ASSERT_TRUE(v.size() == 4);
+
+		int t = TC_Common::strto<int>(v[1].substr(strlen("thread:")));
+		int i = TC_Common::strto<int>(v[2].substr(strlen("seq:")));
+		ASSERT_TRUE(i == next[t]);
+		ASSERT_TRUE(v[3] == (i % 100 == 0 ? large : ""));
+		next[t]++;
+	}
+
+	TC_File::removeFile("./stage_test.log", false);
+}
+
+TEST_F(UtilLoggerStageTest, testLogger)
+{
+	checkLogger(64, 4, 10000, 1);
+}
+
+TEST_F(UtilLoggerStageTest, testLoggerOverflow)
+{
+	//暂存队列很小, 大部分日志都要放到公共队列, 多个写日志线程
+	checkLogger(2, 4, 20000, 1);
+	checkLogger(2, 4, 20000, 3);
+}
+
+static void benchmark(size_t stage, int threads, int count)
+{
+	TC_LoggerThreadGroup group;
+	group.start(1);
+
+	TC_RollLogger logger;
+	logger.init("./stage_test", 1024 * 1024 * 1024, 1);
+	logger.modFlag(TC_RollLogger::HAS_MTIME | TC_RollLogger::HAS_LEVEL);
+	logger.setupThread(&group);
+	logger.setStage(stage);
+
+	vector<vector<int64_t>> costs(threads);
+
+	int64_t start = TNOWUS;
+
+	vector<std::thread*> vt;
+	for (int t = 0; t < threads; t++)
+	{
+		vt.push_back(new std::thread([&, t](){
+			costs[t].reserve(count);
+			for (int i = 0; i < count; i++)
+			{
+				auto begin = std::chrono::steady_clock::now();
+				logger.debug() << "benchmark thread:" << t << ", seq:" << i << ", some text to make it a normal log line" << endl;
+				costs[t].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+			}
+		}));
+	}
+
+	for (auto th : vt)
+	{
+		th->join();
+		delete th;
+	}
+
+	int64_t us = TNOWUS - start;
+
+	logger.unSetupThread();
+
+	vector<int64_t> all;
+	for (auto &c : costs)
+	{
+		all.insert(all.end(), c.begin(), c.end());
+	}
+	std::sort(all.begin(), all.end());
+
+	LOG_CONSOLE_DEBUG << (stage > 0 ? "stage" : "queue") << ", threads:" << threads << ", lines:" << all.size() << ", " << (int64_t)all.size() * 1000000 / (us + 1) << " lines/s"
+		<< ", p50:" << all[all.size() / 2] << "ns, p99:" << all[all.size() * 99 / 100] << "ns" << endl;
+
+	TC_File::removeFile("./stage_test.log", false);
+}
+
+TEST_F(UtilLoggerStageTest, testBenchmark)
+{
+	benchmark(0, 8, 50000);
+	benchmark(1024, 8, 50000);
+}
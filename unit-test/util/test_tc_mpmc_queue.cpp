@@ -0,0 +1,234 @@
+﻿#include "util/tc_mpmc_queue.h"
+#include "util/tc_thread_queue.h"
+#include "util/tc_cas_queue.h"
+#include "util/tc_logger.h"
+#include "util/tc_common.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace tars;
+
+class UtilMPMCQueueTest : public testing::Test
+{
+public:
+	//添加日志
+	static void SetUpTestCase()
+	{
+	}
+	static void TearDownTestCase()
+	{
+	}
+	virtual void SetUp()   //TEST跑之前会执行SetUp
+	{
+	}
+	virtual void TearDown() //TEST跑完之后会执行TearDown
+	{
+	}
+};
+
+TEST_F(UtilMPMCQueueTest, testPushPop)
+{
+	TC_MPMCQueue<int> queue(5);
+
+	ASSERT_TRUE(queue.capacity() == 8);
+	ASSERT_TRUE(queue.empty());
+
+	for (int i = 0; i < 8; i++)
+	{
+		ASSERT_TRUE(queue.try_push(i));
+	}
+
+	//满了
+	ASSERT_FALSE(queue.try_push(8));
+	ASSERT_TRUE(queue.size() == 8);
+
+	int v;
+	for (int i = 0; i < 8; i++)
+	{
+		ASSERT_TRUE(queue.pop_front(v));
+		ASSERT_TRUE(v == i);
+	}
+
+	ASSERT_FALSE(queue.pop_front(v));
+	ASSERT_FALSE(queue.wait(0));
+}
+
+TEST_F(UtilMPMCQueueTest, testBatch)
+{
+	TC_MPMCQueue<shared_ptr<string>> queue(16);
+
+	deque<shared_ptr<string>> data;
+	for (int i = 0; i < 10; i++)
+	{
+		data.push_back(std::make_shared<string>(TC_Common::tostr(i)));
+	}
+
+	queue.push_back(data);
+	ASSERT_TRUE(queue.size() == 10);
+
+	vector<shared_ptr<string>> out;
+	ASSERT_TRUE(queue.pop_front(out, 4) == 4);
+	ASSERT_TRUE(queue.pop_front(out, 100) == 6);
+	ASSERT_TRUE(queue.pop_front(out, 100) == 0);
+
+	for (size_t i = 0; i < out.size(); i++)
+	{
+		ASSERT_TRUE(*out[i] == TC_Common::tostr(i));
+		//队列中不再持有引用
+		ASSERT_TRUE(out[i].use_count() == 2);
+	}
+}
+
+TEST_F(UtilMPMCQueueTest, testWaitNotify)
+{
+	TC_MPMCQueue<int> queue;
+
+	int64_t start = TNOWMS;
+	ASSERT_FALSE(queue.wait(50));
+	ASSERT_TRUE(TNOWMS - start >= 40);
+
+	std::thread notify([&]{
+		TC_Common::msleep(50);
+		queue.notifyT();
+	});
+
+	int v;
+	ASSERT_FALSE(queue.pop_front(v, -1));
+	notify.join();
+
+	std::thread push([&]{
+		TC_Common::msleep(50);
+		queue.push_back(100);
+	});
+
+	ASSERT_TRUE(queue.pop_front(v, 1000));
+	ASSERT_TRUE(v == 100);
+	push.join();
+}
+
+TEST_F(UtilMPMCQueueTest, testMultiThread)
+{
+	TC_MPMCQueue<int64_t> queue(1024);
+
+	const int producers = 4;
+	const int consumers = 4;
+	const int64_t count = 100000;
+
+	std::atomic<int64_t> sum(0);
+	std::atomic<int64_t> total(0);
+
+	vector<std::thread> threads;
+
+	for (int i = 0; i < consumers; i++)
+	{
+		threads.push_back(std::thread([&]{
+			int64_t v;
+			while (total < producers * count)
+			{
+				if (queue.pop_front(v, 10))
+				{
+					sum += v;
+					++total;
+				}
+			}
+		}));
+	}
+
+	for (int i = 0; i < producers; i++)
+	{
+		threads.push_back(std::thread([&]{
+			for (int64_t j = 1; j <= count; j++)
+			{
+				queue.push_back(j);
+			}
+		}));
+	}
+
+	for (auto &t : threads)
+	{
+		t.join();
+	}
+
+	ASSERT_TRUE(total == producers * count);
+	ASSERT_TRUE(sum == producers * count * (count + 1) / 2);
+	ASSERT_TRUE(queue.empty());
+}
+
+template<typename Q, typename PUSH, typename POP>
+static int64_t benchmark(Q &queue, int producers, int consumers, int64_t count, PUSH push, POP pop)
+{
+	std::atomic<int64_t> total(0);
+
+	vector<std::thread> threads;
+
+	int64_t start = TNOWUS;
+
+	for (int i = 0; i < consumers; i++)
+	{
+		threads.push_back(std::thread([&]{
+			int64_t v;
+			while (total < producers * count)
+			{
+				if (pop(queue, v))
+				{
+					++total;
+				}
+			}
+		}));
+	}
+
+	for (int i = 0; i < producers; i++)
+	{
+		threads.push_back(std::thread([&]{
+			for (int64_t j = 0; j < count; j++)
+			{
+				push(queue, j);
+			}
+		}));
+	}
+
+	for (auto &t : threads)
+	{
+		t.join();
+	}
+
+	return TNOWUS - start;
+}
+
+TEST_F(UtilMPMCQueueTest, testBenchmark)
+{
+	const int64_t count = 200000;
+
+	int threads[][2] = { {1, 1}, {2, 2}, {4, 4} };
+
+	for (auto &t : threads)
+	{
+		int producers = t[0];
+		int consumers = t[1];
+
+		TC_ThreadQueue<int64_t> threadQueue;
+		int64_t us1 = benchmark(threadQueue, producers, consumers, count,
+			[](TC_ThreadQueue<int64_t> &q, int64_t v){ q.push_back(v); },
+			[](TC_ThreadQueue<int64_t> &q, int64_t &v){ return q.pop_front(v, 10); });
+
+		TC_CasQueue<int64_t> casQueue;
+		int64_t us2 = benchmark(casQueue, producers, consumers, count,
+			[](TC_CasQueue<int64_t> &q, int64_t v){ q.push_back(v); },
+			[](TC_CasQueue<int64_t> &q, int64_t &v){ return q.pop_front(v); });
+
+		TC_MPMCQueue<int64_t> mpmcQueue;
+		int64_t us3 = benchmark(mpmcQueue, producers, consumers, count,
+			[](TC_MPMCQueue<int64_t> &q, int64_t v){ q.push_back(v); },
+			[](TC_MPMCQueue<int64_t> &q, int64_t &v){ return q.pop_front(v, 10); });
+
+		int64_t total = producers * count;
+
+		LOG_CONSOLE_DEBUG << "producers:" << producers << ", consumers:" << consumers
+			<< ", TC_ThreadQueue:" << total * 1000000 / (us1 + 1) << "/s"
+			<< ", TC_CasQueue:" << total * 1000000 / (us2 + 1) << "/s"
+			<< ", TC_MPMCQueue:" << total * 1000000 / (us3 + 1) << "/s" << endl;
+	}
+}
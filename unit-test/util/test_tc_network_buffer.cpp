@@ -450,4 +450,72 @@ TEST_F(UtilNetworkBufferTest, testCompact)
 	data->compact();
 
 	ASSERT_TRUE(TC_Port::strncasecmp(data->buffer(), &buff[10], data->length()) == 0);
-}
\ No newline at end of file
+}
+
+TEST_F(UtilNetworkBufferTest, testSlice)
+{
+	TC_NetWorkBuffer buff(NULL);
+
+	string a(100, 'a');
+	buff.addBuffer(a);
+
+	TC_NetWorkBuffer::Slice slice;
+	ASSERT_TRUE(buff.getSlice(50, slice));
+	ASSERT_TRUE(slice.size() == 50);
+
+	//数据在同一个buffer中, 不copy
+	ASSERT_TRUE(slice.data() == buff.getBufferPointer().first);
+
+	buff.moveHeader(100);
+	ASSERT_TRUE(buff.empty());
+
+	//被Slice引用的buffer不会被复用
+	auto data = buff.getOrCreateBuffer(100, 300);
+	memset(data->free(), 'b', data->left());
+	data->addWriteIdx(data->left());
+
+	ASSERT_TRUE(slice.toString() == string(50, 'a'));
+	ASSERT_TRUE(slice.sub(10, 20).toString() == string(20, 'a'));
+
+	//数据跨buffer, 合并后引用
+	buff.clearBuffers();
+	buff.addBuffer(std::make_shared<TC_NetWorkBuffer::Buffer>("abc", 3));
+	buff.addBuffer(std::make_shared<TC_NetWorkBuffer::Buffer>("def", 3));
+
+	ASSERT_TRUE(buff.getSlice(5, slice));
+	ASSERT_TRUE(slice.toString() == "abcde");
+	ASSERT_FALSE(buff.getSlice(7, slice));
+}
+
+TEST_F(UtilNetworkBufferTest, testParseSlice)
+{
+	TC_NetWorkBuffer buff(NULL);
+
+	string body(10000, 'x');
+	uint32_t len = htonl(body.size() + sizeof(uint32_t));
+
+	string packet = string((const char*)&len, sizeof(len)) + body;
+
+	//先收到一部分数据
+	buff.addBuffer(packet.c_str(), 1000);
+
+	TC_NetWorkBuffer::Slice slice;
+	ASSERT_TRUE(buff.parseBufferOf4(slice, 4, 100000) == TC_NetWorkBuffer::PACKET_LESS);
+
+	//剩余的数据收到同一个buffer中
+	auto data = buff.getOrCreateBuffer(1024, 2048);
+	ASSERT_TRUE(buff.listSize() == 1);
+	ASSERT_TRUE(data->left() >= packet.size() - 1000);
+	memcpy(data->free(), packet.c_str() + 1000, packet.size() - 1000);
+	data->addWriteIdx(packet.size() - 1000);
+	buff.addLength(packet.size() - 1000);
+
+	const char *p = buff.getBufferPointer().first;
+
+	ASSERT_TRUE(buff.parseBufferOf4(slice, 4, 100000) == TC_NetWorkBuffer::PACKET_FULL);
+	ASSERT_TRUE(slice.data() == p + sizeof(uint32_t));
+	ASSERT_TRUE(slice.toString() == body);
+	ASSERT_TRUE(buff.empty());
+
+	ASSERT_TRUE(buff.parseBufferOf4(slice, 4, 100000) == TC_NetWorkBuffer::PACKET_LESS);
+}
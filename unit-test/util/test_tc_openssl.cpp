@@ -0,0 +1,264 @@
+﻿#include "util/tc_openssl.h"
+#include "util/tc_socket.h"
+#include "util/tc_common.h"
+#include "util/tc_logger.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+#if TARS_SSL
+#include <openssl/ssl.h>
+#endif
+
+using namespace std;
+using namespace tars;
+
+#if TARS_SSL
+
+class UtilOpenSSLTest : public testing::Test
+{
+public:
+	//添加日志
+	static void SetUpTestCase()
+	{
+	}
+	static void TearDownTestCase()
+	{
+	}
+	virtual void SetUp()   //TEST跑之前会执行SetUp
+	{
+	}
+	virtual void TearDown() //TEST跑完之后会执行TearDown
+	{
+	}
+};
+
+static const string CERT_PATH = string(CMAKE_SOURCE_DIR) + "/certs/";
+
+//本地建立一对tcp连接
+static void createConnection(TC_Socket &server, TC_Socket &client)
+{
+	TC_Socket listen;
+	listen.createSocket();
+	listen.setReuseAddr();
+	listen.bind("127.0.0.1", 0);
+	listen.listen(10);
+
+	string ip;
+	uint16_t port = 0;
+	listen.getSockName(ip, port);
+
+	client.createSocket();
+	client.connect("127.0.0.1", port);
+
+	struct sockaddr_in addr;
+	SOCKET_LEN_TYPE len = sizeof(addr);
+	listen.accept(server, (struct sockaddr*)&addr, len);
+}
+
+//握手数据在内存里交换, 不经过socket
+static bool handshake(TC_OpenSSL &server, TC_OpenSSL &client)
+{
+	server.init(true);
+	client.init(false);
+
+	TC_NetWorkBuffer toServer(NULL);
+	TC_NetWorkBuffer toClient(NULL);
+
+	if (client.doHandshake(toServer) != 0)
+		return false;
+
+	for (int i = 0; i < 10 && (!server.isHandshaked() || !client.isHandshaked()); i++)
+	{
+		string data = toServer.getBuffersString();
+		toServer.clearBuffers();
+		if (server.read(data.data(), data.size(), toClient) != 0)
+			return false;
+
+		data = toClient.getBuffersString();
+		toClient.clearBuffers();
+		if (client.read(data.data(), data.size(), toServer) != 0)
+			return false;
+	}
+
+	return server.isHandshaked() && client.isHandshaked();
+}
+
+static void sendAll(int fd, TC_NetWorkBuffer &buff)
+{
+	pair<const char*, size_t> vec[1];
+	while (!buff.empty())
+	{
+		buff.getBufferPointers(vec, 1);
+		int ret = ::send(fd, vec[0].first, vec[0].second, 0);
+		if (ret <= 0)
+			return;
+		buff.moveHeader(ret);
+	}
+}
+
+//server收到的数据和block(循环)比较
+static bool checkData(size_t offset, const char *data, size_t len, const string &block)
+{
+	while (len > 0)
+	{
+		size_t pos = offset % block.size();
+		size_t n = std::min(len, block.size() - pos);
+		if (memcmp(data, block.data() + pos, n) != 0)
+			return false;
+
+		offset += n;
+		data += n;
+		len -= n;
+	}
+	return true;
+}
+
+//client发送total字节给server, 返回server收到的数据是否和发送的一致
+static bool transfer(TC_OpenSSL &server, TC_OpenSSL &client, TC_Socket &ss, TC_Socket &cs, size_t total, const string &block)
+{
+	size_t received = 0;
+	bool same = true;
+
+	std::thread recvThread([&]()
+	{
+		vector<char> buff(64 * 1024);
+		TC_NetWorkBuffer out(NULL);
+		TC_NetWorkBuffer *plain = server.recvBuffer();
+
+		//不一致时也要继续收完, 否则发送方会阻塞
+		while (received < total)
+		{
+			if (server.isKtlsRx())
+			{
+				int ret = server.recvKtls(ss.getfd(), buff.data(), (uint32_t)buff.size(), 0);
+				if (ret <= 0)
+					break;
+				same = checkData(received, buff.data(), ret, block) && same;
+				received += ret;
+			}
+			else
+			{
+				int ret = ::recv(ss.getfd(), buff.data(), buff.size(), 0);
+				if (ret <= 0 || server.read(buff.data(), ret, out) != 0)
+					break;
+
+				pair<const char*, size_t> vec[1];
+				while (!plain->empty())
+				{
+					plain->getBufferPointers(vec, 1);
+					same = checkData(received, vec[0].first, vec[0].second, block) && same;
+					received += vec[0].second;
+					plain->moveHeader(vec[0].second);
+				}
+			}
+		}
+	});
+
+	TC_NetWorkBuffer out(NULL);
+	for (size_t sent = 0; sent < total; sent += block.size())
+	{
+		//kTLS时write直接放明文, 由内核加密
+		client.write(block.data(), std::min(block.size(), total - sent), out);
+		sendAll(cs.getfd(), out);
+	}
+
+	recvThread.join();
+
+	return same && received == total;
+}
+
+static void testKtls(bool tls12)
+{
+	shared_ptr<TC_OpenSSL::CTX> serverCtx = TC_OpenSSL::newCtx("", CERT_PATH + "server.crt", CERT_PATH + "server.key", false, "", true);
+	shared_ptr<TC_OpenSSL::CTX> clientCtx = TC_OpenSSL::newCtx("", "", "", false, "", true);
+	ASSERT_TRUE(serverCtx && clientCtx);
+
+	if (tls12)
+	{
+		SSL_CTX_set_max_proto_version(clientCtx->ctx, TLS1_2_VERSION);
+	}
+
+	const size_t total = 256 * 1024 * 1024;
+	//内容不是周期重复的, 错位/丢数据都能发现
+	string block(16 * 1024 + 7, 0);
+	for (size_t i = 0; i < block.size(); i++)
+	{
+		block[i] = (char)(i * 131 + i / 251);
+	}
+
+	//openssl内存BIO
+	int64_t us1 = 0;
+	{
+		TC_Socket ss, cs;
+		createConnection(ss, cs);
+
+		shared_ptr<TC_OpenSSL> server = TC_OpenSSL::newSSL(TC_OpenSSL::newCtx("", CERT_PATH + "server.crt", CERT_PATH + "server.key", false, ""));
+		shared_ptr<TC_OpenSSL> client = TC_OpenSSL::newSSL(clientCtx);
+		ASSERT_TRUE(handshake(*server, *client));
+
+		int64_t start = TC_Common::now2us();
+		ASSERT_TRUE(transfer(*server, *client, ss, cs, total, block));
+		us1 = TC_Common::now2us() - start;
+	}
+
+	//kTLS
+	TC_Socket ss, cs;
+	createConnection(ss, cs);
+
+	shared_ptr<TC_OpenSSL> server = TC_OpenSSL::newSSL(serverCtx);
+	shared_ptr<TC_OpenSSL> client = TC_OpenSSL::newSSL(clientCtx);
+	ASSERT_TRUE(handshake(*server, *client));
+
+	bool succ = server->enableKtls(ss.getfd());
+	ASSERT_TRUE(client->enableKtls(cs.getfd()) == succ);
+	ASSERT_TRUE(server->isKtlsTx() == server->isKtlsRx());
+
+	{
+		TC_NetWorkBuffer out(NULL);
+		client->write("hello", 5, out);
+		sendAll(cs.getfd(), out);
+
+		char buff[1024];
+		string data;
+		while (data.size() < 5)
+		{
+			if (server->isKtlsRx())
+			{
+				//内核已经解密
+				int ret = server->recvKtls(ss.getfd(), buff, sizeof(buff), 0);
+				ASSERT_TRUE(ret > 0);
+				data.append(buff, ret);
+				continue;
+			}
+
+			int ret = ::recv(ss.getfd(), buff, sizeof(buff), 0);
+			ASSERT_TRUE(ret > 0);
+
+			server->read(buff, ret, out);
+			data += server->recvBuffer()->getBuffersString();
+			server->recvBuffer()->clearBuffers();
+		}
+		ASSERT_TRUE(data == "hello");
+	}
+
+	//内核不支持时回退到openssl, 数据照常收发
+	int64_t start = TC_Common::now2us();
+	ASSERT_TRUE(transfer(*server, *client, ss, cs, total, block));
+	int64_t us2 = TC_Common::now2us() - start;
+
+	LOG_CONSOLE_DEBUG << (tls12 ? "TLS1.2" : "TLS1.3") << ", " << total / 1024 / 1024 << "MB, openssl: " << total / (us1 + 1) << "MB/s, "
+		<< (succ ? "ktls: " : "ktls not support, fallback: ") << total / (us2 + 1) << "MB/s" << endl;
+}
+
+TEST_F(UtilOpenSSLTest, testKtls12)
+{
+	testKtls(true);
+}
+
+TEST_F(UtilOpenSSLTest, testKtls13)
+{
+	testKtls(false);
+}
+
+#endif
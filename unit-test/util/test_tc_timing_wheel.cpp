@@ -0,0 +1,293 @@
+﻿#include "util/tc_timing_wheel.h"
+#include "util/tc_timeout_queue_new.h"
+#include "util/tc_timeout_queue_noid.h"
+#include "util/tc_common.h"
+#include "util/tc_logger.h"
+#include "gtest/gtest.h"
+
+#include <map>
+#include <set>
+
+using namespace std;
+using namespace tars;
+
+class UtilTimingWheelTest : public testing::Test
+{
+public:
+	//添加日志
+	static void SetUpTestCase()
+	{
+	}
+	static void TearDownTestCase()
+	{
+	}
+	virtual void SetUp()   //TEST跑之前会执行SetUp
+	{
+	}
+	virtual void TearDown() //TEST跑完之后会执行TearDown
+	{
+	}
+};
+
+TEST_F(UtilTimingWheelTest, testExpire)
+{
+	int64_t now = 1000000;
+	TC_TimingWheel<int> wheel(1, now);
+
+	ASSERT_TRUE(wheel.nextExpire() == -1);
+
+	wheel.add(now + 10, 10);
+	wheel.add(now + 300, 300);
+	wheel.add(now + 70000, 70000);
+	wheel.add(now - 5, -5);
+
+	ASSERT_TRUE(wheel.size() == 4);
+	ASSERT_TRUE(wheel.nextExpire() <= now);
+
+	int v;
+	ASSERT_TRUE(wheel.expire(now, v));
+	ASSERT_TRUE(v == -5);
+	ASSERT_FALSE(wheel.expire(now, v));
+
+	ASSERT_TRUE(wheel.nextExpire() > now && wheel.nextExpire() <= now + 10);
+
+	ASSERT_FALSE(wheel.expire(now + 9, v));
+	ASSERT_TRUE(wheel.expire(now + 10, v));
+	ASSERT_TRUE(v == 10);
+
+	ASSERT_FALSE(wheel.expire(now + 299, v));
+	ASSERT_TRUE(wheel.expire(now + 300, v));
+	ASSERT_TRUE(v == 300);
+
+	ASSERT_TRUE(wheel.nextExpire() <= now + 70000);
+	ASSERT_FALSE(wheel.expire(now + 69999, v));
+	ASSERT_TRUE(wheel.expire(now + 70000, v));
+	ASSERT_TRUE(v == 70000);
+
+	ASSERT_TRUE(wheel.empty());
+}
+
+TEST_F(UtilTimingWheelTest, testErase)
+{
+	int64_t now = 0;
+	TC_TimingWheel<string> wheel(1, now);
+
+	uint64_t id1 = wheel.add(now + 100, "a");
+	uint64_t id2 = wheel.add(now + 100, "b");
+	uint64_t id3 = wheel.add(now + 100000, "c");
+
+	string v;
+	ASSERT_TRUE(wheel.get(id1, v) && v == "a");
+	ASSERT_TRUE(wheel.erase(id1));
+	ASSERT_FALSE(wheel.erase(id1));
+	ASSERT_FALSE(wheel.get(id1, v));
+	ASSERT_TRUE(wheel.erase(id3));
+
+	//节点复用后, 旧的id失效
+	uint64_t id4 = wheel.add(now + 200, "d");
+	ASSERT_TRUE(id4 != id1);
+	ASSERT_FALSE(wheel.erase(id1));
+
+	//到期但还没有pop的也可以删除
+	wheel.advance(now + 100);
+	ASSERT_TRUE(wheel.erase(id2));
+	ASSERT_FALSE(wheel.pop(v));
+
+	ASSERT_TRUE(wheel.expire(now + 1000, v) && v == "d");
+	ASSERT_TRUE(wheel.empty());
+}
+
+TEST_F(UtilTimingWheelTest, testLongRange)
+{
+	//超出时间轮范围的数据
+	int64_t now = 0;
+	TC_TimingWheel<int> wheel(1000, now);
+
+	int64_t far = (((int64_t)1 << 32) + 12345) * 1000;
+
+	wheel.add(far, 1);
+
+	int v;
+	ASSERT_FALSE(wheel.expire(far - 1000, v));
+	ASSERT_TRUE(wheel.expire(far, v) && v == 1);
+}
+
+TEST_F(UtilTimingWheelTest, testRandom)
+{
+	int64_t now = 123456789;
+	TC_TimingWheel<uint32_t> wheel(1, now);
+
+	multimap<int64_t, uint32_t> expect;
+	map<uint32_t, uint64_t> ids;
+
+	srand(1);
+	uint32_t id = 0;
+
+	for (int loop = 0; loop < 20000; loop++)
+	{
+		int op = rand() % 10;
+		if (op < 5)
+		{
+			int64_t delay;
+			switch (rand() % 4)
+			{
+			case 0: delay = rand() % 256; break;
+			case 1: delay = rand() % 65536; break;
+			case 2: delay = rand() % (1 << 24); break;
+			default: delay = -(rand() % 10); break;
+			}
+
+			++id;
+			ids[id] = wheel.add(now + delay, id);
+			expect.insert(make_pair(now + delay, id));
+		}
+		else if (op < 7 && !ids.empty())
+		{
+			auto it = ids.begin();
+			std::advance(it, rand() % ids.size());
+
+			ASSERT_TRUE(wheel.erase(it->second));
+
+			for (auto e = expect.begin(); e != expect.end(); ++e)
+			{
+				if (e->second == it->first)
+				{
+					expect.erase(e);
+					break;
+				}
+			}
+			ids.erase(it);
+		}
+		else
+		{
+			int64_t next = wheel.nextExpire();
+			if (!expect.empty())
+			{
+				//时间轮给的时间不能晚于最早的到期时间
+				ASSERT_TRUE(next >= 0 && next <= (std::max)(expect.begin()->first, now));
+			}
+
+			//跳到下一个时间点或者随机前进
+			now = (rand() % 2 && next > now) ? next : now + rand() % 100000;
+
+			set<uint32_t> got;
+			uint32_t v;
+			wheel.advance(now);
+			while (wheel.pop(v))
+			{
+				got.insert(v);
+				ids.erase(v);
+			}
+
+			set<uint32_t> should;
+			while (!expect.empty() && expect.begin()->first <= now)
+			{
+				should.insert(expect.begin()->second);
+				expect.erase(expect.begin());
+			}
+
+			ASSERT_TRUE(got == should);
+		}
+
+		ASSERT_TRUE(wheel.size() == expect.size());
+	}
+}
+
+TEST_F(UtilTimingWheelTest, testTimeoutQueue)
+{
+	TC_TimeoutQueueNew<int> queue;
+
+	int64_t now = TNOWMS;
+
+	for (int i = 1; i <= 10; i++)
+	{
+		ASSERT_TRUE(queue.push(i, queue.generateId(), now + (i <= 5 ? -1 : 100000), i % 2 == 0));
+	}
+
+	ASSERT_TRUE(queue.size() == 10);
+	ASSERT_TRUE(queue.getSendListSize() == 5);
+
+	int v;
+	ASSERT_TRUE(queue.erase(1, v) && v == 1);
+
+	set<int> timeout;
+	while (queue.timeout(v))
+	{
+		timeout.insert(v);
+	}
+	ASSERT_TRUE(timeout == set<int>({2, 3, 4, 5}));
+	ASSERT_TRUE(queue.size() == 5);
+	ASSERT_TRUE(queue.getSendListSize() == 2);
+
+	ASSERT_TRUE(queue.get(6, v) && v == 6);
+	ASSERT_TRUE(queue.size() == 4);
+
+	TC_TimeoutQueueNoID<int> noid;
+	for (int i = 1; i <= 10; i++)
+	{
+		ASSERT_TRUE(noid.push(i, now + (i <= 5 ? -1 : 100000)));
+	}
+
+	timeout.clear();
+	while (noid.timeout(v))
+	{
+		timeout.insert(v);
+	}
+	ASSERT_TRUE(timeout == set<int>({1, 2, 3, 4, 5}));
+	ASSERT_TRUE(noid.size() == 5);
+	ASSERT_TRUE(noid.pop(v) && v == 6);
+}
+
+TEST_F(UtilTimingWheelTest, testBenchmark)
+{
+	int64_t now = 0;
+	const int count = 50000;
+
+	//模拟请求: 插入, 大部分在超时前删除(收到回包), 剩下的超时
+	{
+		TC_TimingWheel<uint32_t> wheel(1, now);
+		vector<uint64_t> ids(count);
+
+		int64_t start = TNOWUS;
+		for (int loop = 0; loop < 20; loop++)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				ids[i] = wheel.add(now + 3000 + i % 100, i);
+			}
+			for (int i = 0; i < count; i += 2)
+			{
+				wheel.erase(ids[i]);
+			}
+			now += 5000;
+			uint32_t v;
+			wheel.advance(now);
+			while (wheel.pop(v)) {}
+		}
+		LOG_CONSOLE_DEBUG << "TC_TimingWheel: " << TNOWUS - start << "us" << endl;
+	}
+
+	{
+		multimap<int64_t, uint32_t> timer;
+		vector<multimap<int64_t, uint32_t>::iterator> ids(count);
+
+		int64_t start = TNOWUS;
+		for (int loop = 0; loop < 20; loop++)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				ids[i] = timer.insert(make_pair(now + 3000 + i % 100, i));
+			}
+			for (int i = 0; i < count; i += 2)
+			{
+				timer.erase(ids[i]);
+			}
+			now += 5000;
+			while (!timer.empty() && timer.begin()->first <= now)
+			{
+				timer.erase(timer.begin());
+			}
+		}
+		LOG_CONSOLE_DEBUG << "multimap: " << TNOWUS - start << "us" << endl;
+	}
+}
@@ -0,0 +1,226 @@
+﻿/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except 
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed 
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR 
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the 
+ * specific language governing permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include "util/tc_consistent_hash_new.h"
+
+namespace tars
+{
+
+/////////////////////////////////////////////////
+/**
+ * @file tc_consistent_hash_ring.h
+ * @brief 紧凑的一致性hash环.
+ * @brief Compact consistent hash ring.
+ *
+ * 说明:
+ * - 环上只保存两个数组: 排好序的uint32 hash值, 以及对应的节点下标, 查找时不分配内存, 不比较字符串
+ * - 虚拟节点的hash计算和TC_ConsistentHashNew一致, 同样的节点名称和权重映射结果相同
+ * - addNode/sortNode构建完成后只读, 节点变化时重新构建一个新环替换旧的,
+ *   多线程共享时用shared_ptr<const TC_ConsistentHashRing>配合std::atomic_load/std::atomic_store替换
+ * - 支持有界负载(consistent hashing with bounded loads): 每个节点的负载上限为 ceil(c * (总负载 + 1) / 节点数),
+ *   命中的节点超过上限时沿环顺时针找下一个未超限的节点, 热点key不会压垮单个节点
+ *
+ * Description:
+ * - Only a sorted uint32 hash array and a node index array are kept, lookups do not allocate
+ * - Virtual nodes are hashed the same way as TC_ConsistentHashNew
+ * - Read only after addNode/sortNode, rebuild a new ring and swap it when nodes change
+ * - Bounded loads: a node whose load exceeds ceil(c * (total + 1) / nodes) is skipped clockwise
+ */
+
+/////////////////////////////////////////////////
+/**
+ *  @brief 一致性hash环
+ *  @brief Consistent Hash Ring
+ */
+class UTIL_DLL_API TC_ConsistentHashRing
+{
+public:
+    /**
+     *  @brief 构造函数
+     *  @brief Constructor
+     */
+    TC_ConsistentHashRing(TC_HashAlgorithmType hashType = E_TC_CONHASH_KETAMAHASH);
+
+    /**
+     * @brief 增加节点, 所有节点加完后调用sortNode
+     * @brief add node, call sortNode after all nodes are added
+     *
+     * @param node   节点名称
+     * @param node   node name
+     * @param index  节点下标, 使用有界负载时需要从0开始连续
+     * @param index  node subscript, must be 0..n-1 when bounded loads are used
+     * @param weight 节点的权重，默认为1
+     * @param weight node weight, default value is 1
+     * @return       0: 成功, -1: 失败
+     * @return       0: success, -1: fail
+     */
+    int addNode(const string & node, unsigned int index, int weight = 1);
+
+    /**
+     * @brief 排序, 生成环
+     * @brief Sort and build the ring
+     */
+    void sortNode();
+
+    /**
+     * @brief 获取某hashcode对应到的节点node的下标.
+     * @brief Gets the subscript of the node to which a certain hashcode corresponds
+     *
+     * @param hashcode hashcode
+     * @param iIndex   对应到的节点下标
+     * @param iIndex   the subscript of the node to which corresponds
+     * @return         0:获取成功   -1:没有被添加的节点
+     * @return         0:obtain successfully  -1:no nodes added
+     */
+    int getIndex(uint32_t hashcode, unsigned int & iIndex) const
+    {
+        if (_vHash.empty())
+        {
+            iIndex = 0;
+            return -1;
+        }
+
+        iIndex = _vIndex[position(hashcode)];
+        return 0;
+    }
+
+    /**
+     * @brief 有界负载方式获取某hashcode对应到的节点node的下标.
+     * @brief Gets the subscript of the node with bounded loads
+     *
+     * @param hashcode hashcode
+     * @param iIndex   对应到的节点下标
+     * @param iIndex   the subscript of the node to which corresponds
+     * @param c        负载系数, 必须大于1, 越小越均衡, 但是key迁移越多
+     * @param c        load factor, must be greater than 1
+     * @param load     size_t load(unsigned int index), 返回节点当前的负载(比如在途请求数)
+     * @param load     returns the current load of a node (e.g. inflight requests)
+     * @return         0:获取成功   -1:没有被添加的节点
+     * @return         0:obtain successfully  -1:no nodes added
+     */
+    template<typename LoadF>
+    int getIndex(uint32_t hashcode, unsigned int & iIndex, double c, const LoadF &load) const
+    {
+        if (_vHash.empty())
+        {
+            iIndex = 0;
+            return -1;
+        }
+
+        size_t pos = position(hashcode);
+
+        size_t total = 0;
+        for (unsigned int i = 0; i < _nodeCount; i++)
+        {
+            total += load(i);
+        }
+
+        size_t capacity = (size_t)std::ceil(c * (total + 1) / _nodeCount);
+
+        //c > 1时所有节点的上限之和大于总负载, 一定能找到
+        for (size_t i = 0; i < _vHash.size(); i++)
+        {
+            unsigned int index = _vIndex[pos];
+            if (load(index) < capacity)
+            {
+                iIndex = index;
+                return 0;
+            }
+
+            if (++pos == _vHash.size())
+            {
+                pos = 0;
+            }
+        }
+
+        iIndex = _vIndex[position(hashcode)];
+        return 0;
+    }
+
+    /**
+     * @brief 获取某key对应到的节点node的下标.
+     * @brief Gets the subscript of the node to which a key corresponds.
+     */
+    int getIndex(const string & key, unsigned int & iIndex) const;
+
+    /**
+     * @brief 环上虚拟节点的个数
+     * @brief virtual node count
+     */
+    size_t size() const { return _vHash.size(); }
+
+    /**
+     * @brief 节点个数(下标最大值 + 1)
+     * @brief node count
+     */
+    size_t nodeCount() const { return _nodeCount; }
+
+    /**
+     * @brief 清空
+     * @brief clear
+     */
+    void clear();
+
+protected:
+    /**
+     * 第一个hash值大于hashcode的位置, 没有则回到0, 和TC_ConsistentHashNew::getIndex的结果一致
+     */
+    size_t position(uint32_t hashcode) const
+    {
+        if (hashcode <= _vHash.front() || hashcode > _vHash.back())
+        {
+            return 0;
+        }
+
+        //无分支的二分查找, 找到最后一个不大于hashcode的位置
+        const uint32_t *base = _vHash.data();
+        size_t n = _vHash.size();
+        while (n > 1)
+        {
+            size_t half = n / 2;
+            base = (base[half] <= hashcode) ? base + half : base;
+            n -= half;
+        }
+
+        return (base - _vHash.data()) + 1;
+    }
+
+protected:
+    /**
+     * 排好序的hash值
+     */
+    vector<uint32_t>        _vHash;
+
+    /**
+     * _vHash对应的节点下标
+     */
+    vector<uint32_t>        _vIndex;
+
+    /**
+     * 构建中的数据, 高32位hash, 低32位下标, sortNode后释放
+     */
+    vector<uint64_t>        _vBuild;
+
+    unsigned int            _nodeCount = 0;
+
+    TC_HashAlgorithmPtr     _ptrHashAlg;
+};
+
+}
@@ -21,9 +21,14 @@
 #include <set>
 #include <deque>
 #include <map>
+#include <vector>
+#include <string>
 #include <functional>
+#include <atomic>
+#include <mutex>
 #include "util/tc_platform.h"
 #include "util/tc_fcontext.h"
+#include "util/tc_work_steal_deque.h"
 #include "util/tc_thread_queue.h"
 #include "util/tc_monitor.h"
 #include "util/tc_thread.h"
@@ -48,6 +53,7 @@ namespace tars
  * - TC_CoroutineInfo, 协程信息类, 每个协程都对应一个TC_CoroutineInfo对象, 协程切换本质就是切换TC_CoroutineInfo对象, 正常情况下业务不需要感知该对象
  * - TC_CoroutineScheduler, 协程调度器类, 负责管理和调度协程, 本质上就是管理和调度TC_CoroutineInfo
  * - TC_Coroutine, 协程类, 继承于线程类(TC_Thread), 用来给业务快速使用协程
+ * - TC_CoroutineSchedulerGroup, 调度器分组, 多个线程的调度器之间通过工作窃取均衡还没有开始执行的任务
  *
  * TC_CoroutineScheduler详细说明:
  * - 该类是协程调度的核心, 业务使用上, 框架需要和这个类打交道, 业务上除非自己来实现协程管理逻辑, 否则通常可以不深入了解该类的实现
@@ -110,10 +116,22 @@ struct stack_traits
 	static stack_context allocate(std::size_t);
 
 	static void deallocate( stack_context &);
+
+	/**
+	 * 栈已经提交(使用过)的大小, 从栈顶开始按页统计, 平台不支持时返回0
+	 */
+	static std::size_t used(const stack_context &);
+
+	/**
+	 * 保留栈顶keep大小, 下面的内存还给系统(栈内容不再需要)
+	 * @param lazy, true: MADV_FREE(内存紧张时才回收), false: MADV_DONTNEED
+	 */
+	static void trim(const stack_context &, std::size_t keep, bool lazy);
 };
 
 
 class TC_CoroutineScheduler;
+class TC_CoroutineSchedulerGroup;
 
 ///////////////////////////////////////////
 /**
@@ -254,6 +272,16 @@ public:
      */
     void registerFunc(const std::function<void ()> &callback);
 
+    /**
+     * 只保存处理函数, 不创建上下文(共享栈模式下第一次切换到协程时再makeContext)
+     */
+    void setCallback(const std::function<void ()> &callback);
+
+    /**
+     * 在协程的栈上创建上下文
+     */
+    void makeContext();
+
     /**
      * 设置协程的内存空间
      */
@@ -337,6 +365,23 @@ private:
      * 协程具体执行函数
      */
     std::function<void ()> 		_callback;
+
+    /*
+     * 使用的共享栈, -1表示独立栈
+     */
+    int                         _sharedIndex = -1;
+
+    /*
+     * 共享栈模式下, 被其他协程换出时保存的栈数据
+     */
+    string                      _saveStack;
+
+    /*
+     * 还没有创建上下文
+     */
+    bool                        _needInit = false;
+
+    friend class TC_CoroutineScheduler;
 };
 
 ///////////////////////////////////////////
@@ -378,11 +423,68 @@ public:
      */
     void setPoolStackSize(uint32_t iPoolSize, size_t iStackSize);
 
+    /**
+     * 设置栈的复用(init之前调用)
+     * 协程启动时才分配栈, 结束后归还到空闲列表给后面的协程复用, 栈的个数只和同时存在的协程数有关
+     * @param maxFree, 空闲列表最多缓存的栈个数, 超过直接释放
+     * @param keepSize, 栈归还时保留栈顶已使用的内存大小, 超出部分通过madvise还给系统(-1表示不归还)
+     * @param lazyFree, true: MADV_FREE, 内存紧张时系统才回收; false: MADV_DONTNEED, 立即回收
+     */
+    void setStackPool(size_t maxFree, size_t keepSize, bool lazyFree = false);
+
+    /**
+     * 开启共享栈(init之前调用), 适合大量长时间挂起的协程
+     * 协程轮流分配到sharedCount个共享栈上运行, 被换出时把已使用的栈数据拷贝出来, 换入时再拷贝回去
+     * 注意: 协程挂起时栈上的变量不能被其他协程或者线程访问(地址不变, 但内容已经被其他协程覆盖)
+     * @param sharedCount, 共享栈个数, 0表示关闭
+     */
+    void setSharedStack(size_t sharedCount);
+
+    /**
+     * 栈的统计信息
+     */
+    struct StackStat
+    {
+        size_t      stacks = 0;         //已经分配的独立栈个数(包括空闲的)
+        size_t      freeStacks = 0;     //空闲的独立栈个数
+        size_t      highWater = 0;      //协程结束时统计的栈使用最高水位(字节, 独立栈按页统计)
+        size_t      savedSize = 0;      //共享栈模式下, 换出的协程保存的栈数据大小
+        uint64_t    copies = 0;         //共享栈模式下, 栈数据换出的次数
+    };
+
+    /**
+     * 获取栈的统计信息, 用于评估合理的栈大小
+     */
+    StackStat getStackStat() const;
+
     /**
      * 创建协程
      */
     uint32_t go(const std::function<void ()> &callback);
 
+    /**
+     * 加入调度器分组(run之前调用)
+     */
+    void setGroup(const shared_ptr<TC_CoroutineSchedulerGroup> &group);
+
+    /**
+     * 获取调度器分组, 没有则返回null
+     */
+    inline const shared_ptr<TC_CoroutineSchedulerGroup> &getGroup() const { return _group; }
+
+    /**
+     * 提交任务(只能在调度器所在线程调用)
+     * 没有分组时等同于go, 有分组时先放到自己的窃取队列, 轮到时再启动协程, 在此之前可能被分组内空闲的调度器窃取走
+     * @return 是否成功
+     */
+    bool post(const std::function<void ()> &callback);
+
+    /**
+     * 还能提交的任务数: 空闲的协程数减去自己窃取队列中还没有启动的任务数
+     * post有分组时不占用协程, 提交方需要用它来控制积压, 没有分组时等同于getFreeSize
+     */
+    uint32_t getPostFreeSize();
+
     /**
      * 通知循环醒过来
      */
@@ -487,6 +589,11 @@ public:
      * 是否在主协程中
      */
     inline bool isMainCoroutine() { return _currentCoro->getUid() == 0; }
+
+    /**
+     * 是否在业务协程中(调度器还没有运行或者在主协程中都返回false)
+     */
+    inline bool isInCoroutine() const { return _currentCoro != NULL && _currentCoro->getUid() != 0; }
     
     /**
      * 调度器中的主协程
@@ -572,6 +679,42 @@ protected:
      */
     void moveToFreeList(TC_CoroutineInfo *coro);
 
+    /**
+     * 从分组的队列中取任务启动协程(每次最多启动一个, 剩下的留给其他调度器窃取)
+     * @param bSteal, 自己的队列为空时是否窃取其他调度器的任务
+     * @return 是否启动了协程
+     */
+    bool goGroupTask(bool bSteal);
+
+    /**
+     * 没有可执行的协程时等待, 有分组时先尝试窃取
+     */
+    void waitIdle();
+
+    /**
+     * 分配独立栈(优先复用空闲的)
+     */
+    stack_context allocStack();
+
+    /**
+     * 协程结束后回收栈(不能在协程自己的栈上调用)
+     */
+    void releaseStack(TC_CoroutineInfo *coro);
+
+    /**
+     * 切换到共享栈协程前, 换出栈上原来的协程, 换入目标协程
+     */
+    void switchSharedStack(TC_CoroutineInfo *to);
+
+    /**
+     * 共享栈
+     */
+    struct SharedStack
+    {
+        stack_context       ctx;
+        TC_CoroutineInfo    *owner = NULL;
+    };
+
 private:
 
     /*
@@ -673,6 +816,197 @@ private:
      * 解决在使用协程锁时tc_coroutine_mutex.h(TC_CoMutex)，可能多线程使用TC_CoroutineScheduler->put造成的_activeCoroQueue队列写冲突
      */
 	std::mutex				_mutex;
+
+    /**
+     * 调度器分组
+     */
+    shared_ptr<TC_CoroutineSchedulerGroup> _group;
+
+    /**
+     * 在分组中的序号
+     */
+    size_t                  _groupIndex = 0;
+
+    /**
+     * 空闲的独立栈
+     */
+    vector<stack_context>   _freeStacks;
+
+    /**
+     * 空闲栈最多缓存的个数
+     */
+    size_t                  _maxFreeStacks = (size_t)-1;
+
+    /**
+     * 栈归还时保留的大小
+     */
+    size_t                  _keepStackSize = (size_t)-1;
+
+    /**
+     * 是否用MADV_FREE
+     */
+    bool                    _lazyFree = false;
+
+    /**
+     * 共享栈
+     */
+    vector<SharedStack>     _sharedStacks;
+
+    /**
+     * 下一个分配的共享栈
+     */
+    size_t                  _sharedPos = 0;
+
+    /**
+     * 栈的统计
+     */
+    StackStat               _stackStat;
+};
+
+/**
+ * 协程调度器分组, 用于多个线程(每个线程一个调度器)之间均衡负载:
+ * - 每个调度器有一个工作窃取队列(TC_WorkStealDeque), 通过post提交的任务先放到自己的队列中
+ * - 调度器没有待启动的协程时, 才从自己的队列底部取一个任务启动协程
+ * - 调度器空闲(没有可执行的协程)时, 从其他调度器的队列顶部窃取任务, 在自己的线程中启动协程
+ * - 只窃取还没有开始执行的任务; 已经开始执行的协程(包括yield后已经就绪的), 栈、epoll上注册的事件、线程私有数据都和所在线程绑定, 不迁移
+ * - 提交任务时如果自己已经有积压, 会唤醒一个空闲的调度器来窃取
+ */
+class UTIL_DLL_API TC_CoroutineSchedulerGroup
+{
+public:
+    typedef std::function<void ()> Task;
+
+    /**
+     * 构造
+     * @param maxSize, 最多加入的调度器个数
+     */
+    TC_CoroutineSchedulerGroup(size_t maxSize);
+
+    /**
+     * 析构, 释放还没有执行的任务
+     */
+    ~TC_CoroutineSchedulerGroup();
+
+    /**
+     * 调度器加入分组
+     * @return 组内序号, 满了返回-1
+     */
+    int join(TC_CoroutineScheduler *scheduler);
+
+    /**
+     * 调度器离开分组(调度器结束时), 队列中剩下的任务由其他调度器窃取
+     * @param index
+     */
+    void leave(size_t index);
+
+    /**
+     * 已经加入的调度器个数
+     */
+    inline size_t size() const { return _size; }
+
+    /**
+     * 调度器队列中等待的任务数(近似值)
+     * @param index
+     */
+    size_t getTaskSize(size_t index) const;
+
+    /**
+     * 所有调度器窃取成功的总数
+     */
+    uint64_t getSteals() const;
+
+    /**
+     * 调度器窃取到的任务数
+     * @param index
+     */
+    uint64_t getSteals(size_t index) const;
+
+    /**
+     * 调度器被其他调度器窃取走的任务数
+     * @param index
+     */
+    uint64_t getStolen(size_t index) const;
+
+    /**
+     * 调度器提交的任务数
+     * @param index
+     */
+    uint64_t getPosts(size_t index) const;
+
+    /**
+     * 调度器窃取失败(其他队列都为空或者竞争失败)的次数
+     * @param index
+     */
+    uint64_t getStealFails(size_t index) const;
+
+protected:
+    friend class TC_CoroutineScheduler;
+
+    struct Member
+    {
+        Member() : deque(1024) { }
+
+        TC_WorkStealDeque<Task*>    deque;
+
+        //保护scheduler, 唤醒空闲调度器时调度器不能已经释放
+        std::mutex                  mutex;
+
+        TC_CoroutineScheduler*      scheduler = NULL;
+
+        std::atomic<bool>           idle{false};
+
+        std::atomic<uint64_t>       posts{0};
+
+        std::atomic<uint64_t>       steals{0};
+
+        std::atomic<uint64_t>       stolen{0};
+
+        std::atomic<uint64_t>       stealFails{0};
+    };
+
+    /**
+     * 放到调度器自己的队列(只能调度器所在线程调用)
+     * @return 放入前队列中的任务数
+     */
+    size_t push(size_t index, Task *task);
+
+    /**
+     * 从调度器自己的队列取任务(只能调度器所在线程调用)
+     */
+    Task *pop(size_t index);
+
+    /**
+     * 窃取其他调度器的任务
+     */
+    Task *steal(size_t index);
+
+    /**
+     * 设置空闲标记
+     */
+    void setIdle(size_t index, bool idle);
+
+    /**
+     * 唤醒一个空闲的调度器(除了index自己)
+     */
+    void notifyIdle(size_t index);
+
+protected:
+    /**
+     * 所有成员, 构造时分配好, 窃取时不需要加锁遍历
+     */
+    vector<Member*>         _members;
+
+    /**
+     * 已经加入的个数
+     */
+    std::atomic<size_t>     _size{0};
+
+    /**
+     * 窃取的起始位置, 避免都从同一个调度器开始窃取
+     */
+    std::atomic<size_t>     _stealPos{0};
+
+    std::mutex              _mutex;
 };
 
 /**
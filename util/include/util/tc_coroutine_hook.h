@@ -0,0 +1,69 @@
+﻿/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except 
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed 
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR 
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the 
+ * specific language governing permissions and limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include "util/tc_platform.h"
+
+namespace tars
+{
+/////////////////////////////////////////////////
+/**
+ * @file tc_coroutine_hook.h
+ * @brief 协程系统调用hook.
+ *
+ * 说明:
+ * - 编译时打开TARS_CORO_HOOK(cmake -DTARS_CORO_HOOK=ON, 只支持linux)才生效, 否则isHooked始终返回false
+ * - hook了socket/close/fcntl/setsockopt/connect/read/write/recv/send/recvfrom/sendto/poll/epoll_wait/sleep/usleep/nanosleep/gethostbyname
+ * - 只有当前线程运行着TC_CoroutineScheduler, 并且在业务协程中(非主协程)调用时才会切换协程, 其他情况行为和系统调用一致
+ * - 在协程中创建的socket内部会设置成非阻塞, 阻塞的读写/连接在EAGAIN时把句柄注册到调度器的TC_Epoller上, 然后让出协程, 直到句柄可读写或者超时
+ * - 业务自己设置了O_NONBLOCK的句柄不做处理(例如框架自己的网络句柄)
+ * - SO_RCVTIMEO/SO_SNDTIMEO设置的超时在等待时同样有效, 超时返回-1, errno=EAGAIN(connect超时errno=ETIMEDOUT)
+ * - sleep/usleep/nanosleep转成调度器的sleep, gethostbyname放到后台线程执行, 完成后唤醒协程
+ * - 这样原来阻塞的客户端代码(TC_TCPClient, TC_Mysql, TC_HttpRequest::doRequest等)不需要修改, 就可以在协程中并发执行
+ */
+/////////////////////////////////////////////////
+
+class UTIL_DLL_API TC_CoroutineHook
+{
+public:
+	/**
+	 * @brief 设置当前线程是否启用hook(默认启用)
+	 * @param enable
+	 */
+	static void setEnable(bool enable);
+
+	/**
+	 * @brief 当前线程是否启用hook
+	 */
+	static bool isEnable();
+
+	/**
+	 * @brief 当前调用是否会被hook(编译打开了hook, 线程启用了hook, 并且在调度器的业务协程中)
+	 */
+	static bool isHooked();
+
+	/**
+	 * @brief 等待句柄事件, 在协程中让出协程等待, 否则用poll阻塞等待
+	 * @param fd
+	 * @param events, POLLIN/POLLOUT
+	 * @param timeout, 毫秒, <0表示一直等待
+	 * @return int, >0: 有事件, 0: 超时, <0: 出错
+	 */
+	static int wait(int fd, short events, int timeout);
+};
+
+}
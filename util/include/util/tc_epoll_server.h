@@ -34,6 +34,7 @@
 #include "util/tc_network_buffer.h"
 #include "util/tc_transceiver.h"
 #include "util/tc_cas_queue.h"
+#include "util/tc_mpmc_queue.h"
 #include "util/tc_coroutine.h"
 #include "util/tc_openssl.h"
 
@@ -196,8 +197,20 @@ public:
         inline const TC_Socket::addr_type& addr() const      { return _addr; }
         inline const string & ip() const   { parseIpPort(); return _ip; }
         inline uint16_t port() const       { parseIpPort(); return _port; }
-        inline vector<char> & buffer()     { return _rbuffer; }
-        inline const vector<char> & buffer() const { return _rbuffer; }
+        inline vector<char> & buffer()     { materialize(); return _rbuffer; }
+        inline const vector<char> & buffer() const { materialize(); return _rbuffer; }
+        //接收的内容直接引用网络buffer(slice protocol解析时有效, 不copy数据)
+        inline TC_NetWorkBuffer::Slice & slice() { return _rslice; }
+        inline const TC_NetWorkBuffer::Slice & slice() const { return _rslice; }
+        //协议解析(parseHttp)时已经解析出的http请求头部/包体位置, 没有为NULL
+        inline shared_ptr<TC_HttpRequestParser> & httpParser() { return _httpParser; }
+        inline const shared_ptr<TC_HttpRequestParser> & httpParser() const { return _httpParser; }
+        //接收内容的地址和长度, 优先使用slice, 不会触发copy
+        inline pair<const char*, size_t> getBufferPointer() const
+        {
+            if(!_rslice.empty()) return make_pair(_rslice.data(), _rslice.size());
+            return make_pair(_rbuffer.data(), _rbuffer.size());
+        }
         inline int64_t recvTimeStamp() const { return _recvTimeStamp/1000; }
         inline int64_t recvTimeStampUs() const { return _recvTimeStamp; }
         inline bool isOverload() const     { return _isOverload; }
@@ -223,6 +236,15 @@ public:
         inline shared_ptr<SendContext> createCloseContext()    { return std::make_shared<SendContext>(shared_from_this(), 'c'); }
     protected:
         void parseIpPort() const;
+        //兼容buffer()接口, 把slice的内容copy到_rbuffer中
+        inline void materialize() const
+        {
+            if(!_rslice.empty())
+            {
+                _rslice.toVector(_rbuffer);
+                _rslice.clear();
+            }
+        }
     protected:
     	int _threadIndex;       //网络线程id
         uint32_t _uid;            /**连接标示*/
@@ -231,7 +253,9 @@ public:
         mutable uint16_t _port;           /**远程连接的端口*/
         int _fd;                /*保存产生该消息的fd，用于回包时选择网络线程*/
         weak_ptr<BindAdapter> _adapter;        /**标识哪一个adapter的消息*/
-        vector<char> _rbuffer;        /**接收的内容*/
+        mutable vector<char> _rbuffer;        /**接收的内容*/
+        mutable TC_NetWorkBuffer::Slice _rslice;    /**接收的内容(引用网络buffer)*/
+        shared_ptr<TC_HttpRequestParser> _httpParser;    /**http请求的解析结果*/
         bool _isOverload = false;     /**是否已过载 */
         bool _isClosed = false;       /**是否已关闭*/
         int _closeType;     /*如果是关闭消息包，则标识关闭类型,0:表示客户端主动关闭；1:服务端主动关闭;2:连接超时服务端主动关闭*/
@@ -274,6 +298,7 @@ public:
     typedef TC_ThreadQueue<shared_ptr<SendContext>> send_queue;
 
 //    typedef recv_queue::queue_type recv_queue_type;
+    typedef TC_MPMCQueue<shared_ptr<RecvContext>> recv_ring;
 
     ////////////////////////////////////////////////////////////////////////////
 
@@ -289,39 +314,62 @@ public:
         class DataQueue
         {
         public:
+            /**
+             * 构造
+             * @param ringCapacity, >0时使用无锁队列(TC_MPMCQueue), 否则使用TC_ThreadQueue
+             */
+            DataQueue(size_t ringCapacity = 0) { if(ringCapacity > 0) _ring.reset(new recv_ring(ringCapacity)); }
+
         	/**
         	 * 通知等待在队列上线程都醒过来
         	 */
-            inline void notify() { return _rbuffer.notifyT(); }
+            inline void notify() { if(_ring) _ring->notifyT(); else _rbuffer.notifyT(); }
 
             /**
              * push数据到队列中, 同时唤醒某个等待处理线程
              * @param recv
              */
-            inline void push_back(const shared_ptr<RecvContext> &recv ) { _rbuffer.push_back(recv); }
-            inline void push_back(const deque<shared_ptr<RecvContext>> &recv ) { _rbuffer.push_back(recv); }
+            inline void push_back(const shared_ptr<RecvContext> &recv ) { if(_ring) _ring->push_back(recv); else _rbuffer.push_back(recv); }
+            inline void push_back(const deque<shared_ptr<RecvContext>> &recv ) { if(_ring) _ring->push_back(recv); else _rbuffer.push_back(recv); }
 
             /**
              * 在队列上等待
              * @param millseconds
              * @return
              */
-            inline bool wait(size_t millseconds) { return _rbuffer.wait(millseconds); }
+            inline bool wait(size_t millseconds) { return _ring ? _ring->wait(millseconds) : _rbuffer.wait(millseconds); }
 
             /**
              * 弹出头部数据(如果没有数据也不阻塞)
              * @param data
              * @return
              */
-            inline bool pop_front(shared_ptr<RecvContext> &data) { return _rbuffer.pop_front(data, 0, false); }
+            inline bool pop_front(shared_ptr<RecvContext> &data) { return _ring ? _ring->try_pop(data) : _rbuffer.pop_front(data, 0, false); }
+
+			inline size_t size(){ return _ring ? _ring->size() : _rbuffer.size(); }
+
+            /**
+             * 是否是无锁队列
+             * @return
+             */
+            inline bool isLockFree() const { return _ring.get() != NULL; }
 
-			inline size_t size(){ return _rbuffer.size(); }
+            /**
+             * 无锁队列满时的回调
+             * @param f
+             */
+            inline void setFullFunctor(const recv_ring::full_functor &f) { if(_ring) _ring->setFullFunctor(f); }
 
         protected:
             /**
              * 接收的数据队列
              */
             recv_queue _rbuffer;
+
+            /**
+             * 接收的数据队列(无锁)
+             */
+            std::unique_ptr<recv_ring> _ring;
         };
 
         /**
@@ -369,6 +417,33 @@ public:
          */
         inline void enableQueueMode() { _queueMode = true; }
 
+        /**
+         * 使用无锁队列(TC_MPMCQueue)替换默认的TC_ThreadQueue, 必须在服务启动前调用
+         * 队列满了网络线程会等待handle处理, 因此容量要大于BindAdapter的队列容量(setQueueCapacity)
+         * 网络线程和handle线程合并的模式下, 生产和消费都在同一个线程, 不使用无锁队列
+         * @param capacity, 每个队列的容量, 0表示使用TC_ThreadQueue
+         */
+        void enableLockFreeQueue(size_t capacity);
+
+        /**
+         * 是否使用无锁队列
+         * @return
+         */
+        inline bool isLockFreeQueue() const { return _threadDataQueue[0]->isLockFree(); }
+
+        /**
+         * handle的协程调度器组成分组(TC_CoroutineSchedulerGroup), 空闲的handle窃取其他handle还没有开始处理的请求, 必须在服务启动前调用
+         * 只在NET_THREAD_QUEUE_HANDLES_CO并且非队列模式下生效
+         * @param enable
+         */
+        void enableCoroutineSteal(bool enable);
+
+        /**
+         * 获取协程调度器分组, 没有开启返回null
+         * @return
+         */
+        inline const shared_ptr<TC_CoroutineSchedulerGroup> &getSchedulerGroup() const { return _schedulerGroup; }
+
 		/**
 		* handleIndex相应的DataQueue的大小
 		* @param handleIndex
@@ -443,6 +518,11 @@ public:
          */
         vector<shared_ptr<TC_CoroutineScheduler>>  _schedulers;
 
+        /**
+         * handle协程调度器的分组(工作窃取)
+         */
+        shared_ptr<TC_CoroutineSchedulerGroup>     _schedulerGroup;
+
         /**
          * wait time for queue
          */
@@ -641,6 +721,19 @@ public:
          */
         int send(const shared_ptr<SendContext> & data);
 
+        /**
+         * 添加发送buffer, 暂不发送, 等flushSend时和其他包一起聚合发送(writev)
+         * @param data
+         * @return bool, true: 第一次添加(需要调用flushSend)
+         */
+        bool appendSend(const shared_ptr<SendContext> & data);
+
+        /**
+         * 聚合发送appendSend添加的数据
+         * @return int, -1:发送出错, 0:正常
+         */
+        int flushSend();
+
         /**
          * 增加数据到队列中
          * @param vtRecvData
@@ -764,6 +857,11 @@ public:
          */
         size_t _messageSize = 0;
 
+        /**
+         * 是否有appendSend添加的数据等待flushSend
+         */
+        bool _pendingFlush = false;
+
         /**
          * 每5秒发送的数据
          */
@@ -1236,6 +1334,19 @@ public:
          */
         inline TC_NetWorkBuffer::protocol_functor & getProtocol() { return _pf; }
 
+        /**
+         * 注册slice协议解析器(解析出的包直接引用网络buffer, 不copy数据)
+         * 设置后优先于protocol_functor, 调用setProtocol会清除
+         * @param spf
+         */
+        void setSliceProtocol(const TC_NetWorkBuffer::slice_protocol_functor & spf);
+
+        /**
+         * 获取slice协议解析器
+         * @return slice_protocol_functor&
+         */
+        inline TC_NetWorkBuffer::slice_protocol_functor & getSliceProtocol() { return _spf; }
+
         /**
          * 解析包头处理对象
          * @return protocol_functor&
@@ -1352,6 +1463,18 @@ public:
          */
         inline void enableQueueMode() { return _dataBuffer->enableQueueMode(); }
 
+        /**
+         * 网络线程和handle之间使用无锁队列(必须在服务启动前调用)
+         * @param capacity, 队列容量, 0表示使用默认的TC_ThreadQueue
+         */
+        inline void enableLockFreeQueue(size_t capacity) { return _dataBuffer->enableLockFreeQueue(capacity); }
+
+        /**
+         * handle之间窃取还没有开始处理的请求(NET_THREAD_QUEUE_HANDLES_CO并且非队列模式下有效, 必须在服务启动前调用)
+         * @param enable
+         */
+        inline void enableCoroutineSteal(bool enable) { return _dataBuffer->enableCoroutineSteal(enable); }
+
 //        /**
 //         * 设置close回调函数
 //         */
@@ -1490,6 +1613,11 @@ public:
          */
         TC_NetWorkBuffer::protocol_functor _pf;
 
+        /**
+         * 协议解析(slice方式)
+         */
+        TC_NetWorkBuffer::slice_protocol_functor _spf;
+
         /**
          * 首个数据包包头过滤
          */
@@ -1831,6 +1959,11 @@ public:
          */
         send_queue              _sbuffer;
 
+        /**
+         * processPipe中需要聚合发送的连接
+         */
+        vector<uint32_t>        _flushUids;
+
         // /**
         //  * 空连接超时时间,单位是毫秒,默认值2s,
         //  * 该时间必须小于等于adapter自身的超时时间
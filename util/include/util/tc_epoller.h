@@ -63,6 +63,8 @@ namespace tars
  * 9 TC_Epoller对象的loop方法, 会发起一个epoll wait的事件循环, 会阻塞当前线程
  * 10 TC_Epoller对象的done方法, 会执行一次epoll wait事件, 如果没有任何事件发生, 则只会等待最后ms毫秒(参数确定)
  * 11 TC_Epoller对象中的notify方法, 可以主动唤醒epoll wait
+ * 12 linux下编译时打开TARS_IO_URING, 可以通过setBackend/setDefaultBackend选择io_uring作为事件后端(内核不支持时自动回退为epoll)
+ *    io_uring后端用poll(ET模式下为multishot poll)来模拟epoll事件, 所有add/mod/del在下一次wait时与等待合并为一次系统调用提交
  */
 /////////////////////////////////////////////////
 
@@ -70,10 +72,22 @@ namespace tars
  * @brief epoller操作类，已经默认采用了EPOLLET方式做触发
  * @brief epoller operation class, EPOLLET has been used by default for triggering 
  */
+class TC_IoUringPoller;
+
 class UTIL_DLL_API TC_Epoller : public TC_TimerBase
 {
 
 public:
+	/**
+	 * 事件后端
+	 * Event backend
+	 */
+	enum EPOLLER_BACKEND
+	{
+		EB_EPOLL    = 0,    //epoll(mac下为kqueue, windows下为wepoll)
+		EB_IO_URING = 1,    //io_uring(仅linux, 且编译时打开TARS_IO_URING)
+	};
+
     class UTIL_DLL_API EpollInfo : public enable_shared_from_this<EpollInfo>
 	{
 	public:
@@ -144,8 +158,9 @@ public:
 		 * @brief 添加监听句柄
 		 *
 		 * @param events
+		 * @return 0: 成功, 其他: 失败(例如句柄已经在epoll中, 或者句柄不支持epoll)
 		 */
-		void add(uint32_t events);
+		int add(uint32_t events);
 
 		/**
 		 * @brief 修改句柄事件.
@@ -267,6 +282,54 @@ public:
 	 */
 	void create(int max_connections, bool createNotify = true);
 
+	/**
+	 * 设置事件后端, 需要在create之前调用, io_uring不可用时create会回退为epoll
+	 * Set event backend, must be called before create, fallback to epoll if io_uring is not available
+	 * @param backend
+	 */
+	void setBackend(EPOLLER_BACKEND backend) { _backend = backend; }
+
+	/**
+	 * 当前实际使用的事件后端(create之后有效)
+	 * The backend actually in use (valid after create)
+	 * @return
+	 */
+	EPOLLER_BACKEND getBackend() const { return _backend; }
+
+	/**
+	 * 设置进程内新创建的TC_Epoller默认使用的事件后端(框架网络线程/协程调度器中的epoller都会使用它), 启动时设置
+	 * Set default backend for newly created TC_Epoller in this process, should be called at startup
+	 * @param backend
+	 */
+	static void setDefaultBackend(EPOLLER_BACKEND backend);
+
+	/**
+	 * 进程默认事件后端
+	 * @return
+	 */
+	static EPOLLER_BACKEND getDefaultBackend();
+
+	/**
+	 * 当前系统(内核及编译选项)是否支持io_uring后端
+	 * Whether io_uring backend is supported by current kernel and build
+	 * @return
+	 */
+	static bool isIoUringSupported();
+
+	/**
+	 * 事件后端名称
+	 * @param backend
+	 * @return epoll/io_uring
+	 */
+	static string backendName(EPOLLER_BACKEND backend);
+
+	/**
+	 * 解析事件后端名称(epoll/io_uring), 无法识别时返回EB_EPOLL
+	 * @param name
+	 * @return
+	 */
+	static EPOLLER_BACKEND backendFromName(const string &name);
+
 	/**
 	 * disable et模式
 	 */
@@ -286,8 +349,9 @@ public:
 	 * @param fd
      * @param data   data
 	 * @param events
+	 * @return 0: 成功, 其他: 失败
 	 */
-    void add(SOCKET_TYPE fd, uint64_t data, uint32_t events);
+    int add(SOCKET_TYPE fd, uint64_t data, uint32_t events);
 
 	/**
 	 * @brief 修改句柄事件, 这种模式不能指定epoll关联的数据(通过EpollInfo)
@@ -510,6 +574,16 @@ protected:
 	 * 空闲处理
 	 */
 	vector<std::function<void()>> _idleCallbacks;
+
+	/**
+	 * 事件后端
+	 */
+	EPOLLER_BACKEND _backend;
+
+	/**
+	 * io_uring后端, _backend为EB_IO_URING时有效
+	 */
+	TC_IoUringPoller *_uring = NULL;
 };
 
 }
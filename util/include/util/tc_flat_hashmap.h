@@ -0,0 +1,507 @@
+﻿/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except 
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed 
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR 
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the 
+ * specific language governing permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <functional>
+#include "util/tc_platform.h"
+#include "util/tc_ex.h"
+#include "util/tc_hash_fun.h"
+
+using namespace std;
+
+namespace tars
+{
+
+/////////////////////////////////////////////////
+/**
+* @file tc_flat_hashmap.h 
+* @brief  开放寻址的内存hashmap类 
+* @brief  Open addressing memory hashmap class
+*/            
+/////////////////////////////////////////////////
+/**
+* @brief Flat hash map异常类
+* @brief Flat Hash Map Exception Class
+*/
+struct TC_FlatHashMap_Exception : public TC_Exception
+{
+    TC_FlatHashMap_Exception(const string &buffer) : TC_Exception(buffer){};
+    ~TC_FlatHashMap_Exception() throw(){};
+};
+
+////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief  基于内存的开放寻址hashmap, 所有操作需要自己加锁 
+ * @brief  Memory-based open addressing hashmap, all operations require their own locks
+ *  
+ *内存hashmap，不要直接使用该类，通过jmem组件(TarsFlatHashMap)来使用. 
+ *Memory hashmap, do not use this class directly, use it through jmem components(TarsFlatHashMap).
+ *
+ *适合key/value都比较小且长度有上限的cache(例如key 8~64字节, value 256字节以内): 
+ *Suitable for caches whose keys and values are small and bounded (e.g. 8~64 bytes keys, values under 256 bytes):
+ *
+ *1 数据直接存放在定长的槽位中, 没有链表和内存块分配, 查找不需要在共享内存中跳转多次;
+ *1 Data is stored inline in fixed-size slots, no chains and no chunk allocation, lookups do not chase pointers in shared memory;
+ *
+ *2 每个槽位有一个控制字节(空/已删除/hash的低7位), 每16个为一组, 
+ *  查找时一次比较一组控制字节(有SSE2时用SIMD指令), 只有控制字节匹配的槽位才比较key;
+ *2 Every slot has a control byte (empty/deleted/lower 7 bits of the hash), grouped by 16,
+ *  a lookup compares a whole group at once (with SIMD when SSE2 is available), keys are only compared for matching control bytes;
+ *
+ *3 元素个数达到槽位数的7/8时, 按照CLOCK算法淘汰数据(get时设置访问标记, 指针扫过时清除标记, 淘汰没有标记的数据);
+ *3 When the element count reaches 7/8 of the slots, data is eliminated by the CLOCK algorithm
+ *  (get sets the reference bit, the hand clears it when passing, unreferenced data is eliminated);
+ *
+ *4 删除后留下的删除标记太多时, 原地重新整理一次;
+ *4 When too many deleted markers are left, the table is rebuilt in place;
+ *
+ *5 修改过程中进程退出, 下次connect时会删除正在修改的数据(整理过程中退出则清空), 其他数据不受影响;
+ *5 If the process exits while modifying, connect removes the data being modified (or clears all of it when rebuilding), other data is not affected;
+ *
+ *6 槽位个数在create时确定, 不支持扩容.
+ *6 The slot count is fixed by create, expanding is not supported.
+ */
+class TC_FlatHashMap
+{
+public:
+    /**
+     * @brief 淘汰的数据
+     * @brief Eliminated data
+     */
+    struct BlockData
+    {
+        string  _key;       /**数据Key*/
+        string  _value;     /**数据value*/
+    };
+
+    /**
+     * @brief map头
+     * @brief map header
+     */
+#pragma pack(1) 
+    struct tagMapHead
+    {
+        /*large version*/
+        char     _cMaxVersion;       /**大版本*/
+        /*small version*/
+        char     _cMinVersion;       /**小版本*/
+        /*Is it read-only*/
+        bool     _bReadOnly;         /**是否只读*/
+        /*Is it possible to phase out automatically*/
+        bool     _bAutoErase;        /**是否可以自动淘汰*/
+        /*Modification status: 0: none, 1: modifying _iModifySlot, 2: rebuilding*/
+        char     _cModifyStatus;     /**修改状态: 0:没有修改, 1:正在修改_iModifySlot, 2:正在整理*/
+        /*Maximum key size*/
+        uint32_t _iMaxKeySize;       /**key的最大长度*/
+        /*Maximum value size*/
+        uint32_t _iMaxValueSize;     /**value的最大长度*/
+        /*Slot size*/
+        uint32_t _iSlotSize;         /**槽位大小*/
+        /*mamory size*/
+        size_t   _iMemSize;          /**内存大小*/
+        /*Number of slots, a multiple of 16*/
+        size_t   _iSlotCount;        /**槽位个数, 16的倍数*/
+        /*total number of elements*/
+        size_t   _iElementCount;     /**总元素个数*/
+        /*Number of deleted markers*/
+        size_t   _iDeletedCount;     /**删除标记个数*/
+        /*CLOCK hand*/
+        size_t   _iClockHand;        /**CLOCK淘汰指针*/
+        /*Slot being modified*/
+        size_t   _iModifySlot;       /**正在修改的槽位*/
+        /*Get times*/
+        size_t   _iGetCount;         /**get次数*/
+        /*Hit Counts*/
+        size_t   _iHitCount;         /**命中次数*/
+        /*Number of eliminated data*/
+        size_t   _iEraseCount;       /**淘汰的数据个数*/
+        /*Reserved*/
+        size_t   _iReserve[4];       /**保留*/
+    };
+
+    /**
+     * @brief 槽位头部, 后面紧跟key和value
+     * @brief Slot header, followed by key and value
+     */
+    struct tagSlotHead
+    {
+        /*Key length*/
+        uint8_t  _iKeyLen;           /**key长度*/
+        /*CLOCK reference bit*/
+        uint8_t  _bRef;              /**CLOCK访问标记*/
+        /*Value length*/
+        uint16_t _iValueLen;         /**value长度*/
+    };
+#pragma pack() 
+
+    //定义版本号
+    //Define Version Number
+    enum
+    {
+        /*Large version number of current map*/
+        MAX_VERSION         = 0,    /**当前map的大版本号*/
+        /*Small version number of current map*/
+        MIN_VERSION         = 1,    /**当前map的小版本号*/
+    };
+
+    /**
+     * @brief get, set等int返回值
+     * @brief get, set, and other int return values
+     */
+    enum
+    {
+        RT_OK                   = 0,    /**成功*/
+        RT_NO_DATA              = 2,    /**没有数据*/
+        RT_ERASE_OK             = 5,    /**淘汰数据成功*/
+        RT_READONLY             = 6,    /**map只读*/
+        RT_NO_MEMORY            = 7,    /**内存不够*/
+        RT_DECODE_ERR           = -1,   /**解析错误*/
+        RT_EXCEPTION_ERR        = -2,   /**异常*/
+        RT_VERSION_MISMATCH_ERR = -4,   /**版本不一致*/
+        RT_DATA_TOO_LONG        = -8,   /**key或者value超过最大长度*/
+    };
+
+    /**
+     * @brief 控制字节, 其他值(0~0x7f)为hash的低7位
+     * @brief Control bytes, other values (0~0x7f) are the lower 7 bits of the hash
+     */
+    enum
+    {
+        CTRL_EMPTY      = 0x80,     /**空槽位*/
+        CTRL_DELETED    = 0xfe,     /**删除标记*/
+        GROUP_SIZE      = 16,       /**每组槽位个数*/
+    };
+
+    using hash_functor = std::function<size_t (const string& )>;
+
+    /**
+     * @brief 构造函数
+     * @brief Constructor
+     */
+    TC_FlatHashMap()
+    : _pHead(NULL)
+    , _pCtrl(NULL)
+    , _pSlot(NULL)
+    , _iGroupCount(0)
+    , _iMaxKeySize(64)
+    , _iMaxValueSize(256)
+    , _hashf(hash_new<string>())
+    {
+    }
+
+    /**
+     * @brief 初始化key和value的最大长度, create之前调用
+     * @brief Initialize the maximum key and value size, call before create
+     * @param iMaxKeySize: key的最大长度, <=255
+     * @param iMaxValueSize: value的最大长度, <=65535
+     */
+    void initDataSize(size_t iMaxKeySize, size_t iMaxValueSize);
+
+    /**
+     * @brief 初始化, 之前需要调用:initDataSize
+     * @brief Initialize, need to call before: initDataSize
+     * @param pAddr 绝对地址
+     * @param iSize 大小
+     */
+    void create(void *pAddr, size_t iSize);
+
+    /**
+     * @brief 连接上已经存在的hashmap, 上次修改没有完成时修复
+     * @brief Connect to an existing hashmap, repairs an unfinished modification
+     * @param pAddr 地址
+     * @param iSize 内存大小
+     */
+    void connect(void *pAddr, size_t iSize);
+
+    /**
+     * @brief 元素个数
+     * @brief Number of elements
+     */
+    size_t size() const                         { return _pHead->_iElementCount; }
+
+    /**
+     * @brief 槽位个数
+     * @brief Number of slots
+     */
+    size_t getSlotCount() const                 { return _pHead->_iSlotCount; }
+
+    /**
+     * @brief 最多能存放的元素个数, 达到以后开始淘汰
+     * @brief Maximum number of elements, elimination starts when it is reached
+     */
+    size_t getMaxElementCount() const           { return _pHead->_iSlotCount - _pHead->_iSlotCount / 8; }
+
+    /**
+     * @brief 删除标记个数
+     * @brief Number of deleted markers
+     */
+    size_t getDeletedCount() const              { return _pHead->_iDeletedCount; }
+
+    /**
+     * @brief 设置只读
+     * @brief Set read-only
+     * @param bReadOnly
+     */
+    void setReadOnly(bool bReadOnly)            { _pHead->_bReadOnly = bReadOnly; }
+
+    /**
+     * @brief 是否只读
+     * @brief Is it read-only
+     */
+    bool isReadOnly() const                     { return _pHead->_bReadOnly; }
+
+    /**
+     * @brief 设置是否可以自动淘汰, 不淘汰时满了set返回RT_NO_MEMORY
+     * @brief Set whether it can be eliminated automatically, set returns RT_NO_MEMORY when full otherwise
+     * @param bAutoErase
+     */
+    void setAutoErase(bool bAutoErase)          { _pHead->_bAutoErase = bAutoErase; }
+
+    /**
+     * @brief 是否可以自动淘汰
+     * @brief Whether it can be eliminated automatically
+     */
+    bool isAutoErase() const                    { return _pHead->_bAutoErase; }
+
+    /**
+     * @brief 头部信息
+     * @brief Header information
+     */
+    tagMapHead& getMapHead()                    { return *_pHead; }
+
+    /**
+     * @brief 设置hash方式
+     * @brief Set hash method
+     * @param hashf
+     */
+    void setHashFunctor(hash_functor hashf)     { _hashf = hashf; }
+
+    /**
+     * @brief 返回hash处理器
+     * @brief Return hash processor
+     */
+    hash_functor &getHashFunctor()              { return _hashf; }
+
+    /**
+     * @brief 描述
+     * @brief Description
+     */
+    string desc();
+
+    /**
+     * @brief 获取数据, 设置访问标记
+     * @brief Get data, set the reference bit
+     * @param k
+     * @param v
+     * @return int:
+     *          RT_NO_DATA: 没有数据
+     *          RT_OK:获取数据成功
+     */
+    int get(const string &k, string &v);
+
+    /**
+     * @brief 设置数据, 满了时按照CLOCK淘汰数据
+     * @brief Set data, data is eliminated by CLOCK when it is full
+     * @param k
+     * @param v
+     * @param vtData, 淘汰的数据
+     * @return int:
+     *          RT_READONLY: map只读
+     *          RT_DATA_TOO_LONG: key或者value太长
+     *          RT_NO_MEMORY: 没有空间(不淘汰数据情况下会出现)
+     *          RT_OK: 设置成功
+     */
+    int set(const string &k, const string &v, vector<BlockData> &vtData);
+
+    /**
+     * @brief 删除数据
+     * @brief Delete data
+     * @param k
+     * @param data, 被删除的数据
+     * @return int:
+     *          RT_READONLY: map只读
+     *          RT_NO_DATA: 没有当前数据
+     *          RT_OK: 删除数据成功
+     */
+    int del(const string &k, BlockData &data);
+
+    /**
+     * @brief 按照CLOCK淘汰一个数据
+     * @brief Eliminate one piece of data by CLOCK
+     * @param data, 被淘汰的数据
+     * @return int:
+     *          RT_READONLY: map只读
+     *          RT_NO_DATA: 没有数据
+     *          RT_ERASE_OK: 淘汰成功
+     */
+    int erase(BlockData &data);
+
+    /**
+     * @brief 清空
+     * @brief Clear
+     */
+    void clear();
+
+    /**
+     * @brief 遍历所有数据, 顺序是槽位的顺序
+     * @brief Traverse all data in slot order
+     * @param f, void (const string &k, const string &v)
+     */
+    template<typename F>
+    void forEach(F f)
+    {
+        for(size_t i = 0; i < _pHead->_iSlotCount; i++)
+        {
+            if(isFull(_pCtrl[i]))
+            {
+                f(getKey(i), getValue(i));
+            }
+        }
+    }
+
+protected:
+
+    /**
+     * 初始化指针
+     */
+    void init(void *pAddr);
+
+    /**
+     * 数据区偏移
+     */
+    static size_t ctrlOffset()                  { return (sizeof(tagMapHead) + 63) & ~(size_t)63; }
+
+    /**
+     * 控制字节是否是有数据
+     */
+    static bool isFull(uint8_t c)               { return (c & 0x80) == 0; }
+
+    /**
+     * hash值, 低7位作为控制字节, 高位决定从哪一组开始找
+     */
+    uint64_t hashValue(const string &k);
+
+    /**
+     * 开始查找的组
+     */
+    size_t startGroup(uint64_t h) const         { return (size_t)(((h >> 32) * _iGroupCount) >> 32); }
+
+    /**
+     * 控制字节
+     */
+    static uint8_t h2(uint64_t h)               { return (uint8_t)(h & 0x7f); }
+
+    /**
+     * 槽位地址
+     */
+    tagSlotHead *slot(size_t i)                 { return (tagSlotHead*)(_pSlot + i * _pHead->_iSlotSize); }
+
+    string getKey(size_t i)                     { tagSlotHead *s = slot(i); return string((char*)(s + 1), s->_iKeyLen); }
+    string getValue(size_t i)                   { tagSlotHead *s = slot(i); return string((char*)(s + 1) + _pHead->_iMaxKeySize, s->_iValueLen); }
+
+    /**
+     * 一组控制字节中等于c的位置, 第n位为1表示第n个字节匹配
+     */
+    static uint32_t matchByte(const uint8_t *g, uint8_t c);
+
+    /**
+     * 一组控制字节中空的或者删除标记的位置
+     */
+    static uint32_t matchEmptyOrDeleted(const uint8_t *g);
+
+    /**
+     * 最低的1的位置
+     */
+    static uint32_t lowestBit(uint32_t m);
+
+    /**
+     * 查找key所在的槽位, 没有返回(size_t)-1
+     */
+    size_t find(const string &k, uint64_t h);
+
+    /**
+     * 查找插入的槽位(空的或者删除标记), 调用者保证有空位
+     */
+    size_t findInsert(uint64_t h);
+
+    /**
+     * 删除槽位的数据
+     */
+    void eraseSlot(size_t i);
+
+    /**
+     * CLOCK淘汰一个数据
+     */
+    void evict(BlockData &data);
+
+    /**
+     * 删除标记太多时原地整理: 去掉删除标记, 数据放回离开始组最近的位置
+     */
+    void rebuild();
+
+    /**
+     * 修复上次没有完成的修改
+     */
+    void recover();
+
+    /**
+     * 开始/结束修改槽位
+     */
+    void beginModify(size_t i)                  { _pHead->_iModifySlot = i; _pHead->_cModifyStatus = 1; }
+    void endModify()                            { _pHead->_cModifyStatus = 0; }
+
+protected:
+    /**
+     * 头部指针
+     */
+    tagMapHead      *_pHead;
+
+    /**
+     * 控制字节
+     */
+    uint8_t         *_pCtrl;
+
+    /**
+     * 槽位
+     */
+    char            *_pSlot;
+
+    /**
+     * 组的个数
+     */
+    size_t          _iGroupCount;
+
+    /**
+     * create时key/value的最大长度
+     */
+    size_t          _iMaxKeySize;
+    size_t          _iMaxValueSize;
+
+    /**
+     * 整理时交换槽位用
+     */
+    string          _tmpSlot;
+
+    /**
+     * hash算法
+     */
+    hash_functor    _hashf;
+};
+
+}
@@ -555,9 +555,9 @@ public:
          * @param pAddr
          * @param iSize
          */
-        void append(void *pAddr, size_t iSize)
+        void append(void *pAddr, size_t iSize, size_t iReserve = 0)
         {
-            _pChunkAllocator->append(pAddr, iSize);
+            _pChunkAllocator->append(pAddr, iSize, iReserve);
         }
 
         /**
@@ -1237,8 +1237,14 @@ public:
         size_t _iSyncTail;           /**回写链表*/
         /*Number of OnlyKeys*/
         size_t _iOnlyKeyCount;         /** OnlyKey个数*/
-        /*retain*/
-        size_t _iReserve[4];        /**保留*/
+        /*Offset of the current hash bucket array, 0: right after the header (where create puts it)*/
+        size_t _iHashAddr;          /**当前hash桶数组的偏移地址, 0表示紧跟在头部后面(create时的位置)*/
+        /*Number of the first bucket in the current array, the block records the bucket number*/
+        size_t _iHashBase;          /**当前hash桶数组第一个桶的编号, block中记录的是编号*/
+        /*Offset of the new hash bucket array while rehashing, 0: not rehashing*/
+        size_t _iRehashAddr;        /**rehash时新hash桶数组的偏移地址, 0表示没有rehash*/
+        /*Number of migrated old buckets * 2, the lowest bit is 1 while the next bucket is being migrated*/
+        size_t _iRehashIndex;       /**已经迁移完的旧hash桶个数*2, 最低位为1表示正在迁移下一个桶*/
     };
 
     /**
@@ -1393,6 +1399,12 @@ public:
     , _lock_end(this, 0, 0, 0)
     , _end(this, (size_t)(-1))
     , _hashf(hash<string>())
+    , _bLocalAutoErase(true)
+    , _iHashAddr(0)
+    , _iRehashAddr(0)
+    , _iHashBase(0)
+    , _iRehashBase(0)
+    , _iRehashStep(1)
     {
     }
 
@@ -1461,6 +1473,25 @@ public:
      */
     int append(void *pAddr, size_t iSize);
 
+    /**
+     *  @brief 扩展内存, 同时增加hash桶的个数
+     *  @brief Expand memory and increase the number of hash buckets at the same time
+     * 新的hash桶数组放在扩展部分的开头, 之后每次get/set等操作迁移几个旧的桶(见setRehashStep), 也可以调用rehash主动迁移
+     * The new bucket array is put at the beginning of the expanded part, then a few old buckets are migrated by every get/set etc (see setRehashStep), rehash can also be called to migrate
+     * 迁移过程中数据可以正常读写, 每个block的迁移都是一次完整的修改, 进程重启后继续迁移
+     * Data can be read and written while migrating, moving each block is one complete modification, migration continues after restart
+     * 旧的hash桶数组迁移完以后不再使用(不回收)
+     * The old bucket array is not used (nor reclaimed) after migration
+     * @param pAddr, 扩展后的空间
+     * @param pAddr expanded space
+     * @param iSize
+     * @param iHashCount, 新的hash桶个数(取最近的素数), 0表示按照扩展后的大小计算; 不比当前多时只扩展内存
+     * @param iHashCount new number of hash buckets (nearest prime), 0: calculated from the expanded size; only memory is expanded if it is not more than now
+     * @return 0:成功, -1:失败
+     * @return 0:success, -1:failure
+     */
+    int append(void *pAddr, size_t iSize, size_t iHashCount);
+
     /**
      *  @brief 获取每种大小内存块的头部信息
      * @brief Get header information for each memory block size
@@ -1492,7 +1523,56 @@ public:
      *
      * @return size_t
      */
-    size_t getHashCount()                           { return _hash.size(); }
+    size_t getHashCount()                           { return _iRehashAddr == 0 ? _hash.size() : _hash.size() + _rehash.size(); }
+
+    /**
+     * @brief  是否正在rehash
+     * @brief Whether rehashing is in progress
+     * rehash时hash桶的下标[0, 旧桶个数)是旧的桶, 之后是新的桶, getHashCount返回两者之和
+     * While rehashing, bucket index [0, old count) are the old buckets, the new ones follow, getHashCount returns the sum
+     *
+     * @return bool
+     */
+    bool isRehashing()                              { return _pHead->_iRehashAddr != 0; }
+
+    /**
+     * @brief  获取rehash进度
+     * @brief Get rehash progress
+     * @param iMigrated, 已经迁移完的旧hash桶个数
+     * @param iMigrated number of old buckets already migrated
+     * @param iOldCount, 旧hash桶个数
+     * @param iOldCount number of old buckets
+     * @param iNewCount, 新hash桶个数, 没有rehash时为0
+     * @param iNewCount number of new buckets, 0 if not rehashing
+     */
+    void getRehashProgress(size_t &iMigrated, size_t &iOldCount, size_t &iNewCount);
+
+    /**
+     * @brief  设置每次get/set等操作顺便迁移的hash桶个数, 0表示只通过rehash迁移(当前进程有效)
+     * @brief Set the number of buckets migrated by every get/set etc, 0: only migrated by rehash (only for the current process)
+     * @param iStep
+     */
+    void setRehashStep(size_t iStep)                { _iRehashStep = iStep; }
+
+    /**
+     * @brief  获取每次操作迁移的hash桶个数
+     * @brief Get the number of buckets migrated by every operation
+     *
+     * @return size_t
+     */
+    size_t getRehashStep()                          { return _iRehashStep; }
+
+    /**
+     * @brief  迁移iStep个旧的hash桶(空桶也算), 上次中途退出没有迁移完的桶会先迁移完
+     * @brief Migrate iStep old buckets (empty ones count), a bucket left half migrated last time is finished first
+     * 会修改其他hash桶, 分段锁时需要锁住所有分段; 只读时不迁移
+     * Other buckets are modified, all stripes must be locked for striped locks; nothing is migrated when read-only
+     * @param iStep
+     *
+     * @return size_t, 还没有迁移的旧hash桶个数, 0表示没有rehash或者已经完成
+     * @return size_t, number of old buckets left, 0: not rehashing or finished
+     */
+    size_t rehash(size_t iStep);
 
     /**
      * @brief  获取元素的个数
@@ -1563,6 +1643,15 @@ public:
      */
     bool isAutoErase()                              { return _pHead->_bAutoErase; }
 
+    /**
+     * @brief  设置当前进程是否允许淘汰(不修改共享内存中的AutoErase设置)
+     * @brief  Set whether the current process may erase old data (the AutoErase setting in shared memory is not changed)
+     * 只锁住部分hash桶修改数据时, 不能淘汰其他桶的数据, 关闭后内存不够时返回RT_NO_MEMORY, 操作时也不会顺便rehash
+     * When only part of the hash buckets are locked, data in other buckets must not be erased, RT_NO_MEMORY is returned instead, and no rehash is done by the operation either
+     * @param bEnable
+     */
+    void setLocalAutoErase(bool bEnable)            { _bLocalAutoErase = bEnable; }
+
     /**
      * @brief  设置淘汰方式
      * @brief Set up elimination method
@@ -1624,7 +1713,7 @@ public:
      *
      * @return tagHashItem&
      */
-    tagHashItem *item(size_t iIndex)                { return &_hash[iIndex]; }
+    tagHashItem *item(size_t iIndex)                { return iIndex < _hash.size() ? &_hash[iIndex] : &_rehash[iIndex - _hash.size()]; }
 
     /**
      * @brief  dump到文件
@@ -1786,6 +1875,79 @@ public:
      */
     int get(const string& k, string &v);
 
+    /**
+     * @brief  只读方式获取数据, 不刷新GET时间链, 也不修改统计, 不写任何共享数据
+     * @brief  Get data read-only, the GET time chain and statistics are not changed, no shared data is written
+     * 用于分段锁: 调用者只需要保证index这个hash桶没有被修改, 其他桶可以同时修改
+     * For striped locks: the caller only needs to make sure bucket index is not being modified, other buckets can be modified at the same time
+     * 返回的iAddr在该桶被修改之前都有效, 可以稍后通过refreshGet批量刷新GET时间链
+     * The returned iAddr is valid until the bucket is modified, the GET time chain can be refreshed later by refreshGet
+     * @param k
+     * @param index: hashIndex(k)
+     * @param v
+     * @param iSyncTime
+     * @param iAddr: 数据所在的block, 只有返回RT_OK时有效
+     * @param iAddr The block of the data, only valid when RT_OK is returned
+     *
+     * @return int:
+     *          RT_NO_DATA: 没有数据
+     *          RT_NO_DATA: no data
+     *          RT_ONLY_KEY:只有Key
+     *          RT_ONLY_KEY: key only
+     *          RT_OK:获取数据成功
+     *          RT_OK:get data successfully
+     */
+    int peek(const string& k, size_t index, string &v, time_t &iSyncTime, size_t &iAddr);
+
+    /**
+     * @brief  批量刷新GET时间链, 并累加get/命中次数(配合peek使用)
+     * @brief  Refresh the GET time chain in batch and add get/hit count (used with peek)
+     * vtAddr里的block必须都还有效, 按顺序刷新, 最后一个在链表头部
+     * All blocks in vtAddr must still be valid, they are refreshed in order, the last one ends at the head
+     * @param vtAddr
+     * @param iGetCount
+     * @param iHitCount
+     */
+    void refreshGet(const vector<size_t> &vtAddr, size_t iGetCount, size_t iHitCount);
+
+    /**
+     * @brief  预取一批hash桶以及桶上第一个block的头部, 批量操作前调用, 减少逐个访问时的cache miss
+     * @brief  Prefetch a batch of hash buckets and the head of their first block, called before batch operations to reduce cache misses
+     * 只读, 不需要doUpdate
+     * Read-only, no doUpdate is needed
+     * @param vIndex: hashIndex
+     */
+    void prefetch(const vector<size_t> &vIndex);
+
+    /**
+     * @brief  根据Key计算hash值
+     * @brief Calculate the number of hash values based on Key
+     * @param k
+     *
+     * @return size_t
+     */
+    size_t hashIndex(const string& k);
+
+    /**
+     * @brief  根据hash值计算hash桶的下标(rehash时已经迁移的桶在新的数组里)
+     * @brief Calculate the bucket index from the hash value (buckets already migrated are in the new array while rehashing)
+     * @param h
+     *
+     * @return size_t
+     */
+    size_t hashValueIndex(size_t h)
+    {
+        size_t n = _hash.size();
+        size_t i = h % n;
+
+        if(_iRehashAddr != 0 && i < (_pHead->_iRehashIndex >> 1))
+        {
+            return n + h % _rehash.size();
+        }
+
+        return i;
+    }
+
     /**
      * @brief  设置数据, 修改时间链, 内存不够时会自动淘汰老的数据
      * @brief  Set up data, modify time chains, and automatically eliminate old data when memory is low
@@ -2161,6 +2323,78 @@ protected:
      */
     void delListCount(size_t index) { update(&item(index)->_iListCount, (uint32_t)item(index)->_iListCount-1); }
 
+    /**
+     * @brief  hash桶下标换成block中记录的编号
+     * @brief Convert the bucket index to the number recorded in the block
+     * @param index
+     *
+     * @return size_t
+     */
+    size_t toBlockIndex(size_t index) { return index < _hash.size() ? _iHashBase + index : _iRehashBase + index - _hash.size(); }
+
+    /**
+     * @brief  block中记录的编号换成hash桶下标
+     * @brief Convert the number recorded in the block to the bucket index
+     * @param iBlockIndex
+     *
+     * @return size_t
+     */
+    size_t fromBlockIndex(size_t iBlockIndex)
+    {
+        if(iBlockIndex >= _iHashBase && iBlockIndex - _iHashBase < _hash.size())
+        {
+            return iBlockIndex - _iHashBase;
+        }
+
+        assert(_iRehashAddr != 0);
+        return _hash.size() + iBlockIndex - _iRehashBase;
+    }
+
+    /**
+     * @brief  扩展内存, 扩展部分开头的iReserve字节不给数据区
+     * @brief Expand memory, the first iReserve bytes of the expanded part are not given to the data area
+     * @param pAddr
+     * @param iSize
+     * @param iReserve
+     *
+     * @return int
+     */
+    int doAppend(void *pAddr, size_t iSize, size_t iReserve);
+
+    /**
+     * @brief  连接当前的hash桶数组(rehash开始或者结束以后)
+     * @brief Connect the current bucket arrays (after rehash starts or finishes)
+     */
+    void syncHash();
+
+    /**
+     * @brief  计算新hash桶数组第一个桶的编号, 和旧数组的编号不重叠, 并且尽量小(block中的编号是32位)
+     * @brief Calculate the number of the first new bucket, not overlapping with the old numbers and as small as possible (32 bits in the block)
+     * @param iNewCount
+     *
+     * @return size_t
+     */
+    size_t rehashBase(size_t iNewCount) { return iNewCount <= _pHead->_iHashBase ? 0 : _pHead->_iHashBase + _hash.size(); }
+
+    /**
+     * @brief  把旧hash桶index的第一个block迁移到新的hash桶
+     * @brief Move the first block of old bucket index to the new bucket
+     * @param index
+     */
+    void rehashBlock(size_t index);
+
+    /**
+     * @brief  操作时顺便迁移几个hash桶
+     * @brief Migrate a few buckets along with the operation
+     */
+    void autoRehash()
+    {
+        if(_iRehashAddr != 0 && _bLocalAutoErase && !_pHead->_bReadOnly)
+        {
+            rehash(_iRehashStep);
+        }
+    }
+
     /**
      * @brief 相对地址换成绝对地址
      * @brief Replace relative address with absolute address
@@ -2192,16 +2426,6 @@ protected:
      */
     size_t eraseExcept(size_t iNowAddr, vector<BlockData> &vtData);
 
-    /**
-     * @brief  根据Key计算hash值
-     * @brief Calculate the number of hash values based on Key
-     * @param pKey
-     * @param iKeyLen
-     *
-     * @return size_t
-     */
-    size_t hashIndex(const string& k);
-
     /**
      * @brief  根据Key查找数据
      * @brief Find data based on Key
@@ -2320,6 +2544,38 @@ protected:
      * Hash Value Formula
      */
     hash_functor                _hashf;
+
+    /**
+     * 当前进程是否允许淘汰
+     * Whether the current process may erase old data
+     */
+    bool                        _bLocalAutoErase;
+
+    /**
+     * rehash时新的hash桶数组
+     * New hash bucket array while rehashing
+     */
+    TC_MemVector<tagHashItem>   _rehash;
+
+    /**
+     * 当前连接的hash桶数组偏移地址, 和头部不一致时需要重新连接
+     * Offsets of the connected bucket arrays, reconnected when they differ from the header
+     */
+    size_t                      _iHashAddr;
+    size_t                      _iRehashAddr;
+
+    /**
+     * 当前和新hash桶数组第一个桶的编号
+     * Numbers of the first bucket in the current and new arrays
+     */
+    size_t                      _iHashBase;
+    size_t                      _iRehashBase;
+
+    /**
+     * 每次操作迁移的hash桶个数
+     * Number of buckets migrated by every operation
+     */
+    size_t                      _iRehashStep;
 };
 
 }
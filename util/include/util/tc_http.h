@@ -107,6 +107,7 @@ struct TC_HttpRequest_Exception : public TC_Http_Exception
 class TC_TCPClient;
 class TC_HttpRequest;
 class TC_HttpResponse;
+class TC_HttpRequestParser;
 
 /**   
  * @brief  简单的URL解析类.
@@ -1443,6 +1444,19 @@ public:
      */
     bool decode(const char *sBuffer, size_t iLength);
 
+	/**
+	 * @brief 用增量解析器的结果生成请求(解析器已经解析完整, 这里才生成string)
+	 * @brief Build the request from a completed TC_HttpRequestParser (strings are materialised here)
+	 *
+	 * @param sBuffer 解析器解析的数据
+	 * @param sBuffer data parsed by the parser
+	 * @param parser
+	 * @throw         TC_HttpRequest_Exception
+	 * @return        解析器是否解析完整
+	 * @return        whether the parser has a complete request
+	 */
+	bool decode(const char *sBuffer, const TC_HttpRequestParser &parser);
+
     /**
      * @brief 生成请求(采用string方式).
      * @brief Generate a request (in string mode).
@@ -1786,5 +1800,240 @@ protected:
     int                _requestType;
 };
 
+/********************* TC_HttpRequestParser ***********************/
+
+/**
+ * @brief 增量http请求解析器(状态机).
+ * @brief Incremental(resumable) HTTP/1.1 request parser.
+ *
+ * 1 记住上次扫描到的位置, 请求分多次收到时不用从头扫描
+ * 1 Remembers the scan position, a request arriving in several segments is never rescanned
+ *
+ * 2 请求行/头部/包体都以(偏移, 长度)记录, 不拷贝数据, 需要时才生成string
+ * 2 Request line, headers and body are recorded as (offset, length) views into the buffer, strings are materialised on demand
+ *
+ * 3 常用头部(HEADER_ID)解析时直接记下位置, 获取时不用查找
+ * 3 Well-known headers (HEADER_ID) are indexed while parsing
+ *
+ * 4 每次调用parse时传入的数据必须从请求第一个字节开始, 已经解析过的部分不能变(数据可以搬移, 比如buffer合并)
+ * 4 Each parse() gets the data from the first byte of the request, already parsed bytes must not change (the memory may move)
+ */
+class UTIL_DLL_API TC_HttpRequestParser
+{
+public:
+	/**
+	 * @brief 常用头部
+	 * @brief Well-known headers
+	 */
+	enum HEADER_ID
+	{
+		HEADER_UNKNOWN = -1,
+		HEADER_HOST,
+		HEADER_CONTENT_LENGTH,
+		HEADER_CONTENT_TYPE,
+		HEADER_CONNECTION,
+		HEADER_TRANSFER_ENCODING,
+		HEADER_COOKIE,
+		HEADER_USER_AGENT,
+		HEADER_ACCEPT,
+		HEADER_ACCEPT_ENCODING,
+		HEADER_UPGRADE,
+		HEADER_COUNT,
+	};
+
+	/**
+	 * @brief 数据在buffer中的位置(相对请求第一个字节)
+	 * @brief Position of data in the buffer(relative to the first byte of the request)
+	 */
+	struct View
+	{
+		uint32_t offset = 0;
+		uint32_t length = 0;
+	};
+
+	/**
+	 * @brief 头部
+	 * @brief header
+	 */
+	struct Header
+	{
+		View name;
+		View value;
+		int  id = HEADER_UNKNOWN;
+	};
+
+	TC_HttpRequestParser() { reset(); }
+
+	/**
+	 * @brief 重置, 开始解析下一个请求
+	 * @brief Reset, ready for the next request
+	 */
+	void reset();
+
+	/**
+	 * @brief 解析(可以多次调用, 从上次停下的位置继续)
+	 * @brief Parse (may be called repeatedly, continues where it stopped)
+	 *
+	 * @param data 从请求第一个字节开始的数据
+	 * @param data data starting from the first byte of the request
+	 * @param len  数据长度
+	 * @param len  data length
+	 * @return PACKET_LESS: 不全, PACKET_FULL: 完整, PACKET_ERR: 不是http请求或者格式错误
+	 * @return PACKET_LESS: incomplete, PACKET_FULL: complete, PACKET_ERR: not http or malformed
+	 */
+	TC_NetWorkBuffer::PACKET_TYPE parse(const char *data, size_t len);
+
+	/**
+	 * @brief 已经扫描过的长度
+	 * @brief Length already scanned
+	 */
+	size_t scanned() const { return _scan; }
+
+	/**
+	 * @brief 是否解析完整
+	 * @brief Whether the request is complete
+	 */
+	bool isComplete() const { return _state == S_DONE; }
+
+	/**
+	 * @brief 头部是否收齐
+	 * @brief Whether the header is complete
+	 */
+	bool isHeadComplete() const { return _state > S_HEADER; }
+
+	/**
+	 * @brief 完整请求的长度(isComplete后有效), 后面可能是下一个请求
+	 * @brief Length of the complete request(valid after isComplete), the next request may follow
+	 */
+	size_t packetLength() const { return _packetLength; }
+
+	/**
+	 * @brief 头部长度(包括最后的空行)
+	 * @brief Head length(including the final empty line)
+	 */
+	size_t headLength() const { return _headLength; }
+
+	/**
+	 * @brief 请求类型, TC_HttpRequest::REQUEST_GET等
+	 * @brief Request type, TC_HttpRequest::REQUEST_GET etc
+	 */
+	int requestType() const { return _requestType; }
+
+	/**
+	 * @brief 请求行
+	 * @brief Request line
+	 */
+	const View &method() const { return _method; }
+	const View &url() const { return _url; }
+	const View &version() const { return _version; }
+
+	/**
+	 * @brief 所有头部(按出现顺序)
+	 * @brief All headers (in order)
+	 */
+	const vector<Header> &headers() const { return _headers; }
+
+	/**
+	 * @brief 常用头部(重复时是第一个), 没有返回NULL
+	 * @brief Well-known header(the first one if repeated), NULL if absent
+	 */
+	const Header *findHeader(HEADER_ID id) const { return (id >= 0 && id < HEADER_COUNT && _known[id]) ? &_headers[_known[id] - 1] : NULL; }
+
+	/**
+	 * @brief 按名字查找头部(不区分大小写), 没有返回NULL
+	 * @brief Find header by name(case insensitive), NULL if absent
+	 */
+	const Header *findHeader(const char *data, const char *name) const;
+
+	/**
+	 * @brief 获取头部的值
+	 * @brief Get header value
+	 */
+	string getHeader(const char *data, HEADER_ID id) const;
+	string getHeader(const char *data, const char *name) const;
+
+	/**
+	 * @brief 是否chunk编码
+	 * @brief Whether chunked
+	 */
+	bool isChunked() const { return _chunked; }
+
+	/**
+	 * @brief 包体长度(chunk时是所有chunk的总长度)
+	 * @brief Body length(sum of the chunks when chunked)
+	 */
+	size_t contentLength() const { return _contentLength; }
+
+	/**
+	 * @brief 包体, 不是chunk时只有一段
+	 * @brief Body pieces, only one piece when not chunked
+	 */
+	const vector<View> &content() const { return _content; }
+
+	/**
+	 * @brief 获取包体
+	 * @brief Get body
+	 */
+	void getContent(const char *data, string &content) const;
+
+	/**
+	 * @brief 生成string
+	 * @brief Materialise a view
+	 */
+	static string str(const char *data, const View &v) { return string(data + v.offset, v.length); }
+
+	/**
+	 * @brief 头部名字对应的HEADER_ID
+	 * @brief HEADER_ID of the header name
+	 */
+	static int headerId(const char *name, size_t len);
+
+protected:
+	enum STATE
+	{
+		S_LINE,
+		S_HEADER,
+		S_BODY,
+		S_CHUNK_SIZE,
+		S_CHUNK_DATA,
+		S_CHUNK_TRAILER,
+		S_DONE,
+	};
+
+	/**
+	 * 找到下一行, 返回'\n'的位置, 没有返回-1(记住扫描位置)
+	 */
+	int64_t nextLine(const char *data, size_t len);
+
+	bool parseLine(const char *data, size_t end);
+
+	bool parseHeader(const char *data, size_t end);
+
+protected:
+	STATE           _state;
+
+	//当前行的开始位置
+	size_t          _pos;
+
+	//已经扫描的位置
+	size_t          _scan;
+
+	int             _requestType;
+	View            _method;
+	View            _url;
+	View            _version;
+
+	vector<Header>  _headers;
+
+	//常用头部在_headers中的位置+1, 0表示没有
+	uint16_t        _known[HEADER_COUNT];
+
+	bool            _chunked;
+	size_t          _headLength;
+	size_t          _contentLength;
+	size_t          _chunkSize;
+	vector<View>    _content;
+	size_t          _packetLength;
+};
 
 }
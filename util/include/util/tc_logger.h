@@ -37,6 +37,8 @@
 #include <set>
 #include <chrono>
 #include <thread>
+#include <atomic>
+#include <memory>
 #include <stdlib.h>
 
 #if TARGET_PLATFORM_LINUX||TARGET_PLATFORM_IOS
@@ -148,6 +150,91 @@ namespace tars
 
 	class TC_LoggerThreadGroup;
 
+	//////////////////////////////////////////////////////////////////////////////
+	/**
+	 * @brief 线程私有的日志暂存队列.
+	 * @brief Thread private log staging ring.
+	 *
+	 * 单生产者(写日志的业务线程)单消费者(写日志线程)的环形队列, 记录预先分配好,
+	 * 短日志直接拷贝到记录中, 不分配内存也不加锁, 长日志保存在记录的string中
+	 * Single producer (business thread) single consumer (log thread) ring of preallocated records
+	 */
+	class UTIL_DLL_API TC_LoggerStage
+	{
+	public:
+		/**
+		 * 记录中可以直接保存的日志长度
+		 * Max length stored inline in a record
+		 */
+		enum { RECORD_SIZE = 240 };
+
+		/**
+		 * @brief 构造
+		 * @param count, 记录个数(向上取2的幂)
+		 */
+		TC_LoggerStage(size_t count);
+
+		/**
+		 * @brief 放入一条日志(只能在所属的业务线程中调用)
+		 * @return false: 队列满了
+		 */
+		bool push(size_t threadId, const char *data, size_t len);
+
+		/**
+		 * @brief 取出所有日志(只能在一个线程中调用)
+		 * @return 取出的条数
+		 */
+		size_t pop(deque<pair<size_t, string> > &ds);
+
+		/**
+		 * @brief 是否为空
+		 */
+		bool empty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+
+		/**
+		 * @brief 日志放到了公共队列, 记下当时的flush次数(只能在所属的业务线程中调用)
+		 * @param flushSeq, 放入公共队列以后读取的flush次数
+		 */
+		void setOverflow(size_t flushSeq) { _overflow = true; _overflowSeq = flushSeq; }
+
+		/**
+		 * @brief 放到公共队列的日志是否可能还没被取走(只能在所属的业务线程中调用)
+		 * 是的话后面的日志也要放到公共队列, 否则同一个线程的日志会乱序
+		 * 之后又完成了两次flush, 公共队列中这个线程的日志一定已经取走
+		 * @param flushSeq, 当前的flush次数
+		 */
+		bool isOverflow(size_t flushSeq)
+		{
+			if (_overflow && flushSeq - _overflowSeq >= 2)
+			{
+				_overflow = false;
+			}
+			return _overflow;
+		}
+
+	protected:
+		struct Record
+		{
+			size_t 	threadId = 0;
+			size_t 	len 	 = 0;
+			char 	data[RECORD_SIZE];
+			string 	large;
+		};
+
+		vector<Record> 		_records;
+		size_t 				_mask;
+
+		//生产者和消费者的位置分开在不同的cache line
+		char 				_pad1[64];
+		std::atomic<size_t> _head;
+		char 				_pad2[64];
+		std::atomic<size_t> _tail;
+
+		//以下只有所属的业务线程访问
+		bool 				_overflow = false;
+		size_t 				_overflowSeq = 0;
+	};
+
 	//////////////////////////////////////////////////////////////////////////////
 	/**
 	 * @brief 具体写日志基类
@@ -161,7 +248,7 @@ namespace tars
 		 * @brief 构造函数
 		 * @brief Constructor
 		 */
-		TC_LoggerRoll() : _pThreadGroup(NULL)
+		TC_LoggerRoll() : _pThreadGroup(NULL), _id(++_idGen)
 		{
 		}
 
@@ -198,12 +285,38 @@ namespace tars
 		 */
 		void write(const pair<size_t, string> &buffer);
 
+		/**
+		 * @brief 写到日志.
+		 * @brief Write to Log
+		 *
+		 * 开启暂存后, 异步写日志时先放到当前线程的暂存队列(满了再放到公共队列)
+		 * @param data, 日志内容
+		 * @param len, 日志长度
+		 */
+		void write(const char *data, size_t len);
+
 		/**
 		 * @brief 刷新缓存到文件
 		 * @brief Refresh Cache to File
 		 */
 		void flush();
 
+		/**
+		 * @brief 设置每个线程的暂存记录数(只在异步写日志时生效)
+		 * @brief Set per-thread staging records (only for asynchronous logging)
+		 *
+		 * 开启后每个写日志的线程有独立的暂存队列, 写日志不再竞争公共队列的锁, 短日志不再分配内存,
+		 * 写日志线程批量取出后再写文件. 每个线程占用约records*RECORD_SIZE的内存
+		 * @param records, 0表示关闭
+		 */
+		void setStage(size_t records) { _stageRecords = records; }
+
+		/**
+		 * @brief 是否开启了暂存
+		 * @brief Whether staging is enabled
+		 */
+		bool isStage() const { return _stageRecords > 0 && _pThreadGroup != NULL; }
+
 		/**
 		 * @brief 设置染色是否生效.
 		 * @brief Set whether the dye works.
@@ -266,6 +379,35 @@ namespace tars
 		 *
 		 */
 		static unordered_map<uint64_t, string> _mapThreadID;
+
+		/**
+		 * @brief 获取当前线程的暂存队列
+		 */
+		TC_LoggerStage *getStage();
+
+		/**
+		 * 唯一id(线程私有数据中用来区分roll对象)
+		 */
+		uint64_t _id;
+
+		static std::atomic<uint64_t> _idGen;
+
+		/**
+		 * 每个线程暂存的记录数
+		 */
+		size_t _stageRecords = 0;
+
+		/**
+		 * 所有线程的暂存队列, 取数据时也加这个锁, 保证只有一个消费者
+		 */
+		std::mutex _stageMutex;
+
+		vector<shared_ptr<TC_LoggerStage> > _stages;
+
+		/**
+		 * flush的次数(取完公共队列和暂存队列以后加1)
+		 */
+		std::atomic<size_t> _flushSeq{0};
 	};
 
 	typedef TC_AutoPtr<TC_LoggerRoll> TC_LoggerRollPtr;
@@ -491,6 +633,49 @@ namespace tars
 		std::streamsize _buffer_len;
 	};
 
+	/**
+	 * @brief 一行日志的格式化缓冲, 短日志用内部数组, 不分配内存
+	 * @brief Format buffer of one log line, short lines use the inline array
+	 */
+	class LoggerLineBuffer : public std::basic_streambuf<char>
+	{
+	public:
+		LoggerLineBuffer()
+		{
+			setp(_data, _data + sizeof(_data));
+		}
+
+		const char *data() const { return pbase(); }
+
+		size_t size() const { return pptr() - pbase(); }
+
+	protected:
+		virtual int_type overflow(int_type c)
+		{
+			size_t len = size();
+
+			if (pbase() == _data)
+			{
+				_large.assign(_data, len);
+			}
+
+			_large.resize(len * 2);
+
+			setp(&_large[0], &_large[0] + _large.size());
+			pbump((int)len);
+
+			if (traits_type::eq_int_type(c, traits_type::eof()))
+			{
+				return traits_type::not_eof(c);
+			}
+
+			return sputc(traits_type::to_char_type(c));
+		}
+
+		char 	_data[256];
+		string 	_large;
+	};
+
 	/**
 	 * @brief 临时类, 析够的时候写日志
 	 * @brief Temporary class, log when enough analysis
@@ -504,8 +689,9 @@ namespace tars
 		 *
 		 * @param stream
 		 * @param mutex
+		 * @param roll, 不为NULL时(开启了暂存)直接写到roll, 不经过公共的输出流, 不加锁
 		 */
-		LoggerStream(const char *header, ostream *stream, ostream *estream, TC_ThreadMutex &mutex) : _stream(stream), _estream(estream), _mutex(mutex)
+		LoggerStream(const char *header, ostream *stream, ostream *estream, TC_ThreadMutex &mutex, TC_LoggerRoll *roll = NULL) : _buffer(&_lineBuffer), _stream(stream), _estream(estream), _mutex(mutex), _roll(roll)
 		{
 			if (stream)
 			{
@@ -521,9 +707,15 @@ namespace tars
 		{
 			if (_stream)
 			{
+				if (_roll)
+				{
+					_roll->write(_lineBuffer.data(), _lineBuffer.size());
+					return;
+				}
+
 				TC_LockT<TC_ThreadMutex> lock(_mutex);
 				_stream->clear();
-				(*_stream) << _buffer.str();
+				_stream->write(_lineBuffer.data(), _lineBuffer.size());
 				_stream->flush();
 			}
 		}
@@ -606,11 +798,17 @@ namespace tars
 		LoggerStream &operator=(const LoggerStream &lt);
 
 	protected:
+		/**
+		* 格式化缓冲
+		* Format buffer
+		*/
+		LoggerLineBuffer _lineBuffer;
+
 		/**
 		* 缓冲区
 		* Buffer
 		*/
-		std::stringstream _buffer;
+		std::ostream _buffer;
 
 		/**
 		 * 输出流
@@ -629,6 +827,11 @@ namespace tars
 		 */
 //		TC_SpinLock &_mutex;
 		TC_ThreadMutex &_mutex;
+
+		/**
+		 * 开启暂存时直接写的roll
+		 */
+		TC_LoggerRoll *_roll;
 	};
 
 	/**
@@ -923,13 +1126,11 @@ namespace tars
 			if (hasFlag(TC_Logger::HAS_MTIME))
 			{
 				// auto time_now = chrono::system_clock::now();
-				time_t t = TNOW;//std::chrono::system_clock::to_time_t(time_now);
-
 				auto duration_in_ms = TNOWMS; //chrono::duration_cast<chrono::milliseconds>(time_now.time_since_epoch());
 
-				tm tt;
+				time_t t = (time_t)(duration_in_ms / 1000);//std::chrono::system_clock::to_time_t(time_now);
 
-				TC_Port::localtime_r(&t, &tt);
+				const tm &tt = localtime(t);
 
 				const char *szFormat = (_bHasSquareBracket) ? ("[%04d-%02d-%02d %02d:%02d:%02d.%03d]%s") : ("%04d-%02d-%02d %02d:%02d:%02d.%03d%s");
 				n += snprintf(c + n, len - n, szFormat,
@@ -939,8 +1140,7 @@ namespace tars
 			{
 				time_t t = TNOW;//std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
 
-				tm tt;
-				TC_Port::localtime_r(&t, &tt);
+				const tm &tt = localtime(t);
 // #if TARGET_PLATFORM_LINUX||TARGET_PLATFORM_IOS
 // 				localtime_r(&t, &tt);
 // #else
@@ -971,6 +1171,24 @@ namespace tars
 			}
 		}
 
+		/**
+		 * @brief 线程内缓存同一秒的localtime结果(localtime_r内部有全局锁)
+		 * @brief Per-thread cache of localtime for the same second
+		 */
+		static const tm &localtime(time_t t)
+		{
+			static thread_local time_t lastTime = -1;
+			static thread_local tm lastTm;
+
+			if (t != lastTime)
+			{
+				TC_Port::localtime_r(&t, &lastTm);
+				lastTime = t;
+			}
+
+			return lastTm;
+		}
+
 		LoggerStream stream(int level)
 		{
 			ostream *ost = NULL;
@@ -982,7 +1200,7 @@ namespace tars
 
 				ost = &_stream;
 
-				return LoggerStream(c, ost, &_estream, _spinMutex);
+				return LoggerStream(c, ost, &_estream, _spinMutex, this->_roll->isStage() ? this->_roll.get() : NULL);
 			}
 
 			return LoggerStream(NULL, ost, &_estream, _spinMutex);
@@ -1192,6 +1410,12 @@ namespace tars
 		 */
 		void flush() { _roll->flush(); }
 
+		/**
+		 * @brief 设置每个线程的暂存记录数, 0关闭(见TC_LoggerRoll::setStage)
+		 * @brief Set per-thread staging records, 0 to disable
+		 */
+		void setStage(size_t records) { _roll->setStage(records); }
+
 	protected:
 		/**
 		 * @brief 具体写日志操作类
@@ -557,8 +557,10 @@ public:
      * @param pAddr 已经是空间被扩展之后的地址
      * @param pAddr Address already after space has been expanded
      * @param iSize
+     * @param iReserve 扩展部分开头保留给调用者使用的字节数, 不参与分配
+     * @param iReserve Bytes at the beginning of the expanded part kept for the caller, not used for allocation
      */
-    void append(void *pAddr, size_t iSize);
+    void append(void *pAddr, size_t iSize, size_t iReserve = 0);
 
     /**
      * @brief 获取每个block的大小, 包括后续增加的内存块的大小
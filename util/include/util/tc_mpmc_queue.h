@@ -0,0 +1,590 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <cassert>
+#include <condition_variable>
+#include <functional>
+#include "util/tc_platform.h"
+
+using namespace std;
+
+namespace tars
+{
+/////////////////////////////////////////////////
+/**
+ * @file tc_mpmc_queue.h
+ * @brief 有界无锁多生产者多消费者队列(环形数组).
+ *
+ * 说明:
+ * - 容量固定(向上取整到2的幂), 每个槽位有一个序号, 生产者/消费者通过CAS抢占位置, 入队出队都不加锁
+ * - 支持批量入队/出队, 批量时一次CAS抢占多个连续槽位
+ * - 等待数据时先自旋, 再yield, 最后才在条件变量上休眠; 自旋次数会根据最近是否自旋成功自适应调整
+ * - 只有存在休眠的消费者时, 生产者才会加锁唤醒, 高负载下基本没有futex调用
+ * - 队列满时push_back会自旋等待(背压), 不满时不会阻塞, 可以用try_push自己处理满的情况
+ * - 消费者不在队列上等待时(比如在协程调度器中), 需要通过setFullFunctor在队列满时唤醒消费者
+ * - 接口和TC_ThreadQueue保持一致, 可以直接替换
+ */
+
+/////////////////////////////////////////////////
+/**
+ * @brief 有界无锁多生产者多消费者队列
+ */
+template<typename T>
+class TC_MPMCQueue
+{
+public:
+    /**
+     * 队列满时的回调
+     */
+    typedef std::function<void()> full_functor;
+
+    /**
+     * @brief 构造
+     * @param capacity, 队列容量, 向上取整到2的幂
+     */
+    explicit TC_MPMCQueue(size_t capacity = 64 * 1024);
+
+    ~TC_MPMCQueue();
+
+    typedef deque<T> queue_type;
+
+    /**
+     * @brief 放数据到队列后端, 队列满了返回false
+     * @param t
+     * @return bool
+     */
+    bool try_push(const T& t);
+
+    /**
+     * @brief 从头部获取数据, 没有数据返回false
+     * @param t
+     * @return bool
+     */
+    bool try_pop(T& t);
+
+    /**
+     * @brief 放数据到队列后端, 队列满了则自旋等待.
+     * @param t
+     * @param notify, 是否唤醒休眠的消费者
+     */
+    void push_back(const T& t, bool notify = true);
+
+    /**
+     * @brief 批量放数据到队列后端(一次抢占多个槽位), 队列满了则自旋等待.
+     * @param qt
+     * @param notify, 是否唤醒休眠的消费者
+     */
+    template<typename D>
+    void push_back(const D& qt, bool notify = true);
+
+    /**
+     * @brief 从头部获取数据, 没有数据则等待.
+     * @param t
+     * @param millsecond(wait = true时才生效)  阻塞等待时间(ms), 0 表示不阻塞, -1 永久等待
+     * @param wait, 是否等待
+     * @return bool: true, 获取了数据, false, 无数据
+     */
+    bool pop_front(T& t, size_t millsecond = 0, bool wait = true);
+
+    /**
+     * @brief 批量从头部获取数据(不阻塞)
+     * @param vt, 输出(追加)
+     * @param max, 最多获取的个数
+     * @return size_t, 获取的个数
+     */
+    size_t pop_front(vector<T>& vt, size_t max);
+
+    /**
+     * @brief 唤醒所有等待在队列上的线程
+     */
+    void notifyT();
+
+    /**
+     * @brief 设置队列满时的回调, 生产者等待空间时会周期性调用, 用于唤醒不在队列上等待的消费者
+     * 必须在使用队列之前设置
+     * @param f
+     */
+    void setFullFunctor(const full_functor &f) { _fullFunctor = f; }
+
+    /**
+     * @brief 无数据则等待(先自旋, 再休眠).
+     * @return bool 非空返回true，超时或者被notifyT唤醒返回false
+     */
+    bool wait(size_t millsecond);
+
+    /**
+     * @brief 队列大小(并发时是近似值)
+     */
+    size_t size() const;
+
+    /**
+     * @brief 是否为空(并发时是近似值)
+     */
+    bool empty() const { return size() == 0; }
+
+    /**
+     * @brief 容量
+     */
+    size_t capacity() const { return _mask + 1; }
+
+protected:
+    TC_MPMCQueue(const TC_MPMCQueue&) = delete;
+    TC_MPMCQueue& operator=(const TC_MPMCQueue&) = delete;
+
+    /**
+     * 批量抢占最多n个可以写入的连续槽位, 返回抢占的个数, pos为起始位置
+     */
+    size_t claimPush(size_t n, size_t &pos);
+
+    /**
+     * 批量抢占最多n个可以读取的连续槽位, 返回抢占的个数, pos为起始位置
+     */
+    size_t claimPop(size_t n, size_t &pos);
+
+    /**
+     * 写入到已经抢占的槽位
+     */
+    void publish(size_t pos, const T& t);
+
+    /**
+     * 从已经抢占的槽位中取出
+     */
+    void consume(size_t pos, T& t);
+
+    /**
+     * 有消费者在休眠时唤醒
+     */
+    void wakeup(bool all);
+
+    /**
+     * 自旋等待队列有空间
+     * @param published, 本次调用是否已经放入了部分数据(需要先唤醒消费者)
+     */
+    void backoff(size_t &count, bool published);
+
+protected:
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    static const size_t CACHE_LINE = 64;
+
+    //自旋次数的范围
+    static const size_t MIN_SPIN = 16;
+    static const size_t MAX_SPIN = 4096;
+
+    Cell *              _cells;
+
+    size_t              _mask;
+
+    //生产者和消费者的位置放在不同的cache line上, 避免伪共享
+    char                _pad0[CACHE_LINE];
+    std::atomic<size_t> _enqueuePos{0};
+    char                _pad1[CACHE_LINE];
+    std::atomic<size_t> _dequeuePos{0};
+    char                _pad2[CACHE_LINE];
+
+    //当前自旋次数
+    std::atomic<size_t> _spin{MIN_SPIN * 4};
+
+    //休眠的消费者个数
+    std::atomic<int>    _sleepers{0};
+
+    //notifyT计数, 判断是否被唤醒过
+    std::atomic<size_t> _lockId{0};
+
+    std::mutex          _mutex;
+
+    std::condition_variable _cond;
+
+    full_functor        _fullFunctor;
+};
+
+template<typename T> TC_MPMCQueue<T>::TC_MPMCQueue(size_t capacity)
+{
+    size_t n = 2;
+    while (n < capacity)
+    {
+        n <<= 1;
+    }
+
+    _mask = n - 1;
+    _cells = new Cell[n];
+
+    for (size_t i = 0; i < n; i++)
+    {
+        _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+template<typename T> TC_MPMCQueue<T>::~TC_MPMCQueue()
+{
+    T t;
+    while (try_pop(t))
+    {
+    }
+
+    delete[] _cells;
+}
+
+template<typename T> size_t TC_MPMCQueue<T>::claimPush(size_t n, size_t &pos)
+{
+    pos = _enqueuePos.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        size_t k = 0;
+        for (; k < n; k++)
+        {
+            size_t seq = _cells[(pos + k) & _mask].seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + k);
+            if (diff != 0)
+            {
+                if (k == 0 && diff > 0)
+                {
+                    //其他生产者已经抢占了, 重新读取位置
+                    k = (size_t)-1;
+                }
+                break;
+            }
+        }
+
+        if (k == (size_t)-1)
+        {
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+            continue;
+        }
+
+        if (k == 0)
+        {
+            //满了
+            return 0;
+        }
+
+        if (_enqueuePos.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed))
+        {
+            return k;
+        }
+    }
+}
+
+template<typename T> size_t TC_MPMCQueue<T>::claimPop(size_t n, size_t &pos)
+{
+    pos = _dequeuePos.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        size_t k = 0;
+        for (; k < n; k++)
+        {
+            size_t seq = _cells[(pos + k) & _mask].seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + k + 1);
+            if (diff != 0)
+            {
+                if (k == 0 && diff > 0)
+                {
+                    //其他消费者已经抢占了, 重新读取位置
+                    k = (size_t)-1;
+                }
+                break;
+            }
+        }
+
+        if (k == (size_t)-1)
+        {
+            pos = _dequeuePos.load(std::memory_order_relaxed);
+            continue;
+        }
+
+        if (k == 0)
+        {
+            //空了
+            return 0;
+        }
+
+        if (_dequeuePos.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed))
+        {
+            return k;
+        }
+    }
+}
+
+template<typename T> void TC_MPMCQueue<T>::publish(size_t pos, const T& t)
+{
+    Cell &cell = _cells[pos & _mask];
+
+    new (&cell.storage) T(t);
+
+    cell.seq.store(pos + 1, std::memory_order_release);
+}
+
+template<typename T> void TC_MPMCQueue<T>::consume(size_t pos, T& t)
+{
+    Cell &cell = _cells[pos & _mask];
+
+    T *p = reinterpret_cast<T*>(&cell.storage);
+
+    t = std::move(*p);
+    p->~T();
+
+    cell.seq.store(pos + _mask + 1, std::memory_order_release);
+}
+
+template<typename T> void TC_MPMCQueue<T>::wakeup(bool all)
+{
+    //和wait中的_sleepers++配对, 保证要么生产者看到休眠者, 要么消费者看到数据
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (_sleepers.load(std::memory_order_relaxed) > 0)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (all)
+        {
+            _cond.notify_all();
+        }
+        else
+        {
+            _cond.notify_one();
+        }
+    }
+}
+
+template<typename T> void TC_MPMCQueue<T>::backoff(size_t &count, bool published)
+{
+    if (published)
+    {
+        wakeup(true);
+    }
+
+    if (_fullFunctor && count % MIN_SPIN == 0)
+    {
+        _fullFunctor();
+    }
+
+    if (++count < MIN_SPIN)
+    {
+        return;
+    }
+
+    if (count < MAX_SPIN)
+    {
+        std::this_thread::yield();
+    }
+    else
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+template<typename T> bool TC_MPMCQueue<T>::try_push(const T& t)
+{
+    size_t pos;
+    if (claimPush(1, pos) == 0)
+    {
+        return false;
+    }
+
+    publish(pos, t);
+
+    return true;
+}
+
+template<typename T> bool TC_MPMCQueue<T>::try_pop(T& t)
+{
+    size_t pos;
+    if (claimPop(1, pos) == 0)
+    {
+        return false;
+    }
+
+    consume(pos, t);
+
+    return true;
+}
+
+template<typename T> void TC_MPMCQueue<T>::push_back(const T& t, bool notify)
+{
+    size_t count = 0;
+    while (!try_push(t))
+    {
+        backoff(count, false);
+    }
+
+    if (notify)
+    {
+        wakeup(false);
+    }
+}
+
+template<typename T> template<typename D> void TC_MPMCQueue<T>::push_back(const D& qt, bool notify)
+{
+    auto it = qt.begin();
+    size_t left = qt.size();
+    size_t count = 0;
+
+    while (left > 0)
+    {
+        size_t pos;
+        size_t k = claimPush(left, pos);
+
+        if (k == 0)
+        {
+            //已经放入的数据需要先唤醒消费者取走, 否则可能一直等不到空间
+            backoff(count, left < qt.size());
+            continue;
+        }
+
+        for (size_t i = 0; i < k; i++, ++it)
+        {
+            publish(pos + i, *it);
+        }
+
+        left -= k;
+    }
+
+    if (notify)
+    {
+        wakeup(qt.size() > 1);
+    }
+}
+
+template<typename T> bool TC_MPMCQueue<T>::pop_front(T& t, size_t millsecond, bool wait)
+{
+    if (try_pop(t))
+    {
+        return true;
+    }
+
+    if (!wait || millsecond == 0)
+    {
+        return false;
+    }
+
+    size_t lockId = _lockId.load(std::memory_order_acquire);
+
+    while (this->wait(millsecond))
+    {
+        if (try_pop(t))
+        {
+            return true;
+        }
+
+        //被其他消费者抢走了
+        if (lockId != _lockId.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+template<typename T> size_t TC_MPMCQueue<T>::pop_front(vector<T>& vt, size_t max)
+{
+    size_t pos;
+    size_t k = claimPop(max, pos);
+
+    for (size_t i = 0; i < k; i++)
+    {
+        vt.emplace_back();
+        consume(pos + i, vt.back());
+    }
+
+    return k;
+}
+
+template<typename T> void TC_MPMCQueue<T>::notifyT()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_lockId;
+    _cond.notify_all();
+}
+
+template<typename T> bool TC_MPMCQueue<T>::wait(size_t millsecond)
+{
+    if (!empty())
+    {
+        return true;
+    }
+
+    if (millsecond == 0)
+    {
+        return false;
+    }
+
+    size_t lockId = _lockId.load(std::memory_order_acquire);
+
+    //先自旋等待, 自旋成功则下次多自旋一些, 否则减少自旋
+    size_t spin = _spin.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < spin; i++)
+    {
+        if (!empty())
+        {
+            _spin.store((std::min)(spin * 2, (size_t)MAX_SPIN), std::memory_order_relaxed);
+            return true;
+        }
+
+        if (i >= MIN_SPIN)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    _spin.store((std::max)(spin / 2, (size_t)MIN_SPIN), std::memory_order_relaxed);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    ++_sleepers;
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    auto pred = [&] { return !empty() || lockId != _lockId.load(std::memory_order_relaxed); };
+
+    bool ret;
+    if (millsecond == (size_t)-1)
+    {
+        _cond.wait(lock, pred);
+        ret = true;
+    }
+    else
+    {
+        ret = _cond.wait_for(lock, std::chrono::milliseconds(millsecond), pred);
+    }
+
+    --_sleepers;
+
+    return ret && !empty();
+}
+
+template<typename T> size_t TC_MPMCQueue<T>::size() const
+{
+    size_t dequeuePos = _dequeuePos.load(std::memory_order_acquire);
+    size_t enqueuePos = _enqueuePos.load(std::memory_order_acquire);
+
+    return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+}
+
+}
+
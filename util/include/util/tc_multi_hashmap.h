@@ -2455,6 +2455,14 @@ public:
      */
     int get(const string &mk, vector<Value> &vs);
 
+    /**
+     * @brief 预取一批联合主键的hash桶以及桶上第一个block的头部, 批量get前调用, 减少逐个访问时的cache miss
+     * @brief Prefetch hash buckets of a batch of joint keys and the head of their first block, called before batch get to reduce cache misses
+     * @param vKey, 主key和除主key外的联合主键
+     * @param vKey, main key and the joint key except main key
+     */
+    void prefetch(const vector<pair<string, string> > &vKey);
+
     /**
      * @brief 获取主key hash下的所有数据 
      *        , 不修改GET时间链，主要用于迁移
@@ -20,6 +20,7 @@
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <atomic>
 #include "util/tc_platform.h"
 #include "util/tc_socket.h"
 
@@ -51,6 +52,8 @@
 namespace tars
 {
 
+class TC_HttpRequestParser;
+
 /**
 * @brief
 */
@@ -82,6 +85,14 @@ public:
 	 */
 	typedef std::function<PACKET_TYPE(TC_NetWorkBuffer &, vector<char> &)> protocol_functor;
 
+	class Slice;
+
+	/**
+	 * 定义协议解析器接口(解析结果是指向接收buffer的Slice, 不copy数据)
+	 * Define Protocol Resolver Interface (the result is a Slice onto the receive buffer, no copy)
+	 */
+	typedef std::function<PACKET_TYPE(TC_NetWorkBuffer &, Slice &)> slice_protocol_functor;
+
 	/**
 	   * buffer
 	   */
@@ -300,7 +311,15 @@ public:
 			_writeIdx += len;
 		}
 
+		/**
+		 * 是否有Slice引用了该buffer中的数据, 有引用时不能整理/复用buffer空间
+		 * Whether any Slice refers to the data, if so the buffer must not be compacted or reused
+		 * @return
+		 */
+		inline bool sliced() const { return _slices > 0; }
+
 		friend class TC_NetWorkBuffer;
+		friend class Slice;
 	protected:
 		/**
 		 * buffer pointer, 内存空间:[0, _capacity), 实际数据: [_readIdx, _writeIdx)
@@ -321,6 +340,89 @@ public:
 		 * 总内存空间
 		 */
 		size_t			_capacity 	= 1024*8;
+
+		/**
+		 * 引用该buffer的Slice个数
+		 */
+		std::atomic<int> _slices{0};
+	};
+
+	/**
+	 * 对Buffer中一段数据的引用(不copy数据), 可以跨线程传递
+	 * 持有Slice期间, 对应的Buffer不会被释放, 也不会被TC_NetWorkBuffer整理或复用
+	 * A refcounted view onto the data of a Buffer (no copy), it can be passed across threads,
+	 * the Buffer is neither released nor compacted/reused by TC_NetWorkBuffer while any Slice holds it
+	 */
+	class UTIL_DLL_API Slice
+	{
+	public:
+		Slice() {}
+
+		/**
+		 * 构造
+		 * @param buff, 数据所在的buffer
+		 * @param data, 数据起始地址(必须在buff内)
+		 * @param length, 数据长度
+		 */
+		Slice(const shared_ptr<Buffer> &buff, const char *data, size_t length);
+
+		/**
+		 * 数据首地址
+		 * @return
+		 */
+		inline const char *data() const { return _data; }
+
+		/**
+		 * 数据长度
+		 * @return
+		 */
+		inline size_t size() const { return _length; }
+
+		/**
+		 * 是否为空
+		 * @return
+		 */
+		inline bool empty() const { return _length == 0; }
+
+		/**
+		 * 子Slice, 和当前Slice共享同一个Buffer
+		 * @param offset
+		 * @param length
+		 * @return
+		 */
+		Slice sub(size_t offset, size_t length) const;
+
+		/**
+		 * copy数据到vector
+		 * @param v
+		 */
+		void toVector(vector<char> &v) const { v.assign(_data, _data + _length); }
+
+		/**
+		 * copy数据到string
+		 * @return
+		 */
+		string toString() const { return string(_data, _length); }
+
+		/**
+		 * 释放引用
+		 */
+		void clear();
+
+	protected:
+		struct Holder
+		{
+			Holder(const shared_ptr<Buffer> &buff) : _buff(buff) { ++_buff->_slices; }
+			~Holder() { --_buff->_slices; }
+
+			shared_ptr<Buffer> _buff;
+		};
+
+		shared_ptr<Holder>	_holder;
+
+		const char *		_data 	= NULL;
+
+		size_t 				_length = 0;
 	};
 
 
@@ -585,6 +687,13 @@ public:
 	 */
 	void *getContextData() { return _contextData; }
 
+	/**
+	 * 取走parseHttp最后解析出的完整请求的解析结果(头部/包体在请求中的位置), 没有返回NULL
+	 * Take the parser result of the last request completed by parseHttp(positions of headers/body in the request), NULL if none
+	 * @return
+	 */
+	std::shared_ptr<TC_HttpRequestParser> takeHttpParser() { return std::move(_httpParser); }
+
 	/**
 	 * 增加buffer
 	 * Add buffer
@@ -747,6 +856,15 @@ public:
 	 */
 	pair<const char*, size_t> getBufferPointer() const;
 
+	/**
+	 * 获取前count块有效数据buffer的指针, 可以用来聚合发送(writev)
+	 * Get pointers of the first count valid data buffers, can be used for gather send (writev)
+	 * @param vec, 输出
+	 * @param count, vec的大小
+	 * @return 实际获取的块数
+	 */
+	size_t getBufferPointers(pair<const char*, size_t> *vec, size_t count) const;
+
 	/**
 	 * 将链表上的所有buffer拼接起来
 	 * Stitch together all buffers on the list
@@ -822,6 +940,17 @@ public:
 		return buffer;
 	}
 
+	/**
+	 * 获取前len字节的Slice(注意: 不往后移动)
+	 * 数据在第一个buffer中时不copy数据, 否则会合并成一个新的buffer
+	 * Get a Slice of the first len bytes (Note: Do not move backwards),
+	 * no copy if the data is in the first buffer, otherwise it is merged into a new buffer
+	 * @param len
+	 * @param slice
+	 * @return false: 数据不够
+	 */
+	bool getSlice(size_t len, Slice &slice);
+
 	/**
 	 * 往后移动len个字节
 	 * Move len bytes backward
@@ -898,6 +1027,16 @@ public:
 	 */
 	PACKET_TYPE parseBufferOf4(vector<char> &buffer, uint32_t minLength, uint32_t maxLength);
 
+	/**
+	 * 同parseBufferOf4, 包体以Slice方式返回, 不copy数据
+	 * Same as parseBufferOf4, the package body is returned as a Slice without copy
+	 * @param slice
+	 * @param minLength
+	 * @param maxLength
+	 * @return PACKET_TYPE
+	 */
+	PACKET_TYPE parseBufferOf4(Slice &slice, uint32_t minLength, uint32_t maxLength);
+
 	/**
 	 * 解析二进制包, 1字节长度+包体(iMinLength<包长<iMaxLength, 否则返回PACKET_ERR)
 	 * Parse binary package, 1 byte length + package (iMinLength<package length<iMaxLength, otherwise return PACKET_ERR)
@@ -943,6 +1082,19 @@ public:
 		return in.parseBufferOf4(out, iMinLength, iMaxLength);
 	}
 
+	/**
+	 * 同parseBinary4, 包体以Slice方式返回(不copy数据), 用于slice_protocol_functor
+	 * Same as parseBinary4, the package body is returned as a Slice (no copy), for slice_protocol_functor
+	 * @param in
+	 * @param out
+	 * @return
+	 */
+	template<uint32_t iMinLength, uint32_t iMaxLength>
+	static TC_NetWorkBuffer::PACKET_TYPE parseBinary4Slice(TC_NetWorkBuffer&in, Slice &out)
+	{
+		return in.parseBufferOf4(out, iMinLength, iMaxLength);
+	}
+
 	/**
 	 * http1
 	 * @param in
@@ -1021,6 +1173,47 @@ protected:
 		return PACKET_FULL;
 	}
 
+	template<typename T>
+	TC_NetWorkBuffer::PACKET_TYPE parseBuffer(Slice &slice, T minLength, T maxLength)
+	{
+		if(getBufferLength() < sizeof(T))
+		{
+			return PACKET_LESS;
+		}
+
+		if(minLength < sizeof(T))
+			minLength = sizeof(T);
+
+		T length = getValue<T>();
+
+		if(length < minLength || length > maxLength)
+		{
+			return PACKET_ERR;
+		}
+
+		if(getBufferLength() < length)
+		{
+			reserveContinuous(length);
+			return PACKET_LESS;
+		}
+
+		moveHeader(sizeof(T));
+
+		if(!getSlice(length - sizeof(T), slice))
+		{
+			return PACKET_LESS;
+		}
+
+		moveHeader(length - sizeof(T));
+		return PACKET_FULL;
+	}
+
+	/**
+	 * 包还没收全时, 让后续数据尽量收到同一个buffer中, 以便整包可以直接Slice
+	 * @param length, 整包长度
+	 */
+	void reserveContinuous(size_t length);
+
 protected:
 	/**
 	 * 连接信息(不同的类里面不一样)
@@ -1038,6 +1231,12 @@ protected:
 	 */
 	std::function<void(TC_NetWorkBuffer*)> _deconstruct;
 
+	/**
+	 * parseHttp解析出的完整请求
+	 * parser result of the request completed by parseHttp
+	 */
+	std::shared_ptr<TC_HttpRequestParser> _httpParser;
+
 	/**
 	 * buffer list
 	 */
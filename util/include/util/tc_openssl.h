@@ -66,6 +66,10 @@ public:
     {
 	    CTX(SSL_CTX *x) : ctx(x) {}
 	    SSL_CTX *ctx = nullptr;
+	    /**
+	     * 握手完成后是否尝试开启内核TLS(kTLS)
+	     */
+	    bool ktls = false;
 		virtual ~CTX();
     };
 
@@ -75,9 +79,10 @@ public:
      * @param certfile
      * @param keyfile
      * @param verifyClient
+     * @param ktls, 握手完成后尝试把会话密钥交给内核(kTLS), 内核不支持时自动回退
      * @return
      */
-	static shared_ptr<CTX> newCtx(const std::string& cafile, const std::string& certfile, const std::string& keyfile, bool verifyClient, const string &ciphers);
+	static shared_ptr<CTX> newCtx(const std::string& cafile, const std::string& certfile, const std::string& keyfile, bool verifyClient, const string &ciphers, bool ktls = false);
 
 	/**
 	 * new ssl
@@ -89,6 +94,11 @@ public:
 	static void getMemData(BIO* bio, TC_NetWorkBuffer& buf);
 	static int doSSLRead(SSL* ssl, TC_NetWorkBuffer& out);
 
+	/**
+	 * TLS1.3的流量密钥只能通过keylog回调拿到(开启kTLS时设置)
+	 */
+	static void keylogCallback(const SSL* ssl, const char* line);
+
 protected:
    /**
     * @brief deny
@@ -166,6 +176,34 @@ public:
 	 */
 	void setWriteBufferSize(size_t size);
 
+	/**
+	 * @brief 握手完成后开启内核TLS(kTLS)
+	 * 把会话密钥通过setsockopt(TLS_TX/TLS_RX)交给内核, 之后发送的数据由内核加密, 收到的数据由内核解密,
+	 * 收发直接走普通的send/recv, 不再经过openssl的内存BIO
+	 * 只支持TLS1.2/TLS1.3的AES-GCM, 内核没有tls模块或者算法不支持时返回false, 继续走openssl
+	 * @param fd, socket句柄
+	 * @param tx, 是否开启发送方向(发送缓存中还有没发出去的密文时不能开启)
+	 * @return 至少一个方向开启成功返回true
+	 */
+	bool enableKtls(int fd, bool tx = true);
+
+	/**
+	 * @brief 发送方向是否已经交给内核
+	 */
+	bool isKtlsTx() const { return _ktlsTx; }
+
+	/**
+	 * @brief 接收方向是否已经交给内核
+	 */
+	bool isKtlsRx() const { return _ktlsRx; }
+
+	/**
+	 * @brief 开启kTLS接收后读取数据
+	 * 内核只把应用数据交给上层, 握手消息(比如session ticket)直接丢弃, 收到告警当作对端关闭
+	 * @return >0: 数据长度, 0: 对端关闭, <0: 错误(errno)
+	 */
+	int recvKtls(int fd, void* buf, uint32_t len, int flag);
+
 	friend class TC_SSLManager;
 private:
 
@@ -194,6 +232,29 @@ private:
      */
     TC_NetWorkBuffer _plainBuf;
 
+	/**
+	 * 握手完成后尝试开启kTLS
+	 */
+	bool _ktls;
+
+	/**
+	 * kTLS是否已开启
+	 */
+	bool _ktlsTx;
+	bool _ktlsRx;
+
+	/**
+	 * 握手完成时内存BIO里紧跟着的记录数(已经由openssl解密, 接收序号要跳过)
+	 * 最后一个记录不完整时不能开启接收方向
+	 */
+	uint64_t _ktlsRxRecords;
+	bool _ktlsRxAligned;
+
+	/**
+	 * TLS1.3的流量密钥
+	 */
+	string _clientSecret;
+	string _serverSecret;
 };
 #else
 //未开启openssl得时候，定义一个空得对象保留指针占位符
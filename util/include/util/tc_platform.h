@@ -88,3 +88,9 @@
 #define SVT_DLL_API 
 #endif
 
+//预取内存到cache, 只是提示, 不支持的编译器为空
+#if defined(__GNUC__) || defined(__clang__)
+#define TC_PREFETCH(p) __builtin_prefetch((const void*)(p))
+#else
+#define TC_PREFETCH(p)
+#endif
@@ -25,6 +25,7 @@
 #include "util/tc_autoptr.h"
 #include "util/tc_monitor.h"
 #include "util/tc_timeprovider.h"
+#include "util/tc_timing_wheel.h"
 
 using namespace std;
 
@@ -34,7 +35,7 @@ namespace tars
 /**
  * @file tc_timeout_queue_new.h
  * @brief 超时队列, 没有锁, 非线程安全.
- *
+ * 超时时间用时间轮(TC_TimingWheel)管理, 插入/删除/超时都是O(1)
  */
 /////////////////////////////////////////////////
 
@@ -44,11 +45,10 @@ class TC_TimeoutQueueNew
 public:
 
     struct PtrInfo;
-    struct NodeInfo;
     struct SendInfo;
 
     typedef unordered_map<uint32_t, PtrInfo>     data_type;
-    typedef multimap<int64_t,NodeInfo>      time_type;
+    typedef TC_TimingWheel<uint32_t>        time_type;
     typedef list<SendInfo>                  send_type;
 
     typedef std::function<void(T&)> data_functor;
@@ -57,15 +57,10 @@ public:
     {
         T ptr;
         bool hasSend;
-        typename time_type::iterator timeIter;
+        uint64_t timeId;
         typename send_type::iterator sendIter;
     };
 
-    struct NodeInfo
-    {
-        typename data_type::iterator dataIter;
-    };
-
     struct SendInfo
     {
         typename data_type::iterator dataIter;
@@ -99,6 +94,12 @@ public:
      */
     bool getSend(T & t);
 
+    /**
+     * 获取所有要发送的数据, 顺序和依次getSend/popSend一致
+     * @return 获取到的个数
+     */
+    size_t getSends(vector<T> & vt);
+
     /**
      * 把已经发送的数据从list里面删除
      */
@@ -184,6 +185,17 @@ template<typename T> bool TC_TimeoutQueueNew<T>::getSend(T & t)
 }
 
 
+template<typename T> size_t TC_TimeoutQueueNew<T>::getSends(vector<T> & vt)
+{
+    vt.reserve(vt.size() + _send.size());
+    for(auto it = _send.rbegin(); it != _send.rend(); ++it)
+    {
+        assert(!it->dataIter->second.hasSend);
+        vt.push_back(it->dataIter->second.ptr);
+    }
+    return _send.size();
+}
+
 template<typename T> void TC_TimeoutQueueNew<T>::popSend(bool del)
 {
     assert(!_send.empty());
@@ -192,7 +204,7 @@ template<typename T> void TC_TimeoutQueueNew<T>::popSend(bool del)
     stSendInfo.dataIter->second.hasSend = true;
     if(del)
     {
-        _time.erase(stSendInfo.dataIter->second.timeIter);
+        _time.erase(stSendInfo.dataIter->second.timeId);
         _data.erase(stSendInfo.dataIter);
     }
     _send.pop_back();
@@ -211,7 +223,7 @@ template<typename T> bool TC_TimeoutQueueNew<T>::get(uint32_t uniqId, T & t, boo
 
     if(bErase)
     {
-        _time.erase(it->second.timeIter);
+        _time.erase(it->second.timeId);
         if(!it->second.hasSend)
         {
             _send.erase(it->second.sendIter);
@@ -242,9 +254,7 @@ template<typename T> bool TC_TimeoutQueueNew<T>::push(T& ptr, uint32_t uniqId,in
     result = _data.insert(make_pair(uniqId, pi));
     if (result.second == false) return false;
 
-    NodeInfo stNodeInfo;
-    stNodeInfo.dataIter = result.first;
-    result.first->second.timeIter = _time.insert(make_pair(timeout,stNodeInfo));
+    result.first->second.timeId = _time.add(timeout, uniqId);
 
     //没有发送放到list队列里面
     if(!hasSend)
@@ -260,60 +270,35 @@ template<typename T> bool TC_TimeoutQueueNew<T>::push(T& ptr, uint32_t uniqId,in
 
 template<typename T> void TC_TimeoutQueueNew<T>::timeout()
 {
-    int64_t iNow = TNOWMS;
-    while(true)
+    T t;
+    while(timeout(t))
     {
-        typename time_type::iterator it = _time.begin();
-
-        if(_time.end() == it || it->first>iNow)
-            break;
-
-        if(!it->second.dataIter->second.hasSend)
-        {
-            _send.erase(it->second.dataIter->second.sendIter);
-        }
-        _data.erase(it->second.dataIter);
-        _time.erase(it);
     }
 }
 
 template<typename T> bool TC_TimeoutQueueNew<T>::timeout(T & t)
 {
-    int64_t iNow = TNOWMS;
-    if(_time.empty())
-        return false;
-    typename time_type::iterator it = _time.begin();
-    if(it->first>iNow)
+    uint32_t uniqId;
+    if(!_time.expire(TNOWMS, uniqId))
         return false;
 
-    t=it->second.dataIter->second.ptr;
-    if(!it->second.dataIter->second.hasSend)
+    typename data_type::iterator it = _data.find(uniqId);
+    assert(it != _data.end());
+
+    t = it->second.ptr;
+    if(!it->second.hasSend)
     {
-        _send.erase(it->second.dataIter->second.sendIter);
+        _send.erase(it->second.sendIter);
     }
-    _data.erase(it->second.dataIter);
-    _time.erase(it);
+    _data.erase(it);
     return true;
 }
 
 template<typename T> void TC_TimeoutQueueNew<T>::timeout(data_functor &df)
 {
-    while(true)
+    T ptr;
+    while(timeout(ptr))
     {
-        int64_t iNow = TNOWMS;
-        T ptr;
-        typename time_type::iterator it = _time.begin();
-        if(_time.end() == it || it->first>iNow)
-            break;
-
-        ptr=it->second.dataIter->second.ptr;
-        if(!it->second.dataIter->second.hasSend)
-        {
-            _send.erase(it->second.dataIter->second.sendIter);
-        }
-        _data.erase(it->second.dataIter);
-        _time.erase(it);
-
         try { df(ptr); } catch(...) { }
     }
 }
@@ -330,7 +315,7 @@ template<typename T> bool TC_TimeoutQueueNew<T>::erase(uint32_t uniqId, T & t)
     {
         _send.erase(it->second.sendIter);
     }
-    _time.erase(it->second.timeIter);
+    _time.erase(it->second.timeId);
     _data.erase(it);
 
     return true;
@@ -24,6 +24,7 @@
 #include "util/tc_autoptr.h"
 #include "util/tc_monitor.h"
 #include "util/tc_timeprovider.h"
+#include "util/tc_timing_wheel.h"
 
 using namespace std;
 
@@ -43,20 +44,14 @@ class TC_TimeoutQueueNoID
 public:
 
     struct PtrInfo;
-    struct NodeInfo;
 
-    typedef multimap<uint64_t,NodeInfo>      time_type;
     typedef list<PtrInfo>                   list_type;
+    typedef TC_TimingWheel<typename list_type::iterator> time_type;
 
     struct PtrInfo
     {
         T ptr;
-        typename time_type::iterator timeIter;
-    };
-
-    struct NodeInfo
-    {
-        typename list_type::iterator listIter;
+        uint64_t timeId;
     };
 
     /**
@@ -161,7 +156,7 @@ template<typename T> bool TC_TimeoutQueueNoID<T>::pop(T & t)
 
     t = pi.ptr;
 
-    _time.erase(pi.timeIter);
+    _time.erase(pi.timeId);
     _list.pop_back();
 
     return true;
@@ -177,46 +172,30 @@ template<typename T> bool TC_TimeoutQueueNoID<T>::push(T& ptr, uint64_t timeout)
 
     PtrInfo & pinfo = _list.front();
 
-    NodeInfo stNodeInfo;
-    stNodeInfo.listIter = _list.begin();
-    pinfo.timeIter = _time.insert(make_pair(timeout,stNodeInfo));
+    pinfo.timeId = _time.add(timeout, _list.begin());
 
     return true;
 }
 
 template<typename T> void TC_TimeoutQueueNoID<T>::timeout()
 {
-    uint64_t iNow = TNOWMS;
-    while(true)
+    T t;
+    while(timeout(t))
     {
-        typename time_type::iterator it = _time.begin();
-
-        if(_time.end() == it || it->first>iNow)
-            break;
-
-        _list.erase(it->second.listIter);
-        _time.erase(it);
     }
 }
 
 template<typename T> bool TC_TimeoutQueueNoID<T>::timeout(T & t)
 {
-    if(_time.empty())
+    typename list_type::iterator it;
+    if(!_time.expire(TNOWMS, it))
     {
         return false;
     }
 
-    typename time_type::iterator it = _time.begin();
-    if(it->first > TNOWMS)
-    {
-        return false;
-    }
-
-    t=it->second.listIter->ptr;
-
-    _list.erase(it->second.listIter);
+    t = it->ptr;
 
-    _time.erase(it);
+    _list.erase(it);
 
     return true;
 }
@@ -26,6 +26,7 @@
 #include "util/tc_thread_pool.h"
 #include "util/tc_timeprovider.h"
 #include "util/tc_cron.h"
+#include "util/tc_timing_wheel.h"
 
 namespace tars
 {
@@ -57,13 +58,14 @@ protected:
 		uint64_t                _fireMillseconds = 0;	//事件触发时间
         TC_Cron                 _cron;  //crontab
         uint32_t                _uniqueId = 0;
+        uint64_t                _timerId = 0;   //在时间轮中的id
 	};
 
     typedef std::set<uint64_t> EVENT_SET;
 
     typedef std::unordered_map<uint64_t, shared_ptr<Func>> MAP_EVENT;
 
-    typedef map<uint64_t, set<uint64_t>> MAP_TIMER;
+    typedef TC_TimingWheel<uint32_t> MAP_TIMER;
 
 public:
 
@@ -302,7 +304,7 @@ protected:
 
 	MAP_EVENT   _tmpEvent;      //id, 事件
 
-    MAP_TIMER   _mapTimer;      //时间, 事件
+    MAP_TIMER   _mapTimer;      //时间轮, 事件触发时间->事件id
 
 	atomic_uint _increaseId = {0};
 	
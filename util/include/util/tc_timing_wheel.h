@@ -0,0 +1,553 @@
+﻿/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+#pragma once
+
+#include <vector>
+#include <cassert>
+#include <cstring>
+#include "util/tc_platform.h"
+#include "util/tc_timeprovider.h"
+
+using namespace std;
+
+namespace tars
+{
+/////////////////////////////////////////////////
+/**
+ * @file tc_timing_wheel.h
+ * @brief 分层时间轮, 没有锁, 非线程安全.
+ *
+ * 说明:
+ * - 4层, 每层256个槽, 第0层一个槽是一个tick(默认1ms), 总共覆盖2^32个tick, 超出的放在最高层, 到期前会重新放置
+ * - 插入, 删除, 到期都是O(1), 节点放在数组中复用, 稳定运行后没有内存分配
+ * - 到期的数据先放入到期链表, 再通过pop逐个取出
+ * - add返回的id带有版本号, 节点复用后旧的id失效, erase/get旧的id会返回false
+ */
+/////////////////////////////////////////////////
+
+template<typename T>
+class TC_TimingWheel
+{
+public:
+    /**
+     * @brief 构造
+     * @param tickMs, 每个tick的毫秒数
+     * @param nowMs, 当前时间(毫秒)
+     */
+    explicit TC_TimingWheel(uint32_t tickMs = 1, int64_t nowMs = TNOWMS);
+
+    /**
+     * @brief 添加数据
+     * @param expireMs, 到期时间(绝对时间, 毫秒)
+     * @param t, 数据
+     * @return uint64_t, id(不会为0)
+     */
+    uint64_t add(int64_t expireMs, const T &t);
+
+    /**
+     * @brief 删除数据(包括已经到期还没有pop的)
+     * @param id
+     * @return bool, id不存在返回false
+     */
+    bool erase(uint64_t id);
+
+    /**
+     * @brief 获取数据
+     * @param id
+     * @param t
+     * @return bool, id不存在返回false
+     */
+    bool get(uint64_t id, T &t) const;
+
+    /**
+     * @brief 时间推进到nowMs, 到期的数据放入到期链表
+     * @param nowMs
+     */
+    void advance(int64_t nowMs);
+
+    /**
+     * @brief 取出一个到期的数据(需要先advance)
+     * @param t
+     * @return bool, 没有到期数据返回false
+     */
+    bool pop(T &t);
+
+    /**
+     * @brief 推进时间, 并取出一个到期的数据
+     * @param nowMs
+     * @param t
+     * @return bool
+     */
+    bool expire(int64_t nowMs, T &t)
+    {
+        advance(nowMs);
+        return pop(t);
+    }
+
+    /**
+     * @brief 下一次需要advance的时间(毫秒), 不会晚于最早的到期时间(高层的槽需要在这个时间展开)
+     * @return int64_t, 没有数据返回-1
+     */
+    int64_t nextExpire() const;
+
+    /**
+     * @brief 数据个数(包括已经到期还没有pop的)
+     */
+    size_t size() const { return _size; }
+
+    /**
+     * @brief 是否为空
+     */
+    bool empty() const { return _size == 0; }
+
+    /**
+     * @brief 清空
+     */
+    void clear();
+
+protected:
+    enum
+    {
+        LEVEL_BITS  = 8,
+        SLOTS       = 1 << LEVEL_BITS,
+        SLOT_MASK   = SLOTS - 1,
+        LEVELS      = 4,
+        EXPIRED     = LEVELS,       //在到期链表中
+        FREE        = LEVELS + 1,   //空闲节点
+    };
+
+    static const uint32_t NIL = (uint32_t)-1;
+
+    struct Node
+    {
+        T           data;
+        int64_t     expire = 0;     //到期的tick
+        uint32_t    prev = NIL;
+        uint32_t    next = NIL;
+        uint32_t    version = 0;
+        uint8_t     level = FREE;
+        uint8_t     slot = 0;
+    };
+
+    struct List
+    {
+        uint32_t head = NIL;
+        uint32_t tail = NIL;
+    };
+
+    /**
+     * 根据到期tick放到对应的槽中
+     */
+    void place(uint32_t index);
+
+    void link(List &l, uint32_t index);
+
+    void unlink(List &l, uint32_t index);
+
+    List &listOf(const Node &node) { return node.level == EXPIRED ? _expired : _slots[node.level][node.slot]; }
+
+    /**
+     * 把高层的槽展开到低层
+     */
+    void cascade(int level, size_t slot);
+
+    /**
+     * 从from开始(包括from)查找第一个非空的槽, 返回距离, 没有返回SLOTS
+     */
+    size_t findSlot(int level, size_t from) const;
+
+    /**
+     * 时间轮上下一个需要处理的tick(到期或者展开), 没有返回-1
+     */
+    int64_t nextTick() const;
+
+    uint32_t allocate();
+
+    void release(uint32_t index);
+
+    bool find(uint64_t id, uint32_t &index) const;
+
+protected:
+    int64_t             _tickMs;
+
+    //下一个要处理的tick
+    int64_t             _current;
+
+    size_t              _size = 0;
+
+    size_t              _expiredSize = 0;
+
+    vector<Node>        _nodes;
+
+    uint32_t            _free = NIL;
+
+    List                _slots[LEVELS][SLOTS];
+
+    //非空的槽
+    uint64_t            _bitmap[LEVELS][SLOTS / 64];
+
+    List                _expired;
+};
+
+template<typename T> TC_TimingWheel<T>::TC_TimingWheel(uint32_t tickMs, int64_t nowMs) : _tickMs(tickMs == 0 ? 1 : tickMs)
+{
+    _current = nowMs / _tickMs + 1;
+    memset(_bitmap, 0, sizeof(_bitmap));
+}
+
+template<typename T> uint32_t TC_TimingWheel<T>::allocate()
+{
+    uint32_t index;
+    if (_free != NIL)
+    {
+        index = _free;
+        _free = _nodes[index].next;
+    }
+    else
+    {
+        index = (uint32_t)_nodes.size();
+        _nodes.emplace_back();
+    }
+
+    Node &node = _nodes[index];
+    node.prev = node.next = NIL;
+    ++node.version;
+    if (node.version == 0)
+    {
+        node.version = 1;
+    }
+    return index;
+}
+
+template<typename T> void TC_TimingWheel<T>::release(uint32_t index)
+{
+    Node &node = _nodes[index];
+    node.data = T();
+    node.level = FREE;
+    node.prev = NIL;
+    node.next = _free;
+    _free = index;
+}
+
+template<typename T> bool TC_TimingWheel<T>::find(uint64_t id, uint32_t &index) const
+{
+    index = (uint32_t)(id & 0xFFFFFFFF);
+    uint32_t version = (uint32_t)(id >> 32);
+
+    return index < _nodes.size() && _nodes[index].level != FREE && _nodes[index].version == version;
+}
+
+template<typename T> void TC_TimingWheel<T>::link(List &l, uint32_t index)
+{
+    Node &node = _nodes[index];
+    node.prev = l.tail;
+    node.next = NIL;
+    if (l.tail != NIL)
+    {
+        _nodes[l.tail].next = index;
+    }
+    else
+    {
+        l.head = index;
+    }
+    l.tail = index;
+}
+
+template<typename T> void TC_TimingWheel<T>::unlink(List &l, uint32_t index)
+{
+    Node &node = _nodes[index];
+    if (node.prev != NIL)
+    {
+        _nodes[node.prev].next = node.next;
+    }
+    else
+    {
+        l.head = node.next;
+    }
+
+    if (node.next != NIL)
+    {
+        _nodes[node.next].prev = node.prev;
+    }
+    else
+    {
+        l.tail = node.prev;
+    }
+
+    if (node.level == EXPIRED)
+    {
+        --_expiredSize;
+    }
+    else if (node.level < LEVELS && l.head == NIL)
+    {
+        _bitmap[node.level][node.slot >> 6] &= ~((uint64_t)1 << (node.slot & 63));
+    }
+}
+
+template<typename T> void TC_TimingWheel<T>::place(uint32_t index)
+{
+    Node &node = _nodes[index];
+
+    if (node.expire < _current)
+    {
+        node.level = EXPIRED;
+        link(_expired, index);
+        ++_expiredSize;
+        return;
+    }
+
+    int64_t expire = node.expire;
+    uint64_t delta = (uint64_t)(expire - _current);
+
+    //超出范围的先放在最高层的最远处
+    if (delta >= ((uint64_t)1 << (LEVEL_BITS * LEVELS)))
+    {
+        delta = ((uint64_t)1 << (LEVEL_BITS * LEVELS)) - 1;
+        expire = _current + (int64_t)delta;
+    }
+
+    int level = 0;
+    while (delta >= ((uint64_t)1 << (LEVEL_BITS * (level + 1))))
+    {
+        ++level;
+    }
+
+    size_t slot = (size_t)((expire >> (LEVEL_BITS * level)) & SLOT_MASK);
+
+    node.level = (uint8_t)level;
+    node.slot = (uint8_t)slot;
+    link(_slots[level][slot], index);
+    _bitmap[level][slot >> 6] |= ((uint64_t)1 << (slot & 63));
+}
+
+template<typename T> uint64_t TC_TimingWheel<T>::add(int64_t expireMs, const T &t)
+{
+    uint32_t index = allocate();
+
+    Node &node = _nodes[index];
+    node.data = t;
+    //向上取整, 保证不会提前到期
+    node.expire = (expireMs + _tickMs - 1) / _tickMs;
+
+    place(index);
+
+    ++_size;
+
+    return ((uint64_t)node.version << 32) | index;
+}
+
+template<typename T> bool TC_TimingWheel<T>::erase(uint64_t id)
+{
+    uint32_t index;
+    if (!find(id, index))
+    {
+        return false;
+    }
+
+    unlink(listOf(_nodes[index]), index);
+    release(index);
+    --_size;
+
+    return true;
+}
+
+template<typename T> bool TC_TimingWheel<T>::get(uint64_t id, T &t) const
+{
+    uint32_t index;
+    if (!find(id, index))
+    {
+        return false;
+    }
+
+    t = _nodes[index].data;
+    return true;
+}
+
+template<typename T> void TC_TimingWheel<T>::cascade(int level, size_t slot)
+{
+    List l = _slots[level][slot];
+    _slots[level][slot] = List();
+    _bitmap[level][slot >> 6] &= ~((uint64_t)1 << (slot & 63));
+
+    uint32_t index = l.head;
+    while (index != NIL)
+    {
+        uint32_t next = _nodes[index].next;
+        place(index);
+        index = next;
+    }
+}
+
+template<typename T> size_t TC_TimingWheel<T>::findSlot(int level, size_t from) const
+{
+    for (size_t i = from; i < SLOTS; )
+    {
+        uint64_t bits = _bitmap[level][i >> 6] >> (i & 63);
+        if (bits != 0)
+        {
+            size_t n = 0;
+            while (((bits >> n) & 1) == 0)
+            {
+                ++n;
+            }
+            return i + n - from;
+        }
+        i = (i | 63) + 1;
+    }
+
+    return SLOTS;
+}
+
+template<typename T> void TC_TimingWheel<T>::advance(int64_t nowMs)
+{
+    int64_t now = nowMs / _tickMs;
+
+    while (_current <= now)
+    {
+        if (_size == _expiredSize)
+        {
+            //时间轮上没有数据了, 直接跳过
+            _current = now + 1;
+            break;
+        }
+
+        size_t index = (size_t)(_current & SLOT_MASK);
+
+        if (index == 0)
+        {
+            for (int level = 1; level < LEVELS; level++)
+            {
+                size_t slot = (size_t)((_current >> (LEVEL_BITS * level)) & SLOT_MASK);
+                cascade(level, slot);
+                if (slot != 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        //跳过空的槽, 直接到下一个需要处理的tick
+        size_t distance = findSlot(0, index);
+        if (distance > 0)
+        {
+            int64_t next = distance < SLOTS ? _current + (int64_t)distance : nextTick();
+            if (next <= _current)
+            {
+                next = _current + 1;
+            }
+            _current = next < now + 1 ? next : now + 1;
+            continue;
+        }
+
+        List &l = _slots[0][index];
+        uint32_t i = l.head;
+        while (i != NIL)
+        {
+            uint32_t next = _nodes[i].next;
+            unlink(l, i);
+            _nodes[i].level = EXPIRED;
+            link(_expired, i);
+            ++_expiredSize;
+            i = next;
+        }
+
+        ++_current;
+    }
+}
+
+template<typename T> bool TC_TimingWheel<T>::pop(T &t)
+{
+    uint32_t index = _expired.head;
+    if (index == NIL)
+    {
+        return false;
+    }
+
+    unlink(_expired, index);
+    t = _nodes[index].data;
+    release(index);
+    --_size;
+
+    return true;
+}
+
+template<typename T> int64_t TC_TimingWheel<T>::nextExpire() const
+{
+    if (_size == 0)
+    {
+        return -1;
+    }
+
+    if (_expiredSize > 0)
+    {
+        return (_current - 1) * _tickMs;
+    }
+
+    return nextTick() * _tickMs;
+}
+
+template<typename T> int64_t TC_TimingWheel<T>::nextTick() const
+{
+    int64_t next = -1;
+
+    //每一层找到下一个非空的槽, 第0层是到期时间, 高层是展开的时间, 取最小值
+    for (int level = 0; level < LEVELS; level++)
+    {
+        int shift = LEVEL_BITS * level;
+
+        //还没有展开的第一个槽
+        int64_t block = (_current + ((int64_t)1 << shift) - 1) >> shift;
+        size_t from = (size_t)(block & SLOT_MASK);
+
+        size_t distance = findSlot(level, from);
+        if (distance >= SLOTS)
+        {
+            distance = findSlot(level, 0);
+            if (distance >= SLOTS)
+            {
+                continue;
+            }
+            distance += SLOTS - from;
+        }
+
+        int64_t t = (block + (int64_t)distance) << shift;
+        if (next < 0 || t < next)
+        {
+            next = t;
+        }
+    }
+
+    return next;
+}
+
+template<typename T> void TC_TimingWheel<T>::clear()
+{
+    _nodes.clear();
+    _free = NIL;
+    _size = 0;
+    _expiredSize = 0;
+    _expired = List();
+    for (int level = 0; level < LEVELS; level++)
+    {
+        for (size_t slot = 0; slot < SLOTS; slot++)
+        {
+            _slots[level][slot] = List();
+        }
+    }
+    memset(_bitmap, 0, sizeof(_bitmap));
+}
+
+}
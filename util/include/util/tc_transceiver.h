@@ -66,6 +66,7 @@ struct TC_Transceiver_Exception : public TC_Exception
  * 8 注意: 主要接口都以异常的形式对外抛出错误, 因此外部调用时注意捕获异常(一般是在注册的事件中)
  * 9 连接直接鉴权逻辑, 即可客户端发业务包前, 会发送一个鉴权包到服务器端, 服务器收到同样解包, 鉴权通过后, 才能继续发送业务包
  * 10 具体客户端使用方式可以参考: CommunicatorEpoll类, 服务端参考: tc_epoll_server
+ * 11 tcp发送时, 发送buffer中的多块数据会通过writev一次发送出去, 多个包可以通过sendRequests一起发送, 发送统计见getSendStat
  * 
  */
 class UTIL_DLL_API TC_Transceiver
@@ -297,6 +298,21 @@ public:
      */ 
     virtual ReturnStatus sendRequest(const shared_ptr<TC_NetWorkBuffer::Buffer> &buff, const TC_Socket::addr_type& addr = TC_Socket::addr_type());
 
+    /**
+     * 一起发送多个buffer, tcp时会合并成一次writev(udp时每个buffer一个包)
+     * 返回值同sendRequest, 除eRetError/eRetNotSend外, 所有buffer都已经交给发送buffer
+     * @param buffs, buffer内容
+     * @param addr, 发送地址
+     */
+    ReturnStatus sendRequests(const vector<shared_ptr<TC_NetWorkBuffer::Buffer>> &buffs, const TC_Socket::addr_type& addr = TC_Socket::addr_type());
+
+    /**
+     * 发送统计(所有tcp连接)
+     * @param buffers, 发送的数据块数
+     * @param syscalls, 发送的系统调用次数, buffers - syscalls即聚合发送节省的系统调用次数
+     */
+    static void getSendStat(uint64_t &buffers, uint64_t &syscalls);
+
     /**
      * 是否鉴权成功
      */ 
@@ -511,6 +527,37 @@ protected:
      */
     virtual int send(const void* buf, uint32_t len, uint32_t flag) = 0;
 
+    /*
+     * 网络聚合发送接口, 默认只发送第一块
+     * @param vec
+     * @param count
+     * @return int
+     */
+    virtual int sendv(const pair<const char*, size_t> *vec, size_t count);
+
+    /*
+     * 检查当前是否可以发送业务数据
+     * @return eRetOk: 可以发送
+     */
+    ReturnStatus checkSend();
+
+    /*
+     * 把buffer放入发送buffer(ssl时先加密)
+     * @return eRetOk/eRetError
+     */
+    ReturnStatus appendRequest(const shared_ptr<TC_NetWorkBuffer::Buffer> &buff);
+
+    /*
+     * 发送发送buffer中的数据, 直到发送完或者系统buffer满了
+     */
+    ReturnStatus flushRequest(const TC_Socket::addr_type& addr);
+
+    /*
+     * 发送一次发送buffer中的数据(多块时聚合发送)
+     * @return int, 发送的字节数
+     */
+    int sendBuffers();
+
     /*
      * 网络接收接口
      * @param buf
@@ -672,6 +719,14 @@ public:
      */
     virtual int send(const void* buf, uint32_t len, uint32_t flag);
 
+    /**
+     * TCP 聚合发送实现(writev)
+     * @param vec
+     * @param count
+     * @return int
+     */
+    virtual int sendv(const pair<const char*, size_t> *vec, size_t count);
+
     /**
      * TCP 接收实现
      * @param buf
@@ -704,6 +759,16 @@ public:
      */
     TC_SSLTransceiver(TC_Epoller* epoller, const TC_Endpoint &ep);
 
+    /**
+     * 接收实现, 开启kTLS接收后由内核解密
+     * @param buf
+     * @param len
+     * @param flag
+     *
+     * @return int
+     */
+    virtual int recv(void* buf, uint32_t len, uint32_t flag);
+
     /**
      * 处理返回
      * @return throw 
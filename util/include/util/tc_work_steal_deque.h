@@ -0,0 +1,253 @@
+/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include "util/tc_platform.h"
+
+using namespace std;
+
+namespace tars
+{
+/////////////////////////////////////////////////
+/**
+ * @file tc_work_steal_deque.h
+ * @brief 工作窃取双端队列(Chase-Lev).
+ *
+ * 说明:
+ * - 只有一个所有者线程, 在底部push/pop(后进先出), 不需要CAS(只剩最后一个元素时才和窃取方竞争)
+ * - 其他线程从顶部steal(先进先出), 通过CAS抢占
+ * - 容量不够时所有者自动扩容, 旧的数组保留到析构时才释放(窃取方可能还在读)
+ * - 元素通过std::atomic<T>读写, T必须是指针或者整数这类可以原子读写的类型
+ * - 实现参考: Correct and Efficient Work-Stealing for Weak Memory Models(Lê, Pop, Cohen, Zappa Nardelli)
+ */
+
+/////////////////////////////////////////////////
+/**
+ * @brief 工作窃取双端队列
+ */
+template<typename T>
+class TC_WorkStealDeque
+{
+public:
+    /**
+     * @brief 构造
+     * @param capacity, 初始容量, 向上取整到2的幂
+     */
+    explicit TC_WorkStealDeque(size_t capacity = 256);
+
+    ~TC_WorkStealDeque();
+
+    /**
+     * @brief 放到底部(只能所有者线程调用)
+     * @param t
+     */
+    void push(T t);
+
+    /**
+     * @brief 从底部取出(只能所有者线程调用)
+     * @param t
+     * @return bool, 没有数据返回false
+     */
+    bool pop(T &t);
+
+    /**
+     * @brief 从顶部窃取(任意线程)
+     * @param t
+     * @return bool, 没有数据或者和其他线程竞争失败返回false
+     */
+    bool steal(T &t);
+
+    /**
+     * @brief 大小(并发时是近似值)
+     */
+    size_t size() const;
+
+    /**
+     * @brief 是否为空(并发时是近似值)
+     */
+    bool empty() const { return size() == 0; }
+
+    /**
+     * @brief 当前容量
+     */
+    size_t capacity() const { return _array.load(std::memory_order_relaxed)->mask + 1; }
+
+protected:
+    TC_WorkStealDeque(const TC_WorkStealDeque&) = delete;
+    TC_WorkStealDeque& operator=(const TC_WorkStealDeque&) = delete;
+
+    struct Array
+    {
+        Array(int64_t n) : mask(n - 1), data(new std::atomic<T>[n]) { }
+        ~Array() { delete[] data; }
+
+        T get(int64_t i) const { return data[i & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T t) { data[i & mask].store(t, std::memory_order_relaxed); }
+
+        int64_t         mask;
+        std::atomic<T> *data;
+    };
+
+    /**
+     * 扩容为两倍(只有所有者调用)
+     */
+    Array *grow(Array *a, int64_t bottom, int64_t top);
+
+protected:
+    static const size_t CACHE_LINE = 64;
+
+    //窃取方修改top, 所有者修改bottom, 放在不同的cache line上
+    char                    _pad0[CACHE_LINE];
+    std::atomic<int64_t>    _top{0};
+    char                    _pad1[CACHE_LINE];
+    std::atomic<int64_t>    _bottom{0};
+    char                    _pad2[CACHE_LINE];
+
+    std::atomic<Array*>     _array;
+
+    //扩容后旧的数组
+    vector<Array*>          _garbage;
+};
+
+template<typename T> TC_WorkStealDeque<T>::TC_WorkStealDeque(size_t capacity)
+{
+    int64_t n = 2;
+    while (n < (int64_t)capacity)
+    {
+        n <<= 1;
+    }
+
+    _array.store(new Array(n), std::memory_order_relaxed);
+}
+
+template<typename T> TC_WorkStealDeque<T>::~TC_WorkStealDeque()
+{
+    delete _array.load(std::memory_order_relaxed);
+
+    for (auto a : _garbage)
+    {
+        delete a;
+    }
+}
+
+template<typename T> typename TC_WorkStealDeque<T>::Array *TC_WorkStealDeque<T>::grow(Array *a, int64_t bottom, int64_t top)
+{
+    Array *na = new Array((a->mask + 1) * 2);
+
+    for (int64_t i = top; i < bottom; i++)
+    {
+        na->put(i, a->get(i));
+    }
+
+    _garbage.push_back(a);
+
+    _array.store(na, std::memory_order_release);
+
+    return na;
+}
+
+template<typename T> void TC_WorkStealDeque<T>::push(T t)
+{
+    int64_t b = _bottom.load(std::memory_order_relaxed);
+    int64_t t0 = _top.load(std::memory_order_acquire);
+    Array *a = _array.load(std::memory_order_relaxed);
+
+    if (b - t0 > a->mask)
+    {
+        a = grow(a, b, t0);
+    }
+
+    a->put(b, t);
+
+    std::atomic_thread_fence(std::memory_order_release);
+
+    _bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+template<typename T> bool TC_WorkStealDeque<T>::pop(T &t)
+{
+    int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+    Array *a = _array.load(std::memory_order_relaxed);
+
+    _bottom.store(b, std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    int64_t t0 = _top.load(std::memory_order_relaxed);
+
+    if (t0 > b)
+    {
+        //空的
+        _bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    t = a->get(b);
+
+    if (t0 == b)
+    {
+        //最后一个元素, 和窃取方竞争
+        bool succ = _top.compare_exchange_strong(t0, t0 + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+
+        _bottom.store(b + 1, std::memory_order_relaxed);
+
+        return succ;
+    }
+
+    return true;
+}
+
+template<typename T> bool TC_WorkStealDeque<T>::steal(T &t)
+{
+    int64_t t0 = _top.load(std::memory_order_acquire);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    int64_t b = _bottom.load(std::memory_order_acquire);
+
+    if (t0 >= b)
+    {
+        return false;
+    }
+
+    Array *a = _array.load(std::memory_order_acquire);
+
+    T v = a->get(t0);
+
+    if (!_top.compare_exchange_strong(t0, t0 + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        //被其他窃取方或者所有者抢走了
+        return false;
+    }
+
+    t = v;
+
+    return true;
+}
+
+template<typename T> size_t TC_WorkStealDeque<T>::size() const
+{
+    int64_t b = _bottom.load(std::memory_order_relaxed);
+    int64_t t0 = _top.load(std::memory_order_relaxed);
+
+    return b > t0 ? (size_t)(b - t0) : 0;
+}
+
+}
+
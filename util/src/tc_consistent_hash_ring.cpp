@@ -0,0 +1,115 @@
+﻿/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except 
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed 
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR 
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the 
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_consistent_hash_ring.h"
+#include "util/tc_common.h"
+#include <algorithm>
+
+namespace tars
+{
+
+TC_ConsistentHashRing::TC_ConsistentHashRing(TC_HashAlgorithmType hashType)
+{
+    _ptrHashAlg = TC_HashAlgFactory::getHashAlg(hashType);
+}
+
+int TC_ConsistentHashRing::addNode(const string & node, unsigned int index, int weight)
+{
+    if (_ptrHashAlg.get() == NULL)
+    {
+        return -1;
+    }
+
+    if (index >= _nodeCount)
+    {
+        _nodeCount = index + 1;
+    }
+
+    for (int j = 0; j < weight; j++)
+    {
+        string virtualNode = node + "_" + TC_Common::tostr<int>(j);
+
+        //和TC_ConsistentHashNew::addNode保持一致
+        if (_ptrHashAlg->getHashType() == E_TC_CONHASH_KETAMAHASH)
+        {
+            vector<char> sMd5 = TC_MD5::md5bin(virtualNode);
+            char *p = (char *) sMd5.data();
+
+            for (int i = 0; i < 4; i++)
+            {
+                uint32_t hash = ((uint32_t)(p[i * 4 + 3] & 0xFF) << 24)
+                    | ((uint32_t)(p[i * 4 + 2] & 0xFF) << 16)
+                    | ((uint32_t)(p[i * 4 + 1] & 0xFF) << 8)
+                    | ((uint32_t)(p[i * 4 + 0] & 0xFF));
+
+                _vBuild.push_back(((uint64_t)hash << 32) | index);
+            }
+        }
+        else
+        {
+            uint32_t hash = _ptrHashAlg->hash(virtualNode.c_str(), virtualNode.length());
+
+            _vBuild.push_back(((uint64_t)hash << 32) | index);
+        }
+    }
+
+    return 0;
+}
+
+void TC_ConsistentHashRing::sortNode()
+{
+    for (size_t i = 0; i < _vHash.size(); i++)
+    {
+        _vBuild.push_back(((uint64_t)_vHash[i] << 32) | _vIndex[i]);
+    }
+
+    std::sort(_vBuild.begin(), _vBuild.end());
+
+    _vHash.resize(_vBuild.size());
+    _vIndex.resize(_vBuild.size());
+
+    for (size_t i = 0; i < _vBuild.size(); i++)
+    {
+        _vHash[i] = (uint32_t)(_vBuild[i] >> 32);
+        _vIndex[i] = (uint32_t)_vBuild[i];
+    }
+
+    vector<uint64_t>().swap(_vBuild);
+}
+
+int TC_ConsistentHashRing::getIndex(const string & key, unsigned int & iIndex) const
+{
+    if (_ptrHashAlg.get() == NULL || _vHash.empty())
+    {
+        iIndex = 0;
+        return -1;
+    }
+
+    vector<char> data = TC_MD5::md5bin(key);
+    uint32_t iCode = _ptrHashAlg->hash(data.data(), data.size());
+
+    return getIndex(iCode, iIndex);
+}
+
+void TC_ConsistentHashRing::clear()
+{
+    _vHash.clear();
+    _vIndex.clear();
+    _vBuild.clear();
+    _nodeCount = 0;
+}
+
+}
@@ -123,6 +123,14 @@ void stack_traits::deallocate( stack_context & sctx)  {
 	::VirtualFree( vp, 0, MEM_RELEASE);
 }
 
+//VirtualAlloc时已经全部提交, 不统计
+std::size_t stack_traits::used(const stack_context &) {
+	return 0;
+}
+
+void stack_traits::trim(const stack_context &, std::size_t, bool) {
+}
+
 #else
 
 // 128kb recommended stack size
@@ -206,6 +214,47 @@ void stack_traits::deallocate(stack_context & sctx) {
 	::munmap( vp, sctx.size);
 }
 
+std::size_t stack_traits::used(const stack_context & sctx) {
+	const std::size_t page = stack_traits::page_size();
+
+	//跳过底部的guard-page
+	char * vp = static_cast< char * >( sctx.sp) - sctx.size + page;
+	const std::size_t pages = sctx.size / page - 1;
+
+#if TARGET_PLATFORM_LINUX
+	unsigned char vec[256];
+#else
+	char vec[256];
+#endif
+
+	//栈向下增长, 从底部找到的第一个驻留页就是最高水位
+	for ( std::size_t i = 0; i < pages; i += sizeof(vec)) {
+		const std::size_t n = std::min( pages - i, sizeof(vec));
+		if ( 0 != ::mincore( vp + i * page, n * page, vec)) return 0;
+
+		for ( std::size_t j = 0; j < n; ++j) {
+			if ( vec[j] & 1) return ( pages - i - j) * page;
+		}
+	}
+
+	return 0;
+}
+
+void stack_traits::trim(const stack_context & sctx, std::size_t keep, bool lazy) {
+	const std::size_t page = stack_traits::page_size();
+
+	char * vp = static_cast< char * >( sctx.sp) - sctx.size + page;
+	char * end = static_cast< char * >( sctx.sp) - ( keep + page - 1) / page * page;
+
+	if ( end <= vp) return;
+
+#if defined(MADV_FREE)
+	::madvise( vp, end - vp, lazy ? MADV_FREE : MADV_DONTNEED);
+#else
+	::madvise( vp, end - vp, MADV_DONTNEED);
+#endif
+}
+
 #endif
 
 ////////////////////////////////////////////////////////
@@ -238,6 +287,13 @@ void TC_CoroutineInfo::setStackContext(stack_context stack_ctx)
 }
 
 void TC_CoroutineInfo::registerFunc(const std::function<void ()>& callback)
+{
+	setCallback(callback);
+
+	makeContext();
+}
+
+void TC_CoroutineInfo::setCallback(const std::function<void ()>& callback)
 {
     _callback           = callback;
 
@@ -245,6 +301,13 @@ void TC_CoroutineInfo::registerFunc(const std::function<void ()>& callback)
 
     _init_func.args     = this;
 
+    _needInit           = true;
+}
+
+void TC_CoroutineInfo::makeContext()
+{
+    _needInit           = false;
+
 	fcontext_t ctx      = tars_make_fcontext(_stack_ctx.sp, _stack_ctx.size, TC_CoroutineInfo::corotineEntry);
 
 	transfer_t tf       = tars_jump_fcontext(ctx, this);
@@ -361,6 +424,132 @@ void TC_CoroutineScheduler::setPoolStackSize(uint32_t iPoolSize, size_t iStackSi
 	_stackSize  = iStackSize;
 }
 
+void TC_CoroutineScheduler::setStackPool(size_t maxFree, size_t keepSize, bool lazyFree)
+{
+	_maxFreeStacks  = maxFree;
+	_keepStackSize  = keepSize;
+	_lazyFree       = lazyFree;
+}
+
+void TC_CoroutineScheduler::setSharedStack(size_t sharedCount)
+{
+	assert(!_all_coro);
+
+	_sharedStacks.resize(sharedCount);
+}
+
+TC_CoroutineScheduler::StackStat TC_CoroutineScheduler::getStackStat() const
+{
+	StackStat stat = _stackStat;
+	stat.freeStacks = _freeStacks.size();
+	return stat;
+}
+
+stack_context TC_CoroutineScheduler::allocStack()
+{
+	if(!_freeStacks.empty())
+	{
+		stack_context s_ctx = _freeStacks.back();
+		_freeStacks.pop_back();
+		return s_ctx;
+	}
+
+	++_stackStat.stacks;
+
+	return stack_traits::allocate(_stackSize);
+}
+
+void TC_CoroutineScheduler::releaseStack(TC_CoroutineInfo *coro)
+{
+	if(coro->_sharedIndex >= 0)
+	{
+		SharedStack &shared = _sharedStacks[coro->_sharedIndex];
+		if(shared.owner == coro)
+		{
+			shared.owner = NULL;
+		}
+
+		coro->_sharedIndex = -1;
+		coro->setStackContext(stack_context());
+		return;
+	}
+
+	stack_context &s_ctx = coro->getStackContext();
+	if(!s_ctx.sp)
+	{
+		return;
+	}
+
+	size_t used = stack_traits::used(s_ctx);
+	if(used > _stackStat.highWater)
+	{
+		_stackStat.highWater = used;
+	}
+
+	if(_freeStacks.size() >= _maxFreeStacks)
+	{
+		stack_traits::deallocate(s_ctx);
+		--_stackStat.stacks;
+	}
+	else
+	{
+		if(used > _keepStackSize)
+		{
+			stack_traits::trim(s_ctx, _keepStackSize, _lazyFree);
+		}
+
+		_freeStacks.push_back(s_ctx);
+	}
+
+	coro->setStackContext(stack_context());
+}
+
+void TC_CoroutineScheduler::switchSharedStack(TC_CoroutineInfo *to)
+{
+	SharedStack &shared = _sharedStacks[to->_sharedIndex];
+
+	if(shared.owner != to)
+	{
+		char *top = (char*)shared.ctx.sp;
+
+		//换出: 挂起的协程, 上下文之上的部分就是已经使用的栈
+		if(shared.owner)
+		{
+			TC_CoroutineInfo *owner = shared.owner;
+			char *sp = (char*)owner->getCtx();
+			size_t len = top - sp;
+
+			owner->_saveStack.assign(sp, len);
+
+			_stackStat.savedSize += len;
+			++_stackStat.copies;
+
+			if(len > _stackStat.highWater)
+			{
+				_stackStat.highWater = len;
+			}
+		}
+
+		//换入
+		if(!to->_saveStack.empty())
+		{
+			size_t len = to->_saveStack.size();
+			memcpy(top - len, to->_saveStack.data(), len);
+
+			_stackStat.savedSize -= len;
+
+			string().swap(to->_saveStack);
+		}
+
+		shared.owner = to;
+	}
+
+	if(to->_needInit)
+	{
+		to->makeContext();
+	}
+}
+
 void TC_CoroutineScheduler::init()
 {
 	_usedSize   = 0;
@@ -377,6 +566,12 @@ void TC_CoroutineScheduler::init()
 
 	createCoroutineInfo(_poolSize);
 
+	for(size_t i = 0; i < _sharedStacks.size(); ++i)
+	{
+		_sharedStacks[i].ctx    = stack_traits::allocate(_stackSize);
+		_sharedStacks[i].owner  = NULL;
+	}
+
     TC_CoroutineInfo::CoroutineHeadInit(&_active);
     TC_CoroutineInfo::CoroutineHeadInit(&_avail);
     TC_CoroutineInfo::CoroutineHeadInit(&_inactive);
@@ -392,9 +587,8 @@ void TC_CoroutineScheduler::init()
 
         assert(iId != 0);
 
-        stack_context s_ctx = stack_traits::allocate(_stackSize);
-
-	    TC_CoroutineInfo *coro = new TC_CoroutineInfo(this, iId, s_ctx);
+        //栈在协程启动时才分配
+	    TC_CoroutineInfo *coro = new TC_CoroutineInfo(this, iId, stack_context());
 
         _all_coro[iId] = coro;
 
@@ -421,9 +615,8 @@ int TC_CoroutineScheduler::increaseCoroPoolSize()
     for(int i = 0; i < iInc; ++i)
     {
 	    uint32_t iId        = generateId();
-	    stack_context s_ctx = stack_traits::allocate(_stackSize);
 
-	    TC_CoroutineInfo *coro = new TC_CoroutineInfo(this, iId, s_ctx);
+	    TC_CoroutineInfo *coro = new TC_CoroutineInfo(this, iId, stack_context());
 
         _all_coro[iId] = coro;
 
@@ -461,7 +654,18 @@ uint32_t TC_CoroutineScheduler::go(const std::function<void ()> &callback)
 
     TC_CoroutineInfo::CoroutineAddTail(coro, &_avail);
 
-    coro->registerFunc(callback);
+    if(!_sharedStacks.empty())
+    {
+        //共享栈上可能有正在运行的协程, 第一次切换过去时才创建上下文
+        coro->_sharedIndex = (int)(_sharedPos++ % _sharedStacks.size());
+        coro->setStackContext(_sharedStacks[coro->_sharedIndex].ctx);
+        coro->setCallback(callback);
+    }
+    else
+    {
+        coro->setStackContext(allocStack());
+        coro->registerFunc(callback);
+    }
 
     return coro->getUid();
 }
@@ -477,6 +681,96 @@ bool TC_CoroutineScheduler::full()
 	return false;
 }
 
+void TC_CoroutineScheduler::setGroup(const shared_ptr<TC_CoroutineSchedulerGroup> &group)
+{
+	assert(!_ready);
+
+	int index = group->join(this);
+	if(index < 0)
+	{
+		return;
+	}
+
+	_group      = group;
+	_groupIndex = index;
+}
+
+bool TC_CoroutineScheduler::post(const std::function<void ()> &callback)
+{
+	if(!_group)
+	{
+		return go(callback) != 0;
+	}
+
+	//自己已经有积压, 唤醒空闲的调度器来窃取
+	if(_group->push(_groupIndex, new TC_CoroutineSchedulerGroup::Task(callback)) > 0)
+	{
+		_group->notifyIdle(_groupIndex);
+	}
+
+	return true;
+}
+
+uint32_t TC_CoroutineScheduler::getPostFreeSize()
+{
+	uint32_t freeSize = getFreeSize();
+
+	if(!_group)
+	{
+		return freeSize;
+	}
+
+	size_t pending = _group->getTaskSize(_groupIndex);
+
+	return pending >= freeSize ? 0 : (uint32_t)(freeSize - pending);
+}
+
+bool TC_CoroutineScheduler::goGroupTask(bool bSteal)
+{
+	//还有没开始执行的协程, 先不取新的任务, 留给其他调度器窃取
+	if(!_group || !TC_CoroutineInfo::CoroutineHeadEmpty(&_avail) || full())
+	{
+		return false;
+	}
+
+	TC_CoroutineSchedulerGroup::Task *task = _group->pop(_groupIndex);
+
+	if(task == NULL && bSteal)
+	{
+		task = _group->steal(_groupIndex);
+	}
+
+	if(task == NULL)
+	{
+		return false;
+	}
+
+	uint32_t iRet = go(*task);
+
+	delete task;
+
+	return iRet != 0;
+}
+
+void TC_CoroutineScheduler::waitIdle()
+{
+	if(!_group)
+	{
+		_epoller->done(1000);
+		return;
+	}
+
+	//先设置空闲再窃取, 保证post的调度器要么看到空闲标记来唤醒, 要么这里能取到任务
+	_group->setIdle(_groupIndex, true);
+
+	if(!goGroupTask(true))
+	{
+		_epoller->done(1000);
+	}
+
+	_group->setIdle(_groupIndex, false);
+}
+
 void TC_CoroutineScheduler::notify()
 {
 	assert(_epoller);
@@ -504,7 +798,7 @@ void TC_CoroutineScheduler::run()
 
 		if(activeCoroQueue_empty && TC_CoroutineInfo::CoroutineHeadEmpty(&_avail) && TC_CoroutineInfo::CoroutineHeadEmpty(&_active))
 		{
-			_epoller->done(1000);
+			waitIdle();
 		}
 
 		//唤醒需要激活的协程
@@ -516,6 +810,9 @@ void TC_CoroutineScheduler::run()
 		//唤醒yield的协程
 		wakeupbyself();
 
+		//启动分组队列中的任务
+		goGroupTask(false);
+
 		int iLoop = 100;
 
 		//执行active协程, 每次执行100个, 避免占满cpu
@@ -541,12 +838,17 @@ void TC_CoroutineScheduler::run()
 		}
 
 		//没有任何可执行的写成了, 直接退出!
-		if(_usedSize == 0 && _noCoroutineCallback)
+		if(_usedSize == 0 && _noCoroutineCallback && (!_group || _group->getTaskSize(_groupIndex) == 0))
 		{
 			_noCoroutineCallback(this);
 		}
 	}
 
+	if(_group)
+	{
+		_group->leave(_groupIndex);
+	}
+
 	destroy();
 
 	_ready = false;
@@ -696,6 +998,11 @@ uint32_t TC_CoroutineScheduler::generateId()
 
 void TC_CoroutineScheduler::switchCoro(TC_CoroutineInfo *to)
 {
+	if(to->_sharedIndex >= 0)
+	{
+		switchSharedStack(to);
+	}
+
 	//跳转到to协程
 	_currentCoro = to;
 
@@ -703,6 +1010,12 @@ void TC_CoroutineScheduler::switchCoro(TC_CoroutineInfo *to)
 
 	//并保存协程堆栈
 	to->setCtx(t.fctx);
+
+	//协程执行完了, 回到主协程以后再回收它的栈
+	if(to != &_mainCoro && to->getStatus() == TC_CoroutineInfo::CORO_FREE)
+	{
+		releaseStack(to);
+	}
 }
 
 void TC_CoroutineScheduler::moveToActive(TC_CoroutineInfo *coro)
@@ -786,7 +1099,10 @@ void TC_CoroutineScheduler::destroy()
 		{
 			if(_all_coro[i])
 			{
-				stack_traits::deallocate(_all_coro[i]->getStackContext());
+				if(_all_coro[i]->_sharedIndex < 0 && _all_coro[i]->getStackContext().sp)
+				{
+					stack_traits::deallocate(_all_coro[i]->getStackContext());
+				}
 				delete _all_coro[i];
 				_all_coro[i] = NULL;
 			}
@@ -794,7 +1110,201 @@ void TC_CoroutineScheduler::destroy()
 		delete [] _all_coro;
 		_all_coro = NULL;
 	}
+
+	for(auto &s_ctx : _freeStacks)
+	{
+		stack_traits::deallocate(s_ctx);
+	}
+	_freeStacks.clear();
+
+	for(auto &shared : _sharedStacks)
+	{
+		if(shared.ctx.sp)
+		{
+			stack_traits::deallocate(shared.ctx);
+			shared.ctx = stack_context();
+		}
+		shared.owner = NULL;
+	}
+
+	//最高水位和拷贝次数保留, 调度器结束后仍然可以查看
+	_stackStat.stacks       = 0;
+	_stackStat.savedSize    = 0;
+}
+/////////////////////////////////////////////////////////
+TC_CoroutineSchedulerGroup::TC_CoroutineSchedulerGroup(size_t maxSize)
+{
+	for(size_t i = 0; i < maxSize; i++)
+	{
+		_members.push_back(new Member());
+	}
+}
+
+TC_CoroutineSchedulerGroup::~TC_CoroutineSchedulerGroup()
+{
+	for(size_t i = 0; i < _members.size(); i++)
+	{
+		Task *task;
+		while(_members[i]->deque.pop(task))
+		{
+			delete task;
+		}
+
+		delete _members[i];
+	}
+}
+
+int TC_CoroutineSchedulerGroup::join(TC_CoroutineScheduler *scheduler)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	size_t index = _size;
+	if(index >= _members.size())
+	{
+		return -1;
+	}
+
+	{
+		std::lock_guard<std::mutex> mlock(_members[index]->mutex);
+		_members[index]->scheduler = scheduler;
+	}
+
+	++_size;
+
+	return (int)index;
+}
+
+void TC_CoroutineSchedulerGroup::leave(size_t index)
+{
+	assert(index < _size);
+
+	std::lock_guard<std::mutex> lock(_members[index]->mutex);
+	_members[index]->scheduler = NULL;
+	_members[index]->idle = false;
+}
+
+size_t TC_CoroutineSchedulerGroup::getTaskSize(size_t index) const
+{
+	return _members[index]->deque.size();
+}
+
+uint64_t TC_CoroutineSchedulerGroup::getSteals() const
+{
+	uint64_t steals = 0;
+	for(size_t i = 0; i < _size; i++)
+	{
+		steals += _members[i]->steals;
+	}
+	return steals;
+}
+
+uint64_t TC_CoroutineSchedulerGroup::getSteals(size_t index) const
+{
+	return _members[index]->steals;
+}
+
+uint64_t TC_CoroutineSchedulerGroup::getStolen(size_t index) const
+{
+	return _members[index]->stolen;
+}
+
+uint64_t TC_CoroutineSchedulerGroup::getPosts(size_t index) const
+{
+	return _members[index]->posts;
 }
+
+uint64_t TC_CoroutineSchedulerGroup::getStealFails(size_t index) const
+{
+	return _members[index]->stealFails;
+}
+
+size_t TC_CoroutineSchedulerGroup::push(size_t index, Task *task)
+{
+	Member *m = _members[index];
+
+	size_t n = m->deque.size();
+
+	m->deque.push(task);
+
+	m->posts.fetch_add(1, std::memory_order_relaxed);
+
+	return n;
+}
+
+TC_CoroutineSchedulerGroup::Task *TC_CoroutineSchedulerGroup::pop(size_t index)
+{
+	Task *task = NULL;
+
+	_members[index]->deque.pop(task);
+
+	return task;
+}
+
+TC_CoroutineSchedulerGroup::Task *TC_CoroutineSchedulerGroup::steal(size_t index)
+{
+	size_t n = _size;
+	if(n <= 1)
+	{
+		return NULL;
+	}
+
+	size_t start = _stealPos.fetch_add(1, std::memory_order_relaxed);
+
+	Task *task = NULL;
+
+	for(size_t i = 0; i < n; i++)
+	{
+		size_t victim = (start + i) % n;
+		if(victim == index)
+		{
+			continue;
+		}
+
+		if(_members[victim]->deque.steal(task))
+		{
+			_members[victim]->stolen.fetch_add(1, std::memory_order_relaxed);
+			_members[index]->steals.fetch_add(1, std::memory_order_relaxed);
+			return task;
+		}
+	}
+
+	_members[index]->stealFails.fetch_add(1, std::memory_order_relaxed);
+
+	return NULL;
+}
+
+void TC_CoroutineSchedulerGroup::setIdle(size_t index, bool idle)
+{
+	_members[index]->idle.store(idle, std::memory_order_relaxed);
+
+	//和push之后的notifyIdle配对
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void TC_CoroutineSchedulerGroup::notifyIdle(size_t index)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	size_t n = _size;
+
+	for(size_t i = 1; i < n; i++)
+	{
+		Member *m = _members[(index + i) % n];
+
+		//抢到空闲标记的才唤醒, 同一个空闲调度器只唤醒一次
+		bool idle = true;
+		if(m->idle.load(std::memory_order_relaxed) && m->idle.compare_exchange_strong(idle, false))
+		{
+			std::lock_guard<std::mutex> lock(m->mutex);
+			if(m->scheduler)
+			{
+				m->scheduler->notify();
+				return;
+			}
+		}
+	}
+}
+
 /////////////////////////////////////////////////////////
 TC_Coroutine::TC_Coroutine()
 	: _coroSched(NULL)
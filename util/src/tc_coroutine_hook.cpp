@@ -0,0 +1,905 @@
+﻿/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except 
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed 
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR 
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the 
+ * specific language governing permissions and limitations under the License.
+ */
+#include "util/tc_coroutine_hook.h"
+#include "util/tc_coroutine.h"
+
+#if !TARGET_PLATFORM_WINDOWS
+#include <poll.h>
+#endif
+
+#if TARGET_PLATFORM_LINUX && TARS_CORO_HOOK
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "util/tc_thread_pool.h"
+#endif
+
+namespace tars
+{
+
+static thread_local bool g_hookEnable = true;
+
+void TC_CoroutineHook::setEnable(bool enable)
+{
+	g_hookEnable = enable;
+}
+
+bool TC_CoroutineHook::isEnable()
+{
+	return g_hookEnable;
+}
+
+#if TARGET_PLATFORM_LINUX && TARS_CORO_HOOK
+
+bool TC_CoroutineHook::isHooked()
+{
+	if(!g_hookEnable)
+	{
+		return false;
+	}
+
+	const shared_ptr<TC_CoroutineScheduler> &sched = TC_CoroutineScheduler::scheduler();
+
+	return sched && sched->isInCoroutine();
+}
+
+#else
+
+bool TC_CoroutineHook::isHooked()
+{
+	return false;
+}
+
+int TC_CoroutineHook::wait(int fd, short events, int timeout)
+{
+#if TARGET_PLATFORM_WINDOWS
+	WSAPOLLFD pfd;
+	pfd.fd = fd;
+	pfd.events = events;
+	pfd.revents = 0;
+
+	return WSAPoll(&pfd, 1, timeout);
+#else
+	struct pollfd pfd;
+	pfd.fd = fd;
+	pfd.events = events;
+	pfd.revents = 0;
+
+	return ::poll(&pfd, 1, timeout);
+#endif
+}
+
+#endif
+
+}
+
+#if TARGET_PLATFORM_LINUX && TARS_CORO_HOOK
+
+typedef int (*socket_t)(int domain, int type, int protocol);
+typedef int (*close_t)(int fd);
+typedef int (*fcntl_t)(int fd, int cmd, ...);
+typedef int (*setsockopt_t)(int fd, int level, int optname, const void *optval, socklen_t optlen);
+typedef int (*connect_t)(int fd, const struct sockaddr *addr, socklen_t addrlen);
+typedef ssize_t (*read_t)(int fd, void *buf, size_t count);
+typedef ssize_t (*write_t)(int fd, const void *buf, size_t count);
+typedef ssize_t (*recv_t)(int fd, void *buf, size_t len, int flags);
+typedef ssize_t (*send_t)(int fd, const void *buf, size_t len, int flags);
+typedef ssize_t (*recvfrom_t)(int fd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen);
+typedef ssize_t (*sendto_t)(int fd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen);
+typedef int (*poll_t)(struct pollfd *fds, nfds_t nfds, int timeout);
+typedef int (*epoll_wait_t)(int epfd, struct epoll_event *events, int maxevents, int timeout);
+typedef unsigned int (*sleep_t)(unsigned int seconds);
+typedef int (*usleep_t)(useconds_t usec);
+typedef int (*nanosleep_t)(const struct timespec *req, struct timespec *rem);
+typedef struct hostent *(*gethostbyname_t)(const char *name);
+
+#define HOOK_SYS_FUNC(name) static name##_t g_sys_##name = (name##_t)dlsym(RTLD_NEXT, #name)
+
+HOOK_SYS_FUNC(socket);
+HOOK_SYS_FUNC(close);
+HOOK_SYS_FUNC(fcntl);
+HOOK_SYS_FUNC(setsockopt);
+HOOK_SYS_FUNC(connect);
+HOOK_SYS_FUNC(read);
+HOOK_SYS_FUNC(write);
+HOOK_SYS_FUNC(recv);
+HOOK_SYS_FUNC(send);
+HOOK_SYS_FUNC(recvfrom);
+HOOK_SYS_FUNC(sendto);
+HOOK_SYS_FUNC(poll);
+HOOK_SYS_FUNC(epoll_wait);
+HOOK_SYS_FUNC(sleep);
+HOOK_SYS_FUNC(usleep);
+HOOK_SYS_FUNC(nanosleep);
+HOOK_SYS_FUNC(gethostbyname);
+
+//静态初始化之前就可能被调用(比如其他全局对象的构造函数里)
+#define HOOK_SYS_INIT(name) if(!g_sys_##name) { g_sys_##name = (name##_t)dlsym(RTLD_NEXT, #name); }
+
+namespace tars
+{
+
+/**
+ * 协程中创建的socket的信息, 内部都设置成非阻塞
+ */
+struct HookFdInfo
+{
+	//业务自己是否设置了非阻塞
+	bool	_nonBlock	= false;
+
+	//SO_RCVTIMEO, 毫秒, -1表示不超时
+	int		_recvTimeout	= -1;
+
+	//SO_SNDTIMEO, 毫秒, -1表示不超时
+	int		_sendTimeout	= -1;
+};
+
+static const int HOOK_MAX_FD = 256 * 1024;
+
+//协程在wait中挂起时句柄可能被别的协程close, 用智能指针保证HookFdInfo在使用期间不被释放
+static shared_ptr<HookFdInfo> g_hookFds[HOOK_MAX_FD];
+
+static shared_ptr<HookFdInfo> getHookFdInfo(int fd)
+{
+	if(fd < 0 || fd >= HOOK_MAX_FD)
+	{
+		return NULL;
+	}
+	return std::atomic_load(&g_hookFds[fd]);
+}
+
+static void setHookFdInfo(int fd, const shared_ptr<HookFdInfo> &info)
+{
+	if(fd < 0 || fd >= HOOK_MAX_FD)
+	{
+		return;
+	}
+
+	std::atomic_store(&g_hookFds[fd], info);
+}
+
+/**
+ * wait返回后检查句柄是否已经被close(或者close后fd被复用)
+ */
+static bool isHookFdAlive(int fd, const shared_ptr<HookFdInfo> &info)
+{
+	if(getHookFdInfo(fd) != info)
+	{
+		errno = EBADF;
+		return false;
+	}
+	return true;
+}
+
+static int toTimeout(const struct timeval *tv)
+{
+	if(tv->tv_sec == 0 && tv->tv_usec == 0)
+	{
+		return -1;
+	}
+	return tv->tv_sec * 1000 + tv->tv_usec / 1000;
+}
+
+/**
+ * 在协程中等待多个句柄, 返回后由调用者自己poll出结果
+ * 句柄加入调度器的epoll失败时(例如普通文件, 或者同一个句柄已经被注册过且dup后仍然失败), 不能在协程中等待
+ * @return int, 1: 有事件, 0: 超时, -1: 无法在协程中等待, 调用者需要用系统poll
+ */
+static int waitInCoroutine(struct pollfd *fds, nfds_t nfds, int timeout)
+{
+	HOOK_SYS_INIT(close);
+
+	const shared_ptr<TC_CoroutineScheduler> &sched = TC_CoroutineScheduler::scheduler();
+
+	TC_CoroutineScheduler *pSched = sched.get();
+	TC_Epoller *epoller = sched->getEpoller();
+	uint32_t coroId = sched->getCoroutineId();
+
+	//事件和超时只能唤醒一次
+	struct WaitState
+	{
+		bool _done 		= false;
+		bool _timeout	= false;
+	};
+
+	shared_ptr<WaitState> state = std::make_shared<WaitState>();
+
+	auto wakeup = [pSched, coroId, state](bool timeout)
+	{
+		if(!state->_done)
+		{
+			state->_done = true;
+			state->_timeout = timeout;
+			pSched->put(coroId);
+		}
+	};
+
+	TC_Epoller::EpollInfo::EVENT_CALLBACK callback = [wakeup](const shared_ptr<TC_Epoller::EpollInfo> &) { wakeup(false); return true; };
+
+	map<uint32_t, TC_Epoller::EpollInfo::EVENT_CALLBACK> callbacks;
+	callbacks[EPOLLIN] = callback;
+	callbacks[EPOLLOUT] = callback;
+	callbacks[EPOLLERR] = callback;
+
+	vector<shared_ptr<TC_Epoller::EpollInfo>> infos;
+	infos.reserve(nfds);
+
+	//句柄已经在epoll中时(业务自己注册过, 或者fds中有重复的句柄), dup一个新句柄来等待
+	vector<int> dupFds;
+
+	auto release = [&]()
+	{
+		//先从epoll中删除再close, 否则dup出来的句柄关闭后epoll中仍然残留
+		for(auto &info : infos)
+		{
+			epoller->releaseEpollInfo(info);
+		}
+
+		for(auto fd : dupFds)
+		{
+			g_sys_close(fd);
+		}
+	};
+
+	for(nfds_t i = 0; i < nfds; i++)
+	{
+		//poll忽略负数的句柄
+		if(fds[i].fd < 0)
+		{
+			continue;
+		}
+
+		uint32_t events = EPOLLERR;
+		if(fds[i].events & POLLIN) events |= EPOLLIN;
+		if(fds[i].events & POLLOUT) events |= EPOLLOUT;
+
+		shared_ptr<TC_Epoller::EpollInfo> info = epoller->createEpollInfo(fds[i].fd);
+		info->registerCallback(callbacks, 0);
+
+		//add失败的info不能release, release会把别人注册的句柄从epoll中删掉
+		int ret = info->add(events);
+		if(ret != 0 && errno == EEXIST)
+		{
+			int fd = ::dup(fds[i].fd);
+			if(fd >= 0)
+			{
+				dupFds.push_back(fd);
+
+				info = epoller->createEpollInfo(fd);
+				info->registerCallback(callbacks, 0);
+				ret = info->add(events);
+			}
+		}
+
+		if(ret != 0)
+		{
+			release();
+			return -1;
+		}
+
+		infos.push_back(info);
+	}
+
+	int64_t timerId = 0;
+	if(timeout >= 0)
+	{
+		timerId = epoller->postDelayed(timeout, [wakeup]() { wakeup(true); });
+	}
+
+	sched->yield(false);
+
+	if(timerId != 0)
+	{
+		epoller->erase(timerId);
+	}
+
+	release();
+
+	return state->_timeout ? 0 : 1;
+}
+
+int TC_CoroutineHook::wait(int fd, short events, int timeout)
+{
+	HOOK_SYS_INIT(poll);
+
+	struct pollfd pfd;
+	pfd.fd = fd;
+	pfd.events = events;
+	pfd.revents = 0;
+
+	if(!isHooked())
+	{
+		return g_sys_poll(&pfd, 1, timeout);
+	}
+
+	int ret = waitInCoroutine(&pfd, 1, timeout);
+	if(ret < 0)
+	{
+		return g_sys_poll(&pfd, 1, timeout);
+	}
+
+	return ret;
+}
+
+/**
+ * 阻塞语义的读: 句柄内部是非阻塞的, EAGAIN时等待可读
+ */
+template<typename F>
+static ssize_t hookRead(int fd, F f)
+{
+	shared_ptr<HookFdInfo> info = getHookFdInfo(fd);
+	if(!info || info->_nonBlock)
+	{
+		return f();
+	}
+
+	int timeout = info->_recvTimeout;
+
+	while(true)
+	{
+		ssize_t n = f();
+		if(n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+		{
+			return n;
+		}
+
+		int ret = TC_CoroutineHook::wait(fd, POLLIN, timeout);
+		if(ret == 0)
+		{
+			errno = EAGAIN;
+			return -1;
+		}
+		else if(ret < 0)
+		{
+			return -1;
+		}
+
+		if(!isHookFdAlive(fd, info))
+		{
+			return -1;
+		}
+	}
+}
+
+/**
+ * 阻塞语义的写: 写完所有数据才返回, EAGAIN时等待可写
+ */
+template<typename F>
+static ssize_t hookWrite(int fd, size_t len, F f)
+{
+	shared_ptr<HookFdInfo> info = getHookFdInfo(fd);
+	if(!info || info->_nonBlock)
+	{
+		return f(0);
+	}
+
+	int timeout = info->_sendTimeout;
+
+	size_t sent = 0;
+
+	do
+	{
+		ssize_t n = f(sent);
+		if(n >= 0)
+		{
+			sent += n;
+			continue;
+		}
+
+		if(errno != EAGAIN && errno != EWOULDBLOCK)
+		{
+			return sent > 0 ? (ssize_t)sent : -1;
+		}
+
+		int ret = TC_CoroutineHook::wait(fd, POLLOUT, timeout);
+		if(ret <= 0)
+		{
+			if(sent > 0)
+			{
+				return sent;
+			}
+			if(ret == 0)
+			{
+				errno = EAGAIN;
+			}
+			return -1;
+		}
+
+		if(!isHookFdAlive(fd, info))
+		{
+			return sent > 0 ? (ssize_t)sent : -1;
+		}
+	}
+	while(sent < len);
+
+	return sent;
+}
+
+/**
+ * 阻塞语义的数据报发送: 一次发送一个完整的包, EAGAIN时等待可写后重发
+ */
+template<typename F>
+static ssize_t hookSendPacket(int fd, F f)
+{
+	shared_ptr<HookFdInfo> info = getHookFdInfo(fd);
+	if(!info || info->_nonBlock)
+	{
+		return f();
+	}
+
+	int timeout = info->_sendTimeout;
+
+	while(true)
+	{
+		ssize_t n = f();
+		if(n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+		{
+			return n;
+		}
+
+		int ret = TC_CoroutineHook::wait(fd, POLLOUT, timeout);
+		if(ret == 0)
+		{
+			errno = EAGAIN;
+			return -1;
+		}
+		else if(ret < 0)
+		{
+			return -1;
+		}
+
+		if(!isHookFdAlive(fd, info))
+		{
+			return -1;
+		}
+	}
+}
+
+/**
+ * gethostbyname的结果, 每个协程一份
+ */
+struct HookHostEntry
+{
+	struct hostent		_host;
+	struct hostent		*_result = NULL;
+	vector<char>		_buff;
+	int					_err = 0;
+};
+
+static thread_local unordered_map<uint32_t, shared_ptr<HookHostEntry>> *g_hostEntries = NULL;
+
+static TC_ThreadPool &getHookThreadPool()
+{
+	static TC_ThreadPool *pool = []()
+	{
+		TC_ThreadPool *p = new TC_ThreadPool();
+		p->init(2);
+		p->start();
+		return p;
+	}();
+
+	return *pool;
+}
+
+}
+
+using namespace tars;
+
+extern "C"
+{
+
+int socket(int domain, int type, int protocol)
+{
+	HOOK_SYS_INIT(socket);
+	HOOK_SYS_INIT(fcntl);
+
+	int fd = g_sys_socket(domain, type, protocol);
+
+	if(fd < 0 || !TC_CoroutineHook::isHooked())
+	{
+		return fd;
+	}
+
+	shared_ptr<HookFdInfo> info = std::make_shared<HookFdInfo>();
+	info->_nonBlock = (type & SOCK_NONBLOCK) != 0;
+
+	int flags = g_sys_fcntl(fd, F_GETFL, 0);
+	g_sys_fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+	setHookFdInfo(fd, info);
+
+	return fd;
+}
+
+int close(int fd)
+{
+	HOOK_SYS_INIT(close);
+
+	if(getHookFdInfo(fd))
+	{
+		setHookFdInfo(fd, shared_ptr<HookFdInfo>());
+	}
+
+	return g_sys_close(fd);
+}
+
+int fcntl(int fd, int cmd, ...)
+{
+	HOOK_SYS_INIT(fcntl);
+
+	va_list args;
+	va_start(args, cmd);
+
+	int ret = -1;
+
+	switch(cmd)
+	{
+		//不带参数
+		case F_GETFD:
+		case F_GETOWN:
+		case F_GETSIG:
+		case F_GETLEASE:
+		case F_GETPIPE_SZ:
+			ret = g_sys_fcntl(fd, cmd);
+			break;
+		case F_GETFL:
+		{
+			ret = g_sys_fcntl(fd, cmd);
+			shared_ptr<HookFdInfo> info = getHookFdInfo(fd);
+			if(ret != -1 && info && !info->_nonBlock)
+			{
+				ret &= ~O_NONBLOCK;
+			}
+			break;
+		}
+		case F_SETFL:
+		{
+			int flags = va_arg(args, int);
+			shared_ptr<HookFdInfo> info = getHookFdInfo(fd);
+			if(info)
+			{
+				info->_nonBlock = (flags & O_NONBLOCK) != 0;
+				flags |= O_NONBLOCK;
+			}
+			ret = g_sys_fcntl(fd, cmd, flags);
+			break;
+		}
+		//指针参数
+		case F_GETLK:
+		case F_SETLK:
+		case F_SETLKW:
+		case F_OFD_GETLK:
+		case F_OFD_SETLK:
+		case F_OFD_SETLKW:
+		case F_GETOWN_EX:
+		case F_SETOWN_EX:
+		{
+			void *arg = va_arg(args, void*);
+			ret = g_sys_fcntl(fd, cmd, arg);
+			break;
+		}
+		//int参数
+		default:
+		{
+			int arg = va_arg(args, int);
+			ret = g_sys_fcntl(fd, cmd, arg);
+			break;
+		}
+	}
+
+	va_end(args);
+
+	return ret;
+}
+
+int setsockopt(int fd, int level, int optname, const void *optval, socklen_t optlen)
+{
+	HOOK_SYS_INIT(setsockopt);
+
+	shared_ptr<HookFdInfo> info = getHookFdInfo(fd);
+	if(info && level == SOL_SOCKET && optval && optlen >= (socklen_t)sizeof(struct timeval))
+	{
+		if(optname == SO_RCVTIMEO)
+		{
+			info->_recvTimeout = toTimeout((const struct timeval*)optval);
+		}
+		else if(optname == SO_SNDTIMEO)
+		{
+			info->_sendTimeout = toTimeout((const struct timeval*)optval);
+		}
+	}
+
+	return g_sys_setsockopt(fd, level, optname, optval, optlen);
+}
+
+int connect(int fd, const struct sockaddr *addr, socklen_t addrlen)
+{
+	HOOK_SYS_INIT(connect);
+
+	int ret = g_sys_connect(fd, addr, addrlen);
+
+	shared_ptr<HookFdInfo> info = getHookFdInfo(fd);
+	if(!info || info->_nonBlock || ret == 0 || errno != EINPROGRESS)
+	{
+		return ret;
+	}
+
+	ret = TC_CoroutineHook::wait(fd, POLLOUT, info->_sendTimeout);
+	if(ret == 0)
+	{
+		errno = ETIMEDOUT;
+		return -1;
+	}
+	else if(ret < 0)
+	{
+		return -1;
+	}
+
+	int err = 0;
+	socklen_t len = sizeof(err);
+	if(getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+	{
+		return -1;
+	}
+
+	if(err != 0)
+	{
+		errno = err;
+		return -1;
+	}
+
+	return 0;
+}
+
+ssize_t read(int fd, void *buf, size_t count)
+{
+	HOOK_SYS_INIT(read);
+
+	return hookRead(fd, [&]() { return g_sys_read(fd, buf, count); });
+}
+
+ssize_t write(int fd, const void *buf, size_t count)
+{
+	HOOK_SYS_INIT(write);
+
+	return hookWrite(fd, count, [&](size_t offset) { return g_sys_write(fd, (const char*)buf + offset, count - offset); });
+}
+
+ssize_t recv(int fd, void *buf, size_t len, int flags)
+{
+	HOOK_SYS_INIT(recv);
+
+	return hookRead(fd, [&]() { return g_sys_recv(fd, buf, len, flags); });
+}
+
+ssize_t send(int fd, const void *buf, size_t len, int flags)
+{
+	HOOK_SYS_INIT(send);
+
+	return hookWrite(fd, len, [&](size_t offset) { return g_sys_send(fd, (const char*)buf + offset, len - offset, flags); });
+}
+
+ssize_t recvfrom(int fd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen)
+{
+	HOOK_SYS_INIT(recvfrom);
+
+	return hookRead(fd, [&]() { return g_sys_recvfrom(fd, buf, len, flags, src_addr, addrlen); });
+}
+
+ssize_t sendto(int fd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen)
+{
+	HOOK_SYS_INIT(sendto);
+
+	//udp一次发送一个包, 不拆分
+	return hookSendPacket(fd, [&]() { return g_sys_sendto(fd, buf, len, flags, dest_addr, addrlen); });
+}
+
+int poll(struct pollfd *fds, nfds_t nfds, int timeout)
+{
+	HOOK_SYS_INIT(poll);
+
+	if(timeout == 0 || nfds == 0 || !TC_CoroutineHook::isHooked())
+	{
+		return g_sys_poll(fds, nfds, timeout);
+	}
+
+	int ret = g_sys_poll(fds, nfds, 0);
+	if(ret != 0)
+	{
+		return ret;
+	}
+
+	int64_t deadline = timeout > 0 ? TNOWMS + timeout : 0;
+
+	while(true)
+	{
+		int left = -1;
+		if(timeout > 0)
+		{
+			left = (int)(deadline - TNOWMS);
+			if(left <= 0)
+			{
+				return 0;
+			}
+		}
+
+		int w = waitInCoroutine(fds, nfds, left);
+		if(w == 0)
+		{
+			return 0;
+		}
+		else if(w < 0)
+		{
+			//句柄无法加入协程的epoll, 只能阻塞在系统poll上
+			return g_sys_poll(fds, nfds, left);
+		}
+
+		ret = g_sys_poll(fds, nfds, 0);
+		if(ret != 0)
+		{
+			return ret;
+		}
+	}
+}
+
+int epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout)
+{
+	HOOK_SYS_INIT(epoll_wait);
+
+	//调度器自己的epoll_wait在主协程中, 不会被hook
+	if(timeout == 0 || !TC_CoroutineHook::isHooked())
+	{
+		return g_sys_epoll_wait(epfd, events, maxevents, timeout);
+	}
+
+	//epoll句柄本身可以被监听, 有事件时可读(例如TC_TCPClient内部的TC_Epoller)
+	int ret = g_sys_epoll_wait(epfd, events, maxevents, 0);
+	if(ret != 0)
+	{
+		return ret;
+	}
+
+	int64_t deadline = timeout > 0 ? TNOWMS + timeout : 0;
+
+	while(true)
+	{
+		int left = -1;
+		if(timeout > 0)
+		{
+			left = (int)(deadline - TNOWMS);
+			if(left <= 0)
+			{
+				return 0;
+			}
+		}
+
+		if(TC_CoroutineHook::wait(epfd, POLLIN, left) <= 0)
+		{
+			return 0;
+		}
+
+		ret = g_sys_epoll_wait(epfd, events, maxevents, 0);
+		if(ret != 0)
+		{
+			return ret;
+		}
+	}
+}
+
+unsigned int sleep(unsigned int seconds)
+{
+	HOOK_SYS_INIT(sleep);
+
+	if(!TC_CoroutineHook::isHooked())
+	{
+		return g_sys_sleep(seconds);
+	}
+
+	TC_CoroutineScheduler::scheduler()->sleep(seconds * 1000);
+
+	return 0;
+}
+
+int usleep(useconds_t usec)
+{
+	HOOK_SYS_INIT(usleep);
+
+	if(!TC_CoroutineHook::isHooked())
+	{
+		return g_sys_usleep(usec);
+	}
+
+	TC_CoroutineScheduler::scheduler()->sleep((usec + 999) / 1000);
+
+	return 0;
+}
+
+int nanosleep(const struct timespec *req, struct timespec *rem)
+{
+	HOOK_SYS_INIT(nanosleep);
+
+	if(!req || !TC_CoroutineHook::isHooked())
+	{
+		return g_sys_nanosleep(req, rem);
+	}
+
+	TC_CoroutineScheduler::scheduler()->sleep(req->tv_sec * 1000 + (req->tv_nsec + 999999) / 1000000);
+
+	if(rem)
+	{
+		rem->tv_sec = 0;
+		rem->tv_nsec = 0;
+	}
+
+	return 0;
+}
+
+struct hostent *gethostbyname(const char *name)
+{
+	HOOK_SYS_INIT(gethostbyname);
+
+	if(!name || !TC_CoroutineHook::isHooked())
+	{
+		return g_sys_gethostbyname(name);
+	}
+
+	const shared_ptr<TC_CoroutineScheduler> &sched = TC_CoroutineScheduler::scheduler();
+
+	uint32_t coroId = sched->getCoroutineId();
+
+	if(!g_hostEntries)
+	{
+		g_hostEntries = new unordered_map<uint32_t, shared_ptr<HookHostEntry>>();
+	}
+
+	//上一次返回的结果在同一个协程下一次调用前有效
+	shared_ptr<HookHostEntry> entry = std::make_shared<HookHostEntry>();
+	(*g_hostEntries)[coroId] = entry;
+
+	string host = name;
+	shared_ptr<TC_CoroutineScheduler> s = sched;
+
+	//dns查询放到后台线程, 完成后唤醒协程(put在yield之前也没关系, 要等主协程才会处理)
+	getHookThreadPool().exec([entry, host, s, coroId]()
+	{
+		entry->_buff.resize(8192);
+
+		while(gethostbyname_r(host.c_str(), &entry->_host, entry->_buff.data(), entry->_buff.size(), &entry->_result, &entry->_err) == ERANGE)
+		{
+			entry->_buff.resize(entry->_buff.size() * 2);
+		}
+
+		s->put(coroId);
+	});
+
+	sched->yield(false);
+
+	if(!entry->_result)
+	{
+		h_errno = entry->_err;
+	}
+
+	return entry->_result;
+}
+
+}
+
+#endif
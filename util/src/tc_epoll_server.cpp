@@ -32,6 +32,9 @@
 namespace tars
 {
 
+//当前线程的handle(NET_THREAD_QUEUE_HANDLES_CO), 窃取来的请求由窃取方的handle处理
+static thread_local TC_EpollServer::Handle *g_coroHandle = NULL;
+
 void TC_EpollServer::RecvContext::parseIpPort() const
 {
     if (_ip.empty())
@@ -69,6 +72,45 @@ const shared_ptr<TC_EpollServer::DataBuffer::DataQueue> &TC_EpollServer::DataBuf
     return _threadDataQueue[0];
 }
 
+void TC_EpollServer::DataBuffer::enableLockFreeQueue(size_t capacity)
+{
+    //合并模式下网络线程自己消费, 队列满了会死等
+    if(_epollServer->getOpenCoroutine() == TC_EpollServer::NET_THREAD_MERGE_HANDLES_THREAD || _epollServer->getOpenCoroutine() == TC_EpollServer::NET_THREAD_MERGE_HANDLES_CO)
+    {
+        return;
+    }
+
+    for(size_t i = 0; i < _threadDataQueue.size(); i++)
+    {
+        assert(_threadDataQueue[i]->size() == 0);
+
+        _threadDataQueue[i] = std::make_shared<DataQueue>(capacity);
+
+        //handle在协程调度器中等待, 不在队列上, 队列满时需要唤醒调度器取数据
+        _threadDataQueue[i]->setFullFunctor([this, i]{
+            for(size_t j = 0; j < _schedulers.size(); j++)
+            {
+                if(_schedulers[j] != NULL && (!isQueueMode() || index(j) == i))
+                {
+                    _schedulers[j]->notify();
+                }
+            }
+        });
+    }
+}
+
+void TC_EpollServer::DataBuffer::enableCoroutineSteal(bool enable)
+{
+    if(enable)
+    {
+        _schedulerGroup = std::make_shared<TC_CoroutineSchedulerGroup>(_schedulers.size());
+    }
+    else
+    {
+        _schedulerGroup.reset();
+    }
+}
+
 void TC_EpollServer::DataBuffer::notifyBuffer(uint32_t handleIndex)
 {
     getDataQueue(handleIndex)->notify();
@@ -262,7 +304,8 @@ void TC_EpollServer::Handle::handleOnceCoroutine()
 
         while ((loop--) > 0 && !_epollServer->isTerminate())
         {
-            if ((scheduler->getFreeSize() > 0) && _dataBuffer->pop(_handleIndex, data))
+            //有分组时post不占用协程, 要扣掉窃取队列中的积压, 避免一个handle把共享队列的请求都取到自己的队列中
+            if ((scheduler->getPostFreeSize() > 0) && _dataBuffer->pop(_handleIndex, data))
             {
                 bYield = true;
 
@@ -287,6 +330,28 @@ void TC_EpollServer::Handle::handleOnceCoroutine()
                     //数据在队列中已经超时了
                     handleTimeout(data);
                 }
+                else if (scheduler->getGroup())
+                {
+                    //先放到窃取队列, 可能被空闲的handle窃取走, 由窃取方的handle处理
+                    uint64_t queueTimeout = (uint64_t)_bindAdapter->getQueueTimeout();
+                    bool bPost = scheduler->post([data, queueTimeout]()
+                    {
+                        //在窃取队列中等待的时间也算在队列超时里
+                        if ((TNOWMS - data->recvTimeStamp()) > queueTimeout)
+                        {
+                            g_coroHandle->handleTimeout(data);
+                        }
+                        else
+                        {
+                            g_coroHandle->handle(data);
+                        }
+                    });
+
+                    if (!bPost)
+                    {
+                        handleOverload(data);
+                    }
+                }
                 else
                 {
                     uint32_t iRet = scheduler->go(std::bind(&Handle::handle, this, data));
@@ -459,6 +524,14 @@ void TC_EpollServer::Handle::handleLoopCoroutine()
     _scheduler->setPoolStackSize(this->_epollServer->getCoroutinePoolSize(), this->_epollServer->getCoroutineStackSize());
     _scheduler->getEpoller()->setName("epoller-handle");
 
+    //共享队列时, 同一个adapter的handle之间可以窃取还没有开始处理的请求
+    if(_dataBuffer->getSchedulerGroup() && !_dataBuffer->isQueueMode())
+    {
+        _scheduler->setGroup(_dataBuffer->getSchedulerGroup());
+    }
+
+    g_coroHandle = this;
+
     _dataBuffer->registerScheduler(_handleIndex, _scheduler);
 
     initialize();
@@ -748,6 +821,30 @@ return NULL;
 
 void TC_EpollServer::Connection::onRequestCallback(TC_Transceiver *trans)
 {
+    if(_messages.size() > 1 && isTcp())
+    {
+        //多个包合并成一次writev发送
+        vector<shared_ptr<TC_NetWorkBuffer::Buffer>> buffs;
+        buffs.reserve(_messages.size());
+
+        for(auto &sc : _messages)
+        {
+            buffs.push_back(sc->buffer());
+        }
+
+        TC_Transceiver::ReturnStatus iRet = _trans->sendRequests(buffs, _messages.front()->getRecvContext()->addr());
+
+        if (iRet == TC_Transceiver::eRetError || iRet == TC_Transceiver::eRetNotSend)
+        {
+            return;
+        }
+
+        //数据都已经交给发送buffer了
+        _messageSize = 0;
+        _messages.clear();
+        return;
+    }
+
     while(!_messages.empty())
     {
         auto it = _messages.begin();
@@ -804,6 +901,27 @@ TC_NetWorkBuffer::PACKET_TYPE TC_EpollServer::Connection::onParserCallback(TC_Ne
 
     rbuf.setConnection(this);
 
+    if (_pBindAdapter->getSliceProtocol())
+    {
+        //包直接引用接收buffer, 不copy
+        TC_NetWorkBuffer::Slice slice;
+
+        TC_NetWorkBuffer::PACKET_TYPE ret = _pBindAdapter->getSliceProtocol()(rbuf, slice);
+
+        if (ret == TC_NetWorkBuffer::PACKET_FULL)
+        {
+            auto recv = std::make_shared<RecvContext>(_netThread->getIndex(), getId(), trans->getClientAddr(), getfd(), _pBindAdapter->shared_from_this());
+
+            recv->slice() = std::move(slice);
+
+            this->_bEmptyConn = false;
+
+            _recv.push_back(recv);
+        }
+
+        return ret;
+    }
+
     vector<char> ro;
 
     TC_NetWorkBuffer::PACKET_TYPE ret = _pBindAdapter->getProtocol()(rbuf, ro);
@@ -814,6 +932,9 @@ TC_NetWorkBuffer::PACKET_TYPE TC_EpollServer::Connection::onParserCallback(TC_Ne
 
         recv->buffer().swap(ro);
 
+        //parseHttp的解析结果跟着请求到业务线程
+        recv->httpParser() = rbuf.takeHttpParser();
+
         //收到完整的包才算
         this->_bEmptyConn = false;
 
@@ -1036,6 +1157,56 @@ int TC_EpollServer::Connection::send(const shared_ptr<SendContext> &sc)
     return 0;
 }
 
+bool TC_EpollServer::Connection::appendSend(const shared_ptr<SendContext> &sc)
+{
+    assert(sc);
+
+    _pBindAdapter->increaseSendBufferSize();
+
+    const shared_ptr<TC_NetWorkBuffer::Buffer>& buff = sc->buffer();
+
+    if(!buff->empty())
+    {
+        _messageSize += buff->length();
+
+        _messages.push_back(sc);
+    }
+
+    auto cl = _connList.lock();
+    if(cl)
+    {
+        cl->refresh(getId(), getTimeout() + TNOW);
+    }
+
+    if(_pendingFlush)
+    {
+        return false;
+    }
+
+    _pendingFlush = true;
+
+    return true;
+}
+
+int TC_EpollServer::Connection::flushSend()
+{
+    _pendingFlush = false;
+
+    //发送buffer还有数据, 等EPOLLOUT事件再发送
+    if(_trans->getSendBuffer().empty())
+    {
+        onRequestCallback(_trans.get());
+    }
+
+    //网络句柄无效了, 返回-1, 上层会关闭连接
+    if(!_trans->isValid())
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
 void TC_EpollServer::Connection::setUdpRecvBuffer(size_t nSize)
 {
     _trans->setUdpRecvBuffer(nSize);
@@ -1639,11 +1810,18 @@ void TC_EpollServer::BindAdapter::setProtocol(const TC_NetWorkBuffer::protocol_f
 {
     _pf = pf;
 
+    _spf = nullptr;
+
     _hf = hf;
 
     _iHeaderLen = iHeaderLen;
 }
 
+void TC_EpollServer::BindAdapter::setSliceProtocol(const TC_NetWorkBuffer::slice_protocol_functor &spf)
+{
+    _spf = spf;
+}
+
 //////////////////////////////NetThread//////////////////////////////////
 TC_EpollServer::NetThread::NetThread(int threadIndex, TC_EpollServer *epollServer)
         : _epoller(NULL)
@@ -1764,7 +1942,22 @@ void TC_EpollServer::NetThread::send(const shared_ptr<TC_EpollServer::SendContex
 
         if (cPtr)
         {
-            cPtr->send(data);
+            if (cPtr->isTcp())
+            {
+                //先放到连接的队列中, 本轮处理完后在processPipe中聚合发送
+                if (cPtr->appendSend(data))
+                {
+                    if (_flushUids.empty())
+                    {
+                        notify();
+                    }
+                    _flushUids.push_back(data->uid());
+                }
+            }
+            else
+            {
+                cPtr->send(data);
+            }
         }
     }
     else
@@ -1780,6 +1973,21 @@ void TC_EpollServer::NetThread::processPipe()
 {
     // LOG_CONSOLE("processPipe");
 
+    //同一个连接的多个回包先放到连接的队列中, 最后一起聚合发送(tcp时一次writev)
+    auto flush = [&]()
+    {
+        for (auto uid : _flushUids)
+        {
+            Connection *cPtr = getConnectionPtr(uid);
+
+            if (cPtr && cPtr->flushSend() < 0)
+            {
+                delConnection(cPtr, true, EM_CLIENT_CLOSE);
+            }
+        }
+        _flushUids.clear();
+    };
+
     while (!_sbuffer.empty())
     {
         shared_ptr<SendContext> sc = _sbuffer.front();
@@ -1797,6 +2005,15 @@ void TC_EpollServer::NetThread::processPipe()
         {
             case 'c':
             {
+                //关闭前先把之前的回包发出去
+                flush();
+
+                cPtr = getConnectionPtr(sc->uid());
+                if (!cPtr)
+                {
+                    break;
+                }
+
                 if (cPtr->setClose())
                 {
                     delConnection(cPtr, true, EM_SERVER_CLOSE);
@@ -1805,6 +2022,15 @@ void TC_EpollServer::NetThread::processPipe()
             }
             case 's':
             {
+                if (cPtr->isTcp())
+                {
+                    if (cPtr->appendSend(sc))
+                    {
+                        _flushUids.push_back(sc->uid());
+                    }
+                    break;
+                }
+
                 int ret = cPtr->send(sc);
                 if (ret < 0)
                 {
@@ -1816,6 +2042,8 @@ void TC_EpollServer::NetThread::processPipe()
                 assert(false);
         }
     }
+
+    flush();
 }
 
 void TC_EpollServer::NetThread::setInitializeHandle(std::function<void()> initialize, std::function<void()> handle)
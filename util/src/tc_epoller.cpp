@@ -2,6 +2,7 @@
 #include "util/tc_timeprovider.h"
 #include "util/tc_logger.h"
 #include <algorithm>
+#include <atomic>
 
 #if TARGET_PLATFORM_WINDOWS
 #include "util/sys/epoll.h"
@@ -9,10 +10,433 @@
 #include <unistd.h>
 #endif
 
+#if TARGET_PLATFORM_LINUX && TARS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <signal.h>
+#include <poll.h>
+#include <endian.h>
+#endif
+
 
 namespace tars
 {
 
+#if TARGET_PLATFORM_LINUX && TARS_IO_URING
+
+/**
+ * 基于io_uring的poll后端(直接使用系统调用, 不依赖liburing)
+ * 1 每个fd的add/mod/del只是写入提交队列, 不产生系统调用, 在wait时和等待完成事件合并成一次io_uring_enter
+ * 2 ET模式下使用multishot poll, 一次提交持续触发; 非ET模式使用oneshot poll, 每次触发后重新提交, 以模拟水平触发
+ * 3 user_data = (generation << 32) | fd, mod/del后generation变化, 旧的完成事件会被丢弃
+ * 4 其他线程(例如notify)调用ctrl时, 如果epoll线程正阻塞在wait中, 则由调用线程直接提交, 避免事件延迟
+ */
+class TC_IoUringPoller
+{
+public:
+	~TC_IoUringPoller()
+	{
+		if(_sqes) ::munmap(_sqes, _sqesSize);
+		if(_ringPtr) ::munmap(_ringPtr, _ringSize);
+		if(_ringFd >= 0) ::close(_ringFd);
+	}
+
+	/**
+	 * 初始化, 内核不支持所需特性时返回false
+	 */
+	bool init(unsigned entries, bool et)
+	{
+		_et = et;
+
+		struct io_uring_params p;
+		memset(&p, 0, sizeof(p));
+
+		_ringFd = (int)syscall(__NR_io_uring_setup, entries, &p);
+		if(_ringFd < 0)
+		{
+			return false;
+		}
+
+		//EXT_ARG(5.11)用于带超时的等待, RSRC_TAGS(5.13)之后的内核才支持multishot poll
+		uint32_t need = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG | IORING_FEAT_RSRC_TAGS;
+		if((p.features & need) != need)
+		{
+			return false;
+		}
+
+		size_t sqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+		size_t cqSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+		_ringSize = std::max(sqSize, cqSize);
+
+		_ringPtr = ::mmap(0, _ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+		if(_ringPtr == MAP_FAILED)
+		{
+			_ringPtr = NULL;
+			return false;
+		}
+
+		_sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+		_sqes = (struct io_uring_sqe*)::mmap(0, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES);
+		if(_sqes == MAP_FAILED)
+		{
+			_sqes = NULL;
+			return false;
+		}
+
+		char *ring  = (char*)_ringPtr;
+		_sqHead     = (unsigned*)(ring + p.sq_off.head);
+		_sqTail     = (unsigned*)(ring + p.sq_off.tail);
+		_sqMask     = *(unsigned*)(ring + p.sq_off.ring_mask);
+		_sqEntries  = *(unsigned*)(ring + p.sq_off.ring_entries);
+		_sqArray    = (unsigned*)(ring + p.sq_off.array);
+
+		_cqHead     = (unsigned*)(ring + p.cq_off.head);
+		_cqTail     = (unsigned*)(ring + p.cq_off.tail);
+		_cqMask     = *(unsigned*)(ring + p.cq_off.ring_mask);
+		_cqes       = (struct io_uring_cqe*)(ring + p.cq_off.cqes);
+
+		return true;
+	}
+
+	/**
+	 * 模拟epoll_ctl, 只写入提交队列
+	 */
+	int ctrl(int fd, uint64_t data, uint32_t events, int op)
+	{
+		if(fd < 0)
+		{
+			return -1;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if((size_t)fd >= _fds.size())
+		{
+			_fds.resize(fd + 1024);
+		}
+
+		FdInfo &info = _fds[fd];
+
+		if(info.armed)
+		{
+			//mod/del/重复add: 先撤销旧的poll
+			prepRemove(userData(fd, info.gen));
+			info.armed = false;
+		}
+
+		++info.gen;
+
+		if(op == EPOLL_CTL_DEL)
+		{
+			return 0;
+		}
+
+		info.data   = data;
+		info.events = events;
+		info.armed  = true;
+
+		prepPoll(fd, info);
+
+		if(_waiting)
+		{
+			submit();
+		}
+
+		return 0;
+	}
+
+	/**
+	 * 提交并等待, 结果以epoll_event的形式写入evs
+	 */
+	int wait(epoll_event *evs, int maxevents, int millsecond)
+	{
+		unsigned toSubmit;
+		unsigned minComplete;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			toSubmit = _pending;
+			_pending = 0;
+
+			//完成队列里还有没取完的事件, 不需要等待
+			bool hasReady = (__atomic_load_n(_cqTail, __ATOMIC_ACQUIRE) != *_cqHead);
+
+			minComplete = (millsecond == 0 || hasReady) ? 0 : 1;
+
+			_waiting = (minComplete > 0);
+		}
+
+		int ret = 0;
+
+		if(toSubmit > 0 || minComplete > 0)
+		{
+			struct __kernel_timespec ts;
+			struct io_uring_getevents_arg arg;
+			memset(&arg, 0, sizeof(arg));
+			arg.sigmask_sz = _NSIG / 8;
+
+			if(millsecond > 0)
+			{
+				ts.tv_sec   = millsecond / 1000;
+				ts.tv_nsec  = (millsecond % 1000) * 1000 * 1000;
+				arg.ts      = (uint64_t)&ts;
+			}
+
+			unsigned flags = IORING_ENTER_EXT_ARG;
+			if(minComplete > 0)
+			{
+				flags |= IORING_ENTER_GETEVENTS;
+			}
+
+			ret = (int)syscall(__NR_io_uring_enter, _ringFd, toSubmit, minComplete, flags, &arg, sizeof(arg));
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_waiting = false;
+
+		if(ret >= 0)
+		{
+			//没有提交完的留到下次
+			_pending += toSubmit - std::min((unsigned)ret, toSubmit);
+		}
+		else if(errno == ETIME || errno == EINTR || errno == EBUSY)
+		{
+			_pending += toSubmit;
+		}
+		else
+		{
+			_pending += toSubmit;
+			return -1;
+		}
+
+		return reap(evs, maxevents);
+	}
+
+protected:
+	struct FdInfo
+	{
+		uint64_t data   = 0;
+		uint32_t events = 0;
+		uint32_t gen    = 0;
+		bool     armed  = false;
+	};
+
+	static const uint64_t REMOVE_USER_DATA = (uint64_t)-1;
+
+	static inline uint64_t userData(int fd, uint32_t gen) { return ((uint64_t)gen << 32) | (uint32_t)fd; }
+
+	int reap(epoll_event *evs, int maxevents)
+	{
+		int num = 0;
+
+		unsigned head = *_cqHead;
+		unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+
+		while(head != tail && num < maxevents)
+		{
+			struct io_uring_cqe *cqe = &_cqes[head & _cqMask];
+			++head;
+
+			if(cqe->user_data == REMOVE_USER_DATA)
+			{
+				continue;
+			}
+
+			int fd          = (int)(uint32_t)cqe->user_data;
+			uint32_t gen    = (uint32_t)(cqe->user_data >> 32);
+
+			if((size_t)fd >= _fds.size())
+			{
+				continue;
+			}
+
+			FdInfo &info = _fds[fd];
+
+			//已经被mod/del过的旧poll
+			if(!info.armed || info.gen != gen)
+			{
+				continue;
+			}
+
+			bool more = (cqe->flags & IORING_CQE_F_MORE);
+
+			if(cqe->res == -ECANCELED)
+			{
+				continue;
+			}
+
+			if(cqe->res == -EINVAL && _multishot && _et)
+			{
+				//内核不支持multishot poll, 回退为oneshot
+				_multishot = false;
+				prepPoll(fd, info);
+				continue;
+			}
+
+			evs[num].events     = cqe->res < 0 ? (EPOLLERR | EPOLLHUP) : (uint32_t)cqe->res;
+			evs[num].data.u64   = info.data;
+			++num;
+
+			//poll已经结束(oneshot或multishot被内核终止), 重新提交
+			if(!more && cqe->res >= 0)
+			{
+				prepPoll(fd, info);
+			}
+		}
+
+		__atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+
+		return num;
+	}
+
+	void submit()
+	{
+		if(_pending > 0)
+		{
+			int ret = (int)syscall(__NR_io_uring_enter, _ringFd, _pending, 0, 0, NULL, 0);
+			if(ret > 0)
+			{
+				_pending -= std::min((unsigned)ret, _pending);
+			}
+		}
+	}
+
+	struct io_uring_sqe *getSqe()
+	{
+		unsigned head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+
+		if(_sqLocalTail - head >= _sqEntries)
+		{
+			//提交队列满了, 先提交掉
+			submit();
+
+			head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+			if(_sqLocalTail - head >= _sqEntries)
+			{
+				return NULL;
+			}
+		}
+
+		unsigned idx = _sqLocalTail & _sqMask;
+		struct io_uring_sqe *sqe = &_sqes[idx];
+		memset(sqe, 0, sizeof(*sqe));
+
+		_sqArray[idx] = idx;
+		++_sqLocalTail;
+
+		return sqe;
+	}
+
+	void commit()
+	{
+		__atomic_store_n(_sqTail, _sqLocalTail, __ATOMIC_RELEASE);
+		++_pending;
+	}
+
+	void prepPoll(int fd, const FdInfo &info)
+	{
+		struct io_uring_sqe *sqe = getSqe();
+		if(!sqe)
+		{
+			return;
+		}
+
+		uint32_t events = info.events & (EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP | EPOLLRDHUP | EPOLLPRI);
+
+		sqe->opcode         = IORING_OP_POLL_ADD;
+		sqe->fd             = fd;
+#if __BYTE_ORDER == __BIG_ENDIAN
+		events = (events << 16) | (events >> 16);
+#endif
+		sqe->poll32_events  = events;
+		sqe->len            = (_et && _multishot) ? IORING_POLL_ADD_MULTI : 0;
+		sqe->user_data      = userData(fd, info.gen);
+
+		commit();
+	}
+
+	void prepRemove(uint64_t target)
+	{
+		struct io_uring_sqe *sqe = getSqe();
+		if(!sqe)
+		{
+			return;
+		}
+
+		sqe->opcode     = IORING_OP_POLL_REMOVE;
+		sqe->fd         = -1;
+		sqe->addr       = target;
+		sqe->user_data  = REMOVE_USER_DATA;
+
+		commit();
+	}
+
+protected:
+	int         _ringFd     = -1;
+	bool        _et         = true;
+	bool        _multishot  = true;
+
+	void*       _ringPtr    = NULL;
+	size_t      _ringSize   = 0;
+	struct io_uring_sqe *_sqes = NULL;
+	size_t      _sqesSize   = 0;
+
+	unsigned*   _sqHead     = NULL;
+	unsigned*   _sqTail     = NULL;
+	unsigned    _sqMask     = 0;
+	unsigned    _sqEntries  = 0;
+	unsigned*   _sqArray    = NULL;
+	unsigned    _sqLocalTail= 0;
+	unsigned    _pending    = 0;
+	bool        _waiting    = false;
+
+	unsigned*   _cqHead     = NULL;
+	unsigned*   _cqTail     = NULL;
+	unsigned    _cqMask     = 0;
+	struct io_uring_cqe *_cqes = NULL;
+
+	vector<FdInfo> _fds;
+
+	std::mutex  _mutex;
+};
+
+#endif
+
+static std::atomic<int> g_defaultBackend(TC_Epoller::EB_EPOLL);
+
+void TC_Epoller::setDefaultBackend(EPOLLER_BACKEND backend)
+{
+	g_defaultBackend = backend;
+}
+
+TC_Epoller::EPOLLER_BACKEND TC_Epoller::getDefaultBackend()
+{
+	return (EPOLLER_BACKEND)g_defaultBackend.load();
+}
+
+bool TC_Epoller::isIoUringSupported()
+{
+#if TARGET_PLATFORM_LINUX && TARS_IO_URING
+	TC_IoUringPoller uring;
+	return uring.init(4, true);
+#else
+	return false;
+#endif
+}
+
+string TC_Epoller::backendName(EPOLLER_BACKEND backend)
+{
+	return backend == EB_IO_URING ? "io_uring" : "epoll";
+}
+
+TC_Epoller::EPOLLER_BACKEND TC_Epoller::backendFromName(const string &name)
+{
+	return (name == "io_uring" || name == "iouring") ? EB_IO_URING : EB_EPOLL;
+}
+
+
 TC_Epoller::NotifyInfo::~NotifyInfo()
 {
 	if(_epollInfo && _epoller)
@@ -138,12 +562,13 @@ void TC_Epoller::EpollInfo::release()
 	}
 }
 
-void TC_Epoller::EpollInfo::add(uint32_t events)
+int TC_Epoller::EpollInfo::add(uint32_t events)
 {
 	if(valid())
 	{
-		_epoller->add(_fd, data(), events);
+		return _epoller->add(_fd, data(), events);
 	}
+	return -1;
 }
 
 void TC_Epoller::EpollInfo::mod(uint32_t events)
@@ -174,7 +599,7 @@ TC_Epoller::TC_Epoller()
 #endif
 	_pevs     = nullptr;
 	_max_connections = 1024;
-
+	_backend  = getDefaultBackend();
 }
 
 TC_Epoller::~TC_Epoller()
@@ -195,6 +620,14 @@ TC_Epoller::~TC_Epoller()
 
 	_idleCallbacks.clear();
 
+#if TARGET_PLATFORM_LINUX && TARS_IO_URING
+	if(_uring != nullptr)
+	{
+		delete _uring;
+		_uring = nullptr;
+	}
+#endif
+
 #if TARGET_PLATFORM_WINDOWS
 	if (_iEpollfd != NULL)
 	{
@@ -250,6 +683,13 @@ int TC_Epoller::ctrl(SOCKET_TYPE fd, uint64_t data, uint32_t events, int op)
 #else
 int TC_Epoller::ctrl(SOCKET_TYPE fd, uint64_t data, uint32_t events, int op)
 {
+#if TARGET_PLATFORM_LINUX && TARS_IO_URING
+	if(_uring)
+	{
+		return _uring->ctrl(fd, data, events, op);
+	}
+#endif
+
 	struct epoll_event ev;
 	ev.data.u64 = data;
 
@@ -272,18 +712,38 @@ int TC_Epoller::ctrl(SOCKET_TYPE fd, uint64_t data, uint32_t events, int op)
 
 void TC_Epoller::create(int size, bool createNotify)
 {
+    _max_connections = 128;
+
+#if TARGET_PLATFORM_LINUX && TARS_IO_URING
+	if(_backend == EB_IO_URING)
+	{
+		_uring = new TC_IoUringPoller();
+		if(!_uring->init(1024, _enableET))
+		{
+			//内核不支持, 回退为epoll
+			delete _uring;
+			_uring = NULL;
+			_backend = EB_EPOLL;
+		}
+	}
+#else
+	_backend = EB_EPOLL;
+#endif
+
+	if(_backend == EB_EPOLL)
+	{
 #if TARGET_PLATFORM_IOS
-    _iEpollfd = kqueue();
+	    _iEpollfd = kqueue();
 #else
-	_iEpollfd = epoll_create(size);
+		_iEpollfd = epoll_create(size);
 #endif
+	}
+
     if (nullptr != _pevs)
     {
         delete[] _pevs;
     }
 
-    _max_connections = 128;
-
     _pevs = new epoll_event[_max_connections];
 
     if(createNotify)
@@ -310,8 +770,18 @@ void TC_Epoller::close()
 
 #if TARGET_PLATFORM_LINUX || TARGET_PLATFORM_IOS
 //    LOG_CONSOLE_DEBUG << endl;
-    ::close(_iEpollfd);
-	_iEpollfd = -1;
+#if TARGET_PLATFORM_LINUX && TARS_IO_URING
+	if(_uring != nullptr)
+	{
+		delete _uring;
+		_uring = nullptr;
+	}
+#endif
+	if(_iEpollfd >= 0)
+	{
+	    ::close(_iEpollfd);
+		_iEpollfd = -1;
+	}
 
 #else
     epoll_close(_iEpollfd);
@@ -333,12 +803,12 @@ void TC_Epoller::releaseEpollInfo(const shared_ptr<TC_Epoller::EpollInfo> &epoll
 	}
 }
 
-void TC_Epoller::add(SOCKET_TYPE fd, uint64_t data, uint32_t events)
+int TC_Epoller::add(SOCKET_TYPE fd, uint64_t data, uint32_t events)
 {
 #if TARGET_PLATFORM_IOS
-    ctrl(fd, data, events, EV_ADD|EV_ENABLE);
+    return ctrl(fd, data, events, EV_ADD|EV_ENABLE);
 #else
-    ctrl(fd, data, events, EPOLL_CTL_ADD);
+    return ctrl(fd, data, events, EPOLL_CTL_ADD);
 #endif
 }
 
@@ -378,6 +848,15 @@ int TC_Epoller::wait(int millsecond)
     timeout.tv_sec = millsecond / 1000;
     timeout.tv_nsec = (millsecond % 1000) * 1000 * 1000;
 	ret = kevent64(_iEpollfd, nullptr, 0, _pevs, _max_connections, 0, &timeout);
+#elif TARGET_PLATFORM_LINUX && TARS_IO_URING
+	if(_uring)
+	{
+		ret = _uring->wait(_pevs, _max_connections, millsecond);
+	}
+	else
+	{
+		ret = epoll_wait(_iEpollfd, _pevs, _max_connections, millsecond);
+	}
 #else
 	ret = epoll_wait(_iEpollfd, _pevs, _max_connections, millsecond);
 #endif
@@ -0,0 +1,534 @@
+﻿/**
+ * Tencent is pleased to support the open source community by making Tars available.
+ *
+ * Copyright (C) 2016THL A29 Limited, a Tencent company. All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use this file except 
+ * in compliance with the License. You may obtain a copy of the License at
+ *
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed 
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR 
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the 
+ * specific language governing permissions and limitations under the License.
+ */
+
+#include "util/tc_flat_hashmap.h"
+#include "util/tc_common.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TC_FLAT_HASHMAP_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace tars
+{
+
+uint32_t TC_FlatHashMap::matchByte(const uint8_t *g, uint8_t c)
+{
+#if TC_FLAT_HASHMAP_SSE2
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)g);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)c)));
+#else
+    uint32_t m = 0;
+    for(uint32_t i = 0; i < GROUP_SIZE; i++)
+    {
+        m |= (uint32_t)(g[i] == c) << i;
+    }
+    return m;
+#endif
+}
+
+uint32_t TC_FlatHashMap::matchEmptyOrDeleted(const uint8_t *g)
+{
+#if TC_FLAT_HASHMAP_SSE2
+    //空和删除标记的最高位都是1
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)g));
+#else
+    uint32_t m = 0;
+    for(uint32_t i = 0; i < GROUP_SIZE; i++)
+    {
+        m |= (uint32_t)(g[i] >> 7) << i;
+    }
+    return m;
+#endif
+}
+
+uint32_t TC_FlatHashMap::lowestBit(uint32_t m)
+{
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, m);
+    return (uint32_t)i;
+#else
+    return (uint32_t)__builtin_ctz(m);
+#endif
+}
+
+void TC_FlatHashMap::initDataSize(size_t iMaxKeySize, size_t iMaxValueSize)
+{
+    if(iMaxKeySize == 0 || iMaxKeySize > 0xff || iMaxValueSize > 0xffff)
+    {
+        throw TC_FlatHashMap_Exception("[TC_FlatHashMap::initDataSize] data size error:" + TC_Common::tostr(iMaxKeySize) + "|" + TC_Common::tostr(iMaxValueSize));
+    }
+
+    _iMaxKeySize    = iMaxKeySize;
+    _iMaxValueSize  = iMaxValueSize;
+}
+
+void TC_FlatHashMap::init(void *pAddr)
+{
+    _pHead          = static_cast<tagMapHead*>(pAddr);
+    _pCtrl          = (uint8_t*)pAddr + ctrlOffset();
+    _pSlot          = (char*)_pCtrl + _pHead->_iSlotCount;
+    _iGroupCount    = _pHead->_iSlotCount / GROUP_SIZE;
+
+    _tmpSlot.resize(_pHead->_iSlotSize);
+}
+
+void TC_FlatHashMap::create(void *pAddr, size_t iSize)
+{
+    size_t iSlotSize = (sizeof(tagSlotHead) + _iMaxKeySize + _iMaxValueSize + 7) & ~(size_t)7;
+
+    //每组16个控制字节和16个槽位
+    size_t iGroupCount = iSize > ctrlOffset() ? (iSize - ctrlOffset()) / (GROUP_SIZE * (1 + iSlotSize)) : 0;
+    if(iGroupCount == 0)
+    {
+        throw TC_FlatHashMap_Exception("[TC_FlatHashMap::create] mem size not enougth.");
+    }
+
+    tagMapHead *pHead       = static_cast<tagMapHead*>(pAddr);
+
+    memset(pHead, 0, sizeof(tagMapHead));
+    pHead->_cMaxVersion     = MAX_VERSION;
+    pHead->_cMinVersion     = MIN_VERSION;
+    pHead->_bReadOnly       = false;
+    pHead->_bAutoErase      = true;
+    pHead->_iMaxKeySize     = (uint32_t)_iMaxKeySize;
+    pHead->_iMaxValueSize   = (uint32_t)_iMaxValueSize;
+    pHead->_iSlotSize       = (uint32_t)iSlotSize;
+    pHead->_iMemSize        = iSize;
+    pHead->_iSlotCount      = iGroupCount * GROUP_SIZE;
+
+    init(pAddr);
+
+    memset(_pCtrl, CTRL_EMPTY, _pHead->_iSlotCount);
+}
+
+void TC_FlatHashMap::connect(void *pAddr, size_t iSize)
+{
+    tagMapHead *pHead = static_cast<tagMapHead*>(pAddr);
+
+    if(pHead->_cMaxVersion != MAX_VERSION || pHead->_cMinVersion != MIN_VERSION)
+    {
+        ostringstream os;
+        os << (int)pHead->_cMaxVersion << "." << (int)pHead->_cMinVersion << " != " << ((int)MAX_VERSION) << "." << ((int)MIN_VERSION);
+        throw TC_FlatHashMap_Exception("[TC_FlatHashMap::connect] hash map version not equal:" + os.str() + " (data != code)");
+    }
+
+    if(pHead->_iMemSize != iSize)
+    {
+        throw TC_FlatHashMap_Exception("[TC_FlatHashMap::connect] hash map size not equal:" + TC_Common::tostr(pHead->_iMemSize) + "!=" + TC_Common::tostr(iSize));
+    }
+
+    init(pAddr);
+
+    recover();
+}
+
+void TC_FlatHashMap::recover()
+{
+    if(_pHead->_cModifyStatus == 0)
+    {
+        return;
+    }
+
+    //整理到一半, 数据的位置已经乱了, 只能清空
+    if(_pHead->_cModifyStatus == 2)
+    {
+        clear();
+        return;
+    }
+
+    //正在修改的数据可能不完整, 删除
+    size_t i = _pHead->_iModifySlot;
+    if(i < _pHead->_iSlotCount && isFull(_pCtrl[i]))
+    {
+        _pCtrl[i] = CTRL_DELETED;
+    }
+
+    //计数可能没有更新, 重新统计
+    size_t iElementCount = 0;
+    size_t iDeletedCount = 0;
+    for(i = 0; i < _pHead->_iSlotCount; i++)
+    {
+        if(isFull(_pCtrl[i]))
+        {
+            ++iElementCount;
+        }
+        else if(_pCtrl[i] == CTRL_DELETED)
+        {
+            ++iDeletedCount;
+        }
+    }
+
+    _pHead->_iElementCount  = iElementCount;
+    _pHead->_iDeletedCount  = iDeletedCount;
+
+    endModify();
+}
+
+uint64_t TC_FlatHashMap::hashValue(const string &k)
+{
+    //hash函数的结果可能只有32位且不够均匀, 再混合一次
+    uint64_t h = (uint64_t)_hashf(k);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+size_t TC_FlatHashMap::find(const string &k, uint64_t h)
+{
+    uint8_t c   = h2(h);
+    size_t g    = startGroup(h);
+
+    for(size_t n = 0; n < _iGroupCount; n++)
+    {
+        const uint8_t *pg = _pCtrl + g * GROUP_SIZE;
+
+        uint32_t m = matchByte(pg, c);
+        while(m != 0)
+        {
+            size_t i = g * GROUP_SIZE + lowestBit(m);
+
+            tagSlotHead *s = slot(i);
+            if(s->_iKeyLen == k.length() && memcmp(s + 1, k.data(), k.length()) == 0)
+            {
+                return i;
+            }
+
+            m &= m - 1;
+        }
+
+        //组里有空槽位, 插入时不会越过这一组
+        if(matchByte(pg, CTRL_EMPTY) != 0)
+        {
+            break;
+        }
+
+        if(++g == _iGroupCount)
+        {
+            g = 0;
+        }
+    }
+
+    return (size_t)-1;
+}
+
+size_t TC_FlatHashMap::findInsert(uint64_t h)
+{
+    size_t g = startGroup(h);
+
+    for(size_t n = 0; n < _iGroupCount; n++)
+    {
+        uint32_t m = matchEmptyOrDeleted(_pCtrl + g * GROUP_SIZE);
+        if(m != 0)
+        {
+            return g * GROUP_SIZE + lowestBit(m);
+        }
+
+        if(++g == _iGroupCount)
+        {
+            g = 0;
+        }
+    }
+
+    throw TC_FlatHashMap_Exception("[TC_FlatHashMap::findInsert] no free slot.");
+}
+
+void TC_FlatHashMap::eraseSlot(size_t i)
+{
+    beginModify(i);
+
+    //同一组里还有空槽位, 说明没有数据越过这一组放到后面, 可以直接置空
+    if(matchByte(_pCtrl + i / GROUP_SIZE * GROUP_SIZE, CTRL_EMPTY) != 0)
+    {
+        _pCtrl[i] = CTRL_EMPTY;
+    }
+    else
+    {
+        _pCtrl[i] = CTRL_DELETED;
+        ++_pHead->_iDeletedCount;
+    }
+
+    --_pHead->_iElementCount;
+
+    endModify();
+}
+
+void TC_FlatHashMap::evict(BlockData &data)
+{
+    //最多扫两圈: 第一圈清除所有访问标记
+    for(;;)
+    {
+        size_t i = _pHead->_iClockHand;
+
+        _pHead->_iClockHand = (i + 1 == _pHead->_iSlotCount) ? 0 : i + 1;
+
+        if(!isFull(_pCtrl[i]))
+        {
+            continue;
+        }
+
+        tagSlotHead *s = slot(i);
+        if(s->_bRef)
+        {
+            s->_bRef = 0;
+            continue;
+        }
+
+        data._key   = getKey(i);
+        data._value = getValue(i);
+
+        eraseSlot(i);
+
+        ++_pHead->_iEraseCount;
+        return;
+    }
+}
+
+void TC_FlatHashMap::rebuild()
+{
+    _pHead->_cModifyStatus = 2;
+
+    size_t iSlotCount = _pHead->_iSlotCount;
+    size_t iSlotSize  = _pHead->_iSlotSize;
+
+    //有数据的先改成删除标记, 表示需要重新放置; 原来的删除标记改成空
+    for(size_t i = 0; i < iSlotCount; i++)
+    {
+        _pCtrl[i] = isFull(_pCtrl[i]) ? (uint8_t)CTRL_DELETED : (uint8_t)CTRL_EMPTY;
+    }
+
+    for(size_t i = 0; i < iSlotCount; i++)
+    {
+        if(_pCtrl[i] != CTRL_DELETED)
+        {
+            continue;
+        }
+
+        uint64_t h  = hashValue(getKey(i));
+        size_t t    = findInsert(h);
+
+        //已经在查找路径上最靠前的可用组里, 不用移动
+        if(t / GROUP_SIZE == i / GROUP_SIZE)
+        {
+            _pCtrl[i] = h2(h);
+            continue;
+        }
+
+        if(_pCtrl[t] == CTRL_EMPTY)
+        {
+            memcpy(slot(t), slot(i), iSlotSize);
+            _pCtrl[t] = h2(h);
+            _pCtrl[i] = CTRL_EMPTY;
+        }
+        else
+        {
+            //目标位置的数据也还没有放置, 交换以后重新处理当前位置
+            memcpy(&_tmpSlot[0], slot(t), iSlotSize);
+            memcpy(slot(t), slot(i), iSlotSize);
+            memcpy(slot(i), &_tmpSlot[0], iSlotSize);
+            _pCtrl[t] = h2(h);
+            --i;
+        }
+    }
+
+    _pHead->_iDeletedCount = 0;
+
+    endModify();
+}
+
+int TC_FlatHashMap::get(const string &k, string &v)
+{
+    ++_pHead->_iGetCount;
+
+    size_t i = find(k, hashValue(k));
+    if(i == (size_t)-1)
+    {
+        return RT_NO_DATA;
+    }
+
+    ++_pHead->_iHitCount;
+
+    tagSlotHead *s = slot(i);
+
+    //已经有标记时不写, 减少共享内存的写
+    if(!s->_bRef)
+    {
+        s->_bRef = 1;
+    }
+
+    v.assign((char*)(s + 1) + _pHead->_iMaxKeySize, s->_iValueLen);
+
+    return RT_OK;
+}
+
+int TC_FlatHashMap::set(const string &k, const string &v, vector<BlockData> &vtData)
+{
+    if(_pHead->_bReadOnly)
+    {
+        return RT_READONLY;
+    }
+
+    if(k.length() > _pHead->_iMaxKeySize || v.length() > _pHead->_iMaxValueSize)
+    {
+        return RT_DATA_TOO_LONG;
+    }
+
+    uint64_t h  = hashValue(k);
+    size_t i    = find(k, h);
+
+    if(i != (size_t)-1)
+    {
+        beginModify(i);
+
+        tagSlotHead *s = slot(i);
+        memcpy((char*)(s + 1) + _pHead->_iMaxKeySize, v.data(), v.length());
+        s->_iValueLen   = (uint16_t)v.length();
+        s->_bRef        = 1;
+
+        endModify();
+
+        return RT_OK;
+    }
+
+    if(_pHead->_iElementCount >= getMaxElementCount())
+    {
+        if(!_pHead->_bAutoErase)
+        {
+            return RT_NO_MEMORY;
+        }
+
+        BlockData data;
+        evict(data);
+        vtData.push_back(data);
+    }
+
+    //删除标记太多时, 没有数据的key要查很多组才能确定不存在, 整理一次
+    if(_pHead->_iElementCount + _pHead->_iDeletedCount >= _pHead->_iSlotCount - _pHead->_iSlotCount / 16)
+    {
+        rebuild();
+    }
+
+    i = findInsert(h);
+
+    beginModify(i);
+
+    tagSlotHead *s  = slot(i);
+    s->_iKeyLen     = (uint8_t)k.length();
+    s->_bRef        = 1;
+    s->_iValueLen   = (uint16_t)v.length();
+    memcpy(s + 1, k.data(), k.length());
+    memcpy((char*)(s + 1) + _pHead->_iMaxKeySize, v.data(), v.length());
+
+    if(_pCtrl[i] == CTRL_DELETED)
+    {
+        --_pHead->_iDeletedCount;
+    }
+
+    //数据写完以后再设置控制字节
+    _pCtrl[i] = h2(h);
+
+    ++_pHead->_iElementCount;
+
+    endModify();
+
+    return RT_OK;
+}
+
+int TC_FlatHashMap::del(const string &k, BlockData &data)
+{
+    if(_pHead->_bReadOnly)
+    {
+        return RT_READONLY;
+    }
+
+    size_t i = find(k, hashValue(k));
+    if(i == (size_t)-1)
+    {
+        return RT_NO_DATA;
+    }
+
+    data._key   = k;
+    data._value = getValue(i);
+
+    eraseSlot(i);
+
+    return RT_OK;
+}
+
+int TC_FlatHashMap::erase(BlockData &data)
+{
+    if(_pHead->_bReadOnly)
+    {
+        return RT_READONLY;
+    }
+
+    if(_pHead->_iElementCount == 0)
+    {
+        return RT_NO_DATA;
+    }
+
+    evict(data);
+
+    return RT_ERASE_OK;
+}
+
+void TC_FlatHashMap::clear()
+{
+    memset(_pCtrl, CTRL_EMPTY, _pHead->_iSlotCount);
+
+    _pHead->_iElementCount  = 0;
+    _pHead->_iDeletedCount  = 0;
+    _pHead->_iClockHand     = 0;
+    _pHead->_iGetCount      = 0;
+    _pHead->_iHitCount      = 0;
+    _pHead->_iEraseCount    = 0;
+    _pHead->_cModifyStatus  = 0;
+}
+
+string TC_FlatHashMap::desc()
+{
+    ostringstream s;
+    {
+        s << "[Version          = "   << (int)_pHead->_cMaxVersion << "." << (int)_pHead->_cMinVersion << "]" << endl;
+        s << "[ReadOnly         = "   << _pHead->_bReadOnly         << "]" << endl;
+        s << "[AutoErase        = "   << _pHead->_bAutoErase        << "]" << endl;
+        s << "[MemSize          = "   << _pHead->_iMemSize          << "]" << endl;
+        s << "[MaxKeySize       = "   << _pHead->_iMaxKeySize       << "]" << endl;
+        s << "[MaxValueSize     = "   << _pHead->_iMaxValueSize     << "]" << endl;
+        s << "[SlotSize         = "   << _pHead->_iSlotSize         << "]" << endl;
+        s << "[SlotCount        = "   << _pHead->_iSlotCount        << "]" << endl;
+        s << "[ElementCount     = "   << _pHead->_iElementCount     << "]" << endl;
+        s << "[DeletedCount     = "   << _pHead->_iDeletedCount     << "]" << endl;
+        s << "[ClockHand        = "   << _pHead->_iClockHand        << "]" << endl;
+        s << "[GetCount         = "   << _pHead->_iGetCount         << "]" << endl;
+        s << "[HitCount         = "   << _pHead->_iHitCount         << "]" << endl;
+        s << "[HitRatio(%)      = "   << (_pHead->_iGetCount == 0 ? 0 : _pHead->_iHitCount * 100 / _pHead->_iGetCount) << "]" << endl;
+        s << "[EraseCount       = "   << _pHead->_iEraseCount       << "]" << endl;
+    }
+
+    return s.str();
+}
+
+}
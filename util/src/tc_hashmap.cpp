@@ -299,7 +299,7 @@ void TC_HashMap::Block::deallocate()
 void TC_HashMap::Block::makeNew(size_t index, size_t iAllocSize)
 {
     getBlockHead()->_iSize          = (uint32_t)iAllocSize;
-    getBlockHead()->_iIndex         = (uint32_t)index;
+    getBlockHead()->_iIndex         = (uint32_t)_pMap->toBlockIndex(index);
     getBlockHead()->_iSetNext       = 0;
     getBlockHead()->_iSetPrev       = 0;
     getBlockHead()->_iGetNext       = 0;
@@ -490,11 +490,12 @@ void TC_HashMap::Block::erase()
 
 	//////////////////如果是hash头部, 需要修改hash索引数据指针//////
 	//
-	_pMap->delListCount(getBlockHead()->_iIndex);
+	size_t index = _pMap->fromBlockIndex(getBlockHead()->_iIndex);
+	_pMap->delListCount(index);
 	if(getBlockHead()->_iBlockPrev == 0)
 	{
 		//如果是hash桶的头部, 则还需要处理
-		TC_HashMap::tagHashItem *pItem  = _pMap->item(getBlockHead()->_iIndex);
+		TC_HashMap::tagHashItem *pItem  = _pMap->item(index);
 		assert(pItem->_iBlockAddr == _iHead);
 		if(pItem->_iBlockAddr == _iHead)
 		{
@@ -1073,7 +1074,7 @@ void TC_HashMap::HashMapLockItem::nextItem(int iType)
 
     if(iType == HashMapLockIterator::IT_BLOCK)
     {
-        size_t index = block.getBlockHead()->_iIndex;
+        size_t index = _pMap->fromBlockIndex(block.getBlockHead()->_iIndex);
 
         //当前block链表有元素
         if(block.nextBlock())
@@ -1084,7 +1085,7 @@ void TC_HashMap::HashMapLockItem::nextItem(int iType)
 
         index += 1;
 
-        while(index < _pMap->_hash.size())
+        while(index < _pMap->getHashCount())
         {
             //当前的hash桶也没有数据
             if (_pMap->item(index)->_iBlockAddr == 0)
@@ -1115,7 +1116,7 @@ void TC_HashMap::HashMapLockItem::prevItem(int iType)
 
     if(iType == HashMapLockIterator::IT_BLOCK)
     {
-        size_t index = block.getBlockHead()->_iIndex;
+        size_t index = _pMap->fromBlockIndex(block.getBlockHead()->_iIndex);
         if(block.prevBlock())
         {
             _iAddr = block.getHead();
@@ -1447,6 +1448,10 @@ void TC_HashMap::create(void *pAddr, size_t iSize)
     _pHead->_iHitCount      = 0;
     _pHead->_iBackupTail    = 0;
     _pHead->_iSyncTail      = 0;
+    _pHead->_iHashAddr      = 0;
+    _pHead->_iHashBase      = 0;
+    _pHead->_iRehashAddr    = 0;
+    _pHead->_iRehashIndex   = 0;
 
     //计算平均block大小
     size_t iBlockSize   = (_pHead->_iMinDataSize + _pHead->_iMaxDataSize)/2 + sizeof(Block::tagBlockHead);
@@ -1464,6 +1469,8 @@ void TC_HashMap::create(void *pAddr, size_t iSize)
     void *pDataAddr     = (char*)pHashAddr + _hash.getMemSize();
 
     _pDataAllocator->create(pDataAddr, iSize - ((char*)pDataAddr - (char*)_pHead), sizeof(Block::tagBlockHead) + _pHead->_iMinDataSize, sizeof(Block::tagBlockHead) + _pHead->_iMaxDataSize, _pHead->_fFactor);
+
+    syncHash();
 }
 
 void TC_HashMap::connect(void *pAddr, size_t iSize)
@@ -1482,10 +1489,12 @@ void TC_HashMap::connect(void *pAddr, size_t iSize)
         throw TC_HashMap_Exception("[TC_HashMap::connect] hash map size not equal:" + TC_Common::tostr(_pHead->_iMemSize) + "!=" + TC_Common::tostr(iSize));
     }
 
+    //数据区在create时的hash桶数组后面, rehash以后这个数组不再使用, 但是位置不变
     void *pHashAddr = (char*)_pHead + sizeof(tagMapHead) + sizeof(tagModifyHead);
-    _hash.connect(pHashAddr);
+    TC_MemVector<tagHashItem> hash;
+    hash.connect(pHashAddr);
 
-    void *pDataAddr = (char*)pHashAddr + _hash.getMemSize();
+    void *pDataAddr = (char*)pHashAddr + hash.getMemSize();
 
     _pDataAllocator->connect(pDataAddr);
 
@@ -1493,9 +1502,78 @@ void TC_HashMap::connect(void *pAddr, size_t iSize)
     _iMaxDataSize   = _pHead->_iMaxDataSize;
     _fFactor        = _pHead->_fFactor;
     _fRadio         = _pHead->_fRadio;
+
+    syncHash();
 }
 
 int TC_HashMap::append(void *pAddr, size_t iSize)
+{
+    return doAppend(pAddr, iSize, 0);
+}
+
+int TC_HashMap::append(void *pAddr, size_t iSize, size_t iHashCount)
+{
+    if(iSize <= _pHead->_iMemSize)
+    {
+        return -1;
+    }
+
+    //上次的rehash还没有完成, 先迁移完
+    doUpdate();
+    if(_iRehashAddr != 0)
+    {
+        if(_pHead->_bReadOnly)
+        {
+            return -1;
+        }
+
+        rehash(_hash.size());
+    }
+
+    size_t iOldSize = _pHead->_iMemSize;
+
+    if(iHashCount == 0)
+    {
+        //和create一样按照总的大小计算
+        size_t iBlockSize = (_pHead->_iMinDataSize + _pHead->_iMaxDataSize)/2 + sizeof(Block::tagBlockHead);
+        iHashCount = (iSize - sizeof(TC_MemChunkAllocator::tagChunkAllocatorHead)) / ((size_t)(iBlockSize*_pHead->_fRadio) + sizeof(tagHashItem));
+    }
+    iHashCount = getMinPrimeNumber(iHashCount);
+
+    if(iHashCount <= _hash.size())
+    {
+        return doAppend(pAddr, iSize, 0);
+    }
+
+    //block中记录的桶编号是32位的
+    if(rehashBase(iHashCount) + iHashCount > (size_t)(uint32_t)(-1))
+    {
+        return -1;
+    }
+
+    //新的hash桶数组放在扩展部分的开头, 剩下的给数据区
+    size_t iHashMemSize = TC_MemVector<tagHashItem>::calcMemSize(iHashCount);
+    if(iSize - iOldSize <= iHashMemSize)
+    {
+        return -1;
+    }
+
+    int ret = doAppend(pAddr, iSize, iHashMemSize);
+    if(ret != 0)
+    {
+        return ret;
+    }
+
+    _rehash.create(getAbsolute(iOldSize), iHashMemSize);
+
+    update(&_pHead->_iRehashIndex, (size_t)0);
+    update(&_pHead->_iRehashAddr, iOldSize);
+    doUpdate(true);
+
+    return 0;
+}
+
+int TC_HashMap::doAppend(void *pAddr, size_t iSize, size_t iReserve)
 {
     if(iSize <= _pHead->_iMemSize)
     {
@@ -1514,19 +1592,153 @@ int TC_HashMap::append(void *pAddr, size_t iSize)
     _pHead->_iMemSize = iSize;
 
     void *pHashAddr = (char*)_pHead + sizeof(tagMapHead) + sizeof(tagModifyHead);
-    _hash.connect(pHashAddr);
+    TC_MemVector<tagHashItem> hash;
+    hash.connect(pHashAddr);
 
-    void *pDataAddr = (char*)pHashAddr + _hash.getMemSize();
-    _pDataAllocator->append(pDataAddr, iSize - ((size_t)pDataAddr - (size_t)pAddr));
+    void *pDataAddr = (char*)pHashAddr + hash.getMemSize();
+    _pDataAllocator->append(pDataAddr, iSize - ((size_t)pDataAddr - (size_t)pAddr), iReserve);
 
     _iMinDataSize   = _pHead->_iMinDataSize;
     _iMaxDataSize   = _pHead->_iMaxDataSize;
     _fFactor        = _pHead->_fFactor;
     _fRadio         = _pHead->_fRadio;
 
+    syncHash();
+
     return 0;
 }
 
+void TC_HashMap::syncHash()
+{
+    if(_pHead->_iHashAddr == 0)
+    {
+        _hash.connect((char*)_pHead + sizeof(tagMapHead) + sizeof(tagModifyHead));
+    }
+    else
+    {
+        _hash.connect(getAbsolute(_pHead->_iHashAddr));
+    }
+
+    _iHashAddr      = _pHead->_iHashAddr;
+    _iHashBase      = _pHead->_iHashBase;
+    _iRehashAddr    = _pHead->_iRehashAddr;
+
+    if(_iRehashAddr != 0)
+    {
+        _rehash.connect(getAbsolute(_iRehashAddr));
+        _iRehashBase = rehashBase(_rehash.size());
+    }
+}
+
+void TC_HashMap::getRehashProgress(size_t &iMigrated, size_t &iOldCount, size_t &iNewCount)
+{
+    doUpdate();
+
+    iMigrated   = _pHead->_iRehashIndex >> 1;
+    iOldCount   = _hash.size();
+    iNewCount   = (_iRehashAddr == 0 ? 0 : _rehash.size());
+}
+
+size_t TC_HashMap::rehash(size_t iStep)
+{
+    doUpdate();
+
+    if(_iRehashAddr == 0)
+    {
+        return 0;
+    }
+
+    size_t n = _hash.size();
+    size_t i = _pHead->_iRehashIndex >> 1;
+
+    if(_pHead->_bReadOnly)
+    {
+        return n - i;
+    }
+
+    //上次迁移到一半退出了, 这个桶必须先迁移完, 否则已经迁移的数据查不到
+    bool bBusy = (_pHead->_iRehashIndex & 1);
+
+    while(i < n && (iStep > 0 || bBusy))
+    {
+        if(item(i)->_iBlockAddr != 0)
+        {
+            if(!bBusy)
+            {
+                update(&_pHead->_iRehashIndex, i * 2 + 1);
+                doUpdate(true);
+            }
+
+            while(item(i)->_iBlockAddr != 0)
+            {
+                rehashBlock(i);
+            }
+        }
+
+        if(!bBusy)
+        {
+            --iStep;
+        }
+        bBusy = false;
+        ++i;
+
+        update(&_pHead->_iRehashIndex, i * 2);
+
+        //迁移完了, 切换到新的hash桶数组
+        if(i == n)
+        {
+            update(&_pHead->_iHashAddr, _pHead->_iRehashAddr);
+            update(&_pHead->_iHashBase, _iRehashBase);
+            update(&_pHead->_iRehashAddr, (size_t)0);
+            update(&_pHead->_iRehashIndex, (size_t)0);
+        }
+
+        doUpdate(true);
+    }
+
+    return n - i;
+}
+
+void TC_HashMap::rehashBlock(size_t index)
+{
+    size_t iAddr = item(index)->_iBlockAddr;
+
+    Block block(this, iAddr);
+
+    string k;
+    int ret = HashMapLockItem(this, iAddr).get(k);
+    if(ret != RT_OK)
+    {
+        //数据已经损坏, 无法计算新的hash桶, 和recover一样删除
+        block.erase();
+        return;
+    }
+
+    size_t ni = _hash.size() + _hashf(k) % _rehash.size();
+
+    Block::tagBlockHead *pHead = block.getBlockHead();
+
+    //从旧桶的头部摘下
+    update(&item(index)->_iBlockAddr, pHead->_iBlockNext);
+    if(pHead->_iBlockNext != 0)
+    {
+        update(&block.getBlockHead(pHead->_iBlockNext)->_iBlockPrev, (size_t)0);
+    }
+    delListCount(index);
+
+    //挂在新桶的开头
+    if(item(ni)->_iBlockAddr != 0)
+    {
+        update(&block.getBlockHead(item(ni)->_iBlockAddr)->_iBlockPrev, iAddr);
+    }
+    update(&pHead->_iBlockNext, item(ni)->_iBlockAddr);
+    update(&item(ni)->_iBlockAddr, iAddr);
+    incListCount((uint32_t)ni);
+    update(&pHead->_iIndex, (uint32_t)toBlockIndex(ni));
+
+    doUpdate(true);
+}
+
 void TC_HashMap::clear()
 {
     assert(_pHead);
@@ -1544,6 +1756,17 @@ void TC_HashMap::clear()
     _pHead->_iBackupTail    = 0;
     _pHead->_iSyncTail      = 0;
 
+    //没有数据了, 正在rehash的话直接切换到新的hash桶数组
+    if(_iRehashAddr != 0)
+    {
+        _pHead->_iHashAddr      = _pHead->_iRehashAddr;
+        _pHead->_iHashBase      = _iRehashBase;
+        _pHead->_iRehashAddr    = 0;
+        _pHead->_iRehashIndex   = 0;
+
+        syncHash();
+    }
+
     _hash.clear();
 
     _pDataAllocator->rebuild();
@@ -1635,7 +1858,7 @@ int TC_HashMap::recover(size_t i, bool bRepair)
 {
     doUpdate();
 
-    if( i >= _hash.size())
+    if( i >= getHashCount())
     {
         return 0;
     }
@@ -1675,6 +1898,7 @@ check:
 int TC_HashMap::checkDirty(const string &k)
 {
     doUpdate();
+    autoRehash();
     incGetCount();
 
     int ret         = TC_HashMap::RT_OK;
@@ -1709,6 +1933,7 @@ int TC_HashMap::checkDirty(const string &k)
 int TC_HashMap::setDirty(const string& k)
 {
     doUpdate();
+    autoRehash();
 
     if(_pHead->_bReadOnly) return RT_READONLY;
 
@@ -1744,6 +1969,7 @@ int TC_HashMap::setDirty(const string& k)
 int TC_HashMap::setDirtyAfterSync(const string& k)
 {
     doUpdate();
+    autoRehash();
 
     if(_pHead->_bReadOnly) return RT_READONLY;
 
@@ -1782,6 +2008,7 @@ int TC_HashMap::setDirtyAfterSync(const string& k)
 int TC_HashMap::setClean(const string& k)
 {
     doUpdate();
+    autoRehash();
 
     if(_pHead->_bReadOnly) return RT_READONLY;
 
@@ -1819,6 +2046,7 @@ int TC_HashMap::setClean(const string& k)
 int TC_HashMap::get(const string& k, string &v, time_t &iSyncTime)
 {
     doUpdate();
+    autoRehash();
     incGetCount();
 
     int ret             = TC_HashMap::RT_OK;
@@ -1860,9 +2088,88 @@ int TC_HashMap::get(const string& k, string &v)
     return get(k, v, iSyncTime);
 }
 
+int TC_HashMap::peek(const string& k, size_t index, string &v, time_t &iSyncTime, size_t &iAddr)
+{
+    iAddr = 0;
+
+    if(item(index)->_iBlockAddr == 0)
+    {
+        return TC_HashMap::RT_NO_DATA;
+    }
+
+    //和find一样遍历桶链, 但是不修改命中次数
+    Block mb(this, item(index)->_iBlockAddr);
+    while(true)
+    {
+        int ret = TC_HashMap::RT_OK;
+        HashMapLockItem mcmdi(this, mb.getHead());
+        if(mcmdi.equal(k, v, ret))
+        {
+            if(mb.isOnlyKey())
+            {
+                return TC_HashMap::RT_ONLY_KEY;
+            }
+
+            iSyncTime = mb.getSyncTime();
+            iAddr     = mb.getHead();
+            return TC_HashMap::RT_OK;
+        }
+
+        if (!mb.nextBlock())
+        {
+            return TC_HashMap::RT_NO_DATA;
+        }
+    }
+
+    return TC_HashMap::RT_NO_DATA;
+}
+
+void TC_HashMap::prefetch(const vector<size_t> &vIndex)
+{
+    //先预取所有的桶, 再预取桶上的block, 让两次访存都能并行
+    for(size_t i = 0; i < vIndex.size(); i++)
+    {
+        TC_PREFETCH(item(vIndex[i]));
+    }
+
+    for(size_t i = 0; i < vIndex.size(); i++)
+    {
+        size_t iAddr = item(vIndex[i])->_iBlockAddr;
+        if(iAddr != 0)
+        {
+            TC_PREFETCH(getAbsolute(iAddr));
+        }
+    }
+}
+
+void TC_HashMap::refreshGet(const vector<size_t> &vtAddr, size_t iGetCount, size_t iHitCount)
+{
+    doUpdate();
+
+    if(iGetCount != 0 || iHitCount != 0)
+    {
+        update(&_pHead->_iGetCount, _pHead->_iGetCount + iGetCount);
+        update(&_pHead->_iHitCount, _pHead->_iHitCount + iHitCount);
+        doUpdate(true);
+    }
+
+    //如果只读, 则不刷新get链表
+    if(_pHead->_bReadOnly)
+    {
+        return;
+    }
+
+    for(size_t i = 0; i < vtAddr.size(); i++)
+    {
+        Block block(this, vtAddr[i]);
+        block.refreshGetList();
+    }
+}
+
 int TC_HashMap::set(const string& k, const string& v, bool bDirty, vector<BlockData> &vtData)
 {
     doUpdate();
+    autoRehash();
     incGetCount();
 
     if(_pHead->_bReadOnly) return RT_READONLY;
@@ -1922,6 +2229,7 @@ int TC_HashMap::set(const string& k, const string& v, bool bDirty, vector<BlockD
 int TC_HashMap::set(const string& k, vector<BlockData> &vtData)
 {
     doUpdate();
+    autoRehash();
     incGetCount();
 
     if(_pHead->_bReadOnly) return RT_READONLY;
@@ -1978,6 +2286,7 @@ int TC_HashMap::set(const string& k, vector<BlockData> &vtData)
 int TC_HashMap::del(const string& k, BlockData &data)
 {
     doUpdate();
+    autoRehash();
     incGetCount();
 
     if(_pHead->_bReadOnly) return RT_READONLY;
@@ -2204,9 +2513,9 @@ TC_HashMap::lock_iterator TC_HashMap::begin()
 {
     doUpdate();
 
-    for(size_t i = 0; i < _hash.size(); i++)
+    for(size_t i = 0; i < getHashCount(); i++)
     {
-        tagHashItem &hashItem = _hash[i];
+        tagHashItem &hashItem = *item(i);
         if(hashItem._iBlockAddr != 0)
         {
             return lock_iterator(this, hashItem._iBlockAddr, lock_iterator::IT_BLOCK, lock_iterator::IT_NEXT);
@@ -2220,9 +2529,9 @@ TC_HashMap::lock_iterator TC_HashMap::rbegin()
 {
     doUpdate();
 
-    for(size_t i = _hash.size(); i > 0; i--)
+    for(size_t i = getHashCount(); i > 0; i--)
     {
-        tagHashItem &hashItem = _hash[i-1];
+        tagHashItem &hashItem = *item(i-1);
         if(hashItem._iBlockAddr != 0)
         {
             Block block(this, hashItem._iBlockAddr);
@@ -2293,6 +2602,8 @@ string TC_HashMap::desc()
         s << "[MinDataSize      = "   << _pHead->_iMinDataSize      << "]" << endl;
         s << "[MaxDataSize      = "   << _pHead->_iMaxDataSize      << "]" << endl;
         s << "[HashCount        = "   << _hash.size()               << "]" << endl;
+        s << "[RehashCount      = "   << (_iRehashAddr == 0 ? 0 : _rehash.size()) << "]" << endl;
+        s << "[RehashIndex      = "   << (_pHead->_iRehashIndex >> 1) << "]" << endl;
         s << "[HashRadio        = "   << _pHead->_fRadio            << "]" << endl;
         s << "[ElementCount     = "   << _pHead->_iElementCount     << "]" << endl;
         s << "[SetHead          = "   << _pHead->_iSetHead       << "]" << endl;
@@ -2339,7 +2650,7 @@ string TC_HashMap::desc()
 size_t TC_HashMap::eraseExcept(size_t iNowAddr, vector<BlockData> &vtData)
 {
     //不能被淘汰
-    if(!_pHead->_bAutoErase) return 0;
+    if(!_pHead->_bAutoErase || !_bLocalAutoErase) return 0;
 
     size_t n = _pHead->_iEraseCount;
     if(n == 0) n = 10;
@@ -2405,7 +2716,7 @@ size_t TC_HashMap::eraseExcept(size_t iNowAddr, vector<BlockData> &vtData)
 
 size_t TC_HashMap::hashIndex(const string& k)
 {
-    return _hashf(k) % _hash.size();
+    return hashValueIndex(_hashf(k));
 }
 
 TC_HashMap::lock_iterator TC_HashMap::find(const string& k, size_t index, string &v, int &ret)
@@ -2472,15 +2783,15 @@ void TC_HashMap::analyseHash(uint32_t &iMaxHash, uint32_t &iMinHash, float &fAvg
     fAvgHash = 0;
 
     uint32_t n = 0;
-    for(uint32_t i = 0; i < _hash.size(); i++)
+    for(size_t i = 0; i < getHashCount(); i++)
     {
-        iMaxHash = max(_hash[i]._iListCount, iMaxHash);
-        iMinHash = min(_hash[i]._iListCount, iMinHash);
+        iMaxHash = max(item(i)->_iListCount, iMaxHash);
+        iMinHash = min(item(i)->_iListCount, iMinHash);
         //平均值只统计非0的
-        if(_hash[i]._iListCount != 0)
+        if(item(i)->_iListCount != 0)
         {
             n++;
-            fAvgHash  += _hash[i]._iListCount;
+            fAvgHash  += item(i)->_iListCount;
         }
     }
 
@@ -2536,10 +2847,11 @@ void TC_HashMap::doUpdate(bool bUpdate)
         _pstModifyHead->_iNowIndex        = 0;
         _pstModifyHead->_cModifyStatus    = 0;
     }
-    //==0, 正常状态
-    else if(_pstModifyHead->_cModifyStatus == 0)
+
+    //hash桶数组被rehash切换了(可能是其他进程), 重新连接
+    if(_iHashAddr != _pHead->_iHashAddr || _iRehashAddr != _pHead->_iRehashAddr)
     {
-        return;
+        syncHash();
     }
 }
 
@@ -1856,6 +1856,55 @@ bool TC_HttpRequest::decode(const char *sBuffer, size_t iLength)
 	return (getContentLength() + getHeadLength() + iChunkSuffixLen == iLength);
 }
 
+bool TC_HttpRequest::decode(const char *sBuffer, const TC_HttpRequestParser &parser)
+{
+	assert(sBuffer != NULL);
+
+	if (!parser.isComplete())
+	{
+		return false;
+	}
+
+	reset();
+
+	_requestType = parser.requestType();
+
+	_version = TC_HttpRequestParser::str(sBuffer, parser.version());
+
+	const vector<TC_HttpRequestParser::Header> &headers = parser.headers();
+	for (size_t i = 0; i < headers.size(); i++)
+	{
+		_headers.insert(multimap<string, string>::value_type(TC_HttpRequestParser::str(sBuffer, headers[i].name), TC_HttpRequestParser::str(sBuffer, headers[i].value)));
+	}
+
+	_headLength = parser.headLength();
+
+	_headComplete = true;
+
+	parser.getContent(sBuffer, _content);
+
+	if (parser.isChunked())
+	{
+		setContentLength(_content.length());
+	}
+
+	const char *url = sBuffer + parser.url().offset;
+
+	string sURL(url, parser.url().length);
+
+	if (TC_Port::strncasecmp(url, "https://", 8) != 0 )
+	{
+		if (TC_Port::strncasecmp(url, "http://", 7) != 0 )
+		{
+			sURL = "http://" + getHost() + sURL;
+		}
+	}
+
+	parseURL(sURL);
+
+	return true;
+}
+
 bool TC_HttpRequest::checkRequest(TC_NetWorkBuffer &buff)
 {
 	buff.mergeBuffers();
@@ -2335,6 +2384,431 @@ int TC_HttpRequest::doRequest(TC_HttpResponse &stHttpRsp, int iTimeout)
 	return doRequest(encode(), tcpClient, stHttpRsp);
 }
 
+/********************* TC_HttpRequestParser ***********************/
+
+static const struct
+{
+	const char                          *name;
+	size_t                              length;
+	TC_HttpRequestParser::HEADER_ID     id;
+} KNOWN_HEADERS[] =
+{
+	{ "Host",               4,  TC_HttpRequestParser::HEADER_HOST },
+	{ "Content-Length",     14, TC_HttpRequestParser::HEADER_CONTENT_LENGTH },
+	{ "Content-Type",       12, TC_HttpRequestParser::HEADER_CONTENT_TYPE },
+	{ "Connection",         10, TC_HttpRequestParser::HEADER_CONNECTION },
+	{ "Transfer-Encoding",  17, TC_HttpRequestParser::HEADER_TRANSFER_ENCODING },
+	{ "Cookie",             6,  TC_HttpRequestParser::HEADER_COOKIE },
+	{ "User-Agent",         10, TC_HttpRequestParser::HEADER_USER_AGENT },
+	{ "Accept",             6,  TC_HttpRequestParser::HEADER_ACCEPT },
+	{ "Accept-Encoding",    15, TC_HttpRequestParser::HEADER_ACCEPT_ENCODING },
+	{ "Upgrade",            7,  TC_HttpRequestParser::HEADER_UPGRADE },
+};
+
+int TC_HttpRequestParser::headerId(const char *name, size_t len)
+{
+	for (size_t i = 0; i < sizeof(KNOWN_HEADERS) / sizeof(KNOWN_HEADERS[0]); i++)
+	{
+		if (KNOWN_HEADERS[i].length == len && TC_Port::strncasecmp(KNOWN_HEADERS[i].name, name, len) == 0)
+		{
+			return KNOWN_HEADERS[i].id;
+		}
+	}
+
+	return HEADER_UNKNOWN;
+}
+
+void TC_HttpRequestParser::reset()
+{
+	_state          = S_LINE;
+	_pos            = 0;
+	_scan           = 0;
+	_requestType    = -1;
+	_method         = View();
+	_url            = View();
+	_version        = View();
+	_headers.clear();
+	memset(_known, 0, sizeof(_known));
+	_chunked        = false;
+	_headLength     = 0;
+	_contentLength  = 0;
+	_chunkSize      = 0;
+	_content.clear();
+	_packetLength   = 0;
+}
+
+int64_t TC_HttpRequestParser::nextLine(const char *data, size_t len)
+{
+	const char *p = (const char*)memchr(data + _scan, '\n', len - _scan);
+	if (p == NULL)
+	{
+		//下次从这里继续找
+		_scan = len;
+		return -1;
+	}
+
+	_scan = p - data + 1;
+
+	return p - data;
+}
+
+bool TC_HttpRequestParser::parseLine(const char *data, size_t end)
+{
+	if (end > _pos && data[end - 1] == '\r')
+	{
+		--end;
+	}
+
+	const char *line = data + _pos;
+	const char *f1 = (const char*)memchr(line, ' ', end - _pos);
+	if (f1 == NULL)
+	{
+		return false;
+	}
+
+	const char *f2 = (const char*)memchr(f1 + 1, ' ', data + end - f1 - 1);
+	if (f2 == NULL || f2 == f1 + 1)
+	{
+		return false;
+	}
+
+	_method.offset  = (uint32_t)_pos;
+	_method.length  = (uint32_t)(f1 - line);
+	_url.offset     = (uint32_t)(f1 + 1 - data);
+	_url.length     = (uint32_t)(f2 - f1 - 1);
+	_version.offset = (uint32_t)(f2 + 1 - data);
+	_version.length = (uint32_t)(data + end - f2 - 1);
+
+	return _version.length > 5 && TC_Port::strncasecmp(f2 + 1, "HTTP/", 5) == 0;
+}
+
+bool TC_HttpRequestParser::parseHeader(const char *data, size_t end)
+{
+	const char *s = data + _pos;
+	const char *e = data + end;
+
+	if (e > s && *(e - 1) == '\r')
+	{
+		--e;
+	}
+
+	const char *colon = (const char*)memchr(s, ':', e - s);
+	if (colon == NULL)
+	{
+		//和TC_Http::parseHeaderString一样, 忽略没有':'的行
+		return true;
+	}
+
+	if (_headers.size() >= 0xFFFF)
+	{
+		return false;
+	}
+
+	const char *ne = colon;
+	while (s < ne && (*s == ' ' || *s == '\t'))
+		++s;
+	while (ne > s && (*(ne - 1) == ' ' || *(ne - 1) == '\t'))
+		--ne;
+
+	const char *v = colon + 1;
+	while (v < e && (*v == ' ' || *v == '\t'))
+		++v;
+	while (e > v && (*(e - 1) == ' ' || *(e - 1) == '\t'))
+		--e;
+
+	Header h;
+	h.name.offset   = (uint32_t)(s - data);
+	h.name.length   = (uint32_t)(ne - s);
+	h.value.offset  = (uint32_t)(v - data);
+	h.value.length  = (uint32_t)(e - v);
+	h.id            = headerId(s, ne - s);
+
+	if (h.id == HEADER_CONTENT_LENGTH)
+	{
+		if (v == e)
+		{
+			return false;
+		}
+
+		size_t length = 0;
+		for (const char *p = v; p < e; ++p)
+		{
+			if (*p < '0' || *p > '9' || length > (size_t)0xFFFFFFFF)
+			{
+				return false;
+			}
+			length = length * 10 + (*p - '0');
+		}
+
+		//重复的Content-Length必须一致
+		if (_known[HEADER_CONTENT_LENGTH] && length != _contentLength)
+		{
+			return false;
+		}
+
+		_contentLength = length;
+	}
+	else if (h.id == HEADER_TRANSFER_ENCODING)
+	{
+		//chunked必须是最后一个编码
+		_chunked = (e - v >= 7 && TC_Port::strncasecmp(e - 7, "chunked", 7) == 0);
+	}
+
+	_headers.push_back(h);
+
+	if (h.id != HEADER_UNKNOWN && _known[h.id] == 0)
+	{
+		_known[h.id] = (uint16_t)_headers.size();
+	}
+
+	return true;
+}
+
+TC_NetWorkBuffer::PACKET_TYPE TC_HttpRequestParser::parse(const char *data, size_t len)
+{
+	if (len < _scan)
+	{
+		//数据不是上次的数据了, 重新解析
+		reset();
+	}
+
+	if (_state == S_LINE && _scan == 0)
+	{
+		//前面几个字节就可以判断是不是http请求, 不用等完整的请求行
+		const char *p = (const char*)memchr(data, ' ', std::min(len, (size_t)10));
+		if (p == NULL)
+		{
+			return len >= 10 ? TC_NetWorkBuffer::PACKET_ERR : TC_NetWorkBuffer::PACKET_LESS;
+		}
+
+		auto it = TC_Http::HEADER.find(string(data, p - data));
+		if (it == TC_Http::HEADER.end())
+		{
+			return TC_NetWorkBuffer::PACKET_ERR;
+		}
+
+		_requestType = it->second;
+	}
+
+	while (true)
+	{
+		switch (_state)
+		{
+			case S_LINE:
+			{
+				int64_t end = nextLine(data, len);
+				if (end < 0)
+				{
+					return TC_NetWorkBuffer::PACKET_LESS;
+				}
+
+				if (!parseLine(data, end))
+				{
+					return TC_NetWorkBuffer::PACKET_ERR;
+				}
+
+				_pos   = end + 1;
+				_state = S_HEADER;
+				break;
+			}
+			case S_HEADER:
+			{
+				int64_t end = nextLine(data, len);
+				if (end < 0)
+				{
+					return TC_NetWorkBuffer::PACKET_LESS;
+				}
+
+				if ((size_t)end == _pos || ((size_t)end == _pos + 1 && data[_pos] == '\r'))
+				{
+					//空行, 头部结束
+					_headLength = end + 1;
+					_pos        = end + 1;
+
+					if (_chunked)
+					{
+						_contentLength = 0;
+						_state = S_CHUNK_SIZE;
+					}
+					else if (_contentLength > 0)
+					{
+						_state = S_BODY;
+					}
+					else
+					{
+						_packetLength = _headLength;
+						_state = S_DONE;
+					}
+					break;
+				}
+
+				if (!parseHeader(data, end))
+				{
+					return TC_NetWorkBuffer::PACKET_ERR;
+				}
+
+				_pos = end + 1;
+				break;
+			}
+			case S_BODY:
+			{
+				if (len < _headLength + _contentLength)
+				{
+					return TC_NetWorkBuffer::PACKET_LESS;
+				}
+
+				View v;
+				v.offset = (uint32_t)_headLength;
+				v.length = (uint32_t)_contentLength;
+				_content.push_back(v);
+
+				_packetLength = _headLength + _contentLength;
+				_scan  = _packetLength;
+				_state = S_DONE;
+				break;
+			}
+			case S_CHUNK_SIZE:
+			{
+				int64_t end = nextLine(data, len);
+				if (end < 0)
+				{
+					return TC_NetWorkBuffer::PACKET_LESS;
+				}
+
+				//chunk大小, 忽略';'后面的扩展
+				size_t size = 0;
+				size_t i = _pos;
+				for (; i < (size_t)end; ++i)
+				{
+					char c = data[i];
+					int n;
+					if (c >= '0' && c <= '9') n = c - '0';
+					else if (c >= 'a' && c <= 'f') n = c - 'a' + 10;
+					else if (c >= 'A' && c <= 'F') n = c - 'A' + 10;
+					else break;
+
+					if (size > ((size_t)0xFFFFFFFF >> 4))
+					{
+						return TC_NetWorkBuffer::PACKET_ERR;
+					}
+					size = (size << 4) + n;
+				}
+
+				if (i == _pos || (i < (size_t)end && data[i] != ';' && data[i] != '\r' && data[i] != ' '))
+				{
+					return TC_NetWorkBuffer::PACKET_ERR;
+				}
+
+				_pos = end + 1;
+
+				if (size == 0)
+				{
+					_state = S_CHUNK_TRAILER;
+				}
+				else
+				{
+					_chunkSize = size;
+					_state = S_CHUNK_DATA;
+				}
+				break;
+			}
+			case S_CHUNK_DATA:
+			{
+				if (len < _pos + _chunkSize + 2)
+				{
+					return TC_NetWorkBuffer::PACKET_LESS;
+				}
+
+				if (data[_pos + _chunkSize] != '\r' || data[_pos + _chunkSize + 1] != '\n')
+				{
+					return TC_NetWorkBuffer::PACKET_ERR;
+				}
+
+				View v;
+				v.offset = (uint32_t)_pos;
+				v.length = (uint32_t)_chunkSize;
+				_content.push_back(v);
+
+				_contentLength += _chunkSize;
+
+				_pos   = _pos + _chunkSize + 2;
+				_scan  = _pos;
+				_state = S_CHUNK_SIZE;
+				break;
+			}
+			case S_CHUNK_TRAILER:
+			{
+				int64_t end = nextLine(data, len);
+				if (end < 0)
+				{
+					return TC_NetWorkBuffer::PACKET_LESS;
+				}
+
+				if ((size_t)end == _pos || ((size_t)end == _pos + 1 && data[_pos] == '\r'))
+				{
+					_packetLength = end + 1;
+					_state = S_DONE;
+					break;
+				}
+
+				//trailer头部忽略
+				_pos = end + 1;
+				break;
+			}
+			case S_DONE:
+				return TC_NetWorkBuffer::PACKET_FULL;
+		}
+	}
+}
+
+const TC_HttpRequestParser::Header *TC_HttpRequestParser::findHeader(const char *data, const char *name) const
+{
+	size_t len = strlen(name);
+
+	for (size_t i = 0; i < _headers.size(); i++)
+	{
+		const Header &h = _headers[i];
+		if (h.name.length == len && TC_Port::strncasecmp(data + h.name.offset, name, len) == 0)
+		{
+			return &h;
+		}
+	}
+
+	return NULL;
+}
+
+string TC_HttpRequestParser::getHeader(const char *data, HEADER_ID id) const
+{
+	const Header *h = findHeader(id);
+
+	return h ? str(data, h->value) : string();
+}
+
+string TC_HttpRequestParser::getHeader(const char *data, const char *name) const
+{
+	const Header *h = findHeader(data, name);
+
+	return h ? str(data, h->value) : string();
+}
+
+void TC_HttpRequestParser::getContent(const char *data, string &content) const
+{
+	content.clear();
+
+	if (_content.size() == 1)
+	{
+		content.assign(data + _content[0].offset, _content[0].length);
+		return;
+	}
+
+	content.reserve(_contentLength);
+
+	for (size_t i = 0; i < _content.size(); i++)
+	{
+		content.append(data + _content[i].offset, _content[i].length);
+	}
+}
+
 }
 
 
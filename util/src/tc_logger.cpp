@@ -34,6 +34,7 @@ static int __global_logger_debug_init__ = init_global_debug_log();
 bool TC_LoggerRoll::_bDyeingFlag = false;
 TC_SpinLock TC_LoggerRoll::_mutexDyeing;
 unordered_map<uint64_t, string>  TC_LoggerRoll::_mapThreadID;
+std::atomic<uint64_t> TC_LoggerRoll::_idGen{0};
 
 const string LogByDay::FORMAT = "%Y%m%d";
 const string LogByHour::FORMAT = "%Y%m%d%H";
@@ -72,7 +73,79 @@ void TC_LoggerRoll::unSetupThread()
 	flush();
 }
 
+TC_LoggerStage::TC_LoggerStage(size_t count) : _head(0), _tail(0)
+{
+	size_t n = 2;
+	while (n < count)
+	{
+		n <<= 1;
+	}
+
+	_records.resize(n);
+	_mask = n - 1;
+}
+
+bool TC_LoggerStage::push(size_t threadId, const char *data, size_t len)
+{
+	size_t head = _head.load(std::memory_order_relaxed);
+
+	if (head - _tail.load(std::memory_order_acquire) > _mask)
+	{
+		return false;
+	}
+
+	Record &r = _records[head & _mask];
+
+	r.threadId = threadId;
+	r.len      = len;
+
+	if (len <= RECORD_SIZE)
+	{
+		memcpy(r.data, data, len);
+	}
+	else
+	{
+		r.large.assign(data, len);
+	}
+
+	_head.store(head + 1, std::memory_order_release);
+
+	return true;
+}
+
+size_t TC_LoggerStage::pop(deque<pair<size_t, string> > &ds)
+{
+	size_t tail = _tail.load(std::memory_order_relaxed);
+	size_t head = _head.load(std::memory_order_acquire);
+
+	for (size_t i = tail; i != head; ++i)
+	{
+		Record &r = _records[i & _mask];
+
+		if (r.len <= RECORD_SIZE)
+		{
+			ds.push_back(make_pair(r.threadId, string(r.data, r.len)));
+		}
+		else
+		{
+			ds.push_back(make_pair(r.threadId, std::move(r.large)));
+			r.large.clear();
+		}
+	}
+
+	_tail.store(head, std::memory_order_release);
+
+	return head - tail;
+}
+
+//////////////////////////////////////////////////////////////////
+//
 void TC_LoggerRoll::write(const pair<std::size_t, string> &buffer)
+{
+	write(buffer.second.c_str(), buffer.second.length());
+}
+
+void TC_LoggerRoll::write(const char *data, size_t len)
 {
 	size_t ThreadID = 0;
 	if (_bDyeingFlag)
@@ -87,22 +160,99 @@ void TC_LoggerRoll::write(const pair<std::size_t, string> &buffer)
 
 	if (_pThreadGroup)
 	{
-		_buffer.push_back(make_pair(ThreadID, buffer.second));
+		if (_stageRecords > 0)
+		{
+			TC_LoggerStage *stage = getStage();
+
+			//暂存队列满了(写日志线程来不及取), 放到公共队列, 直到放进去的日志都被取走, 后面的日志也放公共队列
+			if (!stage->isOverflow(_flushSeq.load(std::memory_order_acquire)) && stage->push(ThreadID, data, len))
+			{
+				return;
+			}
+
+			_buffer.push_back(make_pair(ThreadID, string(data, len)));
+
+			stage->setOverflow(_flushSeq.load(std::memory_order_acquire));
+			return;
+		}
+
+		_buffer.push_back(make_pair(ThreadID, string(data, len)));
 	}
 	else
 	{
 		//同步记录日志
 		deque<pair<size_t, string> > ds;
-		ds.push_back(make_pair(ThreadID, buffer.second));
+		ds.push_back(make_pair(ThreadID, string(data, len)));
 		roll(ds);
 	}
 }
 
+TC_LoggerStage *TC_LoggerRoll::getStage()
+{
+	//线程退出时释放自己的引用, 剩下的数据由roll取完后释放
+	static thread_local unordered_map<uint64_t, shared_ptr<TC_LoggerStage> > stages;
+	static thread_local uint64_t lastId = 0;
+	static thread_local TC_LoggerStage *lastStage = NULL;
+
+	if (lastId == _id)
+	{
+		return lastStage;
+	}
+
+	shared_ptr<TC_LoggerStage> &stage = stages[_id];
+	if (!stage)
+	{
+		stage = std::make_shared<TC_LoggerStage>(_stageRecords);
+
+		std::lock_guard<std::mutex> lock(_stageMutex);
+		_stages.push_back(stage);
+	}
+
+	lastId    = _id;
+	lastStage = stage.get();
+
+	return lastStage;
+}
+
 void TC_LoggerRoll::flush()
 {
 	TC_CasQueue<pair<size_t, string> >::queue_type qt;
+	TC_CasQueue<pair<size_t, string> >::queue_type other;
+
+	//取数据和写日志都在锁内, 多个线程同时flush时, 先取出的先写
+	std::lock_guard<std::mutex> lock(_stageMutex);
+
+	//先取公共队列再取暂存队列: 放到公共队列的日志, 同一个线程之前放进暂存队列的日志一定在这次(或者之前)取到
+	_buffer.swap(other);
+
+	for (auto it = _stages.begin(); it != _stages.end(); )
+	{
+		(*it)->pop(qt);
 
-	_buffer.swap(qt);
+		//线程已经退出, 数据也取完了
+		if (it->use_count() == 1 && (*it)->empty())
+		{
+			it = _stages.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	_flushSeq.fetch_add(1, std::memory_order_release);
+
+	if (qt.empty())
+	{
+		qt.swap(other);
+	}
+	else
+	{
+		for (auto &e : other)
+		{
+			qt.push_back(std::move(e));
+		}
+	}
 
 	if (!qt.empty())
 	{
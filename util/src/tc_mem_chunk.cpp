@@ -466,7 +466,8 @@ void TC_MemMultiChunkAllocator::connect(void *pAddr)
         return;
     }
 
-    assert(_pHead->_iNext == _pHead->_iSize);
+    //扩展时可能有保留的空间
+    assert(_pHead->_iNext >= _pHead->_iSize);
     assert(_nallocator == NULL);
 
     //下一块地址, 注意这里是嵌套的, 扩展分配空间的时候注意 
@@ -503,19 +504,19 @@ TC_MemMultiChunkAllocator *TC_MemMultiChunkAllocator::lastAlloc()
     return p;
 }
 
-void TC_MemMultiChunkAllocator::append(void *pAddr, size_t iSize)
+void TC_MemMultiChunkAllocator::append(void *pAddr, size_t iSize, size_t iReserve)
 {
     connect(pAddr);
 
     //扩展后的空间地址一定需要>开始的空间
-    assert(iSize > _pHead->_iTotalSize);
+    assert(iSize > _pHead->_iTotalSize + iReserve);
 
-    //扩展空间部分的真实起始地址
-    void *pAppendAddr = (char*)pAddr + _pHead->_iTotalSize;
+    //扩展空间部分的真实起始地址(跳过保留的部分)
+    void *pAppendAddr = (char*)pAddr + _pHead->_iTotalSize + iReserve;
 
     //扩展的部分初始化, 注意这里p不用delete, 最后系统的时候会循环delete所有分配器
     TC_MemMultiChunkAllocator *p = new TC_MemMultiChunkAllocator();
-    p->create(pAppendAddr, iSize - _pHead->_iTotalSize, _pHead->_iMinBlockSize, _pHead->_iMaxBlockSize, _pHead->_fFactor);
+    p->create(pAppendAddr, iSize - _pHead->_iTotalSize - iReserve, _pHead->_iMinBlockSize, _pHead->_iMaxBlockSize, _pHead->_fFactor);
 
     //扩展部分连接到最后一个分配块最后
     TC_MemMultiChunkAllocator *palloc = lastAlloc();
@@ -530,7 +531,7 @@ void TC_MemMultiChunkAllocator::append(void *pAddr, size_t iSize)
         _nallocator     = p;
     }
 
-    assert(_pHead->_iNext == _pHead->_iSize);
+    assert(_pHead->_iNext >= _pHead->_iSize);
 
     //总计大小
     _pHead->_iTotalSize = iSize;
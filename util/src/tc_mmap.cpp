@@ -120,9 +120,10 @@ void TC_Mmap::mmap(const char *file, size_t length)
         _bCreate = true;
     }
 
-    if(_bCreate)
+    //避免空洞文件; 已有的文件比length小时(扩展空间)也要先扩展文件, 否则访问超出文件的部分会SIGBUS
+    struct stat st;
+    if(_bCreate || (fstat(fd, &st) == 0 && (size_t)st.st_size < length))
     {
-        //避免空洞文件
         lseek(fd, length-1, SEEK_SET);
         write(fd,"\0",1);
     }
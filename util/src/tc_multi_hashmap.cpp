@@ -2690,6 +2690,27 @@ void TC_Multi_HashMap::updateMaxMainKeyBlockCount(size_t iCount)
     }
 }
 
+void TC_Multi_HashMap::prefetch(const vector<pair<string, string> > &vKey)
+{
+    vector<uint32_t> vIndex(vKey.size());
+
+    //先预取所有的桶, 再预取桶上的block, 让两次访存都能并行
+    for(size_t i = 0; i < vKey.size(); i++)
+    {
+        vIndex[i] = hashIndex(vKey[i].first, vKey[i].second);
+        TC_PREFETCH(item(vIndex[i]));
+    }
+
+    for(size_t i = 0; i < vIndex.size(); i++)
+    {
+        uint32_t iAddr = item(vIndex[i])->_iBlockAddr;
+        if(iAddr != 0)
+        {
+            TC_PREFETCH(getAbsolute(iAddr));
+        }
+    }
+}
+
 int TC_Multi_HashMap::get(const string &mk, const string &uk, Value &v)
 {
     TC_Multi_HashMap::FailureRecover recover(this);
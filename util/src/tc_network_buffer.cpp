@@ -52,6 +52,31 @@ void TC_NetWorkBuffer::Buffer::alloc(size_t len)
 	}
 }
 
+TC_NetWorkBuffer::Slice::Slice(const shared_ptr<Buffer> &buff, const char *data, size_t length)
+: _holder(std::make_shared<Holder>(buff)), _data(data), _length(length)
+{
+	assert(data >= buff->_buffer && data + length <= buff->_buffer + buff->_capacity);
+}
+
+TC_NetWorkBuffer::Slice TC_NetWorkBuffer::Slice::sub(size_t offset, size_t length) const
+{
+	assert(offset + length <= _length);
+
+	Slice slice;
+	slice._holder = _holder;
+	slice._data = _data + offset;
+	slice._length = length;
+
+	return slice;
+}
+
+void TC_NetWorkBuffer::Slice::clear()
+{
+	_holder.reset();
+	_data = NULL;
+	_length = 0;
+}
+
 void TC_NetWorkBuffer::Buffer::compact()
 {
 	//还没分配空间, 分配空间
@@ -222,7 +247,8 @@ shared_ptr<TC_NetWorkBuffer::Buffer> TC_NetWorkBuffer::getOrCreateBuffer(size_t
 
 	if(_bufferList.empty())
 	{
-		if(!_defaultBuff)
+		//默认buffer还被Slice引用着, 不能复用, 重新分配一个
+		if(!_defaultBuff || _defaultBuff->sliced())
 		{
 			_defaultBuff = std::make_shared<Buffer>();
 			_defaultBuff->alloc(maxCapacity);
@@ -242,8 +268,8 @@ shared_ptr<TC_NetWorkBuffer::Buffer> TC_NetWorkBuffer::getOrCreateBuffer(size_t
 		auto buff = _bufferList.back();
 		if(buff->left() < minCapacity)
 		{
-			//剩余空间太小了, 检查看看是否容量够, 如果够, compact一下
-			if(buff->capacity() - buff->length() >= minCapacity && buff->length() * 3 < buff->capacity())
+			//剩余空间太小了, 检查看看是否容量够, 如果够, compact一下(被Slice引用的buffer不能移动数据)
+			if(!buff->sliced() && buff->capacity() - buff->length() >= minCapacity && buff->length() * 3 < buff->capacity())
 			{
 				buff->compact();
 			}
@@ -351,6 +377,23 @@ pair<const char*, size_t> TC_NetWorkBuffer::getBufferPointer() const
 	return make_pair((*it)->buffer(), (*it)->length());
 }
 
+size_t TC_NetWorkBuffer::getBufferPointers(pair<const char*, size_t> *vec, size_t count) const
+{
+	size_t i = 0;
+
+	for(auto it = _bufferList.begin(); it != _bufferList.end() && i < count; ++it)
+	{
+		if((*it)->empty())
+		{
+			continue;
+		}
+
+		vec[i++] = make_pair((*it)->buffer(), (*it)->length());
+	}
+
+	return i;
+}
+
 const char * TC_NetWorkBuffer::mergeBuffers()
 {
 	//merge to one buffer
@@ -470,6 +513,48 @@ bool TC_NetWorkBuffer::getHeader(size_t len, std::vector<char> &buffer) const
 	return true;
 }
 
+bool TC_NetWorkBuffer::getSlice(size_t len, Slice &slice)
+{
+	if(getBufferLength() < len)
+		return false;
+
+	if(len == 0)
+	{
+		slice.clear();
+		return true;
+	}
+
+	auto buff = *_bufferList.begin();
+
+	if(buff->length() < len)
+	{
+		//数据跨了多个buffer, 合并成一个buffer再引用
+		mergeBuffers();
+
+		buff = *_bufferList.begin();
+	}
+
+	slice = Slice(buff, buff->buffer(), len);
+
+	return true;
+}
+
+void TC_NetWorkBuffer::reserveContinuous(size_t length)
+{
+	if(_bufferList.size() != 1)
+	{
+		return;
+	}
+
+	auto buff = *_bufferList.begin();
+
+	//剩余的包数据放不进当前buffer, 提前扩展好空间, 这样整包收完后就在同一个buffer里
+	if(!buff->sliced() && buff->length() + buff->left() < length)
+	{
+		buff->expansion(length);
+	}
+}
+
 bool TC_NetWorkBuffer::moveHeader(size_t len)
 {
 	if(getBufferLength() < len)
@@ -537,20 +622,42 @@ TC_NetWorkBuffer::PACKET_TYPE TC_NetWorkBuffer::parseBufferOf4(vector<char> &buf
 	return parseBuffer<uint32_t>(buffer, minLength, maxLength);
 }
 
+TC_NetWorkBuffer::PACKET_TYPE TC_NetWorkBuffer::parseBufferOf4(Slice &slice, uint32_t minLength, uint32_t maxLength)
+{
+	return parseBuffer<uint32_t>(slice, minLength, maxLength);
+}
+
 TC_NetWorkBuffer::PACKET_TYPE TC_NetWorkBuffer::checkHttp()
 {
-	try
+	if (empty())
 	{
-		bool b = TC_HttpRequest::checkRequest(*this);
+		return PACKET_LESS;
+	}
 
-		return b ? PACKET_FULL : PACKET_LESS;
+	//增量解析器放在context里, 请求分多次收到时从上次的位置继续解析
+	TC_HttpRequestParser *parser = (TC_HttpRequestParser*)getContextData();
+	if (parser == NULL)
+	{
+		parser = new TC_HttpRequestParser();
+		setContextData(parser, [](TC_NetWorkBuffer *nb){ TC_HttpRequestParser *p = (TC_HttpRequestParser*)(nb->getContextData()); if(p) { nb->setContextData(NULL); delete p; }});
 	}
-	catch (exception &ex)
+
+	//上一个请求已经解析完整, 但数据不是由parseHttp取走的(比如checkHttp后直接getBuffers/clearBuffers), 从头开始解析
+	if (parser->isComplete())
 	{
-		return PACKET_ERR;
+		parser->reset();
 	}
 
-	return PACKET_LESS;
+	const char *data = mergeBuffers();
+
+	TC_NetWorkBuffer::PACKET_TYPE ret = parser->parse(data, getBufferLength());
+
+	if (ret == PACKET_ERR)
+	{
+		parser->reset();
+	}
+
+	return ret;
 }
 
 TC_NetWorkBuffer::PACKET_TYPE TC_NetWorkBuffer::parseHttp(TC_NetWorkBuffer&in, vector<char> &out)
@@ -561,9 +668,19 @@ TC_NetWorkBuffer::PACKET_TYPE TC_NetWorkBuffer::parseHttp(TC_NetWorkBuffer&in, v
 
 	if (b == PACKET_FULL)
 	{
-		out = in.getBuffers();
+		//只取一个完整的请求, 后面的(pipeline)留给下次解析
+		TC_HttpRequestParser *parser = (TC_HttpRequestParser*)in.getContextData();
 
-		in.clearBuffers();
+		size_t length = parser->packetLength();
+
+		in.getHeader(length, out);
+
+		in.moveHeader(length);
+
+		//解析结果跟着请求走, 业务解析时不用再扫描一遍头部
+		in._httpParser = std::make_shared<TC_HttpRequestParser>(std::move(*parser));
+
+		parser->reset();
 	}
 
 	return b;
@@ -18,8 +18,25 @@
 
 #include <openssl/ssl.h>
 #include <openssl/err.h>
+#include <openssl/hmac.h>
 
 #include "util/tc_openssl.h"
+#include "util/tc_common.h"
+
+#if TARGET_PLATFORM_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/tls.h>
+
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#endif
 
 
 namespace tars
@@ -34,6 +51,11 @@ TC_OpenSSL::TC_OpenSSL(SSL* ssl)
 , _isServer(false)
 , _err(0)
 , _plainBuf(NULL)
+, _ktls(false)
+, _ktlsTx(false)
+, _ktlsRx(false)
+, _ktlsRxRecords(0)
+, _ktlsRxAligned(false)
 {
 }
 
@@ -51,6 +73,12 @@ void TC_OpenSSL::release()
     }
     _bHandshaked = false;
     _err = 0;
+    _ktlsTx = false;
+    _ktlsRx = false;
+    OPENSSL_cleanse(&_clientSecret[0], _clientSecret.size());
+    OPENSSL_cleanse(&_serverSecret[0], _serverSecret.size());
+    _clientSecret.clear();
+    _serverSecret.clear();
 }
 
 void TC_OpenSSL::init(bool isServer)
@@ -141,9 +169,9 @@ int TC_OpenSSL::doHandshake(TC_NetWorkBuffer &out, const void* data, size_t size
 
 int TC_OpenSSL::write(const char* data, size_t size, TC_NetWorkBuffer &out)
 {
-    if (!_bHandshaked)
+    if (!_bHandshaked || _ktlsTx)
     {
-	    //握手数据不用加密
+	    //握手数据不用加密, kTLS由内核加密
 	    out.addBuffer(data, size);
 	    return 0;
     }
@@ -164,6 +192,13 @@ int TC_OpenSSL::write(const char* data, size_t size, TC_NetWorkBuffer &out)
 
 int TC_OpenSSL::read(const void* data, size_t size, TC_NetWorkBuffer &out)
 {
+    if (_ktlsRx)
+    {
+        //内核已经解密
+        _plainBuf.addBuffer((const char*)data, size);
+        return 0;
+    }
+
     bool usedData = false;
     if (!_bHandshaked)
     {
@@ -174,6 +209,24 @@ int TC_OpenSSL::read(const void* data, size_t size, TC_NetWorkBuffer &out)
         if (ret != 0)
             return ret;
 
+        if (_bHandshaked && _ktls)
+        {
+            //紧跟着握手的数据下面会由openssl解密, 开启kTLS时接收序号要跳过这些记录
+            char *p = NULL;
+            long len = BIO_get_mem_data(SSL_get_rbio(_ssl), &p);
+            long pos = 0;
+            _ktlsRxRecords = 0;
+            while (pos + 5 <= len)
+            {
+                long recordLen = 5 + (((unsigned char)p[pos + 3] << 8) | (unsigned char)p[pos + 4]);
+                if (pos + recordLen > len)
+                    break;
+                pos += recordLen;
+                ++_ktlsRxRecords;
+            }
+            _ktlsRxAligned = (pos == len);
+        }
+
 //        if (_bHandshaked)
             ; // TODO onHandshake
     }
@@ -256,6 +309,286 @@ int TC_OpenSSL::doSSLRead(SSL* ssl, TC_NetWorkBuffer& out)
 	return 0;
 }
 
+#if TARGET_PLATFORM_LINUX
+
+//TLS1.2 PRF(RFC5246 5)
+static string tls12Prf(const EVP_MD *md, const string &secret, const string &label, const string &seed, size_t len)
+{
+	unsigned char buf[EVP_MAX_MD_SIZE];
+	unsigned int bufLen = 0;
+
+	string ls = label + seed;
+	string a = ls;
+	string out;
+
+	while (out.size() < len)
+	{
+		HMAC(md, secret.data(), (int)secret.size(), (const unsigned char*)a.data(), a.size(), buf, &bufLen);
+		a.assign((const char*)buf, bufLen);
+
+		string in = a + ls;
+		HMAC(md, secret.data(), (int)secret.size(), (const unsigned char*)in.data(), in.size(), buf, &bufLen);
+		out.append((const char*)buf, bufLen);
+	}
+
+	OPENSSL_cleanse(buf, sizeof(buf));
+	out.resize(len);
+	return out;
+}
+
+//TLS1.3 HKDF-Expand-Label(RFC8446 7.1), 输出长度不超过摘要长度, 一轮HMAC就够了
+static string tls13ExpandLabel(const EVP_MD *md, const string &secret, const string &label, size_t len)
+{
+	string info;
+	info += (char)(len >> 8);
+	info += (char)(len & 0xff);
+	info += (char)(6 + label.size());
+	info += "tls13 " + label;
+	info += (char)0;
+	info += (char)1;
+
+	unsigned char buf[EVP_MAX_MD_SIZE];
+	unsigned int bufLen = 0;
+	HMAC(md, secret.data(), (int)secret.size(), (const unsigned char*)info.data(), info.size(), buf, &bufLen);
+
+	string out((const char*)buf, (std::min)((size_t)bufLen, len));
+	OPENSSL_cleanse(buf, sizeof(buf));
+	return out;
+}
+
+template<typename T>
+static bool setKtlsCrypto(int fd, int direction, int version, int cipherType, const string &key, const string &iv, uint64_t seq)
+{
+	T info;
+	memset(&info, 0, sizeof(info));
+
+	info.info.version = version;
+	info.info.cipher_type = cipherType;
+
+	for (int i = 7; i >= 0; i--)
+	{
+		info.rec_seq[i] = (unsigned char)(seq & 0xff);
+		seq >>= 8;
+	}
+
+	memcpy(info.key, key.data(), sizeof(info.key));
+	memcpy(info.salt, iv.data(), sizeof(info.salt));
+
+	if (iv.size() > sizeof(info.salt))
+	{
+		//TLS1.3: nonce = (salt + iv) ^ seq
+		memcpy(info.iv, iv.data() + sizeof(info.salt), sizeof(info.iv));
+	}
+	else
+	{
+		//TLS1.2: 显式nonce, 只需要不重复, 用记录序号
+		memcpy(info.iv, info.rec_seq, sizeof(info.iv));
+	}
+
+	int ret = setsockopt(fd, SOL_TLS, direction, &info, sizeof(info));
+
+	OPENSSL_cleanse(&info, sizeof(info));
+
+	return ret == 0;
+}
+
+static bool setKtlsCrypto(int fd, int direction, int version, const string &key, const string &iv, uint64_t seq)
+{
+	if (key.size() == 16)
+	{
+		return setKtlsCrypto<tls12_crypto_info_aes_gcm_128>(fd, direction, version, TLS_CIPHER_AES_GCM_128, key, iv, seq);
+	}
+#ifdef TLS_CIPHER_AES_GCM_256
+	if (key.size() == 32)
+	{
+		return setKtlsCrypto<tls12_crypto_info_aes_gcm_256>(fd, direction, version, TLS_CIPHER_AES_GCM_256, key, iv, seq);
+	}
+#endif
+	return false;
+}
+
+#endif
+
+void TC_OpenSSL::keylogCallback(const SSL* ssl, const char* line)
+{
+	TC_OpenSSL *p = (TC_OpenSSL*)SSL_get_app_data(ssl);
+	if (!p)
+		return;
+
+	//CLIENT_TRAFFIC_SECRET_0 <client random> <secret>
+	vector<string> v = TC_Common::sepstr<string>(line, " ");
+	if (v.size() != 3)
+		return;
+
+	if (v[0] == "CLIENT_TRAFFIC_SECRET_0")
+	{
+		p->_clientSecret = TC_Common::str2bin(v[2]);
+	}
+	else if (v[0] == "SERVER_TRAFFIC_SECRET_0")
+	{
+		p->_serverSecret = TC_Common::str2bin(v[2]);
+	}
+}
+
+bool TC_OpenSSL::enableKtls(int fd, bool tx)
+{
+#if TARGET_PLATFORM_LINUX
+	if (!_ktls || !_bHandshaked || _ktlsTx || _ktlsRx)
+	{
+		return false;
+	}
+
+	//只尝试一次
+	_ktls = false;
+
+	const SSL_CIPHER *cipher = SSL_get_current_cipher(_ssl);
+	if (!cipher)
+	{
+		return false;
+	}
+
+	size_t keyLen = 0;
+	switch (SSL_CIPHER_get_cipher_nid(cipher))
+	{
+		case NID_aes_128_gcm:
+			keyLen = 16;
+			break;
+#ifdef TLS_CIPHER_AES_GCM_256
+		case NID_aes_256_gcm:
+			keyLen = 32;
+			break;
+#endif
+		default:
+			return false;
+	}
+
+	const EVP_MD *md = SSL_CIPHER_get_handshake_digest(cipher);
+	if (!md)
+	{
+		return false;
+	}
+
+	int version = SSL_version(_ssl);
+
+	string clientKey, serverKey, clientIv, serverIv;
+
+	//握手完成后两个方向都已经有一个记录(Finished)用了新密钥: TLS1.2序号从1开始, TLS1.3换了流量密钥从0开始
+	uint64_t seq = 0;
+
+	if (version == TLS1_2_VERSION)
+	{
+		unsigned char master[SSL_MAX_MASTER_KEY_LENGTH];
+		size_t masterLen = SSL_SESSION_get_master_key(SSL_get_session(_ssl), master, sizeof(master));
+
+		unsigned char random[SSL3_RANDOM_SIZE * 2];
+		SSL_get_server_random(_ssl, random, SSL3_RANDOM_SIZE);
+		SSL_get_client_random(_ssl, random + SSL3_RANDOM_SIZE, SSL3_RANDOM_SIZE);
+
+		//AEAD没有mac key: client key, server key, client iv(4), server iv(4)
+		string block = tls12Prf(md, string((const char*)master, masterLen), "key expansion", string((const char*)random, sizeof(random)), keyLen * 2 + 8);
+		OPENSSL_cleanse(master, sizeof(master));
+
+		clientKey = block.substr(0, keyLen);
+		serverKey = block.substr(keyLen, keyLen);
+		clientIv  = block.substr(keyLen * 2, 4);
+		serverIv  = block.substr(keyLen * 2 + 4, 4);
+		OPENSSL_cleanse(&block[0], block.size());
+
+		seq = 1;
+	}
+#if defined(TLS1_3_VERSION) && defined(TLS_1_3_VERSION)
+	else if (version == TLS1_3_VERSION && !_clientSecret.empty() && !_serverSecret.empty())
+	{
+		clientKey = tls13ExpandLabel(md, _clientSecret, "key", keyLen);
+		serverKey = tls13ExpandLabel(md, _serverSecret, "key", keyLen);
+		clientIv  = tls13ExpandLabel(md, _clientSecret, "iv", 12);
+		serverIv  = tls13ExpandLabel(md, _serverSecret, "iv", 12);
+
+		seq = 0;
+	}
+#endif
+	else
+	{
+		return false;
+	}
+
+	//内核没有tls模块时这里会失败(ENOENT)
+	if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) == 0)
+	{
+		//先开接收方向, 发送方向失败时接收仍然交给内核, 两个方向相互独立
+		if (_ktlsRxAligned)
+		{
+			_ktlsRx = setKtlsCrypto(fd, TLS_RX, version, _isServer ? clientKey : serverKey, _isServer ? clientIv : serverIv, seq + _ktlsRxRecords);
+		}
+
+		if (tx)
+		{
+			_ktlsTx = setKtlsCrypto(fd, TLS_TX, version, _isServer ? serverKey : clientKey, _isServer ? serverIv : clientIv, seq);
+		}
+	}
+
+	OPENSSL_cleanse(&clientKey[0], clientKey.size());
+	OPENSSL_cleanse(&serverKey[0], serverKey.size());
+	OPENSSL_cleanse(&_clientSecret[0], _clientSecret.size());
+	OPENSSL_cleanse(&_serverSecret[0], _serverSecret.size());
+	_clientSecret.clear();
+	_serverSecret.clear();
+
+	return _ktlsTx || _ktlsRx;
+#else
+	return false;
+#endif
+}
+
+int TC_OpenSSL::recvKtls(int fd, void* buf, uint32_t len, int flag)
+{
+#if TARGET_PLATFORM_LINUX
+	while (true)
+	{
+		char cbuf[CMSG_SPACE(sizeof(unsigned char))];
+
+		struct iovec iov;
+		iov.iov_base = buf;
+		iov.iov_len = len;
+
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = cbuf;
+		msg.msg_controllen = sizeof(cbuf);
+
+		int ret = (int)::recvmsg(fd, &msg, flag);
+		if (ret <= 0)
+		{
+			return ret;
+		}
+
+		struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+		if (cmsg && cmsg->cmsg_level == SOL_TLS && cmsg->cmsg_type == TLS_GET_RECORD_TYPE)
+		{
+			unsigned char type = *CMSG_DATA(cmsg);
+
+			//告警(close_notify等)
+			if (type == SSL3_RT_ALERT)
+			{
+				return 0;
+			}
+
+			//握手消息(session ticket等)丢弃
+			if (type != SSL3_RT_APPLICATION_DATA)
+			{
+				continue;
+			}
+		}
+
+		return ret;
+	}
+#else
+	return -1;
+#endif
+}
+
 void TC_OpenSSL::initialize()
 {
 	if(!_initialize)
@@ -269,7 +602,7 @@ void TC_OpenSSL::initialize()
 	}
 }
 
-shared_ptr<TC_OpenSSL::CTX> TC_OpenSSL::newCtx(const std::string& cafile, const std::string& certfile, const std::string& keyfile, bool verifyClient, const string &ciphers)
+shared_ptr<TC_OpenSSL::CTX> TC_OpenSSL::newCtx(const std::string& cafile, const std::string& certfile, const std::string& keyfile, bool verifyClient, const string &ciphers, bool ktls)
 {
 	initialize();
 
@@ -314,7 +647,22 @@ shared_ptr<TC_OpenSSL::CTX> TC_OpenSSL::newCtx(const std::string& cafile, const
 	}
 #undef RETURN_IF_FAIL
 
-	return std::make_shared<TC_OpenSSL::CTX>(ctx);
+	shared_ptr<TC_OpenSSL::CTX> c = std::make_shared<TC_OpenSSL::CTX>(ctx);
+
+#if TARGET_PLATFORM_LINUX && OPENSSL_VERSION_NUMBER >= 0x10101000L
+	if (ktls)
+	{
+		c->ktls = true;
+
+		//TLS1.3的流量密钥从keylog回调里取
+		SSL_CTX_set_keylog_callback(ctx, TC_OpenSSL::keylogCallback);
+
+		//握手后不发session ticket(会话缓存本来就关了), 保证发送序号从0开始
+		SSL_CTX_set_num_tickets(ctx, 0);
+	}
+#endif
+
+	return c;
 }
 
 
@@ -330,7 +678,15 @@ shared_ptr<TC_OpenSSL> TC_OpenSSL::newSSL(const std::shared_ptr<TC_OpenSSL::CTX>
 	BIO_set_mem_eof_return(SSL_get_rbio(ssl), -1);
 	BIO_set_mem_eof_return(SSL_get_wbio(ssl), -1);
 
-	return std::make_shared<TC_OpenSSL>(ssl);
+	shared_ptr<TC_OpenSSL> p = std::make_shared<TC_OpenSSL>(ssl);
+
+	if (ctx->ktls)
+	{
+		p->_ktls = true;
+		SSL_set_app_data(ssl, p.get());
+	}
+
+	return p;
 }
 
 TC_OpenSSL::CTX::~CTX()
@@ -95,15 +95,7 @@ void TC_TimerBase::erase(int64_t uniqId)
 	//LOG_CONSOLE_DEBUG << "before erase event!" << ",uniqId=" << uniqId << "|event size :" << _mapEvent.size() << "|timer size:" << _mapTimer.size() << endl;
 	if (it != _mapEvent.end())
 	{
-		auto itEvent = _mapTimer.find(it->second->_fireMillseconds);
-		if (itEvent != _mapTimer.end())
-		{
-			itEvent->second.erase(uniqId);
-			if (itEvent->second.empty())
-			{
-				_mapTimer.erase(itEvent);
-			}
-		}
+		_mapTimer.erase(it->second->_timerId);
 		it->second->_func = nullptr;
 		_mapEvent.erase(it);
 	}
@@ -123,7 +115,9 @@ int64_t TC_TimerBase::post(const shared_ptr<TC_TimerBase::Func> & event, bool re
 		_mapEvent[uniqId] = event;
 	}
 
-	_mapTimer[event->_fireMillseconds].insert(uniqId);
+	//重复投递时先删除原来的定时
+	_mapTimer.erase(event->_timerId);
+	event->_timerId = _mapTimer.add(event->_fireMillseconds, event->_uniqueId);
 
 	// LOG_CONSOLE_DEBUG << "fireMillseconds:" << event->_fireMillseconds << ", " << TNOWMS << ", " << event->_fireMillseconds - TNOWMS << endl;
 
@@ -204,24 +198,18 @@ int64_t TC_TimerBase::getEvents(TC_TimerBase::EVENT_SET &el)
 {
 	std::unique_lock <std::mutex> lock(_mutex);
 
-	_nextTimer = -1;
+	_mapTimer.advance(TNOWMS);
 
-	for (auto it = _mapTimer.begin(); it != _mapTimer.end();)
+	//时间过了, 有事件需要触发了
+	uint32_t uniqId;
+	while (_mapTimer.pop(uniqId))
 	{
-		if ((uint64_t)it->first <= TNOWMS)
-		{
-			//时间过了, 有事件需要触发了
-			el.insert(it->second.begin(), it->second.end());
-			_mapTimer.erase(it++);
-		}
-		else
-		{
-			//时间还没到
-			_nextTimer = it->first;
-			break;
-		}
+		el.insert(uniqId);
 	}
 
+	//时间还没到的, 时间轮给出下一次需要处理的时间(可能早于实际的事件时间)
+	_nextTimer = _mapTimer.nextExpire();
+
 	return _nextTimer;
 }
 
@@ -4,10 +4,76 @@
 #include "util/tc_openssl.h"
 #endif
 #include <sstream>
+#include <atomic>
+#include <mutex>
+#include <set>
+#if !TARGET_PLATFORM_WINDOWS
+#include <sys/uio.h>
+#endif
 
 namespace tars
 {
 
+//tcp发送统计: 发送的数据块数, 系统调用次数
+//每个线程一份, 只有本线程写, 避免所有网络线程在发送路径上争用同一个cache line, getSendStat时汇总
+struct TransceiverSendStat
+{
+	std::atomic<uint64_t> _buffers{0};
+	std::atomic<uint64_t> _syscalls{0};
+};
+
+struct TransceiverSendStatRegistry
+{
+	std::mutex						_mutex;
+	std::set<TransceiverSendStat*>	_stats;
+
+	//已经退出的线程的统计
+	uint64_t						_buffers = 0;
+	uint64_t						_syscalls = 0;
+};
+
+static TransceiverSendStatRegistry &sendStatRegistry()
+{
+	//不析构, 进程退出时其他线程可能还在发送
+	static TransceiverSendStatRegistry *registry = new TransceiverSendStatRegistry();
+	return *registry;
+}
+
+struct TransceiverThreadSendStat
+{
+	TransceiverSendStat _stat;
+
+	TransceiverThreadSendStat()
+	{
+		TransceiverSendStatRegistry &registry = sendStatRegistry();
+		std::lock_guard<std::mutex> lock(registry._mutex);
+		registry._stats.insert(&_stat);
+	}
+
+	~TransceiverThreadSendStat()
+	{
+		TransceiverSendStatRegistry &registry = sendStatRegistry();
+		std::lock_guard<std::mutex> lock(registry._mutex);
+		registry._stats.erase(&_stat);
+		registry._buffers += _stat._buffers.load(std::memory_order_relaxed);
+		registry._syscalls += _stat._syscalls.load(std::memory_order_relaxed);
+	}
+};
+
+static thread_local TransceiverThreadSendStat g_threadSendStat;
+
+static inline void addSendStat(uint64_t buffers)
+{
+	TransceiverSendStat &stat = g_threadSendStat._stat;
+
+	//只有本线程写, 不需要原子加法
+	stat._buffers.store(stat._buffers.load(std::memory_order_relaxed) + buffers, std::memory_order_relaxed);
+	stat._syscalls.store(stat._syscalls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+//一次聚合发送最多的块数
+static const size_t MAX_SEND_IOV = 64;
+
 class CloseClourse
 {
 public:
@@ -658,12 +724,9 @@ void TC_Transceiver::doRequest()
 	//buf不为空,先发送buffer的内容
 	while (!_sendBuffer.empty())
 	{
-		auto data = _sendBuffer.getBufferPointer();
-		assert(data.first != NULL && data.second != 0);
+//        LOG_CONSOLE_DEBUG << "doRequest buff :" << _sendBuffer.getBufferLength() << endl;
 
-//        LOG_CONSOLE_DEBUG << "doRequest buff :" << string(data.first, (uint32_t)data.second) << endl;
-
-		int iRet = this->send(data.first, (uint32_t)data.second, 0);
+		int iRet = sendBuffers();
 
 		if (iRet <= 0)
 		{
@@ -679,17 +742,8 @@ void TC_Transceiver::doRequest()
 	}
 }
 
-TC_Transceiver::ReturnStatus
-TC_Transceiver::sendRequest(const shared_ptr<TC_NetWorkBuffer::Buffer>& buff, const TC_Socket::addr_type& addr)
+TC_Transceiver::ReturnStatus TC_Transceiver::checkSend()
 {
-//	LOG_CONSOLE_DEBUG << buff->length() << endl;
-
-	//空数据 直接返回成功
-	if (buff->empty())
-	{
-		return eRetOk;
-	}
-
 	// assert(_sendBuffer.empty());
 	//buf不为空, 表示之前的数据还没发送完, 直接返回失败, 等buffer可写了,epoll会通知写事件
 	if (!_sendBuffer.empty())
@@ -708,25 +762,34 @@ TC_Transceiver::sendRequest(const shared_ptr<TC_NetWorkBuffer::Buffer>& buff, co
 		return eRetNotSend;
 	}
 
-		if (_ep.isTcp() && _ep.getAuthType() == TC_Endpoint::AUTH_TYPELOCAL && _authState != eAuthSucc)
-		{
+	if (_ep.isTcp() && _ep.getAuthType() == TC_Endpoint::AUTH_TYPELOCAL && _authState != eAuthSucc)
+	{
 #if TARS_SSL
-			if (isSSL() && !_openssl)
-			{
-				return eRetNotSend;
-			}
+		if (isSSL() && !_openssl)
+		{
+			return eRetNotSend;
+		}
 #endif
 		return eRetNotSend; // 需要鉴权但还没通过，不能发送非认证消息
 	}
 
 #if TARS_SSL
-		// 握手数据已加密,直接发送，会话数据需加密
-		if (isSSL())
-		{
-			if(!_openssl->isHandshaked()) {
-				return eRetNotSend;
-			}
+	// 握手数据已加密,直接发送，会话数据需加密
+	if (isSSL() && !_openssl->isHandshaked())
+	{
+		return eRetNotSend;
+	}
+#endif
 
+	return eRetOk;
+}
+
+TC_Transceiver::ReturnStatus TC_Transceiver::appendRequest(const shared_ptr<TC_NetWorkBuffer::Buffer> &buff)
+{
+#if TARS_SSL
+	//kTLS由内核加密, 直接放入发送buffer
+	if (isSSL() && !_openssl->isKtlsTx())
+	{
 		int ret = _openssl->write(buff->buffer(), (uint32_t) buff->length(), _sendBuffer);
 		if(ret != 0)
 		{
@@ -735,23 +798,24 @@ TC_Transceiver::sendRequest(const shared_ptr<TC_NetWorkBuffer::Buffer>& buff, co
 		}
 
 		buff->clear();
+
+		return eRetOk;
 	}
-	else
-	{
-		_sendBuffer.addBuffer(buff);
-	}
-#else
-	_sendBuffer.addBuffer(buff);
 #endif
 
+	_sendBuffer.addBuffer(buff);
+
+	return eRetOk;
+}
+
+TC_Transceiver::ReturnStatus TC_Transceiver::flushRequest(const TC_Socket::addr_type& addr)
+{
 //	LOG_CONSOLE_DEBUG << _sendBuffer.getBufferLength() << endl;
 
 	_lastAddr = addr;
 	do
 	{
-		auto data = _sendBuffer.getBufferPointer();
-
-		int iRet = this->send(data.first, (uint32_t)data.second, 0);
+		int iRet = sendBuffers();
 		if (iRet < 0)
 		{
 			if (!isValid())
@@ -772,6 +836,114 @@ TC_Transceiver::sendRequest(const shared_ptr<TC_NetWorkBuffer::Buffer>& buff, co
 	return eRetOk;
 }
 
+int TC_Transceiver::sendBuffers()
+{
+	pair<const char*, size_t> vec[MAX_SEND_IOV];
+
+	size_t count = _sendBuffer.getBufferPointers(vec, MAX_SEND_IOV);
+
+	assert(count > 0);
+
+	if (count == 1)
+	{
+		return this->send(vec[0].first, (uint32_t)vec[0].second, 0);
+	}
+
+	return this->sendv(vec, count);
+}
+
+void TC_Transceiver::getSendStat(uint64_t &buffers, uint64_t &syscalls)
+{
+	TransceiverSendStatRegistry &registry = sendStatRegistry();
+	std::lock_guard<std::mutex> lock(registry._mutex);
+
+	buffers = registry._buffers;
+	syscalls = registry._syscalls;
+
+	for(auto stat : registry._stats)
+	{
+		buffers += stat->_buffers.load(std::memory_order_relaxed);
+		syscalls += stat->_syscalls.load(std::memory_order_relaxed);
+	}
+}
+
+int TC_Transceiver::sendv(const pair<const char*, size_t> *vec, size_t count)
+{
+	assert(count > 0);
+
+	return this->send(vec[0].first, (uint32_t)vec[0].second, 0);
+}
+
+TC_Transceiver::ReturnStatus
+TC_Transceiver::sendRequest(const shared_ptr<TC_NetWorkBuffer::Buffer>& buff, const TC_Socket::addr_type& addr)
+{
+//	LOG_CONSOLE_DEBUG << buff->length() << endl;
+
+	//空数据 直接返回成功
+	if (buff->empty())
+	{
+		return eRetOk;
+	}
+
+	ReturnStatus ret = checkSend();
+	if (ret != eRetOk)
+	{
+		return ret;
+	}
+
+	ret = appendRequest(buff);
+	if (ret != eRetOk)
+	{
+		return ret;
+	}
+
+	return flushRequest(addr);
+}
+
+TC_Transceiver::ReturnStatus
+TC_Transceiver::sendRequests(const vector<shared_ptr<TC_NetWorkBuffer::Buffer>> &buffs, const TC_Socket::addr_type& addr)
+{
+	if (!_ep.isTcp())
+	{
+		//udp每个buffer都是一个独立的包, 不能聚合
+		for (auto &buff : buffs)
+		{
+			ReturnStatus ret = sendRequest(buff, addr);
+			if (ret != eRetOk)
+			{
+				return ret;
+			}
+		}
+		return eRetOk;
+	}
+
+	ReturnStatus ret = checkSend();
+	if (ret != eRetOk)
+	{
+		return ret;
+	}
+
+	for (auto &buff : buffs)
+	{
+		if (buff->empty())
+		{
+			continue;
+		}
+
+		ret = appendRequest(buff);
+		if (ret != eRetOk)
+		{
+			return ret;
+		}
+	}
+
+	if (_sendBuffer.empty())
+	{
+		return eRetOk;
+	}
+
+	return flushRequest(addr);
+}
 
 void TC_Transceiver::doAuthCheck(TC_NetWorkBuffer* buff)
 {
@@ -1042,6 +1214,8 @@ int TC_TCPTransceiver::send(const void* buf, uint32_t len, uint32_t flag)
 	int iRet = ::send(_fd, (const char*)buf, len, flag);
 //    LOG_CONSOLE_DEBUG << this << ", send, fd:" << _fd << ", " << _desc << ", iRet:" << iRet << ", len:" << len << endl;
 
+	addSendStat(1);
+
 	if (iRet < 0 && !TC_Socket::isPending())
 	{
         tcpClose(false, CR_SEND, "TC_TCPTransceiver::send, " + _desc + ", fd:" + TC_Common::tostr(_fd));
@@ -1059,6 +1233,64 @@ int TC_TCPTransceiver::send(const void* buf, uint32_t len, uint32_t flag)
 	return iRet;
 }
 
+int TC_TCPTransceiver::sendv(const pair<const char*, size_t> *vec, size_t count)
+{
+	//只有是连接状态才能收发数据
+	if (eConnected != _connStatus)
+	{
+		return -1;
+	}
+
+	count = (std::min)(count, MAX_SEND_IOV);
+
+#if TARGET_PLATFORM_WINDOWS
+	WSABUF iov[MAX_SEND_IOV];
+	for (size_t i = 0; i < count; i++)
+	{
+		iov[i].buf = (char*)vec[i].first;
+		iov[i].len = (ULONG)vec[i].second;
+	}
+
+	DWORD sent = 0;
+	int iRet = ::WSASend(_fd, iov, (DWORD)count, &sent, 0, NULL, NULL);
+	if (iRet == 0)
+	{
+		iRet = (int)sent;
+	}
+#else
+	struct iovec iov[MAX_SEND_IOV];
+	for (size_t i = 0; i < count; i++)
+	{
+		iov[i].iov_base = (void*)vec[i].first;
+		iov[i].iov_len = vec[i].second;
+	}
+
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = count;
+
+	int iRet = (int)::sendmsg(_fd, &msg, 0);
+#endif
+
+	addSendStat(count);
+
+	if (iRet < 0 && !TC_Socket::isPending())
+	{
+		tcpClose(false, CR_SEND, "TC_TCPTransceiver::sendv, " + _desc + ", fd:" + TC_Common::tostr(_fd));
+		return -1;
+	}
+
+#if TARGET_PLATFORM_WINDOWS
+	if(iRet < 0 && TC_Socket::isPending())
+	{
+		_epollInfo->mod(EPOLLIN | EPOLLOUT);
+	}
+#endif
+
+	return iRet;
+}
+
 int TC_TCPTransceiver::recv(void* buf, uint32_t len, uint32_t flag)
 {
 	//只有是连接状态才能收发数据
@@ -1103,6 +1335,41 @@ bool TC_SSLTransceiver::doResponse()
 
 	do
 	{
+		if (_openssl->isKtlsRx())
+		{
+			//内核已经解密, 直接收到明文buffer
+			TC_NetWorkBuffer *rbuf = _openssl->recvBuffer();
+
+			auto data = rbuf->getOrCreateBuffer(BUFFER_SIZE/8, BUFFER_SIZE);
+
+			uint32_t left = (uint32_t)data->left();
+
+			if ((iRet = this->recv((void*)data->free(), left, 0)) > 0)
+			{
+				data->addWriteIdx(iRet);
+
+				rbuf->addLength(iRet);
+
+				//解析协议
+				doProtocolAnalysis(rbuf);
+
+				//收包太多了, 中断一下, 释放线程给send等
+				if (TNOWMS - now >= LONG_NETWORK_TRANS_TIME && isValid())
+				{
+					_epollInfo->mod(EPOLLIN | EPOLLOUT);
+					break;
+				}
+
+				//接收的数据小于buffer大小, 内核会再次通知你
+				if (iRet < (int)left)
+				{
+					break;
+				}
+			}
+
+			continue;
+		}
+
 	    auto data = _recvBuffer.getOrCreateBuffer(BUFFER_SIZE/8, BUFFER_SIZE);
 
 	    uint32_t left = (uint32_t)data->left();
@@ -1138,6 +1405,9 @@ bool TC_SSLTransceiver::doResponse()
 
 			if (!preHandshake)
 			{
+				//握手完成, 尝试把会话密钥交给内核(kTLS), 发送buffer里还有密文时发送方向继续走openssl
+				_openssl->enableKtls(_fd, _sendBuffer.empty());
+
 				if(_isServer)
 				{
 					_onRequestCallback(this);
@@ -1193,6 +1463,31 @@ bool TC_SSLTransceiver::doResponse()
 #endif
 }
 
+int TC_SSLTransceiver::recv(void* buf, uint32_t len, uint32_t flag)
+{
+#if TARS_SSL
+	if (_openssl && _openssl->isKtlsRx())
+	{
+		//只有是连接状态才能收发数据
+		if (eConnected != _connStatus)
+			return -1;
+
+		int iRet = _openssl->recvKtls(_fd, buf, len, flag);
+
+		if ((iRet < 0 && !TC_Socket::isPending()))
+		{
+			int nerr = TC_Exception::getSystemCode();
+			string err = "ktls recv error, errno:" + TC_Common::tostr(nerr) + "," + TC_Exception::parseError(nerr);
+			THROW_ERROR(TC_Transceiver_Exception, CR_RECV, err + ", " + _desc + ", fd:" + TC_Common::tostr(_fd));
+		}
+
+		return iRet;
+	}
+#endif
+
+	return TC_TCPTransceiver::recv(buf, len, flag);
+}
+
 /////////////////////////////////////////////////////////////////
 TC_UDPTransceiver::TC_UDPTransceiver(TC_Epoller* epoller, const TC_Endpoint& ep)
 		: TC_Transceiver(epoller, ep)